@@ -0,0 +1,178 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Benchmarks/Core/FlatHashMap.cpp
+// Description: Flat hash map against std::unordered_map on string and integer keys.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#include "Core/FlatHashMap.hpp"
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace Warlock;
+
+static constexpr std::size_t StringCount = 100000;
+static constexpr std::size_t IntegerCount = 1000000;
+static constexpr std::size_t LookupCount = 4000000;
+static constexpr int Repetitions = 5;
+
+// Best of Repetitions runs of Body, in nanoseconds per Count operations.
+template <typename Function> static double Measure(std::size_t Count, Function &&Body)
+{
+    double best = 1.0e30;
+
+    for (int r = 0; r < Repetitions; r++)
+    {
+        auto start = std::chrono::steady_clock::now();
+        Body();
+        std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+
+        best = std::min(best, elapsed.count() / static_cast<double>(Count));
+    }
+
+    return best;
+};
+
+static void Report(const char *Name, double Unordered, double Flat)
+{
+    std::printf("%-24s %10.1f ns %10.1f ns %8.2fx\n", Name, Unordered, Flat, Unordered / Flat);
+};
+
+// Keeps the compiler from dropping a result.
+static volatile std::uint64_t Sink;
+
+int main()
+{
+    std::mt19937_64 random(1);
+    std::vector<std::string> names(StringCount), misses(StringCount);
+
+    for (std::size_t i = 0; i < StringCount; i++)
+    {
+        names[i] = "resource/mesh_" + std::to_string(i * 7919) + ".bin";
+        misses[i] = "resource/other_" + std::to_string(i) + ".bin";
+    }
+
+    std::vector<std::uint32_t> order(LookupCount);
+
+    for (std::uint32_t &index : order)
+        index = static_cast<std::uint32_t>(random() % StringCount);
+
+    std::vector<std::uint64_t> keys(IntegerCount), lookups(LookupCount);
+
+    for (std::size_t i = 0; i < IntegerCount; i++)
+        keys[i] = i * 2654435761ull;
+
+    for (std::uint64_t &key : lookups)
+        key = keys[random() % IntegerCount];
+
+    std::unordered_map<std::string, int> unorderedStrings;
+    Core::FlatHashMap<std::string, int> flatStrings;
+    std::unordered_map<std::uint64_t, int> unorderedIntegers;
+    Core::FlatHashMap<std::uint64_t, int> flatIntegers;
+
+    for (std::size_t i = 0; i < StringCount; i++)
+    {
+        unorderedStrings[names[i]] = static_cast<int>(i);
+        flatStrings[names[i]] = static_cast<int>(i);
+    }
+
+    for (std::size_t i = 0; i < IntegerCount; i++)
+    {
+        unorderedIntegers[keys[i]] = static_cast<int>(i);
+        flatIntegers[keys[i]] = static_cast<int>(i);
+    }
+
+    std::printf("%-24s %13s %13s %9s\n", "", "unordered_map", "FlatHashMap", "speedup");
+
+    Report("string hit", Measure(LookupCount, [&]()
+    {
+        std::uint64_t sum = 0;
+
+        for (std::uint32_t index : order)
+            sum += unorderedStrings.find(names[index])->second;
+
+        Sink = sum;
+    }), Measure(LookupCount, [&]()
+    {
+        std::uint64_t sum = 0;
+
+        for (std::uint32_t index : order)
+            sum += *flatStrings.Find(names[index]);
+
+        Sink = sum;
+    }));
+
+    Report("string miss", Measure(StringCount, [&]()
+    {
+        std::uint64_t sum = 0;
+
+        for (const std::string &name : misses)
+            sum += unorderedStrings.count(name);
+
+        Sink = sum;
+    }), Measure(StringCount, [&]()
+    {
+        std::uint64_t sum = 0;
+
+        for (const std::string &name : misses)
+            sum += flatStrings.Contains(name);
+
+        Sink = sum;
+    }));
+
+    Report("integer hit", Measure(LookupCount, [&]()
+    {
+        std::uint64_t sum = 0;
+
+        for (std::uint64_t key : lookups)
+            sum += unorderedIntegers.find(key)->second;
+
+        Sink = sum;
+    }), Measure(LookupCount, [&]()
+    {
+        std::uint64_t sum = 0;
+
+        for (std::uint64_t key : lookups)
+            sum += *flatIntegers.Find(key);
+
+        Sink = sum;
+    }));
+
+    Report("integer insert", Measure(IntegerCount, [&]()
+    {
+        std::unordered_map<std::uint64_t, int> map;
+
+        for (std::size_t i = 0; i < IntegerCount; i++)
+            map[keys[i]] = static_cast<int>(i);
+
+        Sink = map.size();
+    }), Measure(IntegerCount, [&]()
+    {
+        Core::FlatHashMap<std::uint64_t, int> map;
+
+        for (std::size_t i = 0; i < IntegerCount; i++)
+            map[keys[i]] = static_cast<int>(i);
+
+        Sink = map.GetCount();
+    }));
+
+    return 0;
+};
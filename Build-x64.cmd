@@ -7,6 +7,8 @@ mkdir Build\Windows\x64\Release\Log
 mkdir Build\Windows\x64\Debug\Object
 mkdir Build\Windows\x64\Debug\Assembly
 mkdir Build\Windows\x64\Debug\Log
+mkdir Build\Windows\x64\Test\Object
+mkdir Build\Windows\x64\Benchmark\Object
 
 REM # [2] Source file compilation
 cl /c /O2 /Ot /Oi /favor:blend /std:c++17 /FaBuild\Windows\x64\Release\Assembly\WarlockEngine.asm /FmBuild\Windows\x64\Release\WarlockEngine.map /FoBuild\Windows\x64\Release\Object\WarlockEngine.obj /nologo /MP2 /showIncludes /TP /utf-8 Source/WarlockEngine.cpp  > Build\Windows\x64\Release\Log\Compiler.log
@@ -21,4 +23,11 @@ del Build\Windows\x64\Release\WarlockEngine.res
 
 REM # [4] Dynamic link library creation
 link /nologo /DLL /SUBSYSTEM:WINDOWS /VERBOSE Build\Windows\x64\Release\Object\WarlockEngine.res Build\Windows\x64\Release\Object\WarlockEngine.obj /OUT:Build\Windows\x64\Release\WarlockEngine.dll > Build\Windows\x64\Release\Log\Linker.log
-link /nologo /DEBUG:FULL /DLL /SUBSYSTEM:WINDOWS /VERBOSE Build\Windows\x64\Debug\Object\WarlockEngine.res Build\Windows\x64\Debug\Object\WarlockEngine.obj /OUT:Build\Windows\x64\Debug\WarlockEngine.dll > Build\Windows\x64\Debug\Log\Linker.log
\ No newline at end of file
+link /nologo /DEBUG:FULL /DLL /SUBSYSTEM:WINDOWS /VERBOSE Build\Windows\x64\Debug\Object\WarlockEngine.res Build\Windows\x64\Debug\Object\WarlockEngine.obj /OUT:Build\Windows\x64\Debug\WarlockEngine.dll > Build\Windows\x64\Debug\Log\Linker.log
+
+REM # [5] Test compilation
+cl /O2 /std:c++17 /EHsc /nologo /utf-8 /ISource /FoBuild\Windows\x64\Test\Object\ /FeBuild\Windows\x64\Test\AsyncReader.exe Tests\IO\AsyncReader.cpp > Build\Windows\x64\Test\AsyncReader.log
+cl /O2 /std:c++17 /EHsc /nologo /utf-8 /ISource /FoBuild\Windows\x64\Test\Object\ /FeBuild\Windows\x64\Test\Loopback.exe Tests\Network\Loopback.cpp > Build\Windows\x64\Test\Loopback.log
+
+REM # [6] Benchmark compilation
+cl /O2 /std:c++17 /EHsc /nologo /utf-8 /ISource /FoBuild\Windows\x64\Benchmark\Object\ /FeBuild\Windows\x64\Benchmark\FlatHashMap.exe Benchmarks\Core\FlatHashMap.cpp > Build\Windows\x64\Benchmark\FlatHashMap.log
@@ -7,6 +7,8 @@ mkdir Build\Windows\x86\Release\Log
 mkdir Build\Windows\x86\Debug\Object
 mkdir Build\Windows\x86\Debug\Assembly
 mkdir Build\Windows\x86\Debug\Log
+mkdir Build\Windows\x86\Test\Object
+mkdir Build\Windows\x86\Benchmark\Object
 
 REM # [2] Source file compilation
 cl /c /O2 /Ot /Oi /favor:blend /std:c++17 /FaBuild\Windows\x86\Release\Assembly\WarlockEngine.asm /FmBuild\Windows\x86\Release\WarlockEngine.map /FoBuild\Windows\x86\Release\Object\WarlockEngine.obj /nologo /MP2 /showIncludes /TP /utf-8 Source/WarlockEngine.cpp > Build\Windows\x86\Release\Log\Compiler.log
@@ -21,4 +23,11 @@ del Build\Windows\x86\Release\WarlockEngine.res
 
 REM # [4] Dynamic link library creation
 link /nologo /DLL /SUBSYSTEM:WINDOWS /VERBOSE Build\Windows\x86\Release\Object\WarlockEngine.res Build\Windows\x86\Release\Object\WarlockEngine.obj /OUT:Build\Windows\x86\Release\WarlockEngine.dll > Build\Windows\x86\Release\Log\Linker.log
-link /nologo /DEBUG:FULL /DLL /SUBSYSTEM:WINDOWS /VERBOSE Build\Windows\x86\Debug\Object\WarlockEngine.res Build\Windows\x86\Debug\Object\WarlockEngine.obj /OUT:Build\Windows\x86\Debug\WarlockEngine.dll > Build\Windows\x86\Debug\Log\Linker.log
\ No newline at end of file
+link /nologo /DEBUG:FULL /DLL /SUBSYSTEM:WINDOWS /VERBOSE Build\Windows\x86\Debug\Object\WarlockEngine.res Build\Windows\x86\Debug\Object\WarlockEngine.obj /OUT:Build\Windows\x86\Debug\WarlockEngine.dll > Build\Windows\x86\Debug\Log\Linker.log
+
+REM # [5] Test compilation
+cl /O2 /std:c++17 /EHsc /nologo /utf-8 /ISource /FoBuild\Windows\x86\Test\Object\ /FeBuild\Windows\x86\Test\AsyncReader.exe Tests\IO\AsyncReader.cpp > Build\Windows\x86\Test\AsyncReader.log
+cl /O2 /std:c++17 /EHsc /nologo /utf-8 /ISource /FoBuild\Windows\x86\Test\Object\ /FeBuild\Windows\x86\Test\Loopback.exe Tests\Network\Loopback.cpp > Build\Windows\x86\Test\Loopback.log
+
+REM # [6] Benchmark compilation
+cl /O2 /std:c++17 /EHsc /nologo /utf-8 /ISource /FoBuild\Windows\x86\Benchmark\Object\ /FeBuild\Windows\x86\Benchmark\FlatHashMap.exe Benchmarks\Core\FlatHashMap.cpp > Build\Windows\x86\Benchmark\FlatHashMap.log
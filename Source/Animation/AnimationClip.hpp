@@ -0,0 +1,451 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Animation/AnimationClip.hpp
+// Description: Compressed skeletal animation clips with quantized, segmented key streams.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_ANIMATION_ANIMATIONCLIP_HPP
+#define WARLOCK_ANIMATION_ANIMATIONCLIP_HPP
+
+#include "Math/Simd.hpp"
+#include "Math/Vector3.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Animation
+    {
+        enum PoseChannel
+        {
+            TranslationX,
+            TranslationY,
+            TranslationZ,
+            RotationX,
+            RotationY,
+            RotationZ,
+            RotationW,
+            ScaleX,
+            ScaleY,
+            ScaleZ,
+            ChannelCount
+        };
+
+        // Structure of arrays pose: each channel is a contiguous array with one value per bone.
+        class Pose
+        {
+            public:
+                explicit Pose(std::size_t BoneCount = 0) : boneCount(BoneCount), values(BoneCount * ChannelCount, 0.0f) {};
+
+                std::size_t GetBoneCount() const
+                {
+                    return boneCount;
+                };
+
+                float *GetChannel(PoseChannel Channel)
+                {
+                    return values.data() + Channel * boneCount;
+                };
+
+                const float *GetChannel(PoseChannel Channel) const
+                {
+                    return values.data() + Channel * boneCount;
+                };
+
+                Math::Vector3<float> GetTranslation(std::size_t Bone) const
+                {
+                    return Math::Vector3<float>(GetChannel(TranslationX)[Bone], GetChannel(TranslationY)[Bone], GetChannel(TranslationZ)[Bone]);
+                };
+
+                Math::Vector3<float> GetScale(std::size_t Bone) const
+                {
+                    return Math::Vector3<float>(GetChannel(ScaleX)[Bone], GetChannel(ScaleY)[Bone], GetChannel(ScaleZ)[Bone]);
+                };
+
+                // Values of stream s = Channel * BoneCount + Bone.
+                float *GetData()
+                {
+                    return values.data();
+                };
+
+            private:
+                std::size_t boneCount;
+                std::vector<float> values;
+        };
+
+        // Uncompressed input sampled at a fixed rate, one full pose per frame.
+        struct RawAnimation
+        {
+            RawAnimation(std::size_t BoneCount, std::size_t FrameCount, float FrameRate) : boneCount(BoneCount), frameCount(FrameCount), frameRate(FrameRate),
+                                                                                         values(BoneCount * FrameCount * ChannelCount, 0.0f) {};
+
+            float &At(std::size_t Frame, PoseChannel Channel, std::size_t Bone)
+            {
+                return values[(Frame * ChannelCount + Channel) * boneCount + Bone];
+            };
+
+            float At(std::size_t Frame, PoseChannel Channel, std::size_t Bone) const
+            {
+                return values[(Frame * ChannelCount + Channel) * boneCount + Bone];
+            };
+
+            std::size_t boneCount;
+            std::size_t frameCount;
+            float frameRate;
+            std::vector<float> values;
+        };
+
+        // Tolerances are absolute errors per key: units for translations, quaternion component
+        // for rotations and scale factor for scales.
+        struct CompressionSettings
+        {
+            CompressionSettings() : translationTolerance(1.0e-3f), rotationTolerance(1.0e-3f), scaleTolerance(1.0e-3f), segmentFrames(16) {};
+
+            float translationTolerance;
+            float rotationTolerance;
+            float scaleTolerance;
+            std::uint32_t segmentFrames;
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // A clip splits every stream (one channel of one bone) in one of four classes:
+        //
+        //   constant  - the whole clip stays within tolerance of one value, stored once;
+        //   narrow    - 8 bit keys suffice in every segment;
+        //   wide      - 16 bit keys suffice in every segment;
+        //   raw       - float keys, for ranges too wide for 16 bits to meet the tolerance.
+        //
+        // Keys are grouped in segments of SegmentFrames frames plus the first key of the next
+        // segment, so interpolation never crosses a segment. Each segment is a self contained
+        // blob holding the per stream range (minimum and scale) followed by rows of narrow, wide
+        // and raw keys, one row per frame, so segments can be streamed in and evicted on their
+        // own.
+        //-----------------------------------------------------------------------------------------
+        class AnimationClip
+        {
+            public:
+                AnimationClip() : boneCount(0), frameCount(0), frameRate(0.0f), segmentFrames(0), narrowStride(0), wideStride(0), rawStride(0), maximumError(0.0f) {};
+
+                static AnimationClip Compress(const RawAnimation &Source, const CompressionSettings &Settings = CompressionSettings())
+                {
+                    AnimationClip clip;
+                    RawAnimation raw = Source;
+                    const std::size_t streams = raw.boneCount * ChannelCount;
+                    const std::size_t frames = raw.frameCount;
+
+                    clip.boneCount = raw.boneCount;
+                    clip.frameCount = frames;
+                    clip.frameRate = raw.frameRate;
+                    clip.segmentFrames = (Settings.segmentFrames ? Settings.segmentFrames : 16);
+
+                    if (frames == 0 || streams == 0)
+                        return clip;
+
+                    // Keep consecutive rotations in the same hemisphere so their components
+                    // interpolate smoothly.
+                    for (std::size_t bone = 0; bone < raw.boneCount; bone++)
+                    {
+                        for (std::size_t frame = 1; frame < frames; frame++)
+                        {
+                            float dot = 0.0f;
+
+                            for (int c = RotationX; c <= RotationW; c++)
+                                dot += raw.At(frame, static_cast<PoseChannel>(c), bone) * raw.At(frame - 1, static_cast<PoseChannel>(c), bone);
+
+                            if (dot < 0.0f)
+                            {
+                                for (int c = RotationX; c <= RotationW; c++)
+                                    raw.At(frame, static_cast<PoseChannel>(c), bone) = -raw.At(frame, static_cast<PoseChannel>(c), bone);
+                            }
+                        }
+                    }
+
+                    const std::size_t segments = (frames > 1 ? (frames - 2) / clip.segmentFrames + 1 : 1);
+
+                    for (std::size_t s = 0; s < streams; s++)
+                    {
+                        PoseChannel channel = static_cast<PoseChannel>(s / raw.boneCount);
+                        std::size_t bone = s % raw.boneCount;
+                        float tolerance = (channel <= TranslationZ ? Settings.translationTolerance : (channel <= RotationW ? Settings.rotationTolerance : Settings.scaleTolerance));
+                        float low = raw.At(0, channel, bone), high = low;
+
+                        for (std::size_t frame = 1; frame < frames; frame++)
+                        {
+                            low = std::fmin(low, raw.At(frame, channel, bone));
+                            high = std::fmax(high, raw.At(frame, channel, bone));
+                        }
+
+                        if (high - low <= 2.0f * tolerance)
+                        {
+                            clip.constantStreams.push_back(static_cast<std::uint32_t>(s));
+                            clip.constantValues.push_back(0.5f * (low + high));
+                            clip.maximumError = std::fmax(clip.maximumError, 0.5f * (high - low));
+                            continue;
+                        }
+
+                        bool narrow = true;
+                        bool wide = true;
+
+                        for (std::size_t segment = 0; segment < segments && wide; segment++)
+                        {
+                            std::size_t first, last;
+                            clip.GetSegmentFrames(segment, first, last);
+
+                            narrow = narrow && (QuantizeError(raw, channel, bone, first, last, 255.0f) <= tolerance);
+                            wide = (QuantizeError(raw, channel, bone, first, last, 65535.0f) <= tolerance);
+                        }
+
+                        (narrow && wide ? clip.narrowStreams : (wide ? clip.wideStreams : clip.rawStreams)).push_back(static_cast<std::uint32_t>(s));
+                    }
+
+                    clip.narrowStride = RoundUp(clip.narrowStreams.size());
+                    clip.wideStride = RoundUp(clip.wideStreams.size());
+                    clip.rawStride = RoundUp(clip.rawStreams.size());
+                    clip.segments.resize(segments);
+
+                    for (std::size_t segment = 0; segment < segments; segment++)
+                        clip.EncodeSegment(raw, segment);
+
+                    return clip;
+                };
+
+                std::size_t GetBoneCount() const
+                {
+                    return boneCount;
+                };
+
+                std::size_t GetFrameCount() const
+                {
+                    return frameCount;
+                };
+
+                float GetFrameRate() const
+                {
+                    return frameRate;
+                };
+
+                float GetDuration() const
+                {
+                    return (frameCount > 1 ? static_cast<float>(frameCount - 1) / frameRate : 0.0f);
+                };
+
+                // Largest absolute difference between a source key and its decoded value.
+                float GetMaximumError() const
+                {
+                    return maximumError;
+                };
+
+                std::size_t GetRawSize() const
+                {
+                    return frameCount * boneCount * ChannelCount * sizeof(float);
+                };
+
+                std::size_t GetCompressedSize() const
+                {
+                    std::size_t size = (constantStreams.size() + narrowStreams.size() + wideStreams.size() + rawStreams.size()) * sizeof(std::uint32_t) +
+                                       constantValues.size() * sizeof(float);
+
+                    for (const std::vector<std::uint8_t> &segment : segments)
+                        size += segment.size();
+
+                    return size;
+                };
+
+                float GetCompressionRatio() const
+                {
+                    std::size_t compressed = GetCompressedSize();
+                    return (compressed ? static_cast<float>(GetRawSize()) / static_cast<float>(compressed) : 0.0f);
+                };
+
+                //---------------------------------------------------------------------------------
+                // Segment streaming
+                //---------------------------------------------------------------------------------
+                std::size_t GetSegmentCount() const
+                {
+                    return segments.size();
+                };
+
+                // Frames [First, Last] covered by a segment, both ends inclusive.
+                void GetSegmentFrames(std::size_t Segment, std::size_t &First, std::size_t &Last) const
+                {
+                    First = Segment * segmentFrames;
+                    Last = (First + segmentFrames < frameCount ? First + segmentFrames : frameCount - 1);
+                };
+
+                std::size_t GetSegment(float Time) const
+                {
+                    std::size_t frame = static_cast<std::size_t>(std::fmax(Time * frameRate, 0.0f));
+                    std::size_t lastInterval = (frameCount > 1 ? frameCount - 2 : 0);
+
+                    return (frame < lastInterval ? frame : lastInterval) / segmentFrames;
+                };
+
+                bool IsSegmentResident(std::size_t Segment) const
+                {
+                    return !segments[Segment].empty();
+                };
+
+                const std::vector<std::uint8_t> &GetSegmentData(std::size_t Segment) const
+                {
+                    return segments[Segment];
+                };
+
+                void EvictSegment(std::size_t Segment)
+                {
+                    std::vector<std::uint8_t>().swap(segments[Segment]);
+                };
+
+                void LoadSegment(std::size_t Segment, std::vector<std::uint8_t> Data)
+                {
+                    segments[Segment] = std::move(Data);
+                };
+
+            private:
+                friend class AnimationSampler;
+
+                static std::size_t RoundUp(std::size_t Count)
+                {
+                    return (Count + WARLOCK_SIMD_WIDTH - 1) / WARLOCK_SIMD_WIDTH * WARLOCK_SIMD_WIDTH;
+                };
+
+                static float QuantizeError(const RawAnimation &Raw, PoseChannel Channel, std::size_t Bone, std::size_t First, std::size_t Last, float Levels)
+                {
+                    float low, scale;
+                    float error = 0.0f;
+
+                    Range(Raw, Channel, Bone, First, Last, Levels, low, scale);
+
+                    for (std::size_t frame = First; frame <= Last; frame++)
+                    {
+                        float value = Raw.At(frame, Channel, Bone);
+                        error = std::fmax(error, std::fabs(Decode(Encode(value, low, scale, Levels), low, scale) - value));
+                    }
+
+                    return error;
+                };
+
+                static void Range(const RawAnimation &Raw, PoseChannel Channel, std::size_t Bone, std::size_t First, std::size_t Last, float Levels,
+                                  float &Low, float &Scale)
+                {
+                    float high = Raw.At(First, Channel, Bone);
+
+                    Low = high;
+
+                    for (std::size_t frame = First + 1; frame <= Last; frame++)
+                    {
+                        Low = std::fmin(Low, Raw.At(frame, Channel, Bone));
+                        high = std::fmax(high, Raw.At(frame, Channel, Bone));
+                    }
+
+                    Scale = (high - Low) / Levels;
+                };
+
+                static std::uint32_t Encode(float Value, float Low, float Scale, float Levels)
+                {
+                    float q = (Scale > 0.0f ? std::round((Value - Low) / Scale) : 0.0f);
+                    return static_cast<std::uint32_t>(std::fmin(std::fmax(q, 0.0f), Levels));
+                };
+
+                static float Decode(std::uint32_t Key, float Low, float Scale)
+                {
+                    return Low + static_cast<float>(Key) * Scale;
+                };
+
+                // Blob layout: float minimum[narrow + wide], float scale[narrow + wide], then one
+                // row of narrowStride bytes per frame, one row of wideStride 16 bit keys per frame
+                // and, from a 4 byte boundary, one row of rawStride floats per frame. A register
+                // of padding at the end keeps vector loads of the last row in bounds.
+                void EncodeSegment(const RawAnimation &Raw, std::size_t Segment)
+                {
+                    std::size_t first, last;
+                    GetSegmentFrames(Segment, first, last);
+
+                    const std::size_t keys = last - first + 1;
+                    const std::size_t ranges = narrowStreams.size() + wideStreams.size();
+                    const std::size_t narrowOffset = 2 * ranges * sizeof(float);
+                    const std::size_t wideOffset = narrowOffset + ((keys * narrowStride + 1) & ~static_cast<std::size_t>(1));
+                    const std::size_t rawOffset = (wideOffset + keys * wideStride * sizeof(std::uint16_t) + 3) & ~static_cast<std::size_t>(3);
+                    const std::size_t size = rawOffset + keys * rawStride * sizeof(float) + 2 * WARLOCK_SIMD_WIDTH * sizeof(float);
+                    std::vector<std::uint8_t> &blob = segments[Segment];
+
+                    blob.assign(size, 0);
+
+                    for (std::size_t r = 0; r < ranges; r++)
+                    {
+                        bool narrow = (r < narrowStreams.size());
+                        std::uint32_t stream = (narrow ? narrowStreams[r] : wideStreams[r - narrowStreams.size()]);
+                        PoseChannel channel = static_cast<PoseChannel>(stream / boneCount);
+                        std::size_t bone = stream % boneCount;
+                        float levels = (narrow ? 255.0f : 65535.0f);
+                        float low, scale;
+
+                        Range(Raw, channel, bone, first, last, levels, low, scale);
+                        std::memcpy(blob.data() + r * sizeof(float), &low, sizeof(float));
+                        std::memcpy(blob.data() + (ranges + r) * sizeof(float), &scale, sizeof(float));
+
+                        for (std::size_t k = 0; k < keys; k++)
+                        {
+                            float value = Raw.At(first + k, channel, bone);
+                            std::uint32_t key = Encode(value, low, scale, levels);
+
+                            maximumError = std::fmax(maximumError, std::fabs(Decode(key, low, scale) - value));
+
+                            if (narrow)
+                                blob[narrowOffset + k * narrowStride + r] = static_cast<std::uint8_t>(key);
+                            else
+                            {
+                                std::uint16_t wide = static_cast<std::uint16_t>(key);
+                                std::memcpy(blob.data() + wideOffset + (k * wideStride + r - narrowStreams.size()) * sizeof(std::uint16_t), &wide, sizeof(wide));
+                            }
+                        }
+                    }
+
+                    for (std::size_t r = 0; r < rawStreams.size(); r++)
+                    {
+                        PoseChannel channel = static_cast<PoseChannel>(rawStreams[r] / boneCount);
+                        std::size_t bone = rawStreams[r] % boneCount;
+
+                        for (std::size_t k = 0; k < keys; k++)
+                        {
+                            float value = Raw.At(first + k, channel, bone);
+                            std::memcpy(blob.data() + rawOffset + (k * rawStride + r) * sizeof(float), &value, sizeof(float));
+                        }
+                    }
+                };
+
+                std::size_t boneCount;
+                std::size_t frameCount;
+                float frameRate;
+                std::size_t segmentFrames;
+                std::size_t narrowStride;
+                std::size_t wideStride;
+                std::size_t rawStride;
+                float maximumError;
+                std::vector<std::uint32_t> constantStreams;
+                std::vector<float> constantValues;
+                std::vector<std::uint32_t> narrowStreams;
+                std::vector<std::uint32_t> wideStreams;
+                std::vector<std::uint32_t> rawStreams;
+                std::vector<std::vector<std::uint8_t>> segments;
+        };
+    };
+};
+
+#endif // WARLOCK_ANIMATION_ANIMATIONCLIP_HPP
@@ -0,0 +1,202 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Animation/AnimationSampler.hpp
+// Description: Batched decompression and interpolation of compressed animation clips.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_ANIMATION_ANIMATIONSAMPLER_HPP
+#define WARLOCK_ANIMATION_ANIMATIONSAMPLER_HPP
+
+#include "AnimationClip.hpp"
+#include "Core/ThreadPool.hpp"
+#include "Math/Simd.hpp"
+#include <cassert>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Animation
+    {
+        // Samples every stream of a clip at once: the quantized rows of the two surrounding keys
+        // are widened, interpolated and rescaled a register of streams at a time, then scattered
+        // into the pose and the rotations renormalized across bones. A sampler owns its scratch
+        // buffer, so keep one per thread.
+        class AnimationSampler
+        {
+            public:
+                // Returns false, leaving the pose untouched, when the segment holding Time is not
+                // resident.
+                bool Sample(const AnimationClip &Clip, float Time, Pose &Output)
+                {
+                    using namespace Math;
+
+                    assert(Output.GetBoneCount() == Clip.boneCount);
+
+                    if (Clip.frameCount == 0 || Clip.segments.empty())
+                        return false;
+
+                    // Locate the key interval; the last frame samples the last interval at its end.
+                    float position = std::fmax(Time * Clip.frameRate, 0.0f);
+                    std::size_t lastInterval = (Clip.frameCount > 1 ? Clip.frameCount - 2 : 0);
+                    std::size_t frame = static_cast<std::size_t>(position);
+
+                    if (frame > lastInterval)
+                        frame = lastInterval;
+
+                    float alpha = (Clip.frameCount > 1 ? std::fmin(position - static_cast<float>(frame), 1.0f) : 0.0f);
+                    std::size_t segment = frame / Clip.segmentFrames;
+                    const std::vector<std::uint8_t> &blob = Clip.segments[segment];
+
+                    if (blob.empty())
+                        return false;
+
+                    std::size_t first, last;
+                    Clip.GetSegmentFrames(segment, first, last);
+
+                    const std::size_t key = frame - first;
+                    const std::size_t next = (key + 1 < last - first + 1 ? key + 1 : key);
+                    const std::size_t keys = last - first + 1;
+                    const std::size_t narrowCount = Clip.narrowStreams.size();
+                    const std::size_t wideCount = Clip.wideStreams.size();
+                    const std::size_t ranges = narrowCount + wideCount;
+                    const std::size_t narrowOffset = 2 * ranges * sizeof(float);
+                    const std::size_t wideOffset = narrowOffset + ((keys * Clip.narrowStride + 1) & ~static_cast<std::size_t>(1));
+                    const std::size_t rawOffset = (wideOffset + keys * Clip.wideStride * sizeof(std::uint16_t) + 3) & ~static_cast<std::size_t>(3);
+                    const std::size_t rawCount = Clip.rawStreams.size();
+                    const float *minimum = reinterpret_cast<const float *>(blob.data());
+                    const float *scale = minimum + ranges;
+                    const std::uint8_t *narrow = blob.data() + narrowOffset;
+                    const std::uint16_t *wide = reinterpret_cast<const std::uint16_t *>(blob.data() + wideOffset);
+                    const float *raw = reinterpret_cast<const float *>(blob.data() + rawOffset);
+                    const SimdFloat weight(alpha);
+
+                    scratch.resize(ranges + Clip.rawStride + WARLOCK_SIMD_WIDTH);
+                    float *decoded = scratch.data();
+
+                    // Lanes past the end of a class spill into the first slots of the next, which
+                    // its pass overwrites right after.
+                    for (std::size_t i = 0; i < narrowCount; i += WARLOCK_SIMD_WIDTH)
+                    {
+                        SimdFloat q0 = ToFloat(SimdInt::Load(narrow + key * Clip.narrowStride + i));
+                        SimdFloat q1 = ToFloat(SimdInt::Load(narrow + next * Clip.narrowStride + i));
+                        SimdFloat q = MulAdd(q1 - q0, weight, q0);
+
+                        MulAdd(q, SimdFloat::Load(scale + i), SimdFloat::Load(minimum + i)).Store(decoded + i);
+                    }
+
+                    for (std::size_t i = 0; i < wideCount; i += WARLOCK_SIMD_WIDTH)
+                    {
+                        SimdFloat q0 = ToFloat(SimdInt::Load(wide + key * Clip.wideStride + i));
+                        SimdFloat q1 = ToFloat(SimdInt::Load(wide + next * Clip.wideStride + i));
+                        SimdFloat q = MulAdd(q1 - q0, weight, q0);
+
+                        MulAdd(q, SimdFloat::Load(scale + narrowCount + i), SimdFloat::Load(minimum + narrowCount + i)).Store(decoded + narrowCount + i);
+                    }
+
+                    for (std::size_t i = 0; i < rawCount; i += WARLOCK_SIMD_WIDTH)
+                    {
+                        SimdFloat f0 = SimdFloat::Load(raw + key * Clip.rawStride + i);
+                        SimdFloat f1 = SimdFloat::Load(raw + next * Clip.rawStride + i);
+
+                        MulAdd(f1 - f0, weight, f0).Store(decoded + ranges + i);
+                    }
+
+                    float *values = Output.GetData();
+
+                    for (std::size_t i = 0; i < narrowCount; i++)
+                        values[Clip.narrowStreams[i]] = decoded[i];
+
+                    for (std::size_t i = 0; i < wideCount; i++)
+                        values[Clip.wideStreams[i]] = decoded[narrowCount + i];
+
+                    for (std::size_t i = 0; i < rawCount; i++)
+                        values[Clip.rawStreams[i]] = decoded[ranges + i];
+
+                    for (std::size_t i = 0; i < Clip.constantStreams.size(); i++)
+                        values[Clip.constantStreams[i]] = Clip.constantValues[i];
+
+                    Normalize(Output);
+                    return true;
+                };
+
+            private:
+                static void Normalize(Pose &Target)
+                {
+                    using namespace Math;
+
+                    float *x = Target.GetChannel(RotationX);
+                    float *y = Target.GetChannel(RotationY);
+                    float *z = Target.GetChannel(RotationZ);
+                    float *w = Target.GetChannel(RotationW);
+                    const std::size_t count = Target.GetBoneCount();
+                    std::size_t i = 0;
+
+                    for (; i + WARLOCK_SIMD_WIDTH <= count; i += WARLOCK_SIMD_WIDTH)
+                    {
+                        SimdFloat qx = SimdFloat::Load(x + i), qy = SimdFloat::Load(y + i), qz = SimdFloat::Load(z + i), qw = SimdFloat::Load(w + i);
+                        SimdFloat inverse = SimdFloat(1.0f) / Sqrt(MulAdd(qx, qx, MulAdd(qy, qy, MulAdd(qz, qz, qw * qw))));
+
+                        (qx * inverse).Store(x + i);
+                        (qy * inverse).Store(y + i);
+                        (qz * inverse).Store(z + i);
+                        (qw * inverse).Store(w + i);
+                    }
+
+                    for (; i < count; i++)
+                    {
+                        float inverse = 1.0f / std::sqrt(x[i] * x[i] + y[i] * y[i] + z[i] * z[i] + w[i] * w[i]);
+
+                        x[i] *= inverse;
+                        y[i] *= inverse;
+                        z[i] *= inverse;
+                        w[i] *= inverse;
+                    }
+                };
+
+                std::vector<float> scratch;
+        };
+
+        struct SampleJob
+        {
+            const AnimationClip *clip;
+            float time;
+            Pose *output;
+        };
+
+        // Samples many clips, typically one per skeleton, across the thread pool. Resident is
+        // optional and receives whether each job found its segment loaded.
+        inline void SampleBatch(const SampleJob *Jobs, std::size_t Count, bool *Resident = nullptr, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            Pool.ParallelFor(0, Count, 16, [&](std::size_t First, std::size_t Last)
+            {
+                AnimationSampler sampler;
+
+                for (std::size_t i = First; i < Last; i++)
+                {
+                    bool sampled = sampler.Sample(*Jobs[i].clip, Jobs[i].time, *Jobs[i].output);
+
+                    if (Resident)
+                        Resident[i] = sampled;
+                }
+            });
+        };
+    };
+};
+
+#endif // WARLOCK_ANIMATION_ANIMATIONSAMPLER_HPP
@@ -0,0 +1,617 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Core/FlatHashMap.hpp
+// Description: Open addressing hash map and set probed a group of slots at a time.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_CORE_FLATHASHMAP_HPP
+#define WARLOCK_CORE_FLATHASHMAP_HPP
+
+#include "Platform/Platform.hpp"
+#include "StringId.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+#if WARLOCK_INSTRUCTION_SET_SSE2
+#include <emmintrin.h>
+#elif (WARLOCK_INSTRUCTION_SET_NEON && WARLOCK_ARCHITECTURE_ARM64)
+#include <arm_neon.h>
+#endif
+
+#if _MSC_VER
+#include <intrin.h>
+#endif
+
+namespace Warlock
+{
+    namespace Core
+    {
+        // Default hash: integers, enums and pointers are mixed so both ends of the result are
+        // usable, strings go through XXH64 and string IDs are already hashes. Transparent, so a
+        // map keyed by std::string can be searched with a std::string_view or a literal.
+        struct FlatHash
+        {
+            template <typename T, typename = typename std::enable_if<(std::is_integral<T>::value || std::is_enum<T>::value || std::is_pointer<T>::value) && !std::is_same<T, const char *>::value && !std::is_same<T, char *>::value>::type> std::uint64_t operator ()(T Value) const
+            {
+                std::uint64_t hash = 0;
+
+                if constexpr (std::is_pointer<T>::value)
+                    hash = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(Value));
+                else
+                    hash = static_cast<std::uint64_t>(Value);
+
+                hash *= 0x9E3779B97F4A7C15ull;
+
+                return hash ^ (hash >> 29);
+            };
+
+            std::uint64_t operator ()(std::string_view Value) const
+            {
+                return HashXx64(Value);
+            };
+
+            std::uint64_t operator ()(StringId Value) const
+            {
+                return Value.GetValue();
+            };
+        };
+
+        namespace Detail
+        {
+            // Every slot has a control byte: empty, deleted, or the low 7 bits of the hash of a
+            // full slot. A probe compares a group of 16 control bytes with one instruction and
+            // only touches the slots whose byte matched.
+            constexpr std::size_t FlatGroupWidth = 16;
+            constexpr std::int8_t FlatEmpty = -128;
+            constexpr std::int8_t FlatDeleted = -2;
+
+            inline int CountTrailingZeros(std::uint32_t Value)
+            {
+#if _MSC_VER
+                unsigned long index;
+                _BitScanForward(&index, Value);
+
+                return static_cast<int>(index);
+#else
+                return __builtin_ctz(Value);
+#endif
+            };
+
+            // Bit i of a match is set when control byte i qualifies.
+            class FlatGroup
+            {
+                public:
+#if WARLOCK_INSTRUCTION_SET_SSE2
+                    explicit FlatGroup(const std::int8_t *Control) : control(_mm_loadu_si128(reinterpret_cast<const __m128i *>(Control))) {};
+
+                    std::uint32_t Match(std::int8_t Hash) const
+                    {
+                        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(control, _mm_set1_epi8(Hash))));
+                    };
+
+                    std::uint32_t MatchEmpty() const
+                    {
+                        return Match(FlatEmpty);
+                    };
+
+                    // Empty or deleted; the only negative values below -1.
+                    std::uint32_t MatchFree() const
+                    {
+                        return static_cast<std::uint32_t>(_mm_movemask_epi8(_mm_cmpgt_epi8(_mm_set1_epi8(-1), control)));
+                    };
+
+                private:
+                    __m128i control;
+#elif (WARLOCK_INSTRUCTION_SET_NEON && WARLOCK_ARCHITECTURE_ARM64)
+                    explicit FlatGroup(const std::int8_t *Control) : control(vld1q_s8(Control)) {};
+
+                    std::uint32_t Match(std::int8_t Hash) const
+                    {
+                        return ToBits(vceqq_s8(control, vdupq_n_s8(Hash)));
+                    };
+
+                    std::uint32_t MatchEmpty() const
+                    {
+                        return Match(FlatEmpty);
+                    };
+
+                    std::uint32_t MatchFree() const
+                    {
+                        return ToBits(vcltq_s8(control, vdupq_n_s8(-1)));
+                    };
+
+                private:
+                    static std::uint32_t ToBits(uint8x16_t Mask)
+                    {
+                        static const std::uint8_t weights[16] = {1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128};
+                        uint8x16_t bits = vandq_u8(Mask, vld1q_u8(weights));
+
+                        return static_cast<std::uint32_t>(vaddv_u8(vget_low_u8(bits))) | (static_cast<std::uint32_t>(vaddv_u8(vget_high_u8(bits))) << 8);
+                    };
+
+                    int8x16_t control;
+#else
+                    explicit FlatGroup(const std::int8_t *Control)
+                    {
+                        std::memcpy(control, Control, FlatGroupWidth);
+                    };
+
+                    std::uint32_t Match(std::int8_t Hash) const
+                    {
+                        std::uint32_t bits = 0;
+
+                        for (std::size_t i = 0; i < FlatGroupWidth; i++)
+                            bits |= static_cast<std::uint32_t>(control[i] == Hash) << i;
+
+                        return bits;
+                    };
+
+                    std::uint32_t MatchEmpty() const
+                    {
+                        return Match(FlatEmpty);
+                    };
+
+                    std::uint32_t MatchFree() const
+                    {
+                        std::uint32_t bits = 0;
+
+                        for (std::size_t i = 0; i < FlatGroupWidth; i++)
+                            bits |= static_cast<std::uint32_t>(control[i] < -1) << i;
+
+                        return bits;
+                    };
+
+                private:
+                    std::int8_t control[FlatGroupWidth];
+#endif
+            };
+
+            template <typename Key, typename Value> struct FlatHashEntry
+            {
+                template <typename K, typename... Arguments> FlatHashEntry(K &&Name, Arguments &&... Values) : key(std::forward<K>(Name)), value(std::forward<Arguments>(Values)...) {};
+
+                Key key;
+                Value value;
+            };
+
+            // Storage shared by FlatHashMap and FlatHashSet (Value void). Slots live in one
+            // array with no allocation per entry; the table grows to keep at most 7/8 of the
+            // slots taken, full or deleted. Inserting or growing moves entries, so pointers to
+            // them last only until the next insertion.
+            template <typename Key, typename Value, typename Hash, typename Equal> class FlatTable
+            {
+                public:
+                    using Slot = typename std::conditional<std::is_void<Value>::value, Key, FlatHashEntry<Key, Value>>::type;
+
+                    template <typename Entry, typename Table> class BasicIterator
+                    {
+                        public:
+                            BasicIterator(Table *Owner, std::size_t Index) : owner(Owner), index(Index)
+                            {
+                                Skip();
+                            };
+
+                            Entry &operator *() const
+                            {
+                                return owner->slots[index];
+                            };
+
+                            Entry *operator ->() const
+                            {
+                                return &owner->slots[index];
+                            };
+
+                            BasicIterator &operator ++()
+                            {
+                                index++;
+                                Skip();
+
+                                return *this;
+                            };
+
+                            bool operator ==(const BasicIterator &Other) const
+                            {
+                                return (index == Other.index);
+                            };
+
+                            bool operator !=(const BasicIterator &Other) const
+                            {
+                                return (index != Other.index);
+                            };
+
+                        private:
+                            void Skip()
+                            {
+                                while (index < owner->capacity && owner->control[index] < 0)
+                                    index++;
+                            };
+
+                            Table *owner;
+                            std::size_t index;
+                    };
+
+                    using Iterator = BasicIterator<Slot, FlatTable>;
+                    using ConstIterator = BasicIterator<const Slot, const FlatTable>;
+
+                    FlatTable() : control(nullptr), slots(nullptr), capacity(0), count(0), growthLeft(0) {};
+
+                    FlatTable(const FlatTable &Other) : FlatTable()
+                    {
+                        *this = Other;
+                    };
+
+                    FlatTable(FlatTable &&Other) noexcept : FlatTable()
+                    {
+                        Swap(Other);
+                    };
+
+                    ~FlatTable()
+                    {
+                        Clear();
+                        Deallocate(control, slots, capacity);
+                    };
+
+                    FlatTable &operator =(const FlatTable &Other)
+                    {
+                        if (this != &Other)
+                        {
+                            Clear();
+                            Reserve(Other.count);
+
+                            for (const Slot &slot : Other)
+                                InsertUnique(hasher(KeyOf(slot)), slot);
+                        }
+
+                        return *this;
+                    };
+
+                    FlatTable &operator =(FlatTable &&Other) noexcept
+                    {
+                        if (this != &Other)
+                        {
+                            FlatTable empty;
+                            Swap(Other);
+                            Other.Swap(empty);
+                        }
+
+                        return *this;
+                    };
+
+                    void Swap(FlatTable &Other)
+                    {
+                        std::swap(control, Other.control);
+                        std::swap(slots, Other.slots);
+                        std::swap(capacity, Other.capacity);
+                        std::swap(count, Other.count);
+                        std::swap(growthLeft, Other.growthLeft);
+                    };
+
+                    template <typename K> bool Contains(const K &Search) const
+                    {
+                        return (FindIndex(Search) != capacity);
+                    };
+
+                    // Returns whether an entry was removed.
+                    template <typename K> bool Erase(const K &Search)
+                    {
+                        const std::size_t index = FindIndex(Search);
+
+                        if (index == capacity)
+                            return false;
+
+                        slots[index].~Slot();
+                        SetControl(index, FlatDeleted);
+                        count--;
+
+                        return true;
+                    };
+
+                    // Keeps the capacity.
+                    void Clear()
+                    {
+                        if (count != 0)
+                        {
+                            for (std::size_t i = 0; i < capacity; i++)
+                            {
+                                if (control[i] >= 0)
+                                    slots[i].~Slot();
+                            }
+                        }
+
+                        if (capacity != 0)
+                            std::memset(control, FlatEmpty, capacity + FlatGroupWidth - 1);
+
+                        count = 0;
+                        growthLeft = GetGrowthLimit(capacity);
+                    };
+
+                    // Makes room for Count entries without growing again.
+                    void Reserve(std::size_t Count)
+                    {
+                        std::size_t target = FlatGroupWidth;
+
+                        while (GetGrowthLimit(target) < Count)
+                            target <<= 1;
+
+                        if (target > capacity)
+                            Rehash(target);
+                    };
+
+                    std::size_t GetCount() const
+                    {
+                        return count;
+                    };
+
+                    std::size_t GetCapacity() const
+                    {
+                        return capacity;
+                    };
+
+                    bool IsEmpty() const
+                    {
+                        return (count == 0);
+                    };
+
+                    Iterator begin()
+                    {
+                        return Iterator(this, 0);
+                    };
+
+                    Iterator end()
+                    {
+                        return Iterator(this, capacity);
+                    };
+
+                    ConstIterator begin() const
+                    {
+                        return ConstIterator(this, 0);
+                    };
+
+                    ConstIterator end() const
+                    {
+                        return ConstIterator(this, capacity);
+                    };
+
+                protected:
+                    static const Key &KeyOf(const Slot &Entry)
+                    {
+                        if constexpr (std::is_void<Value>::value)
+                            return Entry;
+                        else
+                            return Entry.key;
+                    };
+
+                    static std::size_t GetGrowthLimit(std::size_t Capacity)
+                    {
+                        return Capacity - Capacity / 8;
+                    };
+
+                    // Index of the entry with Key, or capacity when there is none.
+                    template <typename K> std::size_t FindIndex(const K &Search) const
+                    {
+                        if (count == 0)
+                            return capacity;
+
+                        const std::uint64_t hash = hasher(Search);
+                        const std::int8_t tag = static_cast<std::int8_t>(hash & 0x7F);
+                        const std::size_t mask = capacity - 1;
+                        std::size_t position = static_cast<std::size_t>(hash >> 7) & mask;
+
+                        // Steps grow by a group each time, which visits every group of a power
+                        // of two table once.
+                        for (std::size_t step = FlatGroupWidth; ; step += FlatGroupWidth)
+                        {
+                            const FlatGroup group(control + position);
+
+                            for (std::uint32_t bits = group.Match(tag); bits != 0; bits &= bits - 1)
+                            {
+                                const std::size_t index = (position + CountTrailingZeros(bits)) & mask;
+
+                                if (equal(KeyOf(slots[index]), Search))
+                                    return index;
+                            }
+
+                            if (group.MatchEmpty() != 0)
+                                return capacity;
+
+                            position = (position + step) & mask;
+                        }
+                    };
+
+                    // Returns the index of the entry with Name and whether it was just inserted, the
+                    // slot being constructed from Name and Values only in that case.
+                    template <typename... Arguments> std::pair<std::size_t, bool> Emplace(const Key &Name, Arguments &&... Values)
+                    {
+                        std::size_t index = FindIndex(Name);
+
+                        if (index != capacity)
+                            return {index, false};
+
+                        return {InsertUnique(hasher(Name), Name, std::forward<Arguments>(Values)...), true};
+                    };
+
+                    // Constructs a slot known not to be in the table yet.
+                    template <typename... Arguments> std::size_t InsertUnique(std::uint64_t Code, Arguments &&... Values)
+                    {
+                        if (growthLeft == 0)
+                        {
+                            // Mostly deleted slots are cleaned up in place, otherwise double.
+                            Rehash(capacity == 0 ? FlatGroupWidth : (count < capacity / 2 ? capacity : 2 * capacity));
+                        }
+
+                        const std::size_t index = FindFree(Code);
+
+                        if (control[index] == FlatEmpty)
+                            growthLeft--;
+
+                        ::new (static_cast<void *>(&slots[index])) Slot(std::forward<Arguments>(Values)...);
+                        SetControl(index, static_cast<std::int8_t>(Code & 0x7F));
+                        count++;
+
+                        return index;
+                    };
+
+                    std::size_t FindFree(std::uint64_t Code) const
+                    {
+                        const std::size_t mask = capacity - 1;
+                        std::size_t position = static_cast<std::size_t>(Code >> 7) & mask;
+
+                        for (std::size_t step = FlatGroupWidth; ; step += FlatGroupWidth)
+                        {
+                            const std::uint32_t bits = FlatGroup(control + position).MatchFree();
+
+                            if (bits != 0)
+                                return (position + CountTrailingZeros(bits)) & mask;
+
+                            position = (position + step) & mask;
+                        }
+                    };
+
+                    // The first FlatGroupWidth - 1 bytes are mirrored past the end, so a group
+                    // can be loaded at any position without wrapping.
+                    void SetControl(std::size_t Index, std::int8_t Byte)
+                    {
+                        control[Index] = Byte;
+
+                        if (Index < FlatGroupWidth - 1)
+                            control[capacity + Index] = Byte;
+                    };
+
+                    void Rehash(std::size_t Capacity)
+                    {
+                        std::int8_t *oldControl = control;
+                        Slot *oldSlots = slots;
+                        const std::size_t oldCapacity = capacity;
+
+                        control = static_cast<std::int8_t *>(::operator new(Capacity + FlatGroupWidth - 1));
+                        slots = static_cast<Slot *>(::operator new(Capacity * sizeof(Slot), std::align_val_t(alignof(Slot))));
+                        capacity = Capacity;
+                        count = 0;
+                        std::memset(control, FlatEmpty, Capacity + FlatGroupWidth - 1);
+                        growthLeft = GetGrowthLimit(Capacity);
+
+                        for (std::size_t i = 0; i < oldCapacity; i++)
+                        {
+                            if (oldControl[i] >= 0)
+                            {
+                                const std::size_t index = FindFree(hasher(KeyOf(oldSlots[i])));
+
+                                ::new (static_cast<void *>(&slots[index])) Slot(std::move(oldSlots[i]));
+                                SetControl(index, oldControl[i]);
+                                oldSlots[i].~Slot();
+                                growthLeft--;
+                                count++;
+                            }
+                        }
+
+                        Deallocate(oldControl, oldSlots, oldCapacity);
+                    };
+
+                    static void Deallocate(std::int8_t *Control, Slot *Slots, std::size_t Capacity)
+                    {
+                        if (Capacity == 0)
+                            return;
+
+                        ::operator delete(Control);
+                        ::operator delete(Slots, std::align_val_t(alignof(Slot)));
+                    };
+
+                    std::int8_t *control;
+                    Slot *slots;
+                    std::size_t capacity;
+                    std::size_t count;
+
+                    // Empty slots that may still be filled before the table grows.
+                    std::size_t growthLeft;
+                    Hash hasher;
+                    Equal equal;
+            };
+        };
+
+        // Drop in for std::unordered_map on hot lookups: one flat array, probed 16 control
+        // bytes at a time, so a lookup usually costs one group compare and one key compare.
+        // Entries expose key and value members. Benchmarks/Core/FlatHashMap.cpp compares it
+        // with std::unordered_map.
+        template <typename Key, typename Value, typename Hash = FlatHash, typename Equal = std::equal_to<>> class FlatHashMap : public Detail::FlatTable<Key, Value, Hash, Equal>
+        {
+            public:
+                // Returns nullptr when the key is absent.
+                template <typename K> Value *Find(const K &Search)
+                {
+                    const std::size_t index = this->FindIndex(Search);
+
+                    return (index == this->capacity ? nullptr : &this->slots[index].value);
+                };
+
+                template <typename K> const Value *Find(const K &Search) const
+                {
+                    const std::size_t index = this->FindIndex(Search);
+
+                    return (index == this->capacity ? nullptr : &this->slots[index].value);
+                };
+
+                // Constructs the value from Arguments only if the key is absent; returns the
+                // value in the table and whether it was inserted.
+                template <typename... Arguments> std::pair<Value *, bool> TryEmplace(const Key &Name, Arguments &&... Values)
+                {
+                    std::pair<std::size_t, bool> result = this->Emplace(Name, std::forward<Arguments>(Values)...);
+
+                    return {&this->slots[result.first].value, result.second};
+                };
+
+                // Leaves an existing value untouched; returns whether Value was inserted.
+                bool Insert(const Key &Name, Value Item)
+                {
+                    return this->Emplace(Name, std::move(Item)).second;
+                };
+
+                // Inserts or replaces.
+                void Assign(const Key &Name, Value Item)
+                {
+                    std::pair<std::size_t, bool> result = this->Emplace(Name);
+
+                    this->slots[result.first].value = std::move(Item);
+                };
+
+                Value &operator [](const Key &Name)
+                {
+                    // Emplace may reallocate, so index the slots only after it.
+                    const std::size_t index = this->Emplace(Name).first;
+
+                    return this->slots[index].value;
+                };
+        };
+
+        template <typename Key, typename Hash = FlatHash, typename Equal = std::equal_to<>> class FlatHashSet : public Detail::FlatTable<Key, void, Hash, Equal>
+        {
+            public:
+                // Returns whether the key was inserted.
+                bool Insert(const Key &Name)
+                {
+                    return this->Emplace(Name).second;
+                };
+        };
+    };
+};
+
+#endif // WARLOCK_CORE_FLATHASHMAP_HPP
@@ -0,0 +1,673 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Core/Logger.hpp
+// Description: Asynchronous binary logger formatting on a background thread.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_CORE_LOGGER_HPP
+#define WARLOCK_CORE_LOGGER_HPP
+
+#include "Platform/Platform.hpp"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+// Logs Format with "{}" replaced by the arguments in turn, e.g.
+//
+//   WARLOCK_LOG(Core::LogLevel::Info, "Loaded {} meshes in {} ms", count, elapsed);
+//
+// The calling thread copies the arguments in binary form to a buffer of its own; strings are
+// copied too, so they need not outlive the call. Format must be a string literal.
+#define WARLOCK_LOG(Level, ...) \
+    do \
+    { \
+        ::Warlock::Core::Logger &warlockLogger = ::Warlock::Core::Logger::GetDefault(); \
+        const ::Warlock::Core::LogLevel warlockLogLevel = (Level); \
+        if (warlockLogger.IsEnabled(warlockLogLevel)) \
+        { \
+            static const ::Warlock::Core::LogSite warlockLogSite = {__FILE__, __LINE__, WARLOCK_LOG_FORMAT(__VA_ARGS__, "")}; \
+            warlockLogger.Write(warlockLogSite, warlockLogLevel, __VA_ARGS__); \
+        } \
+    } while (0)
+
+#define WARLOCK_LOG_FORMAT(Format, ...) Format
+
+namespace Warlock
+{
+    namespace Core
+    {
+        enum class LogLevel : int
+        {
+            Trace,
+            Debug,
+            Info,
+            Warning,
+            Error,
+            Fatal
+        };
+
+        // One per WARLOCK_LOG statement. Records refer to it by address, which serves as the ID
+        // of the format string. The level is not part of it, since a statement may compute it.
+        struct LogSite
+        {
+            const char *file;
+            unsigned int line;
+            const char *format;
+        };
+
+        // Default size of each thread's buffer; records that do not fit are dropped and counted.
+        constexpr std::size_t LogBufferSize = 64 * 1024;
+
+        // Longer string arguments are cut.
+        constexpr std::uint32_t LogMaximumStringLength = 1024;
+
+        namespace Detail
+        {
+            enum class LogArgument : std::uint8_t
+            {
+                End,
+                Signed,
+                Unsigned,
+                Float,
+                Bool,
+                Char,
+                String,
+                Pointer
+            };
+
+            template <typename T> constexpr LogArgument GetLogArgument()
+            {
+                if constexpr (std::is_same<T, bool>::value)
+                    return LogArgument::Bool;
+                else if constexpr (std::is_same<T, char>::value)
+                    return LogArgument::Char;
+                else if constexpr (std::is_enum<T>::value)
+                    return GetLogArgument<typename std::underlying_type<T>::type>();
+                else if constexpr (std::is_integral<T>::value)
+                    return (std::is_signed<T>::value ? LogArgument::Signed : LogArgument::Unsigned);
+                else if constexpr (std::is_floating_point<T>::value)
+                    return LogArgument::Float;
+                else if constexpr (std::is_same<T, const char *>::value || std::is_same<T, char *>::value || std::is_same<T, std::string>::value || std::is_same<T, std::string_view>::value)
+                    return LogArgument::String;
+                else
+                {
+                    static_assert(std::is_pointer<T>::value, "Unsupported log argument type");
+                    return LogArgument::Pointer;
+                }
+            };
+
+            // Tags of an argument list, terminated by End.
+            template <typename... Arguments> struct LogArgumentList
+            {
+                static constexpr LogArgument value[sizeof...(Arguments) + 1] = {GetLogArgument<typename std::decay<Arguments>::type>()..., LogArgument::End};
+            };
+
+            inline std::string_view GetLogString(const char *Value)
+            {
+                return (Value ? std::string_view(Value) : std::string_view("(null)"));
+            };
+
+            inline std::string_view GetLogString(std::string_view Value)
+            {
+                return Value;
+            };
+
+            // Bytes an argument takes in a record: 8 for numbers and pointers, 1 for bool and
+            // char, a 4 byte length and the characters for strings.
+            template <typename T> std::size_t GetLogArgumentSize(const T &Value)
+            {
+                constexpr LogArgument type = GetLogArgument<typename std::decay<T>::type>();
+
+                if constexpr (type == LogArgument::String)
+                    return 4 + std::min<std::size_t>(GetLogString(Value).size(), LogMaximumStringLength);
+                else if constexpr (type == LogArgument::Bool || type == LogArgument::Char)
+                    return 1;
+                else
+                    return 8;
+            };
+
+            template <typename T> void EncodeLogArgument(unsigned char *&Cursor, const T &Value)
+            {
+                constexpr LogArgument type = GetLogArgument<typename std::decay<T>::type>();
+
+                if constexpr (type == LogArgument::String)
+                {
+                    std::string_view text = GetLogString(Value);
+                    std::uint32_t length = static_cast<std::uint32_t>(std::min<std::size_t>(text.size(), LogMaximumStringLength));
+
+                    std::memcpy(Cursor, &length, 4);
+                    std::memcpy(Cursor + 4, text.data(), length);
+                    Cursor += 4 + length;
+                }
+                else if constexpr (type == LogArgument::Bool || type == LogArgument::Char)
+                    *Cursor++ = static_cast<unsigned char>(Value);
+                else
+                {
+                    typename std::conditional<type == LogArgument::Signed, std::int64_t, typename std::conditional<type == LogArgument::Unsigned, std::uint64_t, typename std::conditional<type == LogArgument::Float, double, std::uint64_t>::type>::type>::type value;
+
+                    if constexpr (type == LogArgument::Pointer)
+                        value = reinterpret_cast<std::uintptr_t>(Value);
+                    else
+                        value = static_cast<decltype(value)>(Value);
+
+                    std::memcpy(Cursor, &value, 8);
+                    Cursor += 8;
+                }
+            };
+
+            struct LogRecord
+            {
+                // Bytes including this header, or LogWrapMarker.
+                std::uint32_t size;
+                std::uint32_t level;
+                std::uint64_t timestamp;
+                const LogSite *site;
+                const LogArgument *arguments;
+            };
+
+            constexpr std::uint32_t LogWrapMarker = 0xFFFFFFFFu;
+
+            // Byte ring written by one thread and drained by the logger. Records never wrap; a
+            // wrap marker sends the reader back to the start.
+            class LogBuffer
+            {
+                public:
+                    LogBuffer(std::size_t Capacity) : data(Capacity), capacity(Capacity), head(0), tail(0), cachedTail(0), dropped(0), retired(false) {};
+
+                    // Returns nullptr when the record does not fit until the logger catches up.
+                    unsigned char *Reserve(std::size_t Size, std::uint64_t &End)
+                    {
+                        const std::uint64_t start = head.load(std::memory_order_relaxed);
+                        const std::uint64_t span = (Size + 7) & ~static_cast<std::uint64_t>(7);
+                        const std::uint64_t offset = start & (capacity - 1);
+                        const std::uint64_t padding = (offset + span > capacity ? capacity - offset : 0);
+
+                        if (span > capacity / 4)
+                            return nullptr;
+
+                        if (start + padding + span - cachedTail > capacity)
+                        {
+                            cachedTail = tail.load(std::memory_order_acquire);
+
+                            if (start + padding + span - cachedTail > capacity)
+                                return nullptr;
+                        }
+
+                        if (padding)
+                            reinterpret_cast<LogRecord *>(&data[offset])->size = LogWrapMarker;
+
+                        End = start + padding + span;
+
+                        return &data[(start + padding) & (capacity - 1)];
+                    };
+
+                    void Commit(std::uint64_t End)
+                    {
+                        head.store(End, std::memory_order_release);
+                    };
+
+                    std::vector<unsigned char> data;
+                    std::uint64_t capacity;
+                    alignas(64) std::atomic<std::uint64_t> head;
+                    alignas(64) std::atomic<std::uint64_t> tail;
+
+                    // Owned by the writing thread.
+                    std::uint64_t cachedTail;
+                    std::atomic<std::uint64_t> dropped;
+
+                    // Set when the thread exits; the logger frees the buffer once it is drained.
+                    std::atomic<bool> retired;
+            };
+
+            struct LogThreadState
+            {
+                ~LogThreadState()
+                {
+                    if (buffer)
+                        buffer->retired.store(true, std::memory_order_release);
+                };
+
+                const void *owner = nullptr;
+                std::shared_ptr<LogBuffer> buffer;
+            };
+
+            inline LogThreadState &GetLogThreadState()
+            {
+                thread_local LogThreadState state;
+
+                return state;
+            };
+        };
+
+        // Calling threads only copy the site address, a timestamp and the raw arguments into a
+        // lock free buffer of their own. A background thread merges the buffers in timestamp
+        // order, formats the text and writes it out in batches. Memory is bounded: when a
+        // buffer is full new records are dropped, and the count is written out later.
+        class Logger
+        {
+            public:
+                Logger(std::size_t BufferSize = LogBufferSize) : output(stderr), ownsOutput(false), level(static_cast<int>(LogLevel::Info)), bufferSize(4096), stopping(false), start(std::chrono::steady_clock::now())
+                {
+                    while (bufferSize < BufferSize)
+                        bufferSize <<= 1;
+
+                    worker = std::thread([this]() { WorkerLoop(); });
+                };
+
+                ~Logger()
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        stopping = true;
+                    }
+
+                    condition.notify_all();
+                    worker.join();
+                    Flush();
+                    CloseOutput();
+                };
+
+                Logger(const Logger &) = delete;
+                Logger &operator =(const Logger &) = delete;
+
+                static Logger &GetDefault()
+                {
+                    static Logger logger;
+
+                    return logger;
+                };
+
+                // Appends to Path from now on; false leaves the output unchanged.
+                bool Open(const char *Path)
+                {
+                    std::FILE *file = std::fopen(Path, "ab");
+
+                    if (!file)
+                        return false;
+
+                    std::lock_guard<std::mutex> lock(drainMutex);
+                    DrainLocked();
+                    CloseOutput();
+                    output = file;
+                    ownsOutput = true;
+
+                    return true;
+                };
+
+                // Writes to a stream owned by the caller, e.g. stdout; nullptr discards.
+                void SetOutput(std::FILE *Output)
+                {
+                    std::lock_guard<std::mutex> lock(drainMutex);
+                    DrainLocked();
+                    CloseOutput();
+                    output = Output;
+                    ownsOutput = false;
+                };
+
+                void SetLevel(LogLevel Level)
+                {
+                    level.store(static_cast<int>(Level), std::memory_order_relaxed);
+                };
+
+                bool IsEnabled(LogLevel Level) const
+                {
+                    return (static_cast<int>(Level) >= level.load(std::memory_order_relaxed));
+                };
+
+                // Use WARLOCK_LOG rather than calling this directly.
+                template <typename... Arguments> void Write(const LogSite &Site, LogLevel Level, const char *, const Arguments &... Values)
+                {
+                    Detail::LogThreadState &state = Detail::GetLogThreadState();
+
+                    if (state.owner != this)
+                        AttachThread(state);
+
+                    const std::size_t size = sizeof(Detail::LogRecord) + (std::size_t(0) + ... + Detail::GetLogArgumentSize(Values));
+                    std::uint64_t end;
+                    unsigned char *data = state.buffer->Reserve(size, end);
+
+                    if (!data)
+                    {
+                        state.buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+                        return;
+                    }
+
+                    Detail::LogRecord *record = reinterpret_cast<Detail::LogRecord *>(data);
+                    record->size = static_cast<std::uint32_t>(size);
+                    record->level = static_cast<std::uint32_t>(Level);
+                    record->timestamp = static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+                    record->site = &Site;
+                    record->arguments = Detail::LogArgumentList<Arguments...>::value;
+
+                    unsigned char *cursor = data + sizeof(Detail::LogRecord);
+                    (Detail::EncodeLogArgument(cursor, Values), ...);
+                    (void)cursor;
+
+                    state.buffer->Commit(end);
+                };
+
+                // Formats and writes out everything logged so far, on the calling thread.
+                void Flush()
+                {
+                    std::lock_guard<std::mutex> lock(drainMutex);
+                    DrainLocked();
+                };
+
+                // Flushes the default logger when the process dies on a fatal signal, then lets the
+                // signal take its course. Formatting is not async signal safe, so this is a best
+                // effort: it gives up rather than wait if the crash interrupted a drain.
+                static void InstallCrashHandler()
+                {
+                    for (int signal : {SIGSEGV, SIGABRT, SIGFPE, SIGILL})
+                        std::signal(signal, &CrashHandler);
+                };
+
+            private:
+                struct PendingRecord
+                {
+                    const Detail::LogRecord *record;
+                    std::uint64_t timestamp;
+                };
+
+                void AttachThread(Detail::LogThreadState &State)
+                {
+                    if (State.buffer)
+                        State.buffer->retired.store(true, std::memory_order_release);
+
+                    State.owner = this;
+                    State.buffer = std::make_shared<Detail::LogBuffer>(bufferSize);
+
+                    std::lock_guard<std::mutex> lock(buffersMutex);
+                    buffers.push_back(State.buffer);
+                };
+
+                void WorkerLoop()
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+
+                    while (!stopping)
+                    {
+                        lock.unlock();
+
+                        {
+                            std::lock_guard<std::mutex> drain(drainMutex);
+                            DrainLocked();
+                        }
+
+                        lock.lock();
+                        condition.wait_for(lock, std::chrono::milliseconds(1), [this]() { return stopping; });
+                    }
+                };
+
+                // Takes one pass over every buffer, up to where each one was when the pass started.
+                void DrainLocked()
+                {
+                    std::vector<std::shared_ptr<Detail::LogBuffer>> current;
+
+                    {
+                        std::lock_guard<std::mutex> lock(buffersMutex);
+                        current = buffers;
+                    }
+
+                    pending.clear();
+                    ends.clear();
+
+                    for (const std::shared_ptr<Detail::LogBuffer> &buffer : current)
+                    {
+                        const std::uint64_t head = buffer->head.load(std::memory_order_acquire);
+                        std::uint64_t position = buffer->tail.load(std::memory_order_relaxed);
+
+                        while (position != head)
+                        {
+                            const std::uint64_t offset = position & (buffer->capacity - 1);
+                            const Detail::LogRecord *record = reinterpret_cast<const Detail::LogRecord *>(&buffer->data[offset]);
+
+                            if (record->size == Detail::LogWrapMarker)
+                            {
+                                position += buffer->capacity - offset;
+                                continue;
+                            }
+
+                            pending.push_back({record, record->timestamp});
+                            position += (record->size + 7) & ~static_cast<std::uint64_t>(7);
+                        }
+
+                        ends.push_back(head);
+                    }
+
+                    std::stable_sort(pending.begin(), pending.end(), [](const PendingRecord &First, const PendingRecord &Second) { return First.timestamp < Second.timestamp; });
+
+                    text.clear();
+
+                    for (const PendingRecord &entry : pending)
+                    {
+                        Format(*entry.record);
+
+                        if (text.size() >= 64 * 1024)
+                            WriteText();
+                    }
+
+                    for (std::size_t i = 0; i < current.size(); i++)
+                    {
+                        current[i]->tail.store(ends[i], std::memory_order_release);
+
+                        const std::uint64_t dropped = current[i]->dropped.exchange(0, std::memory_order_relaxed);
+
+                        if (dropped)
+                        {
+                            char line[96];
+                            std::snprintf(line, sizeof(line), "[%12.6f] WARNING Logger: %llu messages dropped\n", GetSeconds(static_cast<std::uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count())), static_cast<unsigned long long>(dropped));
+                            text += line;
+                        }
+                    }
+
+                    WriteText();
+
+                    if (!pending.empty() && output)
+                        std::fflush(output);
+
+                    // Buffers of exited threads go once empty.
+                    std::lock_guard<std::mutex> lock(buffersMutex);
+
+                    buffers.erase(std::remove_if(buffers.begin(), buffers.end(), [](const std::shared_ptr<Detail::LogBuffer> &Buffer)
+                    {
+                        return (Buffer->retired.load(std::memory_order_acquire) && Buffer->head.load(std::memory_order_acquire) == Buffer->tail.load(std::memory_order_relaxed));
+                    }), buffers.end());
+                };
+
+                double GetSeconds(std::uint64_t Timestamp) const
+                {
+                    const std::chrono::steady_clock::duration since(static_cast<std::chrono::steady_clock::rep>(Timestamp));
+
+                    return std::chrono::duration<double>(std::chrono::steady_clock::time_point(since) - start).count();
+                };
+
+                void Format(const Detail::LogRecord &Record)
+                {
+                    static const char *const names[] = {"TRACE", "DEBUG", "INFO", "WARNING", "ERROR", "FATAL"};
+
+                    const LogSite &site = *Record.site;
+                    const char *file = site.file;
+
+                    for (const char *c = site.file; *c; c++)
+                    {
+                        if (*c == '/' || *c == '\\')
+                            file = c + 1;
+                    }
+
+                    char prefix[160];
+                    std::snprintf(prefix, sizeof(prefix), "[%12.6f] %s %s:%u ", GetSeconds(Record.timestamp), names[Record.level], file, site.line);
+                    text += prefix;
+
+                    const unsigned char *cursor = reinterpret_cast<const unsigned char *>(&Record) + sizeof(Detail::LogRecord);
+                    const Detail::LogArgument *argument = Record.arguments;
+
+                    for (const char *c = site.format; *c; c++)
+                    {
+                        if (c[0] != '{' || c[1] != '}' || *argument == Detail::LogArgument::End)
+                        {
+                            text += *c;
+                            continue;
+                        }
+
+                        FormatArgument(*argument++, cursor);
+                        c++;
+                    }
+
+                    text += '\n';
+                };
+
+                void FormatArgument(Detail::LogArgument Type, const unsigned char *&Cursor)
+                {
+                    char value[32];
+
+                    switch (Type)
+                    {
+                        case Detail::LogArgument::Signed:
+                        {
+                            std::int64_t number;
+                            std::memcpy(&number, Cursor, 8);
+                            std::snprintf(value, sizeof(value), "%lld", static_cast<long long>(number));
+                            Cursor += 8;
+                            break;
+                        }
+
+                        case Detail::LogArgument::Unsigned:
+                        {
+                            std::uint64_t number;
+                            std::memcpy(&number, Cursor, 8);
+                            std::snprintf(value, sizeof(value), "%llu", static_cast<unsigned long long>(number));
+                            Cursor += 8;
+                            break;
+                        }
+
+                        case Detail::LogArgument::Float:
+                        {
+                            double number;
+                            std::memcpy(&number, Cursor, 8);
+                            std::snprintf(value, sizeof(value), "%g", number);
+                            Cursor += 8;
+                            break;
+                        }
+
+                        case Detail::LogArgument::Pointer:
+                        {
+                            std::uint64_t address;
+                            std::memcpy(&address, Cursor, 8);
+                            std::snprintf(value, sizeof(value), "0x%llx", static_cast<unsigned long long>(address));
+                            Cursor += 8;
+                            break;
+                        }
+
+                        case Detail::LogArgument::Bool:
+                            std::snprintf(value, sizeof(value), "%s", *Cursor++ ? "true" : "false");
+                            break;
+
+                        case Detail::LogArgument::Char:
+                            value[0] = static_cast<char>(*Cursor++);
+                            value[1] = '\0';
+                            break;
+
+                        case Detail::LogArgument::String:
+                        {
+                            std::uint32_t length;
+                            std::memcpy(&length, Cursor, 4);
+                            text.append(reinterpret_cast<const char *>(Cursor + 4), length);
+                            Cursor += 4 + length;
+                            return;
+                        }
+
+                        default:
+                            return;
+                    }
+
+                    text += value;
+                };
+
+                void WriteText()
+                {
+                    if (output && !text.empty())
+                        std::fwrite(text.data(), 1, text.size(), output);
+
+                    text.clear();
+                };
+
+                void CloseOutput()
+                {
+                    if (output && ownsOutput)
+                        std::fclose(output);
+
+                    output = nullptr;
+                    ownsOutput = false;
+                };
+
+                static void CrashHandler(int Signal)
+                {
+                    Logger &logger = GetDefault();
+
+                    for (int attempt = 0; attempt < 100; attempt++)
+                    {
+                        if (logger.drainMutex.try_lock())
+                        {
+                            logger.DrainLocked();
+                            logger.drainMutex.unlock();
+                            break;
+                        }
+
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    }
+
+                    std::signal(Signal, SIG_DFL);
+                    std::raise(Signal);
+                };
+
+                std::FILE *output;
+                bool ownsOutput;
+                std::atomic<int> level;
+                std::size_t bufferSize;
+
+                std::mutex buffersMutex;
+                std::vector<std::shared_ptr<Detail::LogBuffer>> buffers;
+
+                // Held for a drain; the scratch below belongs to whoever holds it.
+                std::mutex drainMutex;
+                std::vector<PendingRecord> pending;
+                std::vector<std::uint64_t> ends;
+                std::string text;
+
+                std::mutex mutex;
+                std::condition_variable condition;
+                bool stopping;
+                std::chrono::steady_clock::time_point start;
+                std::thread worker;
+        };
+    };
+};
+
+#endif // WARLOCK_CORE_LOGGER_HPP
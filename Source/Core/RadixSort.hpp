@@ -0,0 +1,185 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Core/RadixSort.hpp
+// Description: Parallel LSD radix sort of key/index pairs and reordering of parallel streams.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_CORE_RADIXSORT_HPP
+#define WARLOCK_CORE_RADIXSORT_HPP
+
+#include "ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Core
+    {
+        static constexpr std::size_t RadixSortBlockSize = 65536;
+
+        // Sorts Count keys in ascending order carrying their 32 bit values along; the sort is
+        // stable and only the low KeyBits bits of each key are considered. Scratch arrays must
+        // hold Count elements each. Passes whose digit is equal across all keys are skipped.
+        template <typename Key> void RadixSort(Key *Keys, std::uint32_t *Values, std::size_t Count,
+                                               Key *KeyScratch, std::uint32_t *ValueScratch,
+                                               unsigned int KeyBits = sizeof(Key) * 8,
+                                               ThreadPool &Pool = ThreadPool::GetDefault())
+        {
+            static_assert(std::is_integral<Key>::value && std::is_unsigned<Key>::value, "Radix sort keys must be unsigned integers");
+
+            if (Count < 2)
+                return;
+
+            const std::size_t blocks = (Count + RadixSortBlockSize - 1) / RadixSortBlockSize;
+            std::vector<std::size_t> histogram(blocks * 256);
+            Key *sourceKeys = Keys;
+            Key *targetKeys = KeyScratch;
+            std::uint32_t *sourceValues = Values;
+            std::uint32_t *targetValues = ValueScratch;
+
+            for (unsigned int shift = 0; shift < KeyBits; shift += 8)
+            {
+                // The top digit may be narrower than a byte; bits above KeyBits are ignored.
+                const std::size_t mask = (KeyBits - shift >= 8 ? 0xFF : (std::size_t(1) << (KeyBits - shift)) - 1);
+
+                Pool.ParallelFor(0, blocks, 1, [&](std::size_t First, std::size_t Last)
+                {
+                    for (std::size_t b = First; b < Last; b++)
+                    {
+                        std::size_t *counts = &histogram[b * 256];
+                        std::size_t end = ((b + 1) * RadixSortBlockSize < Count ? (b + 1) * RadixSortBlockSize : Count);
+
+                        std::memset(counts, 0, 256 * sizeof(std::size_t));
+
+                        for (std::size_t i = b * RadixSortBlockSize; i < end; i++)
+                            counts[(sourceKeys[i] >> shift) & mask]++;
+                    }
+                });
+
+                std::size_t offset = 0;
+                bool trivial = false;
+
+                for (std::size_t digit = 0; digit < 256; digit++)
+                {
+                    std::size_t total = 0;
+
+                    for (std::size_t b = 0; b < blocks; b++)
+                    {
+                        std::size_t count = histogram[b * 256 + digit];
+                        histogram[b * 256 + digit] = offset + total;
+                        total += count;
+                    }
+
+                    if (total == Count)
+                        trivial = true;
+
+                    offset += total;
+                }
+
+                if (trivial)
+                    continue;
+
+                Pool.ParallelFor(0, blocks, 1, [&](std::size_t First, std::size_t Last)
+                {
+                    for (std::size_t b = First; b < Last; b++)
+                    {
+                        std::size_t *offsets = &histogram[b * 256];
+                        std::size_t end = ((b + 1) * RadixSortBlockSize < Count ? (b + 1) * RadixSortBlockSize : Count);
+
+                        for (std::size_t i = b * RadixSortBlockSize; i < end; i++)
+                        {
+                            std::size_t target = offsets[(sourceKeys[i] >> shift) & mask]++;
+                            targetKeys[target] = sourceKeys[i];
+                            targetValues[target] = sourceValues[i];
+                        }
+                    }
+                });
+
+                std::swap(sourceKeys, targetKeys);
+                std::swap(sourceValues, targetValues);
+            }
+
+            if (sourceKeys != Keys)
+            {
+                Pool.ParallelFor(Count, [&](std::size_t First, std::size_t Last)
+                {
+                    std::memcpy(Keys + First, sourceKeys + First, (Last - First) * sizeof(Key));
+                    std::memcpy(Values + First, sourceValues + First, (Last - First) * sizeof(std::uint32_t));
+                });
+            }
+        };
+
+        // Sorts the keys and fills Order with the permutation that sorts them, allocating the
+        // scratch memory internally.
+        template <typename Key> void RadixSort(std::vector<Key> &Keys, std::vector<std::uint32_t> &Order,
+                                               unsigned int KeyBits = sizeof(Key) * 8,
+                                               ThreadPool &Pool = ThreadPool::GetDefault())
+        {
+            std::vector<Key> keyScratch(Keys.size());
+            std::vector<std::uint32_t> valueScratch(Keys.size());
+
+            Order.resize(Keys.size());
+
+            for (std::size_t i = 0; i < Order.size(); i++)
+                Order[i] = static_cast<std::uint32_t>(i);
+
+            RadixSort(Keys.data(), Order.data(), Keys.size(), keyScratch.data(), valueScratch.data(), KeyBits, Pool);
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Reordering of structure of arrays streams by a sorted permutation
+        //-----------------------------------------------------------------------------------------
+        template <typename T> void Gather(const std::uint32_t *Order, std::size_t Count, const T *Source, T *Destination,
+                                          ThreadPool &Pool = ThreadPool::GetDefault())
+        {
+            Pool.ParallelFor(Count, [&](std::size_t First, std::size_t Last)
+            {
+                for (std::size_t i = First; i < Last; i++)
+                    Destination[i] = Source[Order[i]];
+            });
+        };
+
+        template <typename T> void ReorderStream(const std::uint32_t *Order, std::size_t Count, T *Stream,
+                                                 ThreadPool &Pool = ThreadPool::GetDefault())
+        {
+            std::vector<T> scratch(Count);
+            Gather(Order, Count, Stream, scratch.data(), Pool);
+
+            Pool.ParallelFor(Count, [&](std::size_t First, std::size_t Last)
+            {
+                for (std::size_t i = First; i < Last; i++)
+                    Stream[i] = scratch[i];
+            });
+        };
+
+        // Permutes every stream in place so that element i becomes the former element Order[i].
+        template <typename... Streams> void Reorder(ThreadPool &Pool, const std::uint32_t *Order, std::size_t Count, Streams *...Data)
+        {
+            (ReorderStream(Order, Count, Data, Pool), ...);
+        };
+
+        template <typename... Streams> void Reorder(const std::uint32_t *Order, std::size_t Count, Streams *...Data)
+        {
+            Reorder(ThreadPool::GetDefault(), Order, Count, Data...);
+        };
+    };
+};
+
+#endif // WARLOCK_CORE_RADIXSORT_HPP
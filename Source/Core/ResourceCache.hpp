@@ -0,0 +1,543 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Core/ResourceCache.hpp
+// Description: Budgeted cache of asynchronously loaded, reference counted resources.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_CORE_RESOURCECACHE_HPP
+#define WARLOCK_CORE_RESOURCECACHE_HPP
+
+#include "StringId.hpp"
+#include "ThreadPool.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Core
+    {
+        enum class ResourceState : std::uint32_t
+        {
+            Loading,
+            Ready,
+            Failed
+        };
+
+        struct ResourceCacheStatistics
+        {
+            // Lookups that found the resource, loaded or in flight.
+            std::uint64_t hits;
+
+            // Lookups that had to start a load.
+            std::uint64_t misses;
+            std::uint64_t evictions;
+            std::uint64_t failures;
+            std::size_t usedBytes;
+            std::size_t budgetBytes;
+            std::size_t entryCount;
+        };
+
+        class ResourceCache;
+
+        namespace Detail
+        {
+            // Set in the reference count of an entry that is evicted or free. Readers that find
+            // it after their increment back off; the count below it stays exact.
+            constexpr std::uint32_t ResourceDead = 0x80000000u;
+
+            template <typename T> struct ResourceType
+            {
+                static constexpr char tag = 0;
+            };
+
+            struct ResourceEntry
+            {
+                std::atomic<std::uint64_t> id{0};
+                std::atomic<std::uint32_t> references{ResourceDead};
+                std::atomic<ResourceState> state{ResourceState::Failed};
+
+                // Set on use, cleared by the eviction clock.
+                std::atomic<bool> used{false};
+
+                void *data = nullptr;
+                void (*destroy)(void *) = nullptr;
+                const void *type = nullptr;
+                std::size_t size = 0;
+            };
+        };
+
+        // A counted reference to a cache entry; the entry is not evicted while one exists.
+        template <typename T> class ResourceHandle
+        {
+            public:
+                ResourceHandle() : cache(nullptr), entry(nullptr) {};
+                ResourceHandle(ResourceCache *Cache, Detail::ResourceEntry *Entry) : cache(Cache), entry(Entry) {};
+
+                ResourceHandle(const ResourceHandle &Other) : cache(Other.cache), entry(Other.entry)
+                {
+                    if (entry)
+                        entry->references.fetch_add(1, std::memory_order_relaxed);
+                };
+
+                ResourceHandle(ResourceHandle &&Other) noexcept : cache(Other.cache), entry(Other.entry)
+                {
+                    Other.cache = nullptr;
+                    Other.entry = nullptr;
+                };
+
+                ~ResourceHandle()
+                {
+                    Reset();
+                };
+
+                ResourceHandle &operator =(ResourceHandle Other)
+                {
+                    std::swap(cache, Other.cache);
+                    std::swap(entry, Other.entry);
+
+                    return *this;
+                };
+
+                void Reset()
+                {
+                    if (entry)
+                        entry->references.fetch_sub(1, std::memory_order_release);
+
+                    cache = nullptr;
+                    entry = nullptr;
+                };
+
+                bool IsValid() const
+                {
+                    return (entry != nullptr);
+                };
+
+                ResourceState GetState() const
+                {
+                    return (entry ? entry->state.load(std::memory_order_acquire) : ResourceState::Failed);
+                };
+
+                bool IsReady() const
+                {
+                    return (GetState() == ResourceState::Ready);
+                };
+
+                // Blocks until the load has finished; returns whether it succeeded.
+                bool Wait() const;
+
+                // nullptr until the resource is ready.
+                const T *Get() const
+                {
+                    return (IsReady() ? static_cast<const T *>(entry->data) : nullptr);
+                };
+
+                const T *operator ->() const
+                {
+                    return Get();
+                };
+
+                std::size_t GetSize() const
+                {
+                    return (IsReady() ? entry->size : 0);
+                };
+
+            private:
+                ResourceCache *cache;
+                Detail::ResourceEntry *entry;
+        };
+
+        // Resources of any type keyed by StringId. Lookups of resident or in flight resources
+        // take no lock: the table is probed with atomic loads and a hit is pinned by raising the
+        // entry's reference count. A miss starts one load on the thread pool, which concurrent
+        // requests for the same ID join. Once loaded resources exceed the budget, entries that
+        // no handle references are evicted in CLOCK order.
+        //
+        // Entries are recycled but never freed while the cache lives, which is what lets a
+        // reader touch an entry that is being evicted and find out afterwards.
+        class ResourceCache
+        {
+            public:
+                ResourceCache(std::size_t BudgetBytes, std::size_t MaximumEntries = 4096, ThreadPool &Pool = ThreadPool::GetDefault()) : pool(Pool), entries(MaximumEntries ? MaximumEntries : 1), budget(BudgetBytes), used(0), hand(0), pending(0), hits(0), misses(0), evictions(0), failures(0), resident(0)
+                {
+                    std::size_t capacity = 16;
+
+                    while (capacity < 2 * entries.size())
+                        capacity <<= 1;
+
+                    slots = std::vector<std::atomic<Detail::ResourceEntry *>>(capacity);
+
+                    for (std::atomic<Detail::ResourceEntry *> &slot : slots)
+                        slot.store(nullptr, std::memory_order_relaxed);
+
+                    for (std::size_t i = entries.size(); i-- > 0; )
+                        freeEntries.push_back(&entries[i]);
+                };
+
+                // Waits for loads in flight, which still refer to the cache.
+                ~ResourceCache()
+                {
+                    {
+                        std::unique_lock<std::mutex> lock(loadMutex);
+                        loaded.wait(lock, [this]() { return pending == 0; });
+                    }
+
+                    for (Detail::ResourceEntry &entry : entries)
+                    {
+                        if (entry.data)
+                            entry.destroy(entry.data);
+                    }
+                };
+
+                ResourceCache(const ResourceCache &) = delete;
+                ResourceCache &operator =(const ResourceCache &) = delete;
+
+                // The resource if it is resident or being loaded, otherwise an invalid handle;
+                // never starts a load. Also invalid when the entry holds another type.
+                template <typename T> ResourceHandle<T> Find(StringId Id)
+                {
+                    Detail::ResourceEntry *entry = Acquire(Id.GetValue());
+
+                    if (!entry)
+                        return ResourceHandle<T>();
+
+                    if (entry->type != &Detail::ResourceType<T>::tag)
+                    {
+                        entry->references.fetch_sub(1, std::memory_order_release);
+                        return ResourceHandle<T>();
+                    }
+
+                    hits.fetch_add(1, std::memory_order_relaxed);
+
+                    return ResourceHandle<T>(this, entry);
+                };
+
+                // Returns a handle to the resource, loading it on the pool if it is neither
+                // resident nor in flight. Loader returns the resource and sets Bytes to the
+                // memory it accounts for, or returns nullptr on failure; a failed resource is
+                // loaded again by the next Load(). Invalid only when every entry is pinned by
+                // a handle or the ID is taken by another type.
+                template <typename T> ResourceHandle<T> Load(StringId Id, std::function<std::unique_ptr<T>(std::size_t &Bytes)> Loader)
+                {
+                    const std::uint64_t id = Id.GetValue();
+                    Detail::ResourceEntry *entry = Acquire(id);
+                    bool created = false;
+
+                    if (!entry)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+
+                        // Another thread may have inserted it since the lock free probe.
+                        entry = Acquire(id);
+
+                        if (!entry)
+                        {
+                            entry = Insert(id, &Detail::ResourceType<T>::tag);
+
+                            if (!entry)
+                                return ResourceHandle<T>();
+
+                            created = true;
+                        }
+                    }
+
+                    if (entry->type != &Detail::ResourceType<T>::tag)
+                    {
+                        entry->references.fetch_sub(1, std::memory_order_release);
+                        return ResourceHandle<T>();
+                    }
+
+                    ResourceState failed = ResourceState::Failed;
+
+                    if (created || entry->state.compare_exchange_strong(failed, ResourceState::Loading, std::memory_order_acq_rel))
+                    {
+                        misses.fetch_add(1, std::memory_order_relaxed);
+                        StartLoad<T>(entry, std::move(Loader));
+                    }
+                    else
+                        hits.fetch_add(1, std::memory_order_relaxed);
+
+                    return ResourceHandle<T>(this, entry);
+                };
+
+                // Lowering the budget evicts right away.
+                void SetBudget(std::size_t BudgetBytes)
+                {
+                    budget.store(BudgetBytes, std::memory_order_relaxed);
+
+                    std::lock_guard<std::mutex> lock(mutex);
+                    EvictOverBudget();
+                };
+
+                ResourceCacheStatistics GetStatistics() const
+                {
+                    ResourceCacheStatistics statistics;
+                    statistics.hits = hits.load(std::memory_order_relaxed);
+                    statistics.misses = misses.load(std::memory_order_relaxed);
+                    statistics.evictions = evictions.load(std::memory_order_relaxed);
+                    statistics.failures = failures.load(std::memory_order_relaxed);
+                    statistics.usedBytes = used.load(std::memory_order_relaxed);
+                    statistics.budgetBytes = budget.load(std::memory_order_relaxed);
+                    statistics.entryCount = resident.load(std::memory_order_relaxed);
+
+                    return statistics;
+                };
+
+            private:
+                template <typename T> friend class ResourceHandle;
+
+                // A slot that held an entry; probes go past it, insertions reuse it.
+                static Detail::ResourceEntry *GetTombstone()
+                {
+                    static Detail::ResourceEntry tombstone;
+
+                    return &tombstone;
+                };
+
+                std::size_t GetHome(std::uint64_t Id) const
+                {
+                    // IDs are already hashes.
+                    return static_cast<std::size_t>(Id ^ (Id >> 32)) & (slots.size() - 1);
+                };
+
+                // Pins and returns the live entry for Id, or nullptr.
+                Detail::ResourceEntry *Acquire(std::uint64_t Id)
+                {
+                    const std::size_t mask = slots.size() - 1;
+                    std::size_t position = GetHome(Id);
+
+                    for (std::size_t probe = 0; probe < slots.size(); probe++, position = (position + 1) & mask)
+                    {
+                        Detail::ResourceEntry *entry = slots[position].load(std::memory_order_acquire);
+
+                        if (!entry)
+                            return nullptr;
+
+                        if (entry == GetTombstone() || entry->id.load(std::memory_order_acquire) != Id)
+                            continue;
+
+                        // The entry may be evicted or recycled between the load and the
+                        // increment, so check again once it is pinned.
+                        const std::uint32_t references = entry->references.fetch_add(1, std::memory_order_acq_rel);
+
+                        if (!(references & Detail::ResourceDead) && entry->id.load(std::memory_order_acquire) == Id && slots[position].load(std::memory_order_acquire) == entry)
+                        {
+                            if (!entry->used.load(std::memory_order_relaxed))
+                                entry->used.store(true, std::memory_order_relaxed);
+
+                            return entry;
+                        }
+
+                        entry->references.fetch_sub(1, std::memory_order_release);
+                    }
+
+                    return nullptr;
+                };
+
+                // Takes a free entry, evicting one if needed, and publishes it pinned for the
+                // caller. Called with the mutex held.
+                Detail::ResourceEntry *Insert(std::uint64_t Id, const void *Type)
+                {
+                    if (freeEntries.empty() && !EvictOne())
+                        return nullptr;
+
+                    Detail::ResourceEntry *entry = freeEntries.back();
+                    freeEntries.pop_back();
+
+                    entry->id.store(Id, std::memory_order_relaxed);
+                    entry->type = Type;
+                    entry->state.store(ResourceState::Loading, std::memory_order_relaxed);
+                    entry->used.store(true, std::memory_order_relaxed);
+                    entry->size = 0;
+
+                    // Clear the dead bit but keep increments of readers still backing off.
+                    entry->references.fetch_add(1 - Detail::ResourceDead, std::memory_order_acq_rel);
+
+                    const std::size_t mask = slots.size() - 1;
+                    std::size_t position = GetHome(Id);
+
+                    while (slots[position].load(std::memory_order_relaxed) != nullptr && slots[position].load(std::memory_order_relaxed) != GetTombstone())
+                        position = (position + 1) & mask;
+
+                    slots[position].store(entry, std::memory_order_release);
+                    resident.fetch_add(1, std::memory_order_relaxed);
+
+                    return entry;
+                };
+
+                template <typename T> void StartLoad(Detail::ResourceEntry *Entry, std::function<std::unique_ptr<T>(std::size_t &Bytes)> Loader)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(loadMutex);
+                        pending++;
+                    }
+
+                    // The loader's own reference keeps the entry resident until it completes.
+                    Entry->references.fetch_add(1, std::memory_order_relaxed);
+
+                    pool.Submit([this, Entry, Loader]()
+                    {
+                        std::size_t bytes = 0;
+                        std::unique_ptr<T> resource = Loader(bytes);
+
+                        Complete(Entry, resource.release(), [](void *Data) { delete static_cast<T *>(Data); }, bytes);
+                    });
+                };
+
+                void Complete(Detail::ResourceEntry *Entry, void *Data, void (*Destroy)(void *), std::size_t Bytes)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+
+                        // A retry after a failure replaces nothing: failed entries hold no data.
+                        Entry->data = Data;
+                        Entry->destroy = Destroy;
+                        Entry->size = (Data ? Bytes : 0);
+                        Entry->state.store(Data ? ResourceState::Ready : ResourceState::Failed, std::memory_order_release);
+                        used.fetch_add(Entry->size, std::memory_order_relaxed);
+
+                        if (!Data)
+                            failures.fetch_add(1, std::memory_order_relaxed);
+
+                        Entry->references.fetch_sub(1, std::memory_order_release);
+                        EvictOverBudget();
+                    }
+
+                    std::lock_guard<std::mutex> lock(loadMutex);
+                    pending--;
+                    loaded.notify_all();
+                };
+
+                void WaitForLoad(const Detail::ResourceEntry *Entry)
+                {
+                    std::unique_lock<std::mutex> lock(loadMutex);
+                    loaded.wait(lock, [Entry]() { return Entry->state.load(std::memory_order_acquire) != ResourceState::Loading; });
+                };
+
+                // Called with the mutex held.
+                void EvictOverBudget()
+                {
+                    while (used.load(std::memory_order_relaxed) > budget.load(std::memory_order_relaxed))
+                    {
+                        if (!EvictOne())
+                            return;
+                    }
+                };
+
+                // Sweeps the clock hand over the entries, giving used ones a second chance, and
+                // evicts the first unpinned loaded or failed entry. False when two full turns
+                // find none.
+                bool EvictOne()
+                {
+                    for (std::size_t step = 0; step < 2 * entries.size(); step++)
+                    {
+                        Detail::ResourceEntry &entry = entries[hand];
+                        hand = (hand + 1) % entries.size();
+
+                        if (entry.references.load(std::memory_order_relaxed) != 0 || entry.state.load(std::memory_order_acquire) == ResourceState::Loading)
+                            continue;
+
+                        if (entry.used.load(std::memory_order_relaxed))
+                        {
+                            entry.used.store(false, std::memory_order_relaxed);
+                            continue;
+                        }
+
+                        std::uint32_t idle = 0;
+
+                        if (!entry.references.compare_exchange_strong(idle, Detail::ResourceDead, std::memory_order_acquire))
+                            continue;
+
+                        Remove(entry);
+
+                        return true;
+                    }
+
+                    return false;
+                };
+
+                void Remove(Detail::ResourceEntry &Entry)
+                {
+                    const std::size_t mask = slots.size() - 1;
+                    std::size_t position = GetHome(Entry.id.load(std::memory_order_relaxed));
+
+                    while (slots[position].load(std::memory_order_relaxed) != &Entry)
+                        position = (position + 1) & mask;
+
+                    // A slot followed by an empty one ends no probe sequence, so it and the
+                    // tombstones before it can go back to empty.
+                    if (slots[(position + 1) & mask].load(std::memory_order_relaxed) == nullptr)
+                    {
+                        slots[position].store(nullptr, std::memory_order_release);
+
+                        for (position = (position - 1) & mask; slots[position].load(std::memory_order_relaxed) == GetTombstone(); position = (position - 1) & mask)
+                            slots[position].store(nullptr, std::memory_order_release);
+                    }
+                    else
+                        slots[position].store(GetTombstone(), std::memory_order_release);
+
+                    if (Entry.data)
+                        Entry.destroy(Entry.data);
+
+                    used.fetch_sub(Entry.size, std::memory_order_relaxed);
+                    Entry.data = nullptr;
+                    Entry.size = 0;
+                    freeEntries.push_back(&Entry);
+                    resident.fetch_sub(1, std::memory_order_relaxed);
+                    evictions.fetch_add(1, std::memory_order_relaxed);
+                };
+
+                ThreadPool &pool;
+                std::vector<Detail::ResourceEntry> entries;
+                std::vector<std::atomic<Detail::ResourceEntry *>> slots;
+
+                // Serializes insertions, evictions and load completions.
+                std::mutex mutex;
+                std::vector<Detail::ResourceEntry *> freeEntries;
+                std::atomic<std::size_t> budget;
+                std::atomic<std::size_t> used;
+                std::size_t hand;
+
+                std::mutex loadMutex;
+                std::condition_variable loaded;
+                std::size_t pending;
+
+                std::atomic<std::uint64_t> hits;
+                std::atomic<std::uint64_t> misses;
+                std::atomic<std::uint64_t> evictions;
+                std::atomic<std::uint64_t> failures;
+                std::atomic<std::size_t> resident;
+        };
+
+        template <typename T> bool ResourceHandle<T>::Wait() const
+        {
+            if (!entry)
+                return false;
+
+            if (entry->state.load(std::memory_order_acquire) == ResourceState::Loading)
+                cache->WaitForLoad(entry);
+
+            return IsReady();
+        };
+    };
+};
+
+#endif // WARLOCK_CORE_RESOURCECACHE_HPP
@@ -0,0 +1,220 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Core/StringId.hpp
+// Description: Compile time string hashing and hashed string identifiers.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_CORE_STRINGID_HPP
+#define WARLOCK_CORE_STRINGID_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+// True while a constant expression is being evaluated, where the hashes below cannot use plain
+// loads; compilers without the builtin always take the byte by byte path.
+#if (__clang_major__ >= 9 || (!__clang__ && __GNUC__ >= 9) || _MSC_VER >= 1925)
+#define WARLOCK_CONSTANT_EVALUATED() __builtin_is_constant_evaluated()
+#else
+#define WARLOCK_CONSTANT_EVALUATED() true
+#endif
+
+namespace Warlock
+{
+    namespace Core
+    {
+        namespace Detail
+        {
+            constexpr std::uint64_t XxPrime1 = 0x9E3779B185EBCA87ull;
+            constexpr std::uint64_t XxPrime2 = 0xC2B2AE3D27D4EB4Full;
+            constexpr std::uint64_t XxPrime3 = 0x165667B19E3779F9ull;
+            constexpr std::uint64_t XxPrime4 = 0x85EBCA77C2B2AE63ull;
+            constexpr std::uint64_t XxPrime5 = 0x27D4EB2F165667C5ull;
+
+            constexpr std::uint64_t RotateLeft(std::uint64_t Value, int Bits)
+            {
+                return (Value << Bits) | (Value >> (64 - Bits));
+            };
+
+            // Little endian reads, built from bytes in constant expressions; the run time loads
+            // assume a little endian target.
+            constexpr std::uint64_t ReadLittle64(std::string_view Text, std::size_t Offset)
+            {
+                std::uint64_t value = 0;
+
+                if (!WARLOCK_CONSTANT_EVALUATED())
+                {
+                    std::memcpy(&value, Text.data() + Offset, 8);
+                    return value;
+                }
+
+                for (int i = 7; i >= 0; i--)
+                    value = (value << 8) | static_cast<std::uint8_t>(Text[Offset + i]);
+
+                return value;
+            };
+
+            constexpr std::uint32_t ReadLittle32(std::string_view Text, std::size_t Offset)
+            {
+                std::uint32_t value = 0;
+
+                if (!WARLOCK_CONSTANT_EVALUATED())
+                {
+                    std::memcpy(&value, Text.data() + Offset, 4);
+                    return value;
+                }
+
+                for (int i = 3; i >= 0; i--)
+                    value = (value << 8) | static_cast<std::uint8_t>(Text[Offset + i]);
+
+                return value;
+            };
+
+            constexpr std::uint64_t XxRound(std::uint64_t Accumulator, std::uint64_t Input)
+            {
+                return RotateLeft(Accumulator + Input * XxPrime2, 31) * XxPrime1;
+            };
+
+            constexpr std::uint64_t XxMerge(std::uint64_t Accumulator, std::uint64_t Value)
+            {
+                return (Accumulator ^ XxRound(0, Value)) * XxPrime1 + XxPrime4;
+            };
+        };
+
+        // 64 bit FNV-1a; simple, but one multiply per byte.
+        constexpr std::uint64_t HashFnv1a(std::string_view Text)
+        {
+            std::uint64_t hash = 0xCBF29CE484222325ull;
+
+            for (char c : Text)
+                hash = (hash ^ static_cast<std::uint8_t>(c)) * 0x100000001B3ull;
+
+            return hash;
+        };
+
+        // XXH64, bit exact with the reference implementation; eight bytes per step.
+        constexpr std::uint64_t HashXx64(std::string_view Text, std::uint64_t Seed = 0)
+        {
+            const std::size_t length = Text.size();
+            std::size_t offset = 0;
+            std::uint64_t hash = Seed + Detail::XxPrime5;
+
+            if (length >= 32)
+            {
+                std::uint64_t v1 = Seed + Detail::XxPrime1 + Detail::XxPrime2;
+                std::uint64_t v2 = Seed + Detail::XxPrime2;
+                std::uint64_t v3 = Seed;
+                std::uint64_t v4 = Seed - Detail::XxPrime1;
+
+                for (; offset + 32 <= length; offset += 32)
+                {
+                    v1 = Detail::XxRound(v1, Detail::ReadLittle64(Text, offset));
+                    v2 = Detail::XxRound(v2, Detail::ReadLittle64(Text, offset + 8));
+                    v3 = Detail::XxRound(v3, Detail::ReadLittle64(Text, offset + 16));
+                    v4 = Detail::XxRound(v4, Detail::ReadLittle64(Text, offset + 24));
+                }
+
+                hash = Detail::RotateLeft(v1, 1) + Detail::RotateLeft(v2, 7) + Detail::RotateLeft(v3, 12) + Detail::RotateLeft(v4, 18);
+                hash = Detail::XxMerge(hash, v1);
+                hash = Detail::XxMerge(hash, v2);
+                hash = Detail::XxMerge(hash, v3);
+                hash = Detail::XxMerge(hash, v4);
+            }
+
+            hash += length;
+
+            for (; offset + 8 <= length; offset += 8)
+                hash = Detail::RotateLeft(hash ^ Detail::XxRound(0, Detail::ReadLittle64(Text, offset)), 27) * Detail::XxPrime1 + Detail::XxPrime4;
+
+            if (offset + 4 <= length)
+            {
+                hash = Detail::RotateLeft(hash ^ (Detail::ReadLittle32(Text, offset) * Detail::XxPrime1), 23) * Detail::XxPrime2 + Detail::XxPrime3;
+                offset += 4;
+            }
+
+            for (; offset < length; offset++)
+                hash = Detail::RotateLeft(hash ^ (static_cast<std::uint8_t>(Text[offset]) * Detail::XxPrime5), 11) * Detail::XxPrime1;
+
+            hash ^= hash >> 33;
+            hash *= Detail::XxPrime2;
+            hash ^= hash >> 29;
+            hash *= Detail::XxPrime3;
+            hash ^= hash >> 32;
+
+            return hash;
+        };
+
+        // A name reduced to its 64 bit hash, so lookups and comparisons are integer ones. Names
+        // written in the source hash at compile time:
+        //
+        //   constexpr StringId albedo = "albedo"_id;
+        //
+        // Names known only at run time hash to the same value through StringId(Name).
+        class StringId
+        {
+            public:
+                constexpr StringId() : value(0) {};
+                constexpr explicit StringId(std::string_view Name) : value(HashXx64(Name)) {};
+
+                static constexpr StringId FromValue(std::uint64_t Value)
+                {
+                    StringId id;
+                    id.value = Value;
+
+                    return id;
+                };
+
+                constexpr std::uint64_t GetValue() const
+                {
+                    return value;
+                };
+
+                constexpr bool IsValid() const
+                {
+                    return (value != 0);
+                };
+
+                constexpr bool operator ==(StringId Other) const
+                {
+                    return (value == Other.value);
+                };
+
+                constexpr bool operator !=(StringId Other) const
+                {
+                    return (value != Other.value);
+                };
+
+                constexpr bool operator <(StringId Other) const
+                {
+                    return (value < Other.value);
+                };
+
+            private:
+                std::uint64_t value;
+        };
+
+        namespace Literals
+        {
+            constexpr StringId operator "" _id(const char *Text, std::size_t Length)
+            {
+                return StringId(std::string_view(Text, Length));
+            };
+        };
+    };
+};
+
+#endif // WARLOCK_CORE_STRINGID_HPP
@@ -0,0 +1,209 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Core/ThreadPool.hpp
+// Description: Class to implement the engine worker threads and data parallel loops.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_CORE_THREADPOOL_HPP
+#define WARLOCK_CORE_THREADPOOL_HPP
+
+#include "Platform/Platform.hpp"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Core
+    {
+        class ThreadPool
+        {
+            public:
+                ThreadPool(unsigned int ThreadCount = 0) : stopping(false)
+                {
+                    if (ThreadCount == 0)
+                    {
+                        unsigned int hardware = std::thread::hardware_concurrency();
+                        ThreadCount = (hardware > 1 ? hardware - 1 : 1);
+                    }
+
+                    for (unsigned int i = 0; i < ThreadCount; i++)
+                        workers.emplace_back([this]() { WorkerLoop(); });
+                };
+
+                ~ThreadPool()
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        stopping = true;
+                    }
+
+                    condition.notify_all();
+
+                    for (std::thread &worker : workers)
+                        worker.join();
+                };
+
+                ThreadPool(const ThreadPool &) = delete;
+                ThreadPool &operator =(const ThreadPool &) = delete;
+
+                static ThreadPool &GetDefault()
+                {
+                    static ThreadPool pool;
+
+                    return pool;
+                };
+
+                // Number of threads taking part in a parallel loop, the calling thread included.
+                unsigned int GetConcurrency() const
+                {
+                    return static_cast<unsigned int>(workers.size()) + 1;
+                };
+
+                void Submit(std::function<void()> Task)
+                {
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        tasks.push_back(std::move(Task));
+                    }
+
+                    condition.notify_one();
+                };
+
+                // Splits [Begin, End) in chunks of Grain elements and calls Body(ChunkBegin, ChunkEnd)
+                // for each of them; returns once every chunk has completed. The calling thread takes
+                // chunks too, so nested loops issued from a worker cannot dead-lock.
+                template <typename Function> void ParallelFor(std::size_t Begin, std::size_t End, std::size_t Grain, Function &&Body)
+                {
+                    if (End <= Begin)
+                        return;
+
+                    if (Grain == 0)
+                        Grain = 1;
+
+                    std::size_t chunks = (End - Begin + Grain - 1) / Grain;
+
+                    if (chunks == 1 || workers.empty())
+                    {
+                        for (std::size_t i = Begin; i < End; i += Grain)
+                            Body(i, (End - i > Grain ? i + Grain : End));
+
+                        return;
+                    }
+
+                    std::shared_ptr<Job> job = std::make_shared<Job>();
+                    job->begin = Begin;
+                    job->end = End;
+                    job->grain = Grain;
+                    job->chunks = chunks;
+                    job->body = &Body;
+                    job->invoke = [](const void *Callable, std::size_t ChunkBegin, std::size_t ChunkEnd)
+                    {
+                        (*static_cast<typename std::remove_reference<Function>::type *>(const_cast<void *>(Callable)))(ChunkBegin, ChunkEnd);
+                    };
+
+                    std::size_t helpers = (chunks - 1 < workers.size() ? chunks - 1 : workers.size());
+
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+
+                        for (std::size_t i = 0; i < helpers; i++)
+                            tasks.push_back([job]() { job->Run(); });
+                    }
+
+                    condition.notify_all();
+                    job->Run();
+
+                    while (job->completed.load(std::memory_order_acquire) < chunks)
+                        std::this_thread::yield();
+                };
+
+                // Convenience overload choosing a grain that gives every thread a few chunks.
+                template <typename Function> void ParallelFor(std::size_t Count, Function &&Body)
+                {
+                    std::size_t grain = Count / (GetConcurrency() * 4);
+
+                    ParallelFor(0, Count, (grain < 1024 ? 1024 : grain), std::forward<Function>(Body));
+                };
+
+            private:
+                struct Job
+                {
+                    Job() : next(0), completed(0) {};
+
+                    void Run()
+                    {
+                        std::size_t chunk;
+
+                        while ((chunk = next.fetch_add(1, std::memory_order_relaxed)) < chunks)
+                        {
+                            std::size_t first = begin + chunk * grain;
+                            std::size_t last = (end - first > grain ? first + grain : end);
+
+                            invoke(body, first, last);
+                            completed.fetch_add(1, std::memory_order_release);
+                        }
+                    };
+
+                    std::atomic<std::size_t> next;
+                    std::atomic<std::size_t> completed;
+                    std::size_t begin;
+                    std::size_t end;
+                    std::size_t grain;
+                    std::size_t chunks;
+                    const void *body;
+                    void (*invoke)(const void *, std::size_t, std::size_t);
+                };
+
+                void WorkerLoop()
+                {
+                    for (;;)
+                    {
+                        std::function<void()> task;
+
+                        {
+                            std::unique_lock<std::mutex> lock(mutex);
+                            condition.wait(lock, [this]() { return stopping || !tasks.empty(); });
+
+                            if (stopping && tasks.empty())
+                                return;
+
+                            task = std::move(tasks.front());
+                            tasks.pop_front();
+                        }
+
+                        task();
+                    }
+                };
+
+                std::vector<std::thread> workers;
+                std::deque<std::function<void()>> tasks;
+                std::mutex mutex;
+                std::condition_variable condition;
+                bool stopping;
+        };
+    };
+};
+
+#endif // WARLOCK_CORE_THREADPOOL_HPP
@@ -0,0 +1,238 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Ecs/Archetype.hpp
+// Description: Archetype tables storing components as columns of fixed size chunks.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_ECS_ARCHETYPE_HPP
+#define WARLOCK_ECS_ARCHETYPE_HPP
+
+#include "Entity.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Ecs
+    {
+        static constexpr std::size_t ChunkSize = 16384;
+        static constexpr std::size_t ColumnAlignment = 64;
+
+        // A chunk holds up to the archetype capacity rows; the entity column comes first and
+        // every component follows in its own cache line aligned column.
+        struct Chunk
+        {
+            unsigned char *data;
+            std::uint32_t count;
+        };
+
+        // Every entity with exactly the same component set lives in the same archetype. Rows are
+        // kept dense: all chunks but the last are full, and removing a row moves the last row
+        // of the last chunk into the hole.
+        class Archetype
+        {
+            public:
+                explicit Archetype(ComponentMask Mask) : mask(Mask), capacity(0)
+                {
+                    std::size_t rowSize = sizeof(Entity);
+
+                    for (std::uint32_t id = 0; id < MaximumComponents; id++)
+                    {
+                        offsets[id] = 0;
+                        addEdges[id] = nullptr;
+                        removeEdges[id] = nullptr;
+
+                        if (Mask & (static_cast<ComponentMask>(1) << id))
+                        {
+                            components.push_back(id);
+                            rowSize += GetComponentInfo(id).size;
+                        }
+                    }
+
+                    // Start from the unpadded estimate and shrink until the aligned columns fit.
+                    capacity = static_cast<std::uint32_t>(ChunkSize / rowSize);
+
+                    while (capacity > 0 && Layout(capacity) > ChunkSize)
+                        capacity--;
+
+                    if (capacity == 0)
+                        throw std::length_error("Archetype row does not fit in a chunk");
+
+                    Layout(capacity);
+                };
+
+                ~Archetype()
+                {
+                    for (Chunk &chunk : chunks)
+                    {
+                        for (std::uint32_t id : components)
+                        {
+                            const ComponentInfo &info = GetComponentInfo(id);
+
+                            for (std::uint32_t row = 0; row < chunk.count; row++)
+                                info.destroy(chunk.data + offsets[id] + row * info.size);
+                        }
+
+                        ::operator delete(chunk.data, std::align_val_t(ColumnAlignment));
+                    }
+                };
+
+                Archetype(const Archetype &) = delete;
+                Archetype &operator =(const Archetype &) = delete;
+
+                ComponentMask GetMask() const
+                {
+                    return mask;
+                };
+
+                bool Has(std::uint32_t Component) const
+                {
+                    return (mask & (static_cast<ComponentMask>(1) << Component)) != 0;
+                };
+
+                const std::vector<std::uint32_t> &GetComponents() const
+                {
+                    return components;
+                };
+
+                std::uint32_t GetCapacity() const
+                {
+                    return capacity;
+                };
+
+                std::size_t GetChunkCount() const
+                {
+                    return chunks.size();
+                };
+
+                Chunk &GetChunk(std::size_t Index)
+                {
+                    return chunks[Index];
+                };
+
+                std::size_t GetEntityCount() const
+                {
+                    return (chunks.empty() ? 0 : (chunks.size() - 1) * capacity + chunks.back().count);
+                };
+
+                Entity *GetEntities(const Chunk &Block) const
+                {
+                    return reinterpret_cast<Entity *>(Block.data);
+                };
+
+                void *GetColumn(const Chunk &Block, std::uint32_t Component) const
+                {
+                    return Block.data + offsets[Component];
+                };
+
+                template <typename T> T *GetColumn(const Chunk &Block) const
+                {
+                    return reinterpret_cast<T *>(Block.data + offsets[Component<T>::Id()]);
+                };
+
+                void *Get(std::uint32_t ChunkIndex, std::uint32_t Row, std::uint32_t Component) const
+                {
+                    return chunks[ChunkIndex].data + offsets[Component] + Row * GetComponentInfo(Component).size;
+                };
+
+                // Appends an uninitialized row; the caller constructs every component in it.
+                void Allocate(const Entity &Owner, std::uint32_t &ChunkIndex, std::uint32_t &Row)
+                {
+                    if (chunks.empty() || chunks.back().count == capacity)
+                        chunks.push_back(Chunk{static_cast<unsigned char *>(::operator new(ChunkSize, std::align_val_t(ColumnAlignment))), 0});
+
+                    Chunk &chunk = chunks.back();
+
+                    ChunkIndex = static_cast<std::uint32_t>(chunks.size() - 1);
+                    Row = chunk.count++;
+                    GetEntities(chunk)[Row] = Owner;
+                };
+
+                // Destroys the components of a row and fills it with the last row. Returns the
+                // entity that moved into the row, or an invalid entity when none did.
+                Entity Free(std::uint32_t ChunkIndex, std::uint32_t Row)
+                {
+                    Chunk &chunk = chunks[ChunkIndex];
+                    Chunk &last = chunks.back();
+                    std::uint32_t lastRow = last.count - 1;
+                    Entity moved;
+
+                    for (std::uint32_t id : components)
+                    {
+                        const ComponentInfo &info = GetComponentInfo(id);
+                        unsigned char *target = chunk.data + offsets[id] + Row * info.size;
+
+                        info.destroy(target);
+
+                        if (&chunk != &last || Row != lastRow)
+                        {
+                            unsigned char *source = last.data + offsets[id] + lastRow * info.size;
+
+                            info.move(target, source);
+                            info.destroy(source);
+                        }
+                    }
+
+                    if (&chunk != &last || Row != lastRow)
+                    {
+                        moved = GetEntities(last)[lastRow];
+                        GetEntities(chunk)[Row] = moved;
+                    }
+
+                    if (--last.count == 0)
+                    {
+                        ::operator delete(last.data, std::align_val_t(ColumnAlignment));
+                        chunks.pop_back();
+                    }
+
+                    return moved;
+                };
+
+                // Cached structural transitions, filled in lazily by the world.
+                Archetype *addEdges[MaximumComponents];
+                Archetype *removeEdges[MaximumComponents];
+
+            private:
+                std::size_t Layout(std::uint32_t Capacity)
+                {
+                    std::size_t offset = sizeof(Entity) * Capacity;
+
+                    for (std::uint32_t id : components)
+                    {
+                        const ComponentInfo &info = GetComponentInfo(id);
+                        std::size_t alignment = (info.alignment > ColumnAlignment ? info.alignment : ColumnAlignment);
+
+                        offset = (offset + alignment - 1) & ~(alignment - 1);
+                        offsets[id] = offset;
+                        offset += info.size * Capacity;
+                    }
+
+                    return offset;
+                };
+
+                ComponentMask mask;
+                std::uint32_t capacity;
+                std::size_t offsets[MaximumComponents];
+                std::vector<std::uint32_t> components;
+                std::vector<Chunk> chunks;
+        };
+    };
+};
+
+#endif // WARLOCK_ECS_ARCHETYPE_HPP
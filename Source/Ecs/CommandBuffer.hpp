@@ -0,0 +1,208 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Ecs/CommandBuffer.hpp
+// Description: Deferred structural changes recorded during iteration and applied afterwards.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_ECS_COMMANDBUFFER_HPP
+#define WARLOCK_ECS_COMMANDBUFFER_HPP
+
+#include "Entity.hpp"
+#include "World.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Ecs
+    {
+        // Records creations, destructions and component changes while queries run, typically
+        // one buffer per worker, and applies them in recording order on Playback. Commands on
+        // entities that died in the meantime are dropped.
+        class CommandBuffer
+        {
+            public:
+                CommandBuffer() = default;
+                CommandBuffer(const CommandBuffer &) = delete;
+                CommandBuffer &operator =(const CommandBuffer &) = delete;
+
+                ~CommandBuffer()
+                {
+                    Clear();
+                };
+
+                // Components given here are added to the new entity when the buffer is played
+                // back.
+                template <typename... Components> void Create(Components &&... Values)
+                {
+                    commands.push_back(Command{Operation::Create, Entity(), 0, 0});
+                    (Push(Operation::Add, Entity(), std::forward<Components>(Values)), ...);
+                };
+
+                void Destroy(const Entity &Target)
+                {
+                    commands.push_back(Command{Operation::Destroy, Target, 0, 0});
+                };
+
+                template <typename T> void Add(const Entity &Target, T &&Value)
+                {
+                    Push(Operation::Add, Target, std::forward<T>(Value));
+                };
+
+                template <typename T> void Remove(const Entity &Target)
+                {
+                    commands.push_back(Command{Operation::Remove, Target, Component<T>::Id(), 0});
+                };
+
+                bool IsEmpty() const
+                {
+                    return commands.empty();
+                };
+
+                // Created, when given, receives the handles of the new entities in recording order.
+                void Playback(World &Target, std::vector<Entity> *Created = nullptr)
+                {
+                    Entity last;
+
+                    for (const Command &command : commands)
+                    {
+                        // Commands following a Create without an entity refer to the new entity.
+                        Entity entity = (command.target.IsValid() ? command.target : last);
+
+                        switch (command.operation)
+                        {
+                            case Operation::Create:
+                                last = Target.Create();
+
+                                if (Created)
+                                    Created->push_back(last);
+                                break;
+
+                            case Operation::Destroy:
+                                Target.Destroy(entity);
+                                break;
+
+                            case Operation::Add:
+                                Target.AddRaw(entity, command.component, payload.get() + command.offset);
+                                break;
+
+                            case Operation::Remove:
+                                Target.RemoveRaw(entity, command.component);
+                                break;
+                        };
+                    }
+
+                    Clear();
+                };
+
+                // Drops every recorded command, destroying pending component values.
+                void Clear()
+                {
+                    for (const Command &command : commands)
+                    {
+                        if (command.operation == Operation::Add)
+                            GetComponentInfo(command.component).destroy(payload.get() + command.offset);
+                    }
+
+                    commands.clear();
+                    used = 0;
+                };
+
+            private:
+                enum class Operation : std::uint8_t
+                {
+                    Create,
+                    Destroy,
+                    Add,
+                    Remove
+                };
+
+                struct Command
+                {
+                    Operation operation;
+                    Entity target;
+                    std::uint32_t component;
+                    std::size_t offset;
+                };
+
+                template <typename Value> void Push(Operation Kind, const Entity &Target, Value &&Data)
+                {
+                    typedef typename std::decay<Value>::type T;
+
+                    std::size_t offset = Reserve(sizeof(T), alignof(T));
+
+                    new (payload.get() + offset) T(std::forward<Value>(Data));
+                    commands.push_back(Command{Kind, Target, Component<T>::Id(), offset});
+                };
+
+                // Payload values are moved into a larger buffer on growth, using their type
+                // erased move so non trivial components survive.
+                std::size_t Reserve(std::size_t Size, std::size_t Alignment)
+                {
+                    std::size_t offset = (used + Alignment - 1) & ~(Alignment - 1);
+
+                    if (offset + Size > capacity)
+                    {
+                        std::size_t grown = (capacity ? capacity * 2 : 4096);
+
+                        while (grown < offset + Size)
+                            grown *= 2;
+
+                        std::unique_ptr<unsigned char[], Deleter> buffer(static_cast<unsigned char *>(::operator new(grown, std::align_val_t(MaximumAlignment))));
+
+                        for (const Command &command : commands)
+                        {
+                            if (command.operation != Operation::Add)
+                                continue;
+
+                            const ComponentInfo &info = GetComponentInfo(command.component);
+
+                            info.move(buffer.get() + command.offset, payload.get() + command.offset);
+                            info.destroy(payload.get() + command.offset);
+                        }
+
+                        payload = std::move(buffer);
+                        capacity = grown;
+                    }
+
+                    used = offset + Size;
+                    return offset;
+                };
+
+                static constexpr std::size_t MaximumAlignment = 64;
+
+                struct Deleter
+                {
+                    void operator ()(unsigned char *Buffer) const
+                    {
+                        ::operator delete(Buffer, std::align_val_t(MaximumAlignment));
+                    };
+                };
+
+                std::vector<Command> commands;
+                std::unique_ptr<unsigned char[], Deleter> payload;
+                std::size_t capacity = 0;
+                std::size_t used = 0;
+        };
+    };
+};
+
+#endif // WARLOCK_ECS_COMMANDBUFFER_HPP
@@ -0,0 +1,141 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Ecs/Entity.hpp
+// Description: Generational entity handles and the component type registry.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_ECS_ENTITY_HPP
+#define WARLOCK_ECS_ENTITY_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+namespace Warlock
+{
+    namespace Ecs
+    {
+        // An index into the entity records plus the generation the record had when the entity
+        // was created; destroying an entity bumps the generation so stale handles stop matching.
+        struct Entity
+        {
+            static constexpr std::uint32_t InvalidIndex = 0xFFFFFFFF;
+
+            Entity() : index(InvalidIndex), generation(0) {};
+            Entity(std::uint32_t Index, std::uint32_t Generation) : index(Index), generation(Generation) {};
+
+            bool IsValid() const
+            {
+                return (index != InvalidIndex);
+            };
+
+            bool operator ==(const Entity &Other) const
+            {
+                return (index == Other.index && generation == Other.generation);
+            };
+
+            bool operator !=(const Entity &Other) const
+            {
+                return !(*this == Other);
+            };
+
+            std::uint32_t index;
+            std::uint32_t generation;
+        };
+
+        static constexpr std::uint32_t MaximumComponents = 64;
+
+        typedef std::uint64_t ComponentMask;
+
+        // Type erased lifetime operations of a component, so archetypes can move rows between
+        // chunks without knowing the component types.
+        struct ComponentInfo
+        {
+            std::size_t size;
+            std::size_t alignment;
+            void (*move)(void *Destination, void *Source);
+            void (*destroy)(void *Value);
+        };
+
+        namespace Detail
+        {
+            inline ComponentInfo *GetComponentTable()
+            {
+                static ComponentInfo table[MaximumComponents];
+                return table;
+            };
+
+            inline std::uint32_t NextComponentId()
+            {
+                static std::atomic<std::uint32_t> next(0);
+                std::uint32_t id = next.fetch_add(1, std::memory_order_relaxed);
+
+                if (id >= MaximumComponents)
+                    throw std::length_error("Too many component types registered");
+
+                return id;
+            };
+        };
+
+        // Ids are assigned on first use, in a thread safe way, and are stable for the lifetime
+        // of the process.
+        template <typename T> struct Component
+        {
+                static_assert(std::is_move_constructible<T>::value && std::is_destructible<T>::value, "Components must be move constructible");
+
+                static std::uint32_t Id()
+                {
+                    static const std::uint32_t id = Register();
+                    return id;
+                };
+
+                static ComponentMask Mask()
+                {
+                    return static_cast<ComponentMask>(1) << Id();
+                };
+
+            private:
+                static std::uint32_t Register()
+                {
+                    std::uint32_t id = Detail::NextComponentId();
+                    ComponentInfo &info = Detail::GetComponentTable()[id];
+
+                    info.size = sizeof(T);
+                    info.alignment = alignof(T);
+                    info.move = [](void *Destination, void *Source) { new (Destination) T(std::move(*static_cast<T *>(Source))); };
+                    info.destroy = [](void *Value) { static_cast<T *>(Value)->~T(); };
+
+                    return id;
+                };
+        };
+
+        inline const ComponentInfo &GetComponentInfo(std::uint32_t Id)
+        {
+            return Detail::GetComponentTable()[Id];
+        };
+
+        template <typename... Components> ComponentMask MakeMask()
+        {
+            return (static_cast<ComponentMask>(0) | ... | Component<typename std::remove_cv<Components>::type>::Mask());
+        };
+    };
+};
+
+#endif // WARLOCK_ECS_ENTITY_HPP
@@ -0,0 +1,148 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Ecs/Query.hpp
+// Description: Cached queries iterating the chunks of matching archetypes.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_ECS_QUERY_HPP
+#define WARLOCK_ECS_QUERY_HPP
+
+#include "Archetype.hpp"
+#include "World.hpp"
+#include "Core/ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Ecs
+    {
+        // Matches every archetype holding all of Components and none of the Exclude mask. The
+        // matching archetypes are cached and only the archetypes created since the last call
+        // are checked, so a query costs nothing to keep around between frames.
+        //
+        // Components may be const qualified to document read only access.
+        template <typename... Components> class Query
+        {
+            public:
+                explicit Query(World &Target, ComponentMask Exclude = 0) : world(Target), include(MakeMask<Components...>()), exclude(Exclude), seen(0) {};
+
+                std::size_t GetEntityCount()
+                {
+                    std::size_t count = 0;
+
+                    Refresh();
+
+                    for (Archetype *archetype : matches)
+                        count += archetype->GetEntityCount();
+
+                    return count;
+                };
+
+                // Body(std::size_t Count, const Entity *Entities, Components *...) once per chunk;
+                // the column pointers are contiguous arrays the body can vectorize over.
+                template <typename Function> void ForEachChunk(Function &&Body)
+                {
+                    Refresh();
+
+                    for (Archetype *archetype : matches)
+                    {
+                        for (std::size_t c = 0; c < archetype->GetChunkCount(); c++)
+                            Visit(archetype, archetype->GetChunk(c), Body);
+                    }
+                };
+
+                // Body(Components &...) once per entity.
+                template <typename Function> void ForEach(Function &&Body)
+                {
+                    ForEachChunk([&](std::size_t Count, const Entity *, Components *... Columns)
+                    {
+                        for (std::size_t i = 0; i < Count; i++)
+                            Body(Columns[i]...);
+                    });
+                };
+
+                // Chunks are handed out to the workers whole, so bodies never share a cache line
+                // of a column with another thread.
+                template <typename Function> void ParallelForEachChunk(Function &&Body, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+                {
+                    Refresh();
+                    work.clear();
+
+                    for (Archetype *archetype : matches)
+                    {
+                        for (std::size_t c = 0; c < archetype->GetChunkCount(); c++)
+                            work.push_back(WorkItem{archetype, &archetype->GetChunk(c)});
+                    }
+
+                    Pool.ParallelFor(0, work.size(), 1, [&](std::size_t First, std::size_t Last)
+                    {
+                        for (std::size_t i = First; i < Last; i++)
+                            Visit(work[i].archetype, *work[i].chunk, Body);
+                    });
+                };
+
+                template <typename Function> void ParallelForEach(Function &&Body, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+                {
+                    ParallelForEachChunk([&](std::size_t Count, const Entity *, Components *... Columns)
+                    {
+                        for (std::size_t i = 0; i < Count; i++)
+                            Body(Columns[i]...);
+                    }, Pool);
+                };
+
+            private:
+                struct WorkItem
+                {
+                    Archetype *archetype;
+                    Chunk *chunk;
+                };
+
+                void Refresh()
+                {
+                    const std::vector<Archetype *> &archetypes = world.GetArchetypes();
+
+                    for (; seen < archetypes.size(); seen++)
+                    {
+                        ComponentMask mask = archetypes[seen]->GetMask();
+
+                        if ((mask & include) == include && !(mask & exclude))
+                            matches.push_back(archetypes[seen]);
+                    }
+                };
+
+                template <typename Function> static void Visit(Archetype *Table, const Chunk &Block, Function &Body)
+                {
+                    if (Block.count == 0)
+                        return;
+
+                    Body(static_cast<std::size_t>(Block.count), static_cast<const Entity *>(Table->GetEntities(Block)),
+                         static_cast<Components *>(Table->GetColumn(Block, Component<typename std::remove_cv<Components>::type>::Id()))...);
+                };
+
+                World &world;
+                ComponentMask include;
+                ComponentMask exclude;
+                std::size_t seen;
+                std::vector<Archetype *> matches;
+                std::vector<WorkItem> work;
+        };
+    };
+};
+
+#endif // WARLOCK_ECS_QUERY_HPP
@@ -0,0 +1,269 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Ecs/World.hpp
+// Description: Entity world owning the archetype tables and the entity records.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_ECS_WORLD_HPP
+#define WARLOCK_ECS_WORLD_HPP
+
+#include "Archetype.hpp"
+#include "Entity.hpp"
+#include "Core/FlatHashMap.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Ecs
+    {
+        // Structural changes (creating and destroying entities, adding and removing components)
+        // move rows between archetypes and must not run while a query iterates; record them in
+        // a CommandBuffer instead.
+        class World
+        {
+            public:
+                World() : entityCount(0)
+                {
+                    GetArchetype(0);
+                };
+
+                World(const World &) = delete;
+                World &operator =(const World &) = delete;
+
+                Entity Create()
+                {
+                    Entity entity = Reserve();
+                    Place(entity, GetArchetype(0));
+
+                    return entity;
+                };
+
+                template <typename... Components> Entity Create(Components &&... Values)
+                {
+                    Entity entity = Reserve();
+                    Archetype *archetype = GetArchetype(MakeMask<typename std::decay<Components>::type...>());
+                    const Record &record = Place(entity, archetype);
+
+                    (new (archetype->Get(record.chunk, record.row, Component<typename std::decay<Components>::type>::Id()))
+                         typename std::decay<Components>::type(std::forward<Components>(Values)), ...);
+
+                    return entity;
+                };
+
+                void Destroy(const Entity &Target)
+                {
+                    if (!IsAlive(Target))
+                        return;
+
+                    Record &record = records[Target.index];
+
+                    Release(record);
+                    record.archetype = nullptr;
+                    record.generation++;
+                    freeIndices.push_back(Target.index);
+                    entityCount--;
+                };
+
+                bool IsAlive(const Entity &Target) const
+                {
+                    return (Target.index < records.size() && records[Target.index].generation == Target.generation && records[Target.index].archetype);
+                };
+
+                std::size_t GetEntityCount() const
+                {
+                    return entityCount;
+                };
+
+                // Adds a component or replaces the value of an existing one.
+                template <typename T> void Add(const Entity &Target, T Value)
+                {
+                    AddRaw(Target, Component<T>::Id(), &Value);
+                };
+
+                template <typename T> void Remove(const Entity &Target)
+                {
+                    RemoveRaw(Target, Component<T>::Id());
+                };
+
+                template <typename T> bool Has(const Entity &Target) const
+                {
+                    return (IsAlive(Target) && records[Target.index].archetype->Has(Component<T>::Id()));
+                };
+
+                // Returns null when the entity is dead or lacks the component. The pointer is
+                // invalidated by any structural change.
+                template <typename T> T *Get(const Entity &Target) const
+                {
+                    if (!Has<T>(Target))
+                        return nullptr;
+
+                    const Record &record = records[Target.index];
+                    return static_cast<T *>(record.archetype->Get(record.chunk, record.row, Component<T>::Id()));
+                };
+
+                // Type erased forms used by command buffer playback; Source is move constructed
+                // into the entity and left for the caller to destroy.
+                void AddRaw(const Entity &Target, std::uint32_t Id, void *Source)
+                {
+                    if (!IsAlive(Target))
+                        return;
+
+                    Record &record = records[Target.index];
+                    const ComponentInfo &info = GetComponentInfo(Id);
+
+                    if (record.archetype->Has(Id))
+                    {
+                        void *value = record.archetype->Get(record.chunk, record.row, Id);
+
+                        info.destroy(value);
+                        info.move(value, Source);
+                        return;
+                    }
+
+                    Archetype *source = record.archetype;
+                    Archetype *target = source->addEdges[Id];
+
+                    if (!target)
+                    {
+                        target = GetArchetype(source->GetMask() | (static_cast<ComponentMask>(1) << Id));
+                        source->addEdges[Id] = target;
+                        target->removeEdges[Id] = source;
+                    }
+
+                    Migrate(Target, target);
+                    info.move(target->Get(record.chunk, record.row, Id), Source);
+                };
+
+                void RemoveRaw(const Entity &Target, std::uint32_t Id)
+                {
+                    if (!IsAlive(Target) || !records[Target.index].archetype->Has(Id))
+                        return;
+
+                    Archetype *source = records[Target.index].archetype;
+                    Archetype *target = source->removeEdges[Id];
+
+                    if (!target)
+                    {
+                        target = GetArchetype(source->GetMask() & ~(static_cast<ComponentMask>(1) << Id));
+                        source->removeEdges[Id] = target;
+                        target->addEdges[Id] = source;
+                    }
+
+                    Migrate(Target, target);
+                };
+
+                // Archetypes are only ever appended, so queries cache how many they have seen.
+                const std::vector<Archetype *> &GetArchetypes() const
+                {
+                    return archetypeList;
+                };
+
+            private:
+                struct Record
+                {
+                    Archetype *archetype;
+                    std::uint32_t chunk;
+                    std::uint32_t row;
+                    std::uint32_t generation;
+                };
+
+                Archetype *GetArchetype(ComponentMask Mask)
+                {
+                    std::unique_ptr<Archetype> *found = archetypes.Find(Mask);
+
+                    if (found)
+                        return found->get();
+
+                    Archetype *archetype = new Archetype(Mask);
+
+                    archetypes.Insert(Mask, std::unique_ptr<Archetype>(archetype));
+                    archetypeList.push_back(archetype);
+
+                    return archetype;
+                };
+
+                Entity Reserve()
+                {
+                    std::uint32_t index;
+
+                    if (!freeIndices.empty())
+                    {
+                        index = freeIndices.back();
+                        freeIndices.pop_back();
+                    }
+                    else
+                    {
+                        index = static_cast<std::uint32_t>(records.size());
+                        records.push_back(Record{nullptr, 0, 0, 0});
+                    }
+
+                    entityCount++;
+                    return Entity(index, records[index].generation);
+                };
+
+                const Record &Place(const Entity &Target, Archetype *Table)
+                {
+                    Record &record = records[Target.index];
+
+                    record.archetype = Table;
+                    Table->Allocate(Target, record.chunk, record.row);
+
+                    return record;
+                };
+
+                void Release(const Record &Old)
+                {
+                    Entity moved = Old.archetype->Free(Old.chunk, Old.row);
+
+                    if (moved.IsValid())
+                    {
+                        records[moved.index].chunk = Old.chunk;
+                        records[moved.index].row = Old.row;
+                    }
+                };
+
+                // Moves the entity row to another archetype, carrying over shared components;
+                // components only present in the target are left for the caller to construct.
+                void Migrate(const Entity &Target, Archetype *Table)
+                {
+                    Record old = records[Target.index];
+                    const Record &record = Place(Target, Table);
+
+                    for (std::uint32_t id : Table->GetComponents())
+                    {
+                        if (old.archetype->Has(id))
+                            GetComponentInfo(id).move(Table->Get(record.chunk, record.row, id), old.archetype->Get(old.chunk, old.row, id));
+                    }
+
+                    Release(old);
+                };
+
+                std::size_t entityCount;
+                std::vector<Record> records;
+                std::vector<std::uint32_t> freeIndices;
+                Core::FlatHashMap<ComponentMask, std::unique_ptr<Archetype>> archetypes;
+                std::vector<Archetype *> archetypeList;
+        };
+    };
+};
+
+#endif // WARLOCK_ECS_WORLD_HPP
@@ -0,0 +1,517 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Geometry/BoundingVolume.hpp
+// Description: Axis aligned boxes, spheres and oriented boxes fitted to point streams.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_GEOMETRY_BOUNDINGVOLUME_HPP
+#define WARLOCK_GEOMETRY_BOUNDINGVOLUME_HPP
+
+#include "Core/ThreadPool.hpp"
+#include "Math/Matrix.hpp"
+#include "Math/Reduction.hpp"
+#include "Math/Simd.hpp"
+#include "Math/Vector3.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <utility>
+
+namespace Warlock
+{
+    namespace Geometry
+    {
+        // Empty when a minimum is above its maximum, as fitted to no points.
+        struct BoundingBox
+        {
+            Math::Vector3<float> minimum;
+            Math::Vector3<float> maximum;
+        };
+
+        struct BoundingSphere
+        {
+            Math::Vector3<float> center;
+            float radius;
+        };
+
+        // Orthonormal, right handed axes in decreasing order of spread, and the half size of
+        // the box along each.
+        struct OrientedBox
+        {
+            Math::Vector3<float> center;
+            Math::Vector3<float> axes[3];
+            Math::Vector3<float> extents;
+        };
+
+        // Directions searched for extreme points by ComputeBoundingSphere: the first 3 are
+        // the axes of Ritter's method, the first 7 add the diagonals of EPOS-14 and all 13 add
+        // the edge directions of EPOS-26. Only the signs matter, so no scale is applied.
+        constexpr int SphereDirections[13][3] =
+        {
+            {1, 0, 0}, {0, 1, 0}, {0, 0, 1},
+            {1, 1, 1}, {1, 1, -1}, {1, -1, 1}, {1, -1, -1},
+            {1, 1, 0}, {1, -1, 0}, {1, 0, 1}, {1, 0, -1}, {0, 1, 1}, {0, 1, -1}
+        };
+
+        namespace Detail
+        {
+            // Projection on SphereDirections[D] with adds and subtracts only.
+            template <std::size_t D> inline Math::SimdFloat Project(Math::SimdFloat x, Math::SimdFloat y, Math::SimdFloat z)
+            {
+                const Math::SimdFloat components[3] = {x, y, z};
+                Math::SimdFloat result = Math::SimdFloat::Zero();
+                bool started = false;
+
+                Math::Detail::Unroll<3>([&](auto C)
+                {
+                    if constexpr (SphereDirections[D][C] != 0)
+                    {
+                        if (!started)
+                            result = (SphereDirections[D][C] > 0 ? components[C] : -components[C]);
+                        else if (SphereDirections[D][C] > 0)
+                            result = result + components[C];
+                        else
+                            result = result - components[C];
+
+                        started = true;
+                    }
+                });
+
+                return result;
+            };
+
+            // Indices of the lowest and highest point along each direction.
+            template <std::size_t Directions> struct ExtremePoints
+            {
+                Math::Detail::ArgExtreme low[Directions];
+                Math::Detail::ArgExtreme high[Directions];
+            };
+
+            template <std::size_t Directions> inline ExtremePoints<Directions> GetNoExtremes()
+            {
+                ExtremePoints<Directions> result;
+
+                for (std::size_t d = 0; d < Directions; d++)
+                {
+                    result.low[d] = {std::numeric_limits<float>::infinity(), std::numeric_limits<std::size_t>::max()};
+                    result.high[d] = {-std::numeric_limits<float>::infinity(), std::numeric_limits<std::size_t>::max()};
+                }
+
+                return result;
+            };
+
+            template <std::size_t Directions> inline void Join(ExtremePoints<Directions> &Result, const ExtremePoints<Directions> &Other)
+            {
+                for (std::size_t d = 0; d < Directions; d++)
+                {
+                    Math::Detail::Join<false>(Result.low[d], Other.low[d]);
+                    Math::Detail::Join<true>(Result.high[d], Other.high[d]);
+                }
+            };
+
+            template <std::size_t Directions>
+            inline ExtremePoints<Directions> GetExtremePoints(const Math::ConstVector3Stream &Points, std::size_t First, std::size_t Last)
+            {
+                using namespace Math;
+
+                return Math::Detail::ReduceBlocks(First, Last, GetNoExtremes<Directions>(), [&](std::size_t BlockFirst, std::size_t BlockLast)
+                {
+                    SimdFloat low[Directions];
+                    SimdFloat high[Directions];
+                    SimdInt lowIndex[Directions];
+                    SimdInt highIndex[Directions];
+                    SimdInt index = SimdInt::Index();
+
+                    // Padding lanes repeat the first point of their register, which has a lower
+                    // index and so wins every tie.
+                    for (std::size_t d = 0; d < Directions; d++)
+                    {
+                        low[d] = SimdFloat(std::numeric_limits<float>::infinity());
+                        high[d] = SimdFloat(-std::numeric_limits<float>::infinity());
+                        lowIndex[d] = SimdInt::Zero();
+                        highIndex[d] = SimdInt::Zero();
+                    }
+
+                    for (std::size_t i = BlockFirst; i < BlockLast; i += WARLOCK_SIMD_WIDTH)
+                    {
+                        const SimdFloat x = Math::Detail::LoadLanes(Points.x + i, BlockLast - i, Points.x[i]);
+                        const SimdFloat y = Math::Detail::LoadLanes(Points.y + i, BlockLast - i, Points.y[i]);
+                        const SimdFloat z = Math::Detail::LoadLanes(Points.z + i, BlockLast - i, Points.z[i]);
+
+                        Math::Detail::Unroll<Directions>([&](auto D)
+                        {
+                            const SimdFloat projection = Project<D>(x, y, z);
+                            const SimdMask lower = projection < low[D];
+                            const SimdMask higher = projection > high[D];
+
+                            low[D] = Min(projection, low[D]);
+                            high[D] = Max(projection, high[D]);
+                            lowIndex[D] = Select(lower, index, lowIndex[D]);
+                            highIndex[D] = Select(higher, index, highIndex[D]);
+                        });
+
+                        index = index + SimdInt(WARLOCK_SIMD_WIDTH);
+                    }
+
+                    ExtremePoints<Directions> result = GetNoExtremes<Directions>();
+
+                    for (std::size_t d = 0; d < Directions; d++)
+                    {
+                        float values[2][WARLOCK_SIMD_WIDTH];
+                        std::int32_t indices[2][WARLOCK_SIMD_WIDTH];
+
+                        low[d].Store(values[0]);
+                        high[d].Store(values[1]);
+                        lowIndex[d].Store(indices[0]);
+                        highIndex[d].Store(indices[1]);
+
+                        for (std::size_t l = 0; l < WARLOCK_SIMD_WIDTH; l++)
+                        {
+                            Math::Detail::Join<false>(result.low[d], {values[0][l], BlockFirst + std::size_t(indices[0][l])});
+                            Math::Detail::Join<true>(result.high[d], {values[1][l], BlockFirst + std::size_t(indices[1][l])});
+                        }
+                    }
+
+                    return result;
+                }, Join<Directions>);
+            };
+
+            inline Math::Vector3<float> GetPoint(const Math::ConstVector3Stream &Points, std::size_t Index)
+            {
+                return Math::Vector3<float>(Points.x[Index], Points.y[Index], Points.z[Index]);
+            };
+
+            // Ritter's step: the smallest sphere holding Sphere and Point, if Point is outside.
+            inline void Grow(BoundingSphere &Sphere, const Math::Vector3<float> &Point)
+            {
+                const Math::Vector3<float> offset = Point - Sphere.center;
+                const float distanceSquared = offset.MagnitudeSquared();
+
+                if (distanceSquared <= Sphere.radius * Sphere.radius)
+                    return;
+
+                const float distance = std::sqrt(distanceSquared);
+                const float radius = 0.5f * (Sphere.radius + distance);
+
+                Sphere.center += offset * ((radius - Sphere.radius) / distance);
+                Sphere.radius = radius;
+            };
+
+            // The smallest sphere holding both.
+            inline void Join(BoundingSphere &Result, const BoundingSphere &Other)
+            {
+                const Math::Vector3<float> offset = Other.center - Result.center;
+                const float distance = offset.Magnitude();
+
+                if (distance + Other.radius <= Result.radius)
+                    return;
+
+                if (distance + Result.radius <= Other.radius)
+                {
+                    Result = Other;
+                    return;
+                }
+
+                const float radius = 0.5f * (distance + Result.radius + Other.radius);
+
+                Result.center += offset * ((radius - Result.radius) / distance);
+                Result.radius = radius;
+            };
+
+            // Grows Seed over [First, Last) in order. Whole registers inside the sphere, the
+            // common case once the seed spans the extremes, cost one test; the others grow
+            // lane by lane.
+            inline BoundingSphere GrowSphere(const Math::ConstVector3Stream &Points, std::size_t First, std::size_t Last, const BoundingSphere &Seed)
+            {
+                using namespace Math;
+
+                BoundingSphere sphere = Seed;
+                SimdFloat cx(sphere.center.x);
+                SimdFloat cy(sphere.center.y);
+                SimdFloat cz(sphere.center.z);
+                SimdFloat radiusSquared(sphere.radius * sphere.radius);
+
+                for (std::size_t i = First; i < Last; i += WARLOCK_SIMD_WIDTH)
+                {
+                    const std::size_t available = Last - i;
+                    const SimdFloat x = Math::Detail::LoadLanes(Points.x + i, available, Points.x[i]) - cx;
+                    const SimdFloat y = Math::Detail::LoadLanes(Points.y + i, available, Points.y[i]) - cy;
+                    const SimdFloat z = Math::Detail::LoadLanes(Points.z + i, available, Points.z[i]) - cz;
+
+                    if (None(MulAdd(x, x, MulAdd(y, y, z * z)) > radiusSquared))
+                        continue;
+
+                    const std::size_t lanes = (available < WARLOCK_SIMD_WIDTH ? available : WARLOCK_SIMD_WIDTH);
+
+                    for (std::size_t l = 0; l < lanes; l++)
+                        Grow(sphere, GetPoint(Points, i + l));
+
+                    cx = SimdFloat(sphere.center.x);
+                    cy = SimdFloat(sphere.center.y);
+                    cz = SimdFloat(sphere.center.z);
+                    radiusSquared = SimdFloat(sphere.radius * sphere.radius);
+                }
+
+                return sphere;
+            };
+
+            // Eigenvectors of a symmetric matrix by cyclic Jacobi rotations, as the columns of
+            // Vectors, with the eigenvalues in Values.
+            inline void GetEigenvectors(const Math::Matrix<3, 3, float> &Symmetric, double (&Vectors)[3][3], double (&Values)[3])
+            {
+                double a[3][3];
+
+                for (int r = 0; r < 3; r++)
+                {
+                    for (int c = 0; c < 3; c++)
+                    {
+                        a[r][c] = Symmetric(r, c);
+                        Vectors[r][c] = (r == c ? 1.0 : 0.0);
+                    }
+                }
+
+                for (int sweep = 0; sweep < 16; sweep++)
+                {
+                    const double off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+                    const double diagonal = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+
+                    if (off <= diagonal * 1.0e-30 || off == 0.0)
+                        break;
+
+                    for (int p = 0; p < 2; p++)
+                    {
+                        for (int q = p + 1; q < 3; q++)
+                        {
+                            if (a[p][q] == 0.0)
+                                continue;
+
+                            const double theta = (a[q][q] - a[p][p]) / (2.0 * a[p][q]);
+                            const double t = (theta >= 0.0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1.0));
+                            const double c = 1.0 / std::sqrt(t * t + 1.0);
+                            const double s = t * c;
+
+                            for (int k = 0; k < 3; k++)
+                            {
+                                const double kp = a[k][p];
+                                const double kq = a[k][q];
+                                a[k][p] = c * kp - s * kq;
+                                a[k][q] = s * kp + c * kq;
+                            }
+
+                            for (int k = 0; k < 3; k++)
+                            {
+                                const double pk = a[p][k];
+                                const double qk = a[q][k];
+                                a[p][k] = c * pk - s * qk;
+                                a[q][k] = s * pk + c * qk;
+                            }
+
+                            for (int k = 0; k < 3; k++)
+                            {
+                                const double kp = Vectors[k][p];
+                                const double kq = Vectors[k][q];
+                                Vectors[k][p] = c * kp - s * kq;
+                                Vectors[k][q] = s * kp + c * kq;
+                            }
+                        }
+                    }
+                }
+
+                for (int i = 0; i < 3; i++)
+                    Values[i] = a[i][i];
+            };
+
+            struct Extents
+            {
+                float minimum[3];
+                float maximum[3];
+            };
+
+            // Extents of the points relative to Origin along three axes.
+            inline Extents GetExtents(const Math::ConstVector3Stream &Points, std::size_t First, std::size_t Last, const Math::Vector3<float> &Origin,
+                                      const Math::Vector3<float> (&Axes)[3])
+            {
+                using namespace Math;
+
+                Math::Detail::Extremes bounds[3];
+                SimdFloat axes[3][3];
+
+                for (int a = 0; a < 3; a++)
+                {
+                    bounds[a] = {SimdFloat(std::numeric_limits<float>::infinity()), SimdFloat(-std::numeric_limits<float>::infinity())};
+                    axes[a][0] = SimdFloat(Axes[a].x);
+                    axes[a][1] = SimdFloat(Axes[a].y);
+                    axes[a][2] = SimdFloat(Axes[a].z);
+                }
+
+                for (std::size_t i = First; i < Last; i += WARLOCK_SIMD_WIDTH)
+                {
+                    const SimdFloat x = Math::Detail::LoadLanes(Points.x + i, Last - i, Points.x[i]) - SimdFloat(Origin.x);
+                    const SimdFloat y = Math::Detail::LoadLanes(Points.y + i, Last - i, Points.y[i]) - SimdFloat(Origin.y);
+                    const SimdFloat z = Math::Detail::LoadLanes(Points.z + i, Last - i, Points.z[i]) - SimdFloat(Origin.z);
+
+                    Math::Detail::Unroll<3>([&](auto A)
+                    {
+                        Math::Detail::Include(bounds[A], MulAdd(x, axes[A][0], MulAdd(y, axes[A][1], z * axes[A][2])));
+                    });
+                }
+
+                Extents result;
+
+                for (int a = 0; a < 3; a++)
+                {
+                    result.minimum[a] = ReduceMin(bounds[a].minimum);
+                    result.maximum[a] = ReduceMax(bounds[a].maximum);
+                }
+
+                return result;
+            };
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Fits over whole point streams, split across the thread pool. Each is a fixed number
+        // of SIMD passes over the stream with partial results joined in stream order, so the
+        // volumes are the same for any thread count.
+        //-----------------------------------------------------------------------------------------
+        inline BoundingBox ComputeBoundingBox(const Math::ConstVector3Stream &Points, std::size_t Count, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            BoundingBox box;
+            Math::MinMax(Points, Count, box.minimum, box.maximum, Pool);
+
+            return box;
+        };
+
+        // Two passes. The first finds the extreme points along the first Directions of
+        // SphereDirections: 3 gives Ritter's seed, 7 and 13 the extremal points of EPOS-14 and
+        // EPOS-26, which cost more arithmetic per point for a tighter seed. The sphere through
+        // the farthest apart pair is grown over the other extremes, then every chunk grows a
+        // copy over its points with Ritter's step and the copies are merged; the result holds
+        // all the points up to rounding. EPOS fits the exact sphere of the extremes instead of
+        // growing over them, which differs only in the seed. A zero sphere at the origin for
+        // no points.
+        template <std::size_t Directions = 7>
+        inline BoundingSphere ComputeBoundingSphere(const Math::ConstVector3Stream &Points, std::size_t Count, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            static_assert(Directions == 3 || Directions == 7 || Directions == 13, "Spheres are seeded from 3, 7 or 13 directions");
+
+            if (Count == 0)
+                return BoundingSphere{Math::Vector3<float>(), 0.0f};
+
+            const std::size_t chunk = Math::Detail::GetReductionChunk(Count, Math::ReductionOrder::Fast, Pool);
+            const Detail::ExtremePoints<Directions> extremes = Math::ParallelReduce(Count, chunk, Pool, Detail::GetNoExtremes<Directions>(), [&](std::size_t First, std::size_t Last)
+            {
+                return Detail::GetExtremePoints<Directions>(Points, First, Last);
+            }, Detail::Join<Directions>);
+
+            std::size_t widest = 0;
+            float widestSquared = -1.0f;
+
+            for (std::size_t d = 0; d < Directions; d++)
+            {
+                const float distanceSquared = (Detail::GetPoint(Points, extremes.high[d].index) - Detail::GetPoint(Points, extremes.low[d].index)).MagnitudeSquared();
+
+                if (distanceSquared > widestSquared)
+                {
+                    widest = d;
+                    widestSquared = distanceSquared;
+                }
+            }
+
+            const Math::Vector3<float> low = Detail::GetPoint(Points, extremes.low[widest].index);
+            const Math::Vector3<float> high = Detail::GetPoint(Points, extremes.high[widest].index);
+            BoundingSphere seed{(low + high) * 0.5f, 0.5f * std::sqrt(widestSquared)};
+
+            for (std::size_t d = 0; d < Directions; d++)
+            {
+                Detail::Grow(seed, Detail::GetPoint(Points, extremes.low[d].index));
+                Detail::Grow(seed, Detail::GetPoint(Points, extremes.high[d].index));
+            }
+
+            // Growth depends on the order within a chunk, so its chunks never follow the pool.
+            return Math::ParallelReduce(Count, Math::ReductionChunkSize, Pool, seed, [&](std::size_t First, std::size_t Last)
+            {
+                return Detail::GrowSphere(Points, First, Last, seed);
+            }, [](BoundingSphere &Result, const BoundingSphere &Other) { Detail::Join(Result, Other); });
+        };
+
+        // Principal component box: the axes are the eigenvectors of the covariance of the
+        // points, and a second pass takes the extents along them. Tight for elongated point
+        // sets; like every PCA fit it can be loose when the spread is nearly isotropic. A
+        // zero box on the world axes for no points.
+        inline OrientedBox ComputeOrientedBox(const Math::ConstVector3Stream &Points, std::size_t Count, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            using Math::Vector3;
+
+            OrientedBox box;
+            box.axes[0] = Vector3<float>(1.0f, 0.0f, 0.0f);
+            box.axes[1] = Vector3<float>(0.0f, 1.0f, 0.0f);
+            box.axes[2] = Vector3<float>(0.0f, 0.0f, 1.0f);
+
+            if (Count == 0)
+                return box;
+
+            Vector3<float> mean;
+            const Math::Matrix<3, 3, float> covariance = Math::Covariance(Points, Count, mean, Math::ReductionOrder::Deterministic, Pool);
+
+            double vectors[3][3];
+            double values[3];
+            Detail::GetEigenvectors(covariance, vectors, values);
+
+            int order[3] = {0, 1, 2};
+
+            for (int i = 1; i < 3; i++)
+            {
+                for (int j = i; j > 0 && values[order[j]] > values[order[j - 1]]; j--)
+                    std::swap(order[j], order[j - 1]);
+            }
+
+            for (int a = 0; a < 2; a++)
+            {
+                const int column = order[a];
+                box.axes[a] = Vector3<float>(static_cast<float>(vectors[0][column]), static_cast<float>(vectors[1][column]), static_cast<float>(vectors[2][column])).GetNormalized();
+            }
+
+            box.axes[2] = Math::VectorProduct(box.axes[0], box.axes[1]);
+
+            const Detail::Extents identity{{std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity(), std::numeric_limits<float>::infinity()},
+                                           {-std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()}};
+
+            const Detail::Extents extents = Math::ParallelReduce(Count, Math::Detail::GetReductionChunk(Count, Math::ReductionOrder::Fast, Pool), Pool, identity,
+                                                                 [&](std::size_t First, std::size_t Last) { return Detail::GetExtents(Points, First, Last, mean, box.axes); },
+                                                                 [](Detail::Extents &Result, const Detail::Extents &Other)
+            {
+                for (int a = 0; a < 3; a++)
+                {
+                    Result.minimum[a] = (Other.minimum[a] < Result.minimum[a] ? Other.minimum[a] : Result.minimum[a]);
+                    Result.maximum[a] = (Other.maximum[a] > Result.maximum[a] ? Other.maximum[a] : Result.maximum[a]);
+                }
+            });
+
+            box.center = mean;
+
+            for (int a = 0; a < 3; a++)
+            {
+                box.center += box.axes[a] * (0.5f * (extents.minimum[a] + extents.maximum[a]));
+                box.extents[a] = 0.5f * (extents.maximum[a] - extents.minimum[a]);
+            }
+
+            return box;
+        };
+    };
+};
+
+#endif // WARLOCK_GEOMETRY_BOUNDINGVOLUME_HPP
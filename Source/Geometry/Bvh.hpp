@@ -0,0 +1,510 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Geometry/Bvh.hpp
+// Description: Class to implement a bounding volume hierarchy over static triangle meshes.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_GEOMETRY_BVH_HPP
+#define WARLOCK_GEOMETRY_BVH_HPP
+
+#include "Ray.hpp"
+#include <algorithm>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Geometry
+    {
+        // Nodes are laid out depth first: the left child of an inner node follows it and the
+        // right child is at index first. Leaves reference count triangles starting at first.
+        struct BvhNode
+        {
+            bool IsLeaf() const
+            {
+                return (count != 0);
+            };
+
+            float minimum[3];
+            std::uint32_t first;
+            float maximum[3];
+            std::uint16_t count;
+            std::uint16_t axis;
+        };
+
+        class Bvh
+        {
+            public:
+                static constexpr std::size_t LeafSize = 4;
+                static constexpr std::size_t BinCount = 16;
+                static constexpr int StackSize = 128;
+
+                // Below this depth nodes split at the centroid median instead of by area, which
+                // halves them each level; trees then stay under 64 + 32 levels, and a traversal
+                // stack never holds more than one entry per level plus one.
+                static constexpr std::size_t MedianDepth = StackSize / 2;
+
+                // Builds the hierarchy with binned surface area heuristic splits over an indexed
+                // triangle mesh. Hit primitives report the triangle index in the original mesh.
+                void Build(const Math::Vector3<float> *Vertices, const std::uint32_t *Indices, std::size_t TriangleCount)
+                {
+                    std::vector<BuildItem> items(TriangleCount);
+
+                    nodes.clear();
+                    nodes.reserve(TriangleCount > 0 ? 2 * TriangleCount / LeafSize + 1 : 1);
+                    triangles.resize(TriangleCount);
+                    primitives.resize(TriangleCount);
+
+                    for (std::size_t i = 0; i < TriangleCount; i++)
+                    {
+                        const Math::Vector3<float> &a = Vertices[Indices[3 * i + 0]];
+                        const Math::Vector3<float> &b = Vertices[Indices[3 * i + 1]];
+                        const Math::Vector3<float> &c = Vertices[Indices[3 * i + 2]];
+                        BuildItem &item = items[i];
+
+                        item.minimum[0] = std::min(a.x, std::min(b.x, c.x));
+                        item.minimum[1] = std::min(a.y, std::min(b.y, c.y));
+                        item.minimum[2] = std::min(a.z, std::min(b.z, c.z));
+                        item.maximum[0] = std::max(a.x, std::max(b.x, c.x));
+                        item.maximum[1] = std::max(a.y, std::max(b.y, c.y));
+                        item.maximum[2] = std::max(a.z, std::max(b.z, c.z));
+
+                        for (int k = 0; k < 3; k++)
+                            item.centroid[k] = 0.5f * (item.minimum[k] + item.maximum[k]);
+
+                        item.index = static_cast<std::uint32_t>(i);
+                    }
+
+                    if (TriangleCount > 0)
+                        BuildNode(items, 0, TriangleCount, 0);
+
+                    for (std::size_t i = 0; i < TriangleCount; i++)
+                    {
+                        std::uint32_t t = items[i].index;
+
+                        primitives[i] = t;
+                        triangles[i] = Triangle(Vertices[Indices[3 * t + 0]], Vertices[Indices[3 * t + 1]], Vertices[Indices[3 * t + 2]]);
+                    }
+                };
+
+                const std::vector<BvhNode> &GetNodes() const
+                {
+                    return nodes;
+                };
+
+                //-------------------------------------------------------------------------------------
+                // Single ray traversal
+                //-------------------------------------------------------------------------------------
+                bool Intersect(const Ray &Value, RayHit &Hit) const
+                {
+                    return Traverse<false>(Value, Hit);
+                };
+
+                bool Occluded(const Ray &Value) const
+                {
+                    RayHit hit;
+
+                    return Traverse<true>(Value, hit);
+                };
+
+                //-------------------------------------------------------------------------------------
+                // Packet traversal; coherent packets walk the tree once for all rays, the others
+                // fall back to one traversal per ray.
+                //-------------------------------------------------------------------------------------
+                template <int N> void Intersect(const RayPacket<N> &Packet, RayPacketHit<N> &Hit) const
+                {
+                    if (Packet.IsCoherent())
+                    {
+                        TraversePacket<N, false>(Packet, Hit);
+                        return;
+                    }
+
+                    for (int i = 0; i < N; i++)
+                    {
+                        if (!Packet.IsActive(i))
+                            continue;
+
+                        RayHit hit = Hit.Get(i);
+                        Traverse<false>(Packet.Get(i), hit);
+
+                        Hit.distance[i] = hit.distance;
+                        Hit.u[i] = hit.u;
+                        Hit.v[i] = hit.v;
+                        Hit.primitive[i] = hit.primitive;
+                    }
+                };
+
+                template <int N> void Occluded(const RayPacket<N> &Packet, bool Result[N]) const
+                {
+                    if (Packet.IsCoherent())
+                    {
+                        RayPacketHit<N> hit;
+                        TraversePacket<N, true>(Packet, hit);
+
+                        for (int i = 0; i < N; i++)
+                            Result[i] = (hit.primitive[i] != InvalidPrimitive);
+
+                        return;
+                    }
+
+                    for (int i = 0; i < N; i++)
+                        Result[i] = (Packet.IsActive(i) && Occluded(Packet.Get(i)));
+                };
+
+            private:
+                struct BuildItem
+                {
+                    float minimum[3];
+                    float maximum[3];
+                    float centroid[3];
+                    std::uint32_t index;
+                };
+
+                struct Bin
+                {
+                    Bin() : count(0)
+                    {
+                        for (int k = 0; k < 3; k++)
+                        {
+                            minimum[k] = RayInfinity;
+                            maximum[k] = -RayInfinity;
+                        }
+                    };
+
+                    void Grow(const float Minimum[3], const float Maximum[3])
+                    {
+                        for (int k = 0; k < 3; k++)
+                        {
+                            minimum[k] = std::min(minimum[k], Minimum[k]);
+                            maximum[k] = std::max(maximum[k], Maximum[k]);
+                        }
+                    };
+
+                    float Area() const
+                    {
+                        float dx = maximum[0] - minimum[0];
+                        float dy = maximum[1] - minimum[1];
+                        float dz = maximum[2] - minimum[2];
+
+                        return (count ? dx * dy + dy * dz + dz * dx : 0.0f);
+                    };
+
+                    float minimum[3];
+                    float maximum[3];
+                    std::size_t count;
+                };
+
+                std::uint32_t BuildNode(std::vector<BuildItem> &Items, std::size_t First, std::size_t Count, std::size_t Depth)
+                {
+                    std::uint32_t index = static_cast<std::uint32_t>(nodes.size());
+                    Bin bounds, centroids;
+
+                    nodes.emplace_back();
+
+                    for (std::size_t i = First; i < First + Count; i++)
+                    {
+                        bounds.Grow(Items[i].minimum, Items[i].maximum);
+                        centroids.Grow(Items[i].centroid, Items[i].centroid);
+                    }
+
+                    for (int k = 0; k < 3; k++)
+                    {
+                        nodes[index].minimum[k] = bounds.minimum[k];
+                        nodes[index].maximum[k] = bounds.maximum[k];
+                    }
+
+                    int axis = -1;
+                    std::size_t split = 0;
+
+                    if (Count > LeafSize && Depth < MedianDepth)
+                    {
+                        float best = RayInfinity;
+
+                        for (int k = 0; k < 3; k++)
+                        {
+                            float extent = centroids.maximum[k] - centroids.minimum[k];
+
+                            if (extent <= 0.0f)
+                                continue;
+
+                            Bin bins[BinCount];
+                            float scale = BinCount / extent;
+
+                            for (std::size_t i = First; i < First + Count; i++)
+                            {
+                                Bin &bin = bins[BinIndex(Items[i].centroid[k], centroids.minimum[k], scale)];
+                                bin.Grow(Items[i].minimum, Items[i].maximum);
+                                bin.count++;
+                            }
+
+                            float rightCost[BinCount];
+                            Bin right;
+
+                            for (std::size_t b = BinCount - 1; b > 0; b--)
+                            {
+                                right.Grow(bins[b].minimum, bins[b].maximum);
+                                right.count += bins[b].count;
+                                rightCost[b] = right.Area() * right.count;
+                            }
+
+                            Bin left;
+
+                            for (std::size_t b = 0; b < BinCount - 1; b++)
+                            {
+                                left.Grow(bins[b].minimum, bins[b].maximum);
+                                left.count += bins[b].count;
+
+                                float cost = left.Area() * left.count + rightCost[b + 1];
+
+                                if (left.count > 0 && left.count < Count && cost < best)
+                                {
+                                    best = cost;
+                                    axis = k;
+                                    split = b + 1;
+                                }
+                            }
+                        }
+                    }
+
+                    std::size_t middle = First;
+
+                    if (axis >= 0)
+                    {
+                        float scale = BinCount / (centroids.maximum[axis] - centroids.minimum[axis]);
+                        float origin = centroids.minimum[axis];
+
+                        middle = std::partition(Items.begin() + First, Items.begin() + First + Count, [&](const BuildItem &Item)
+                        {
+                            return BinIndex(Item.centroid[axis], origin, scale) < split;
+                        }) - Items.begin();
+                    }
+                    else if (Count > 0xFFFF || (Count > LeafSize && Depth >= MedianDepth))
+                    {
+                        axis = 0;
+
+                        for (int k = 1; k < 3; k++)
+                        {
+                            if (centroids.maximum[k] - centroids.minimum[k] > centroids.maximum[axis] - centroids.minimum[axis])
+                                axis = k;
+                        }
+
+                        middle = First + Count / 2;
+
+                        std::nth_element(Items.begin() + First, Items.begin() + middle, Items.begin() + First + Count, [&](const BuildItem &Left, const BuildItem &Right)
+                        {
+                            return Left.centroid[axis] < Right.centroid[axis];
+                        });
+                    }
+
+                    if (axis < 0)
+                    {
+                        nodes[index].first = static_cast<std::uint32_t>(First);
+                        nodes[index].count = static_cast<std::uint16_t>(Count);
+                        nodes[index].axis = 0;
+
+                        return index;
+                    }
+
+                    BuildNode(Items, First, middle - First, Depth + 1);
+                    std::uint32_t right = BuildNode(Items, middle, First + Count - middle, Depth + 1);
+
+                    nodes[index].first = right;
+                    nodes[index].count = 0;
+                    nodes[index].axis = static_cast<std::uint16_t>(axis);
+
+                    return index;
+                };
+
+                static std::size_t BinIndex(float Centroid, float Origin, float Scale)
+                {
+                    std::size_t bin = static_cast<std::size_t>((Centroid - Origin) * Scale);
+
+                    return (bin < BinCount ? bin : BinCount - 1);
+                };
+
+                template <bool AnyHit> bool Traverse(const Ray &Value, RayHit &Hit) const
+                {
+                    if (nodes.empty())
+                        return false;
+
+                    const float direction[3] = {Value.direction.x, Value.direction.y, Value.direction.z};
+                    std::uint32_t stack[StackSize];
+                    int top = 0;
+                    float distance = std::min(Value.maximum, Hit.distance);
+                    bool found = false;
+
+                    stack[top++] = 0;
+
+                    while (top > 0)
+                    {
+                        const BvhNode &node = nodes[stack[--top]];
+                        float tnear;
+
+                        if (!IntersectBox(Value, node.minimum, node.maximum, distance, tnear))
+                            continue;
+
+                        if (node.IsLeaf())
+                        {
+                            for (std::uint32_t i = node.first; i < node.first + node.count; i++)
+                            {
+                                if (IntersectTriangle(Value, triangles[i], distance, Hit))
+                                {
+                                    distance = Hit.distance;
+                                    Hit.primitive = primitives[i];
+                                    found = true;
+
+                                    if (AnyHit)
+                                        return true;
+                                }
+                            }
+
+                            continue;
+                        }
+
+                        std::uint32_t left = static_cast<std::uint32_t>(&node - nodes.data()) + 1;
+                        std::uint32_t right = node.first;
+
+                        if (direction[node.axis] < 0.0f)
+                            std::swap(left, right);
+
+                        assert(top + 2 <= StackSize);
+
+                        stack[top++] = right;
+                        stack[top++] = left;
+                    }
+
+                    return found;
+                };
+
+                template <int N, bool AnyHit> void TraversePacket(const RayPacket<N> &Packet, RayPacketHit<N> &Hit) const
+                {
+                    using namespace Math;
+
+                    constexpr int R = RayPacket<N>::Registers;
+
+                    if (nodes.empty())
+                        return;
+
+                    int lead = 0;
+
+                    while (lead < N - 1 && !Packet.IsActive(lead))
+                        lead++;
+
+                    const float direction[3] = {Packet.directionX[lead], Packet.directionY[lead], Packet.directionZ[lead]};
+                    SimdFloat far[R];
+                    SimdFloat u[R];
+                    SimdFloat v[R];
+                    SimdInt primitive[R];
+                    SimdMask found[R];
+                    std::uint32_t stack[StackSize];
+                    int top = 0;
+
+                    for (int r = 0; r < R; r++)
+                    {
+                        far[r] = Min(SimdFloat::LoadAligned(Packet.maximum + r * WARLOCK_SIMD_WIDTH), SimdFloat::LoadAligned(Hit.distance + r * WARLOCK_SIMD_WIDTH));
+                        u[r] = SimdFloat::Zero();
+                        v[r] = SimdFloat::Zero();
+                        primitive[r] = SimdInt::Load(Hit.primitive + r * WARLOCK_SIMD_WIDTH);
+                        found[r] = (u[r] < u[r]);
+                    }
+
+                    stack[top++] = 0;
+
+                    while (top > 0)
+                    {
+                        const BvhNode &node = nodes[stack[--top]];
+                        bool entered = false;
+
+                        for (int r = 0; r < R && !entered; r++)
+                            entered = Any(IntersectBox(Packet, r, node.minimum, node.maximum, far[r]));
+
+                        if (!entered)
+                            continue;
+
+                        if (node.IsLeaf())
+                        {
+                            bool done = AnyHit;
+
+                            for (std::uint32_t i = node.first; i < node.first + node.count; i++)
+                            {
+                                const SimdInt id(static_cast<std::int32_t>(primitives[i]));
+
+                                for (int r = 0; r < R; r++)
+                                {
+                                    SimdFloat t, hu, hv;
+                                    SimdMask hit = IntersectTriangle(Packet, r, triangles[i], far[r], t, hu, hv);
+
+                                    far[r] = Select(hit, AnyHit ? SimdFloat(-RayInfinity) : t, far[r]);
+                                    u[r] = Select(hit, hu, u[r]);
+                                    v[r] = Select(hit, hv, v[r]);
+                                    primitive[r] = Select(hit, id, primitive[r]);
+                                    found[r] = found[r] | hit;
+                                }
+                            }
+
+                            if (AnyHit)
+                            {
+                                for (int r = 0; r < R && done; r++)
+                                {
+                                    SimdMask active = (SimdFloat::LoadAligned(Packet.minimum + r * WARLOCK_SIMD_WIDTH) <= far[r]);
+                                    done = None(active);
+                                }
+
+                                if (done)
+                                    break;
+                            }
+
+                            continue;
+                        }
+
+                        std::uint32_t left = static_cast<std::uint32_t>(&node - nodes.data()) + 1;
+                        std::uint32_t right = node.first;
+
+                        if (direction[node.axis] < 0.0f)
+                            std::swap(left, right);
+
+                        assert(top + 2 <= StackSize);
+
+                        stack[top++] = right;
+                        stack[top++] = left;
+                    }
+
+                    for (int r = 0; r < R; r++)
+                    {
+                        const int o = r * WARLOCK_SIMD_WIDTH;
+                        SimdMask hit = found[r];
+
+                        if (!AnyHit)
+                        {
+                            Select(hit, far[r], SimdFloat::LoadAligned(Hit.distance + o)).StoreAligned(Hit.distance + o);
+                            Select(hit, u[r], SimdFloat::LoadAligned(Hit.u + o)).StoreAligned(Hit.u + o);
+                            Select(hit, v[r], SimdFloat::LoadAligned(Hit.v + o)).StoreAligned(Hit.v + o);
+                        }
+
+                        primitive[r].Store(Hit.primitive + o);
+                    }
+                };
+
+                std::vector<BvhNode> nodes;
+                std::vector<Triangle> triangles;
+                std::vector<std::uint32_t> primitives;
+        };
+    };
+};
+
+#endif // WARLOCK_GEOMETRY_BVH_HPP
@@ -0,0 +1,291 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Geometry/Culling.hpp
+// Description: Batched frustum culling of sphere and box streams into visible index lists.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_GEOMETRY_CULLING_HPP
+#define WARLOCK_GEOMETRY_CULLING_HPP
+
+#include "Frustum.hpp"
+#include "Core/ThreadPool.hpp"
+#include "Math/Simd.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Geometry
+    {
+        struct SphereStream
+        {
+            const float *x;
+            const float *y;
+            const float *z;
+            const float *radius;
+        };
+
+        struct BoxStream
+        {
+            const float *minimumX;
+            const float *minimumY;
+            const float *minimumZ;
+            const float *maximumX;
+            const float *maximumY;
+            const float *maximumZ;
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Single threaded kernels; Visible must hold (Last - First) indices and receives the
+        // indices of the elements in [First, Last) that are not outside any plane of PlaneMask.
+        // The number of visible elements is returned.
+        //-----------------------------------------------------------------------------------------
+        inline std::size_t CullSpheres(const Frustum &View, const SphereStream &Spheres, std::size_t First, std::size_t Last,
+                                       std::uint32_t *Visible, unsigned int PlaneMask = Frustum::AllPlanes)
+        {
+            using namespace Math;
+
+            int planes[6];
+            int active = 0;
+            std::size_t count = 0;
+            std::size_t i = First;
+
+            for (int p = 0; p < 6; p++)
+            {
+                if (PlaneMask & (1u << p))
+                    planes[active++] = p;
+            }
+
+            if (active == 0)
+            {
+                for (; i < Last; i++)
+                    Visible[count++] = static_cast<std::uint32_t>(i);
+
+                return count;
+            }
+
+            for (; i + WARLOCK_SIMD_WIDTH <= Last; i += WARLOCK_SIMD_WIDTH)
+            {
+                SimdFloat x = SimdFloat::Load(Spheres.x + i);
+                SimdFloat y = SimdFloat::Load(Spheres.y + i);
+                SimdFloat z = SimdFloat::Load(Spheres.z + i);
+                SimdFloat radius = -SimdFloat::Load(Spheres.radius + i);
+                SimdMask inside = (radius == radius);
+
+                for (int p = 0; p < active && Any(inside); p++)
+                {
+                    int k = planes[p];
+                    SimdFloat distance = MulAdd(SimdFloat(View.nx[k]), x, MulAdd(SimdFloat(View.ny[k]), y, MulAdd(SimdFloat(View.nz[k]), z, SimdFloat(View.d[k]))));
+
+                    inside = inside & (distance >= radius);
+                }
+
+                count += CompressStore(SimdInt(static_cast<std::int32_t>(i)) + SimdInt::Index(), inside.Bits(), Visible + count);
+            }
+
+            for (; i < Last; i++)
+            {
+                bool inside = true;
+
+                for (int p = 0; p < active && inside; p++)
+                {
+                    int k = planes[p];
+                    inside = (View.nx[k] * Spheres.x[i] + View.ny[k] * Spheres.y[i] + View.nz[k] * Spheres.z[i] + View.d[k] >= -Spheres.radius[i]);
+                }
+
+                Visible[count] = static_cast<std::uint32_t>(i);
+                count += (inside ? 1 : 0);
+            }
+
+            return count;
+        };
+
+        // Boxes are tested with the corner farthest along each plane normal; since the normal of
+        // a plane is the same for every box, the corner is chosen once per plane and not per lane.
+        inline std::size_t CullBoxes(const Frustum &View, const BoxStream &Boxes, std::size_t First, std::size_t Last,
+                                     std::uint32_t *Visible, unsigned int PlaneMask = Frustum::AllPlanes)
+        {
+            using namespace Math;
+
+            const float *cornerX[6];
+            const float *cornerY[6];
+            const float *cornerZ[6];
+            int planes[6];
+            int active = 0;
+            std::size_t count = 0;
+            std::size_t i = First;
+
+            for (int p = 0; p < 6; p++)
+            {
+                if (!(PlaneMask & (1u << p)))
+                    continue;
+
+                cornerX[active] = (View.nx[p] >= 0.0f ? Boxes.maximumX : Boxes.minimumX);
+                cornerY[active] = (View.ny[p] >= 0.0f ? Boxes.maximumY : Boxes.minimumY);
+                cornerZ[active] = (View.nz[p] >= 0.0f ? Boxes.maximumZ : Boxes.minimumZ);
+                planes[active++] = p;
+            }
+
+            for (; i + WARLOCK_SIMD_WIDTH <= Last; i += WARLOCK_SIMD_WIDTH)
+            {
+                SimdMask inside = (SimdFloat::Zero() == SimdFloat::Zero());
+
+                for (int p = 0; p < active && Any(inside); p++)
+                {
+                    int k = planes[p];
+                    SimdFloat distance = MulAdd(SimdFloat(View.nx[k]), SimdFloat::Load(cornerX[p] + i),
+                                         MulAdd(SimdFloat(View.ny[k]), SimdFloat::Load(cornerY[p] + i),
+                                         MulAdd(SimdFloat(View.nz[k]), SimdFloat::Load(cornerZ[p] + i), SimdFloat(View.d[k]))));
+
+                    inside = inside & (distance >= SimdFloat::Zero());
+                }
+
+                count += CompressStore(SimdInt(static_cast<std::int32_t>(i)) + SimdInt::Index(), inside.Bits(), Visible + count);
+            }
+
+            for (; i < Last; i++)
+            {
+                bool inside = true;
+
+                for (int p = 0; p < active && inside; p++)
+                {
+                    int k = planes[p];
+                    inside = (View.nx[k] * cornerX[p][i] + View.ny[k] * cornerY[p][i] + View.nz[k] * cornerZ[p][i] + View.d[k] >= 0.0f);
+                }
+
+                Visible[count] = static_cast<std::uint32_t>(i);
+                count += (inside ? 1 : 0);
+            }
+
+            return count;
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Multithreaded kernels; each chunk compacts into its own slice of Visible and the slices
+        // are then packed in input order, so the result matches the single threaded kernels.
+        //-----------------------------------------------------------------------------------------
+        static constexpr std::size_t CullingChunkSize = 16384;
+
+        template <typename Kernel> std::size_t CullParallel(Kernel &&Cull, std::size_t Count, std::uint32_t *Visible, Core::ThreadPool &Pool)
+        {
+            const std::size_t chunks = (Count + CullingChunkSize - 1) / CullingChunkSize;
+            std::vector<std::size_t> counts(chunks);
+
+            Pool.ParallelFor(0, chunks, 1, [&](std::size_t FirstChunk, std::size_t LastChunk)
+            {
+                for (std::size_t c = FirstChunk; c < LastChunk; c++)
+                {
+                    std::size_t first = c * CullingChunkSize;
+                    std::size_t last = (first + CullingChunkSize < Count ? first + CullingChunkSize : Count);
+
+                    counts[c] = Cull(first, last, Visible + first);
+                }
+            });
+
+            std::size_t total = (chunks ? counts[0] : 0);
+
+            for (std::size_t c = 1; c < chunks; c++)
+            {
+                std::memmove(Visible + total, Visible + c * CullingChunkSize, counts[c] * sizeof(std::uint32_t));
+                total += counts[c];
+            }
+
+            return total;
+        };
+
+        inline std::size_t CullSpheres(const Frustum &View, const SphereStream &Spheres, std::size_t Count, std::uint32_t *Visible,
+                                       Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            return CullParallel([&](std::size_t First, std::size_t Last, std::uint32_t *Output)
+            {
+                return CullSpheres(View, Spheres, First, Last, Output);
+            }, Count, Visible, Pool);
+        };
+
+        inline std::size_t CullBoxes(const Frustum &View, const BoxStream &Boxes, std::size_t Count, std::uint32_t *Visible,
+                                     Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            return CullParallel([&](std::size_t First, std::size_t Last, std::uint32_t *Output)
+            {
+                return CullBoxes(View, Boxes, First, Last, Output);
+            }, Count, Visible, Pool);
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Hierarchical culling over cells owning contiguous element ranges, such as the cells of
+        // a Morton sorted stream. Cells fully inside emit their whole range without per element
+        // tests, crossing cells only test the planes their bounds crossed.
+        //-----------------------------------------------------------------------------------------
+        struct CullCell
+        {
+            Math::Vector3<float> minimum;
+            Math::Vector3<float> maximum;
+            std::uint32_t first;
+            std::uint32_t count;
+        };
+
+        template <typename Kernel> std::size_t CullCells(const Frustum &View, const CullCell *Cells, std::size_t CellCount,
+                                                         Kernel &&Cull, std::uint32_t *Visible)
+        {
+            std::size_t count = 0;
+
+            for (std::size_t c = 0; c < CellCount; c++)
+            {
+                unsigned int mask = Frustum::AllPlanes;
+                const CullCell &cell = Cells[c];
+
+                switch (View.Classify(cell.minimum, cell.maximum, mask))
+                {
+                    case CullResult::Outside:
+                        break;
+
+                    case CullResult::Inside:
+                        for (std::uint32_t i = 0; i < cell.count; i++)
+                            Visible[count++] = cell.first + i;
+                        break;
+
+                    case CullResult::Intersecting:
+                        count += Cull(static_cast<std::size_t>(cell.first), static_cast<std::size_t>(cell.first) + cell.count, Visible + count, mask);
+                        break;
+                };
+            }
+
+            return count;
+        };
+
+        inline std::size_t CullSphereCells(const Frustum &View, const SphereStream &Spheres, const CullCell *Cells, std::size_t CellCount,
+                                           std::uint32_t *Visible)
+        {
+            return CullCells(View, Cells, CellCount, [&](std::size_t First, std::size_t Last, std::uint32_t *Output, unsigned int Mask)
+            {
+                return CullSpheres(View, Spheres, First, Last, Output, Mask);
+            }, Visible);
+        };
+
+        inline std::size_t CullBoxCells(const Frustum &View, const BoxStream &Boxes, const CullCell *Cells, std::size_t CellCount,
+                                        std::uint32_t *Visible)
+        {
+            return CullCells(View, Cells, CellCount, [&](std::size_t First, std::size_t Last, std::uint32_t *Output, unsigned int Mask)
+            {
+                return CullBoxes(View, Boxes, First, Last, Output, Mask);
+            }, Visible);
+        };
+    };
+};
+
+#endif // WARLOCK_GEOMETRY_CULLING_HPP
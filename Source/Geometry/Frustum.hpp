@@ -0,0 +1,158 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Geometry/Frustum.hpp
+// Description: Class to implement a six plane view frustum.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_GEOMETRY_FRUSTUM_HPP
+#define WARLOCK_GEOMETRY_FRUSTUM_HPP
+
+#include "Math/Vector3.hpp"
+#include <cmath>
+
+namespace Warlock
+{
+    namespace Geometry
+    {
+        enum class CullResult
+        {
+            Outside,
+            Intersecting,
+            Inside
+        };
+
+        // Planes are stored as structure of arrays with inward facing unit normals, so a point p
+        // lies inside plane i when nx[i] * p.x + ny[i] * p.y + nz[i] * p.z + d[i] >= 0.
+        struct Frustum
+        {
+            static constexpr unsigned int AllPlanes = 0x3F;
+
+            Frustum()
+            {
+                for (int i = 0; i < 6; i++)
+                {
+                    nx[i] = 0.0f;
+                    ny[i] = 0.0f;
+                    nz[i] = 0.0f;
+                    d[i] = 0.0f;
+                }
+            };
+
+            // Extracts the planes of a row major view-projection matrix (clip = Matrix * point).
+            // ZeroToOne selects a [0, w] clip depth range instead of [-w, w].
+            Frustum(const float Matrix[16], bool ZeroToOne = false)
+            {
+                const float *r0 = Matrix;
+                const float *r1 = Matrix + 4;
+                const float *r2 = Matrix + 8;
+                const float *r3 = Matrix + 12;
+
+                SetPlane(0, r3[0] + r0[0], r3[1] + r0[1], r3[2] + r0[2], r3[3] + r0[3]);
+                SetPlane(1, r3[0] - r0[0], r3[1] - r0[1], r3[2] - r0[2], r3[3] - r0[3]);
+                SetPlane(2, r3[0] + r1[0], r3[1] + r1[1], r3[2] + r1[2], r3[3] + r1[3]);
+                SetPlane(3, r3[0] - r1[0], r3[1] - r1[1], r3[2] - r1[2], r3[3] - r1[3]);
+
+                if (ZeroToOne)
+                    SetPlane(4, r2[0], r2[1], r2[2], r2[3]);
+                else
+                    SetPlane(4, r3[0] + r2[0], r3[1] + r2[1], r3[2] + r2[2], r3[3] + r2[3]);
+
+                SetPlane(5, r3[0] - r2[0], r3[1] - r2[1], r3[2] - r2[2], r3[3] - r2[3]);
+            };
+
+            void SetPlane(int Index, float a, float b, float c, float Distance)
+            {
+                float length = std::sqrt(a * a + b * b + c * c);
+                float inverse = (length > 0.0f ? 1.0f / length : 0.0f);
+
+                nx[Index] = a * inverse;
+                ny[Index] = b * inverse;
+                nz[Index] = c * inverse;
+                d[Index] = Distance * inverse;
+            };
+
+            void SetPlane(int Index, const Math::Vector3<float> &Normal, float Distance)
+            {
+                SetPlane(Index, Normal.x, Normal.y, Normal.z, Distance);
+            };
+
+            bool Contains(const Math::Vector3<float> &Point) const
+            {
+                for (int i = 0; i < 6; i++)
+                {
+                    if (nx[i] * Point.x + ny[i] * Point.y + nz[i] * Point.z + d[i] < 0.0f)
+                        return false;
+                }
+
+                return true;
+            };
+
+            // Classifies a sphere against the planes set in PlaneMask and clears the bits of the
+            // planes it lies completely inside, so children of a bounding volume hierarchy only
+            // test the planes their parent crossed.
+            CullResult Classify(const Math::Vector3<float> &Centre, float Radius, unsigned int &PlaneMask) const
+            {
+                for (int i = 0; i < 6; i++)
+                {
+                    if (!(PlaneMask & (1u << i)))
+                        continue;
+
+                    float distance = nx[i] * Centre.x + ny[i] * Centre.y + nz[i] * Centre.z + d[i];
+
+                    if (distance < -Radius)
+                        return CullResult::Outside;
+
+                    if (distance >= Radius)
+                        PlaneMask &= ~(1u << i);
+                }
+
+                return (PlaneMask ? CullResult::Intersecting : CullResult::Inside);
+            };
+
+            CullResult Classify(const Math::Vector3<float> &Minimum, const Math::Vector3<float> &Maximum, unsigned int &PlaneMask) const
+            {
+                for (int i = 0; i < 6; i++)
+                {
+                    if (!(PlaneMask & (1u << i)))
+                        continue;
+
+                    float outer = nx[i] * (nx[i] >= 0.0f ? Maximum.x : Minimum.x) +
+                                  ny[i] * (ny[i] >= 0.0f ? Maximum.y : Minimum.y) +
+                                  nz[i] * (nz[i] >= 0.0f ? Maximum.z : Minimum.z) + d[i];
+
+                    if (outer < 0.0f)
+                        return CullResult::Outside;
+
+                    float inner = nx[i] * (nx[i] >= 0.0f ? Minimum.x : Maximum.x) +
+                                  ny[i] * (ny[i] >= 0.0f ? Minimum.y : Maximum.y) +
+                                  nz[i] * (nz[i] >= 0.0f ? Minimum.z : Maximum.z) + d[i];
+
+                    if (inner >= 0.0f)
+                        PlaneMask &= ~(1u << i);
+                }
+
+                return (PlaneMask ? CullResult::Intersecting : CullResult::Inside);
+            };
+
+            float nx[6];
+            float ny[6];
+            float nz[6];
+            float d[6];
+        };
+    };
+};
+
+#endif // WARLOCK_GEOMETRY_FRUSTUM_HPP
@@ -0,0 +1,385 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Geometry/Ray.hpp
+// Description: Rays, ray packets and their intersection with boxes and triangles.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_GEOMETRY_RAY_HPP
+#define WARLOCK_GEOMETRY_RAY_HPP
+
+#include "Culling.hpp"
+#include "Math/Simd.hpp"
+#include "Math/Vector3.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace Warlock
+{
+    namespace Geometry
+    {
+        static constexpr std::uint32_t InvalidPrimitive = 0xFFFFFFFF;
+        static constexpr float RayInfinity = std::numeric_limits<float>::infinity();
+
+        // The reciprocal direction is computed on construction for the slab tests, so a ray is
+        // rebuilt rather than having its direction changed in place.
+        struct Ray
+        {
+            Ray() : origin(0.0f), direction(0.0f, 0.0f, 1.0f), inverse(RayInfinity, RayInfinity, 1.0f), minimum(0.0f), maximum(RayInfinity) {};
+
+            Ray(const Math::Vector3<float> &Origin, const Math::Vector3<float> &Direction, float Minimum = 0.0f, float Maximum = RayInfinity)
+                : origin(Origin), direction(Direction),
+                  inverse(1.0f / Direction.x, 1.0f / Direction.y, 1.0f / Direction.z),
+                  minimum(Minimum), maximum(Maximum) {};
+
+            Math::Vector3<float> origin;
+            Math::Vector3<float> direction;
+            Math::Vector3<float> inverse;
+            float minimum;
+            float maximum;
+        };
+
+        struct RayHit
+        {
+            RayHit() : distance(RayInfinity), u(0.0f), v(0.0f), primitive(InvalidPrimitive) {};
+
+            bool IsHit() const
+            {
+                return (primitive != InvalidPrimitive);
+            };
+
+            float distance;
+            float u;
+            float v;
+            std::uint32_t primitive;
+        };
+
+        // Triangles are kept as a vertex and two edges, which is what Möller-Trumbore consumes.
+        struct Triangle
+        {
+            Triangle() {};
+
+            Triangle(const Math::Vector3<float> &a, const Math::Vector3<float> &b, const Math::Vector3<float> &c)
+            {
+                v0[0] = a.x;
+                v0[1] = a.y;
+                v0[2] = a.z;
+
+                e1[0] = b.x - a.x;
+                e1[1] = b.y - a.y;
+                e1[2] = b.z - a.z;
+
+                e2[0] = c.x - a.x;
+                e2[1] = c.y - a.y;
+                e2[2] = c.z - a.z;
+            };
+
+            float v0[3];
+            float e1[3];
+            float e2[3];
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Single ray kernels
+        //-----------------------------------------------------------------------------------------
+        inline bool IntersectBox(const Ray &Value, const float Minimum[3], const float Maximum[3], float Distance, float &Near)
+        {
+            float tx1 = (Minimum[0] - Value.origin.x) * Value.inverse.x;
+            float tx2 = (Maximum[0] - Value.origin.x) * Value.inverse.x;
+            float ty1 = (Minimum[1] - Value.origin.y) * Value.inverse.y;
+            float ty2 = (Maximum[1] - Value.origin.y) * Value.inverse.y;
+            float tz1 = (Minimum[2] - Value.origin.z) * Value.inverse.z;
+            float tz2 = (Maximum[2] - Value.origin.z) * Value.inverse.z;
+
+            float tnear = std::fmax(std::fmax(std::fmin(tx1, tx2), std::fmin(ty1, ty2)), std::fmax(std::fmin(tz1, tz2), Value.minimum));
+            float tfar = std::fmin(std::fmin(std::fmax(tx1, tx2), std::fmax(ty1, ty2)), std::fmin(std::fmax(tz1, tz2), Distance));
+
+            Near = tnear;
+
+            return (tnear <= tfar);
+        };
+
+        inline bool IntersectTriangle(const Ray &Value, const Triangle &Face, float Distance, RayHit &Hit)
+        {
+            const float *e1 = Face.e1;
+            const float *e2 = Face.e2;
+            const float dx = Value.direction.x, dy = Value.direction.y, dz = Value.direction.z;
+
+            float px = dy * e2[2] - dz * e2[1];
+            float py = dz * e2[0] - dx * e2[2];
+            float pz = dx * e2[1] - dy * e2[0];
+            float det = e1[0] * px + e1[1] * py + e1[2] * pz;
+
+            if (std::fabs(det) < 1e-12f)
+                return false;
+
+            float inv = 1.0f / det;
+            float tx = Value.origin.x - Face.v0[0];
+            float ty = Value.origin.y - Face.v0[1];
+            float tz = Value.origin.z - Face.v0[2];
+            float u = (tx * px + ty * py + tz * pz) * inv;
+
+            if (u < 0.0f || u > 1.0f)
+                return false;
+
+            float qx = ty * e1[2] - tz * e1[1];
+            float qy = tz * e1[0] - tx * e1[2];
+            float qz = tx * e1[1] - ty * e1[0];
+            float v = (dx * qx + dy * qy + dz * qz) * inv;
+
+            if (v < 0.0f || u + v > 1.0f)
+                return false;
+
+            float t = (e2[0] * qx + e2[1] * qy + e2[2] * qz) * inv;
+
+            if (t <= Value.minimum || t >= Distance)
+                return false;
+
+            Hit.distance = t;
+            Hit.u = u;
+            Hit.v = v;
+
+            return true;
+        };
+
+        // Tests one ray against a stream of boxes a register at a time and writes the indices of
+        // the boxes it enters to Hits, returning their number.
+        inline std::size_t IntersectBoxes(const Ray &Value, const BoxStream &Boxes, std::size_t First, std::size_t Last, std::uint32_t *Hits)
+        {
+            using namespace Math;
+
+            const SimdFloat ox(Value.origin.x), oy(Value.origin.y), oz(Value.origin.z);
+            const SimdFloat ix(Value.inverse.x), iy(Value.inverse.y), iz(Value.inverse.z);
+            const SimdFloat tmin(Value.minimum), tmax(Value.maximum);
+            const float *nearX = (Value.inverse.x >= 0.0f ? Boxes.minimumX : Boxes.maximumX);
+            const float *nearY = (Value.inverse.y >= 0.0f ? Boxes.minimumY : Boxes.maximumY);
+            const float *nearZ = (Value.inverse.z >= 0.0f ? Boxes.minimumZ : Boxes.maximumZ);
+            const float *farX = (Value.inverse.x >= 0.0f ? Boxes.maximumX : Boxes.minimumX);
+            const float *farY = (Value.inverse.y >= 0.0f ? Boxes.maximumY : Boxes.minimumY);
+            const float *farZ = (Value.inverse.z >= 0.0f ? Boxes.maximumZ : Boxes.minimumZ);
+            std::size_t count = 0;
+            std::size_t i = First;
+
+            for (; i + WARLOCK_SIMD_WIDTH <= Last; i += WARLOCK_SIMD_WIDTH)
+            {
+                SimdFloat tnear = Max(Max((SimdFloat::Load(nearX + i) - ox) * ix, (SimdFloat::Load(nearY + i) - oy) * iy),
+                                      Max((SimdFloat::Load(nearZ + i) - oz) * iz, tmin));
+                SimdFloat tfar = Min(Min((SimdFloat::Load(farX + i) - ox) * ix, (SimdFloat::Load(farY + i) - oy) * iy),
+                                     Min((SimdFloat::Load(farZ + i) - oz) * iz, tmax));
+
+                count += CompressStore(SimdInt(static_cast<std::int32_t>(i)) + SimdInt::Index(), (tnear <= tfar).Bits(), Hits + count);
+            }
+
+            for (; i < Last; i++)
+            {
+                float minimum[3] = {Boxes.minimumX[i], Boxes.minimumY[i], Boxes.minimumZ[i]};
+                float maximum[3] = {Boxes.maximumX[i], Boxes.maximumY[i], Boxes.maximumZ[i]};
+                float tnear;
+
+                Hits[count] = static_cast<std::uint32_t>(i);
+                count += (IntersectBox(Value, minimum, maximum, Value.maximum, tnear) ? 1 : 0);
+            }
+
+            return count;
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Ray packets; N rays are stored as structure of arrays padded to whole registers, and
+        // padding lanes are kept inactive by an empty [minimum, maximum] interval.
+        //-----------------------------------------------------------------------------------------
+        template <int N> struct RayPacket
+        {
+            static_assert(N == 4 || N == 8 || N == 16, "Ray packets must be 4, 8 or 16 rays wide");
+
+            static constexpr int Lanes = N;
+            static constexpr int Registers = (N + WARLOCK_SIMD_WIDTH - 1) / WARLOCK_SIMD_WIDTH;
+            static constexpr int Padded = Registers * WARLOCK_SIMD_WIDTH;
+
+            RayPacket()
+            {
+                for (int i = 0; i < Padded; i++)
+                {
+                    originX[i] = originY[i] = originZ[i] = 0.0f;
+                    directionX[i] = directionY[i] = 0.0f;
+                    directionZ[i] = 1.0f;
+                    inverseX[i] = inverseY[i] = RayInfinity;
+                    inverseZ[i] = 1.0f;
+                    minimum[i] = 0.0f;
+                    maximum[i] = -1.0f;
+                }
+            };
+
+            void Set(int Lane, const Ray &Value)
+            {
+                originX[Lane] = Value.origin.x;
+                originY[Lane] = Value.origin.y;
+                originZ[Lane] = Value.origin.z;
+                directionX[Lane] = Value.direction.x;
+                directionY[Lane] = Value.direction.y;
+                directionZ[Lane] = Value.direction.z;
+                inverseX[Lane] = Value.inverse.x;
+                inverseY[Lane] = Value.inverse.y;
+                inverseZ[Lane] = Value.inverse.z;
+                minimum[Lane] = Value.minimum;
+                maximum[Lane] = Value.maximum;
+            };
+
+            Ray Get(int Lane) const
+            {
+                return Ray(Math::Vector3<float>(originX[Lane], originY[Lane], originZ[Lane]),
+                           Math::Vector3<float>(directionX[Lane], directionY[Lane], directionZ[Lane]),
+                           minimum[Lane], maximum[Lane]);
+            };
+
+            bool IsActive(int Lane) const
+            {
+                return (minimum[Lane] <= maximum[Lane]);
+            };
+
+            // A packet is coherent when all active rays share the direction sign on every axis,
+            // so that a single front to back child order suits all of them.
+            bool IsCoherent() const
+            {
+                int signs = -1;
+
+                for (int i = 0; i < N; i++)
+                {
+                    if (!IsActive(i))
+                        continue;
+
+                    int lane = (directionX[i] < 0.0f ? 1 : 0) | (directionY[i] < 0.0f ? 2 : 0) | (directionZ[i] < 0.0f ? 4 : 0);
+
+                    if (signs < 0)
+                        signs = lane;
+                    else if (signs != lane)
+                        return false;
+                }
+
+                return true;
+            };
+
+            alignas(32) float originX[Padded];
+            alignas(32) float originY[Padded];
+            alignas(32) float originZ[Padded];
+            alignas(32) float directionX[Padded];
+            alignas(32) float directionY[Padded];
+            alignas(32) float directionZ[Padded];
+            alignas(32) float inverseX[Padded];
+            alignas(32) float inverseY[Padded];
+            alignas(32) float inverseZ[Padded];
+            alignas(32) float minimum[Padded];
+            alignas(32) float maximum[Padded];
+        };
+
+        template <int N> struct RayPacketHit
+        {
+            static constexpr int Padded = RayPacket<N>::Padded;
+
+            RayPacketHit()
+            {
+                for (int i = 0; i < Padded; i++)
+                {
+                    distance[i] = RayInfinity;
+                    u[i] = v[i] = 0.0f;
+                    primitive[i] = InvalidPrimitive;
+                }
+            };
+
+            RayHit Get(int Lane) const
+            {
+                RayHit hit;
+                hit.distance = distance[Lane];
+                hit.u = u[Lane];
+                hit.v = v[Lane];
+                hit.primitive = primitive[Lane];
+
+                return hit;
+            };
+
+            alignas(32) float distance[Padded];
+            alignas(32) float u[Padded];
+            alignas(32) float v[Padded];
+            alignas(32) std::uint32_t primitive[Padded];
+        };
+
+        // Slab test of one register of packet rays against a box; Far holds the current closest
+        // hit of each lane and the lanes entering the box before it are returned.
+        template <int N> Math::SimdMask IntersectBox(const RayPacket<N> &Packet, int Register, const float Minimum[3], const float Maximum[3],
+                                                     Math::SimdFloat Far)
+        {
+            using namespace Math;
+
+            const int o = Register * WARLOCK_SIMD_WIDTH;
+            SimdFloat ox = SimdFloat::LoadAligned(Packet.originX + o);
+            SimdFloat oy = SimdFloat::LoadAligned(Packet.originY + o);
+            SimdFloat oz = SimdFloat::LoadAligned(Packet.originZ + o);
+            SimdFloat ix = SimdFloat::LoadAligned(Packet.inverseX + o);
+            SimdFloat iy = SimdFloat::LoadAligned(Packet.inverseY + o);
+            SimdFloat iz = SimdFloat::LoadAligned(Packet.inverseZ + o);
+
+            SimdFloat tx1 = (SimdFloat(Minimum[0]) - ox) * ix;
+            SimdFloat tx2 = (SimdFloat(Maximum[0]) - ox) * ix;
+            SimdFloat ty1 = (SimdFloat(Minimum[1]) - oy) * iy;
+            SimdFloat ty2 = (SimdFloat(Maximum[1]) - oy) * iy;
+            SimdFloat tz1 = (SimdFloat(Minimum[2]) - oz) * iz;
+            SimdFloat tz2 = (SimdFloat(Maximum[2]) - oz) * iz;
+
+            SimdFloat tnear = Max(Max(Min(tx1, tx2), Min(ty1, ty2)), Max(Min(tz1, tz2), SimdFloat::LoadAligned(Packet.minimum + o)));
+            SimdFloat tfar = Min(Min(Max(tx1, tx2), Max(ty1, ty2)), Min(Max(tz1, tz2), Far));
+
+            return (tnear <= tfar);
+        };
+
+        // Möller-Trumbore of one register of packet rays against a broadcast triangle.
+        template <int N> Math::SimdMask IntersectTriangle(const RayPacket<N> &Packet, int Register, const Triangle &Face, Math::SimdFloat Far,
+                                                          Math::SimdFloat &Distance, Math::SimdFloat &u, Math::SimdFloat &v)
+        {
+            using namespace Math;
+
+            const int o = Register * WARLOCK_SIMD_WIDTH;
+            const SimdFloat e1x(Face.e1[0]), e1y(Face.e1[1]), e1z(Face.e1[2]);
+            const SimdFloat e2x(Face.e2[0]), e2y(Face.e2[1]), e2z(Face.e2[2]);
+            SimdFloat dx = SimdFloat::LoadAligned(Packet.directionX + o);
+            SimdFloat dy = SimdFloat::LoadAligned(Packet.directionY + o);
+            SimdFloat dz = SimdFloat::LoadAligned(Packet.directionZ + o);
+
+            SimdFloat px = dy * e2z - dz * e2y;
+            SimdFloat py = dz * e2x - dx * e2z;
+            SimdFloat pz = dx * e2y - dy * e2x;
+            SimdFloat det = MulAdd(e1x, px, MulAdd(e1y, py, e1z * pz));
+            SimdFloat inv = SimdFloat(1.0f) / det;
+
+            SimdFloat tx = SimdFloat::LoadAligned(Packet.originX + o) - SimdFloat(Face.v0[0]);
+            SimdFloat ty = SimdFloat::LoadAligned(Packet.originY + o) - SimdFloat(Face.v0[1]);
+            SimdFloat tz = SimdFloat::LoadAligned(Packet.originZ + o) - SimdFloat(Face.v0[2]);
+
+            SimdFloat qx = ty * e1z - tz * e1y;
+            SimdFloat qy = tz * e1x - tx * e1z;
+            SimdFloat qz = tx * e1y - ty * e1x;
+
+            u = MulAdd(tx, px, MulAdd(ty, py, tz * pz)) * inv;
+            v = MulAdd(dx, qx, MulAdd(dy, qy, dz * qz)) * inv;
+            Distance = MulAdd(e2x, qx, MulAdd(e2y, qy, e2z * qz)) * inv;
+
+            const SimdFloat zero = SimdFloat::Zero();
+
+            return (Abs(det) >= SimdFloat(1e-12f)) & (u >= zero) & (v >= zero) & (u + v <= SimdFloat(1.0f)) &
+                   (Distance > SimdFloat::LoadAligned(Packet.minimum + o)) & (Distance < Far);
+        };
+    };
+};
+
+#endif // WARLOCK_GEOMETRY_RAY_HPP
@@ -0,0 +1,748 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/IO/AsyncReader.hpp
+// Description: Asynchronous positioned file reads with completions on the thread pool.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_IO_ASYNCREADER_HPP
+#define WARLOCK_IO_ASYNCREADER_HPP
+
+#include "Core/ThreadPool.hpp"
+#include "Platform/Platform.hpp"
+#include <cerrno>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#if WARLOCK_SYSTEM_LINUX
+#include <cstring>
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#endif
+
+namespace Warlock
+{
+    namespace IO
+    {
+        struct ReadResult
+        {
+            std::uint32_t file;
+            std::uint64_t offset;
+            void *buffer;
+            std::size_t size;
+
+            // Bytes read, short only at the end of the file, or a negative error code.
+            std::int64_t result;
+        };
+
+        using ReadCallback = std::function<void(const ReadResult &)>;
+
+        namespace Detail
+        {
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+            using FileHandle = HANDLE;
+            static const FileHandle InvalidFileHandle = INVALID_HANDLE_VALUE;
+
+            inline FileHandle OpenForRead(const char *Path)
+            {
+                return CreateFileA(Path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            };
+
+            inline void CloseForRead(FileHandle File)
+            {
+                ::CloseHandle(File);
+            };
+
+            inline std::int64_t ReadAt(FileHandle File, void *Buffer, std::size_t Size, std::uint64_t Offset)
+            {
+                std::size_t total = 0;
+
+                while (total < Size)
+                {
+                    OVERLAPPED overlapped = {};
+                    overlapped.Offset = static_cast<DWORD>(Offset + total);
+                    overlapped.OffsetHigh = static_cast<DWORD>((Offset + total) >> 32);
+
+                    DWORD chunk = static_cast<DWORD>(Size - total > 0x40000000 ? 0x40000000 : Size - total);
+                    DWORD transferred = 0;
+
+                    if (!ReadFile(File, static_cast<char *>(Buffer) + total, chunk, &transferred, &overlapped))
+                        return (GetLastError() == ERROR_HANDLE_EOF ? static_cast<std::int64_t>(total) : -static_cast<std::int64_t>(GetLastError()));
+
+                    if (transferred == 0)
+                        break;
+
+                    total += transferred;
+                }
+
+                return static_cast<std::int64_t>(total);
+            };
+#else
+            using FileHandle = int;
+            static const FileHandle InvalidFileHandle = -1;
+
+            inline FileHandle OpenForRead(const char *Path)
+            {
+                return open(Path, O_RDONLY | O_CLOEXEC);
+            };
+
+            inline void CloseForRead(FileHandle File)
+            {
+                close(File);
+            };
+
+            inline std::int64_t ReadAt(FileHandle File, void *Buffer, std::size_t Size, std::uint64_t Offset)
+            {
+                std::size_t total = 0;
+
+                while (total < Size)
+                {
+                    ssize_t chunk = pread(File, static_cast<char *>(Buffer) + total, Size - total, static_cast<off_t>(Offset + total));
+
+                    if (chunk < 0 && errno == EINTR)
+                        continue;
+
+                    if (chunk < 0)
+                        return -static_cast<std::int64_t>(errno);
+
+                    if (chunk == 0)
+                        break;
+
+                    total += static_cast<std::size_t>(chunk);
+                }
+
+                return static_cast<std::int64_t>(total);
+            };
+#endif
+
+#if WARLOCK_SYSTEM_LINUX
+            // Minimal io_uring wrapper over the raw system calls, so no library is needed. Only
+            // the submitting side takes a lock; the reaper owns the completion ring.
+            class IoUring
+            {
+                public:
+                    IoUring() : ring(-1), sqRing(nullptr), cqRing(nullptr), sqes(nullptr), sqRingSize(0), cqRingSize(0), sqeSize(0), pendingTail(0) {};
+
+                    ~IoUring()
+                    {
+                        if (sqes)
+                            munmap(sqes, sqeSize);
+
+                        if (cqRing && cqRing != sqRing)
+                            munmap(cqRing, cqRingSize);
+
+                        if (sqRing)
+                            munmap(sqRing, sqRingSize);
+
+                        if (ring >= 0)
+                            close(ring);
+                    };
+
+                    IoUring(const IoUring &) = delete;
+                    IoUring &operator =(const IoUring &) = delete;
+
+                    // Fails on kernels without io_uring or where it is filtered out, like most
+                    // containers; callers fall back to blocking reads then.
+                    bool Setup(unsigned int Entries)
+                    {
+                        io_uring_params parameters;
+                        std::memset(&parameters, 0, sizeof(parameters));
+
+                        ring = static_cast<int>(syscall(__NR_io_uring_setup, Entries, &parameters));
+
+                        if (ring < 0)
+                            return false;
+
+                        sqRingSize = parameters.sq_off.array + parameters.sq_entries * sizeof(std::uint32_t);
+                        cqRingSize = parameters.cq_off.cqes + parameters.cq_entries * sizeof(io_uring_cqe);
+                        sqeSize = parameters.sq_entries * sizeof(io_uring_sqe);
+
+                        if (parameters.features & IORING_FEAT_SINGLE_MMAP)
+                            sqRingSize = cqRingSize = (sqRingSize > cqRingSize ? sqRingSize : cqRingSize);
+
+                        sqRing = Map(sqRingSize, IORING_OFF_SQ_RING);
+                        cqRing = ((parameters.features & IORING_FEAT_SINGLE_MMAP) ? sqRing : Map(cqRingSize, IORING_OFF_CQ_RING));
+                        sqes = static_cast<io_uring_sqe *>(Map(sqeSize, IORING_OFF_SQES));
+
+                        if (!sqRing || !cqRing || !sqes)
+                            return false;
+
+                        unsigned char *sq = static_cast<unsigned char *>(sqRing);
+                        unsigned char *cq = static_cast<unsigned char *>(cqRing);
+
+                        sqHead = reinterpret_cast<unsigned int *>(sq + parameters.sq_off.head);
+                        sqTail = reinterpret_cast<unsigned int *>(sq + parameters.sq_off.tail);
+                        sqMask = *reinterpret_cast<unsigned int *>(sq + parameters.sq_off.ring_mask);
+                        sqEntries = *reinterpret_cast<unsigned int *>(sq + parameters.sq_off.ring_entries);
+                        sqArray = reinterpret_cast<unsigned int *>(sq + parameters.sq_off.array);
+                        cqHead = reinterpret_cast<unsigned int *>(cq + parameters.cq_off.head);
+                        cqTail = reinterpret_cast<unsigned int *>(cq + parameters.cq_off.tail);
+                        cqMask = *reinterpret_cast<unsigned int *>(cq + parameters.cq_off.ring_mask);
+                        cqes = reinterpret_cast<io_uring_cqe *>(cq + parameters.cq_off.cqes);
+                        pendingTail = *sqTail;
+
+                        return true;
+                    };
+
+                    int Register(unsigned int Opcode, const void *Arguments, unsigned int Count)
+                    {
+                        return static_cast<int>(syscall(__NR_io_uring_register, ring, Opcode, Arguments, Count));
+                    };
+
+                    // Returns the next free submission entry, cleared, or nullptr when the queue is
+                    // full of entries not yet handed to the kernel.
+                    io_uring_sqe *Acquire()
+                    {
+                        if (pendingTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries)
+                            return nullptr;
+
+                        unsigned int index = pendingTail & sqMask;
+                        io_uring_sqe *entry = &sqes[index];
+
+                        std::memset(entry, 0, sizeof(io_uring_sqe));
+                        sqArray[index] = index;
+                        pendingTail++;
+
+                        return entry;
+                    };
+
+                    // Publishes every acquired entry with a single system call.
+                    int Submit()
+                    {
+                        unsigned int count = pendingTail - *sqTail;
+
+                        if (count == 0)
+                            return 0;
+
+                        __atomic_store_n(sqTail, pendingTail, __ATOMIC_RELEASE);
+
+                        int submitted;
+
+                        do
+                            submitted = static_cast<int>(syscall(__NR_io_uring_enter, ring, count, 0, 0, nullptr, 0));
+                        while (submitted < 0 && errno == EINTR);
+
+                        return submitted;
+                    };
+
+                    // Blocks until at least one completion is posted, then hands each one to Body.
+                    template <typename Function> void Reap(Function &&Body)
+                    {
+                        unsigned int head = *cqHead;
+
+                        while (head == __atomic_load_n(cqTail, __ATOMIC_ACQUIRE))
+                        {
+                            if (syscall(__NR_io_uring_enter, ring, 0, 1, IORING_ENTER_GETEVENTS, nullptr, 0) < 0 && errno != EINTR)
+                                return;
+                        }
+
+                        for (unsigned int tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE); head != tail; head++)
+                            Body(cqes[head & cqMask]);
+
+                        __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+                    };
+
+                private:
+                    void *Map(std::size_t Size, std::uint64_t Offset)
+                    {
+                        void *view = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring, static_cast<off_t>(Offset));
+
+                        return (view == MAP_FAILED ? nullptr : view);
+                    };
+
+                    int ring;
+                    void *sqRing;
+                    void *cqRing;
+                    io_uring_sqe *sqes;
+                    std::size_t sqRingSize;
+                    std::size_t cqRingSize;
+                    std::size_t sqeSize;
+                    unsigned int *sqHead;
+                    unsigned int *sqTail;
+                    unsigned int *sqArray;
+                    unsigned int sqMask;
+                    unsigned int sqEntries;
+                    unsigned int pendingTail;
+                    unsigned int *cqHead;
+                    unsigned int *cqTail;
+                    unsigned int cqMask;
+                    io_uring_cqe *cqes;
+            };
+#endif
+        };
+
+        // Issues positioned reads without blocking the calling thread. Reads are queued by Read()
+        // and handed to the system in one batch by Submit(); each callback then runs as a task on
+        // the thread pool once its data has landed.
+        //
+        // On Linux the reads go through io_uring, with files and buffers registered with the
+        // kernel ahead of time to save the per request lookups and page pinning. Elsewhere, or
+        // when io_uring is unavailable, a few dedicated threads issue blocking pread calls, so
+        // the pool threads never wait on the device either way.
+        class AsyncReader
+        {
+            public:
+                static constexpr std::uint32_t InvalidFile = 0xFFFFFFFFu;
+                static constexpr std::uint32_t MaximumFiles = 256;
+
+                AsyncReader(Core::ThreadPool &Pool = Core::ThreadPool::GetDefault(), unsigned int QueueDepth = 128, unsigned int FallbackThreads = 4) :
+                    pool(Pool), depth(QueueDepth), outstanding(0), stopping(false), uring(false), fixedFiles(false)
+                {
+                    files.assign(MaximumFiles, Detail::InvalidFileHandle);
+                    requests.resize(depth);
+
+                    for (unsigned int i = 0; i < depth; i++)
+                        freeRequests.push_back(depth - 1 - i);
+
+#if WARLOCK_SYSTEM_LINUX
+                    uring = ring.Setup(depth);
+
+                    if (uring)
+                    {
+                        // An empty fixed file table; slots are filled in as files are opened.
+                        std::vector<int> table(MaximumFiles, -1);
+                        fixedFiles = (ring.Register(IORING_REGISTER_FILES, table.data(), MaximumFiles) == 0);
+                        reaper = std::thread([this]() { ReapLoop(); });
+                        return;
+                    }
+#endif
+
+                    for (unsigned int i = 0; i < (FallbackThreads ? FallbackThreads : 1); i++)
+                        readers.emplace_back([this]() { ReadLoop(); });
+                };
+
+                ~AsyncReader()
+                {
+                    Wait();
+
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        stopping = true;
+
+#if WARLOCK_SYSTEM_LINUX
+                        // A no-op carrying the wake token gets the reaper out of its wait.
+                        if (uring)
+                        {
+                            io_uring_sqe *entry = ring.Acquire();
+
+                            if (!entry)
+                            {
+                                ring.Submit();
+                                entry = ring.Acquire();
+                            }
+
+                            entry->opcode = IORING_OP_NOP;
+                            entry->user_data = WakeToken;
+                            ring.Submit();
+                        }
+#endif
+                    }
+
+                    ready.notify_all();
+
+                    if (reaper.joinable())
+                        reaper.join();
+
+                    for (std::thread &reader : readers)
+                        reader.join();
+
+                    for (std::uint32_t i = 0; i < MaximumFiles; i++)
+                    {
+                        if (files[i] != Detail::InvalidFileHandle)
+                            Detail::CloseForRead(files[i]);
+                    }
+                };
+
+                AsyncReader(const AsyncReader &) = delete;
+                AsyncReader &operator =(const AsyncReader &) = delete;
+
+                bool IsUsingIoUring() const
+                {
+                    return uring;
+                };
+
+                // Returns InvalidFile when the file cannot be opened or the table is full.
+                std::uint32_t OpenFile(const char *Path)
+                {
+                    Detail::FileHandle handle = Detail::OpenForRead(Path);
+
+                    if (handle == Detail::InvalidFileHandle)
+                        return InvalidFile;
+
+                    std::lock_guard<std::mutex> lock(mutex);
+
+                    for (std::uint32_t i = 0; i < MaximumFiles; i++)
+                    {
+                        if (files[i] != Detail::InvalidFileHandle)
+                            continue;
+
+                        files[i] = handle;
+
+#if WARLOCK_SYSTEM_LINUX
+                        if (fixedFiles)
+                            UpdateFixedFile(i, handle);
+#endif
+
+                        return i;
+                    }
+
+                    Detail::CloseForRead(handle);
+                    return InvalidFile;
+                };
+
+                // The file must have no reads in flight.
+                void CloseFile(std::uint32_t File)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+
+                    if (File >= MaximumFiles || files[File] == Detail::InvalidFileHandle)
+                        return;
+
+#if WARLOCK_SYSTEM_LINUX
+                    if (fixedFiles)
+                        UpdateFixedFile(File, -1);
+#endif
+
+                    Detail::CloseForRead(files[File]);
+                    files[File] = Detail::InvalidFileHandle;
+                };
+
+                // Pins Count buffers of BufferSize bytes laid out back to back from Base. Reads
+                // that land entirely inside one of them skip the per request pinning. Replaces any
+                // earlier registration, so call it while no reads are in flight; a no-op on the
+                // fallback path.
+                bool RegisterBuffers(void *Base, std::size_t BufferSize, unsigned int Count)
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+
+                    buffers.clear();
+
+#if WARLOCK_SYSTEM_LINUX
+                    if (!uring)
+                        return false;
+
+                    ring.Register(IORING_UNREGISTER_BUFFERS, nullptr, 0);
+
+                    std::vector<iovec> vectors(Count);
+
+                    for (unsigned int i = 0; i < Count; i++)
+                    {
+                        vectors[i].iov_base = static_cast<char *>(Base) + i * BufferSize;
+                        vectors[i].iov_len = BufferSize;
+                    }
+
+                    if (ring.Register(IORING_REGISTER_BUFFERS, vectors.data(), Count) != 0)
+                        return false;
+
+                    buffers.assign(vectors.begin(), vectors.end());
+                    return true;
+#else
+                    (void)Base;
+                    (void)BufferSize;
+                    (void)Count;
+
+                    return false;
+#endif
+                };
+
+                // Queues a read of Size bytes at Offset into Buffer; nothing reaches the device
+                // until Submit(). Blocks only when QueueDepth reads are already in flight. Large
+                // reads, and reads the system returns short before the end of the file, are
+                // carried on in pieces of at most ReadPieceSize bytes until done.
+                void Read(std::uint32_t File, std::uint64_t Offset, void *Buffer, std::size_t Size, ReadCallback Callback)
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+
+                    if (freeRequests.empty())
+                    {
+                        Flush();
+                        available.wait(lock, [this]() { return !freeRequests.empty(); });
+                    }
+
+                    std::uint32_t slot = freeRequests.back();
+                    freeRequests.pop_back();
+                    outstanding++;
+
+                    Request &request = requests[slot];
+                    request.result = { File, Offset, Buffer, Size, 0 };
+                    request.done = 0;
+                    request.callback = std::move(Callback);
+
+#if WARLOCK_SYSTEM_LINUX
+                    if (uring)
+                    {
+                        io_uring_sqe *entry = ring.Acquire();
+
+                        // The ring holds QueueDepth entries, so a free request always finds a free
+                        // entry once the pending batch has been handed over.
+                        if (!entry)
+                        {
+                            ring.Submit();
+                            entry = ring.Acquire();
+                        }
+
+                        Prepare(entry, slot);
+                        return;
+                    }
+#endif
+
+                    pending.push_back(slot);
+                };
+
+                void Submit()
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    Flush();
+                };
+
+                // Submits anything queued and waits until every callback has returned.
+                void Wait()
+                {
+                    Submit();
+
+                    std::unique_lock<std::mutex> lock(mutex);
+                    idle.wait(lock, [this]() { return outstanding == 0; });
+                };
+
+            private:
+                struct Request
+                {
+                    ReadResult result;
+                    ReadCallback callback;
+
+                    // Bytes landed so far; owned by the reaper while the read is in flight.
+                    std::size_t done;
+                };
+
+                static constexpr std::uint64_t WakeToken = ~static_cast<std::uint64_t>(0);
+
+                // Largest piece handed to the system at once; io_uring lengths are 32 bits.
+                static constexpr std::size_t ReadPieceSize = 0x40000000;
+
+                // Called with the lock held.
+                void Flush()
+                {
+#if WARLOCK_SYSTEM_LINUX
+                    if (uring)
+                    {
+                        ring.Submit();
+                        return;
+                    }
+#endif
+
+                    while (!pending.empty())
+                    {
+                        queued.push_back(pending.front());
+                        pending.pop_front();
+                    }
+
+                    // Read() flushes when it runs out of requests and then waits for one, so the
+                    // reader threads must be woken here and not only by Submit().
+                    ready.notify_all();
+                };
+
+                // Takes the finished request out of its slot and posts its callback to the pool.
+                void Complete(std::uint32_t Slot, std::int64_t Result)
+                {
+                    Request request;
+
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+
+                        request.result = requests[Slot].result;
+                        request.result.result = Result;
+                        request.callback = std::move(requests[Slot].callback);
+                        freeRequests.push_back(Slot);
+                    }
+
+                    available.notify_one();
+
+                    pool.Submit([this, request]()
+                    {
+                        if (request.callback)
+                            request.callback(request.result);
+
+                        // Notify under the lock: a destructor woken by this may free the reader.
+                        std::lock_guard<std::mutex> lock(mutex);
+                        outstanding--;
+                        idle.notify_all();
+                    });
+                };
+
+                void ReadLoop()
+                {
+                    for (;;)
+                    {
+                        std::uint32_t slot;
+                        Detail::FileHandle handle;
+
+                        {
+                            std::unique_lock<std::mutex> lock(mutex);
+                            ready.wait(lock, [this]() { return stopping || !queued.empty(); });
+
+                            if (queued.empty())
+                                return;
+
+                            slot = queued.front();
+                            queued.pop_front();
+                            handle = (requests[slot].result.file < MaximumFiles ? files[requests[slot].result.file] : Detail::InvalidFileHandle);
+                        }
+
+                        const ReadResult &result = requests[slot].result;
+                        std::int64_t bytes = (handle == Detail::InvalidFileHandle ? -EBADF : Detail::ReadAt(handle, result.buffer, result.size, result.offset));
+
+                        Complete(slot, bytes);
+                    }
+                };
+
+#if WARLOCK_SYSTEM_LINUX
+                void Prepare(io_uring_sqe *Entry, std::uint32_t Slot)
+                {
+                    const ReadResult &result = requests[Slot].result;
+                    const std::size_t done = requests[Slot].done;
+                    const std::size_t remaining = result.size - done;
+
+                    Entry->opcode = IORING_OP_READ;
+                    Entry->fd = static_cast<int>(result.file);
+                    Entry->off = result.offset + done;
+                    Entry->addr = reinterpret_cast<std::uint64_t>(static_cast<char *>(result.buffer) + done);
+                    Entry->len = static_cast<std::uint32_t>(remaining > ReadPieceSize ? ReadPieceSize : remaining);
+                    Entry->user_data = Slot;
+
+                    if (fixedFiles)
+                        Entry->flags = IOSQE_FIXED_FILE;
+                    else
+                        Entry->fd = (result.file < MaximumFiles ? files[result.file] : -1);
+
+                    const char *begin = static_cast<const char *>(result.buffer);
+
+                    for (std::size_t i = 0; i < buffers.size(); i++)
+                    {
+                        const char *base = static_cast<const char *>(buffers[i].iov_base);
+
+                        if (begin >= base && begin + result.size <= base + buffers[i].iov_len)
+                        {
+                            Entry->opcode = IORING_OP_READ_FIXED;
+                            Entry->buf_index = static_cast<std::uint16_t>(i);
+                            break;
+                        }
+                    }
+                };
+
+                void UpdateFixedFile(std::uint32_t Index, int Descriptor)
+                {
+                    io_uring_files_update update;
+                    std::memset(&update, 0, sizeof(update));
+                    update.offset = Index;
+                    update.fds = reinterpret_cast<std::uint64_t>(&Descriptor);
+
+                    ring.Register(IORING_REGISTER_FILES_UPDATE, &update, 1);
+                };
+
+                // Carries a read on past a piece or a short return, or completes it at the end of
+                // the file, on an error or once every byte has landed.
+                void Continue(std::uint32_t Slot, std::int32_t Result)
+                {
+                    Request &request = requests[Slot];
+
+                    if (Result < 0)
+                    {
+                        Complete(Slot, Result);
+                        return;
+                    }
+
+                    request.done += static_cast<std::size_t>(Result);
+
+                    if (Result > 0 && request.done < request.result.size)
+                    {
+                        std::lock_guard<std::mutex> lock(mutex);
+                        io_uring_sqe *entry = ring.Acquire();
+
+                        if (!entry)
+                        {
+                            ring.Submit();
+                            entry = ring.Acquire();
+                        }
+
+                        Prepare(entry, Slot);
+                        ring.Submit();
+                        return;
+                    }
+
+                    Complete(Slot, static_cast<std::int64_t>(request.done));
+                };
+
+                void ReapLoop()
+                {
+                    bool running = true;
+
+                    while (running)
+                    {
+                        ring.Reap([&](const io_uring_cqe &Completion)
+                        {
+                            if (Completion.user_data == WakeToken)
+                                running = false;
+                            else
+                                Continue(static_cast<std::uint32_t>(Completion.user_data), Completion.res);
+                        });
+                    }
+                };
+
+                Detail::IoUring ring;
+                std::vector<iovec> buffers;
+#else
+                std::vector<int> buffers;
+#endif
+
+                Core::ThreadPool &pool;
+                const unsigned int depth;
+                std::vector<Detail::FileHandle> files;
+                std::vector<Request> requests;
+                std::vector<std::uint32_t> freeRequests;
+                std::deque<std::uint32_t> pending;
+                std::deque<std::uint32_t> queued;
+                std::size_t outstanding;
+                bool stopping;
+                bool uring;
+                bool fixedFiles;
+                std::mutex mutex;
+                std::condition_variable ready;
+                std::condition_variable available;
+                std::condition_variable idle;
+                std::thread reaper;
+                std::vector<std::thread> readers;
+        };
+    };
+};
+
+#endif // WARLOCK_IO_ASYNCREADER_HPP
@@ -0,0 +1,135 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/IO/BinaryFormat.hpp
+// Description: On disk layout of the binary container format.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_IO_BINARYFORMAT_HPP
+#define WARLOCK_IO_BINARYFORMAT_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace Warlock
+{
+    namespace IO
+    {
+        // A file is a header, the section data, then the section table:
+        //
+        //   FileHeader | component streams, each on a SectionAlignment boundary | SectionEntry[]
+        //
+        // A section holds a named array of elements with up to four components, stored as one
+        // contiguous stream per component, so a Vector3 array becomes three float streams that a
+        // SIMD kernel can read straight out of the mapping. All values are little endian.
+        constexpr std::uint32_t BinaryMagic = 0x4E424C57; // "WLBN"
+        constexpr std::uint16_t BinaryVersionMajor = 1;
+        constexpr std::uint16_t BinaryVersionMinor = 0;
+        constexpr std::size_t SectionAlignment = 64;
+        constexpr std::size_t SectionNameLength = 48;
+        constexpr std::size_t SectionMaximumComponents = 4;
+
+        enum class ElementType : std::uint32_t
+        {
+            Float32,
+            Float64,
+            Int8,
+            UInt8,
+            Int16,
+            UInt16,
+            Int32,
+            UInt32,
+            Int64,
+            UInt64,
+            Half
+        };
+
+        inline std::size_t GetElementSize(ElementType Type)
+        {
+            switch (Type)
+            {
+                case ElementType::Int8:
+                case ElementType::UInt8:
+                    return 1;
+
+                case ElementType::Int16:
+                case ElementType::UInt16:
+                case ElementType::Half:
+                    return 2;
+
+                case ElementType::Float32:
+                case ElementType::Int32:
+                case ElementType::UInt32:
+                    return 4;
+
+                case ElementType::Float64:
+                case ElementType::Int64:
+                case ElementType::UInt64:
+                    return 8;
+            }
+
+            return 0;
+        };
+
+        template <typename T> struct ElementTypeOf;
+        template <> struct ElementTypeOf<float> { static constexpr ElementType value = ElementType::Float32; };
+        template <> struct ElementTypeOf<double> { static constexpr ElementType value = ElementType::Float64; };
+        template <> struct ElementTypeOf<std::int8_t> { static constexpr ElementType value = ElementType::Int8; };
+        template <> struct ElementTypeOf<std::uint8_t> { static constexpr ElementType value = ElementType::UInt8; };
+        template <> struct ElementTypeOf<std::int16_t> { static constexpr ElementType value = ElementType::Int16; };
+        template <> struct ElementTypeOf<std::uint16_t> { static constexpr ElementType value = ElementType::UInt16; };
+        template <> struct ElementTypeOf<std::int32_t> { static constexpr ElementType value = ElementType::Int32; };
+        template <> struct ElementTypeOf<std::uint32_t> { static constexpr ElementType value = ElementType::UInt32; };
+        template <> struct ElementTypeOf<std::int64_t> { static constexpr ElementType value = ElementType::Int64; };
+        template <> struct ElementTypeOf<std::uint64_t> { static constexpr ElementType value = ElementType::UInt64; };
+
+        struct FileHeader
+        {
+            std::uint32_t magic;
+            std::uint16_t versionMajor;
+            std::uint16_t versionMinor;
+            std::uint32_t headerSize;
+            std::uint32_t sectionCount;
+            std::uint64_t tableOffset;
+            std::uint64_t fileSize;
+            std::uint32_t tableChecksum;
+            std::uint32_t reserved[5];
+
+            // Covers every field above, computed with this one zeroed.
+            std::uint32_t headerChecksum;
+            std::uint32_t padding;
+        };
+
+        struct SectionEntry
+        {
+            char name[SectionNameLength];
+            ElementType type;
+            std::uint32_t components;
+            std::uint64_t count;
+
+            // Offset of the first component stream; the others follow at multiples of stride.
+            std::uint64_t offset;
+            std::uint64_t stride;
+            std::uint32_t checksums[SectionMaximumComponents];
+            std::uint32_t flags;
+            std::uint32_t reserved[3];
+        };
+
+        static_assert(sizeof(FileHeader) == 64, "FileHeader layout changed");
+        static_assert(sizeof(SectionEntry) == 112, "SectionEntry layout changed");
+    };
+};
+
+#endif // WARLOCK_IO_BINARYFORMAT_HPP
@@ -0,0 +1,220 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/IO/BinaryReader.hpp
+// Description: Zero copy reader for memory mapped binary container files.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_IO_BINARYREADER_HPP
+#define WARLOCK_IO_BINARYREADER_HPP
+
+#include "BinaryFormat.hpp"
+#include "Checksum.hpp"
+#include "MappedFile.hpp"
+#include <cstring>
+
+namespace Warlock
+{
+    namespace IO
+    {
+        enum class BinaryStatus
+        {
+            Success,
+            OpenFailed,
+            Truncated,
+            BadMagic,
+            UnsupportedVersion,
+            HeaderChecksumMismatch,
+            TableChecksumMismatch,
+            InvalidSection
+        };
+
+        // Maps a container and hands out pointers into it. Open() only touches the header and
+        // the section table, so opening is constant time whatever the file size; section data is
+        // paged in when first read. Section checksums cover the whole payload, so they are only
+        // checked on request through Verify().
+        class BinaryReader
+        {
+            public:
+                BinaryReader() : header(nullptr), table(nullptr) {};
+
+                BinaryStatus Open(const char *Path)
+                {
+                    Close();
+
+                    if (!file.Open(Path))
+                        return BinaryStatus::OpenFailed;
+
+                    BinaryStatus status = Validate();
+
+                    if (status != BinaryStatus::Success)
+                        Close();
+
+                    return status;
+                };
+
+                void Close()
+                {
+                    file.Close();
+                    header = nullptr;
+                    table = nullptr;
+                };
+
+                bool IsOpen() const
+                {
+                    return (header != nullptr);
+                };
+
+                std::size_t GetSectionCount() const
+                {
+                    return (header ? header->sectionCount : 0);
+                };
+
+                const SectionEntry &GetSection(std::size_t Index) const
+                {
+                    return table[Index];
+                };
+
+                // Returns nullptr when no section has this name.
+                const SectionEntry *FindSection(const char *Name) const
+                {
+                    for (std::size_t i = 0; i < GetSectionCount(); i++)
+                    {
+                        if (std::strncmp(table[i].name, Name, SectionNameLength) == 0)
+                            return &table[i];
+                    }
+
+                    return nullptr;
+                };
+
+                const void *GetStream(const SectionEntry &Section, std::uint32_t Component) const
+                {
+                    if (Component >= Section.components)
+                        return nullptr;
+
+                    return file.GetData() + Section.offset + Component * Section.stride;
+                };
+
+                // Typed access; returns nullptr on a missing section, a type mismatch or an out of
+                // range component. The pointer is SectionAlignment aligned and lives until Close().
+                template <typename T> const T *GetStream(const char *Name, std::uint32_t Component = 0) const
+                {
+                    const SectionEntry *section = FindSection(Name);
+
+                    if (!section || section->type != ElementTypeOf<T>::value)
+                        return nullptr;
+
+                    return static_cast<const T *>(GetStream(*section, Component));
+                };
+
+                // Recomputes the section checksums, reading every page of the section.
+                bool Verify(const SectionEntry &Section) const
+                {
+                    const std::size_t size = static_cast<std::size_t>(Section.count * GetElementSize(Section.type));
+
+                    for (std::uint32_t i = 0; i < Section.components; i++)
+                    {
+                        if (Crc32c::Compute(GetStream(Section, i), size) != Section.checksums[i])
+                            return false;
+                    }
+
+                    return true;
+                };
+
+                bool Verify() const
+                {
+                    for (std::size_t i = 0; i < GetSectionCount(); i++)
+                    {
+                        if (!Verify(table[i]))
+                            return false;
+                    }
+
+                    return true;
+                };
+
+                // Asks the system to start reading a section ahead of use.
+                void Prefetch(const SectionEntry &Section) const
+                {
+                    file.Prefetch(static_cast<std::size_t>(Section.offset), static_cast<std::size_t>(Section.stride * Section.components));
+                };
+
+            private:
+                BinaryStatus Validate()
+                {
+                    const unsigned char *data = file.GetData();
+                    const std::uint64_t size = file.GetSize();
+
+                    if (size < sizeof(FileHeader))
+                        return BinaryStatus::Truncated;
+
+                    const FileHeader *candidate = reinterpret_cast<const FileHeader *>(data);
+
+                    if (candidate->magic != BinaryMagic)
+                        return BinaryStatus::BadMagic;
+
+                    // Minor versions only add fields in reserved space.
+                    if (candidate->versionMajor != BinaryVersionMajor || candidate->headerSize < sizeof(FileHeader))
+                        return BinaryStatus::UnsupportedVersion;
+
+                    FileHeader copy = *candidate;
+                    copy.headerChecksum = 0;
+
+                    if (Crc32c::Compute(&copy, sizeof(copy)) != candidate->headerChecksum)
+                        return BinaryStatus::HeaderChecksumMismatch;
+
+                    const std::uint64_t tableSize = static_cast<std::uint64_t>(candidate->sectionCount) * sizeof(SectionEntry);
+
+                    if (candidate->fileSize > size || candidate->tableOffset > size || tableSize > size - candidate->tableOffset)
+                        return BinaryStatus::Truncated;
+
+                    if (candidate->tableOffset % alignof(SectionEntry) != 0)
+                        return BinaryStatus::InvalidSection;
+
+                    const SectionEntry *entries = reinterpret_cast<const SectionEntry *>(data + candidate->tableOffset);
+
+                    if (Crc32c::Compute(entries, static_cast<std::size_t>(tableSize)) != candidate->tableChecksum)
+                        return BinaryStatus::TableChecksumMismatch;
+
+                    // Bound every stream by the file so later pointer arithmetic cannot leave the
+                    // mapping, whatever the table says.
+                    for (std::uint32_t i = 0; i < candidate->sectionCount; i++)
+                    {
+                        const SectionEntry &entry = entries[i];
+                        const std::uint64_t elementSize = GetElementSize(entry.type);
+
+                        if (elementSize == 0 || entry.components == 0 || entry.components > SectionMaximumComponents)
+                            return BinaryStatus::InvalidSection;
+
+                        if (entry.offset % SectionAlignment != 0 || entry.stride % SectionAlignment != 0 || entry.offset > size)
+                            return BinaryStatus::InvalidSection;
+
+                        if (entry.stride > size || entry.count > entry.stride / elementSize || entry.stride * entry.components > size - entry.offset)
+                            return BinaryStatus::InvalidSection;
+                    }
+
+                    header = candidate;
+                    table = entries;
+
+                    return BinaryStatus::Success;
+                };
+
+                MappedFile file;
+                const FileHeader *header;
+                const SectionEntry *table;
+        };
+    };
+};
+
+#endif // WARLOCK_IO_BINARYREADER_HPP
@@ -0,0 +1,294 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/IO/BinaryWriter.hpp
+// Description: Streaming writer for the binary container format.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_IO_BINARYWRITER_HPP
+#define WARLOCK_IO_BINARYWRITER_HPP
+
+#include "BinaryFormat.hpp"
+#include "Checksum.hpp"
+#include "Math/Matrix2.hpp"
+#include "Math/Vector3.hpp"
+#include "Platform/Platform.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#if !(WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+#include <sys/types.h>
+#endif
+
+namespace Warlock
+{
+    namespace IO
+    {
+        // Writes sections without holding them in memory. The element count of a section is
+        // declared up front, which fixes where every component stream lives; data is then written
+        // in pieces of any size, in any component order, while checksums accumulate per stream.
+        // The section table and the final header go out on Close().
+        class BinaryWriter
+        {
+            public:
+                // Elements converted per block when writing interleaved arrays.
+                static constexpr std::size_t BlockSize = 16384;
+
+                BinaryWriter() : file(nullptr), end(0), open(false), failed(false) {};
+
+                ~BinaryWriter()
+                {
+                    Close();
+                };
+
+                BinaryWriter(const BinaryWriter &) = delete;
+                BinaryWriter &operator =(const BinaryWriter &) = delete;
+
+                bool Open(const char *Path)
+                {
+                    Close();
+
+                    file = std::fopen(Path, "wb");
+                    failed = (file == nullptr);
+                    sections.clear();
+                    end = sizeof(FileHeader);
+
+                    if (failed)
+                        return false;
+
+                    // Placeholder, rewritten once the table is known.
+                    FileHeader header = {};
+                    return WriteAt(0, &header, sizeof(header));
+                };
+
+                // Starts a section of Count elements with Components streams each. Only one
+                // section is open at a time.
+                bool BeginSection(const char *Name, ElementType Type, std::uint32_t Components, std::uint64_t Count)
+                {
+                    if (!file || failed || open || Components == 0 || Components > SectionMaximumComponents)
+                        return Fail();
+
+                    if (std::strlen(Name) >= SectionNameLength)
+                        return Fail();
+
+                    SectionEntry entry = {};
+                    std::memcpy(entry.name, Name, std::strlen(Name));
+                    entry.type = Type;
+                    entry.components = Components;
+                    entry.count = Count;
+                    entry.offset = Align(end);
+                    entry.stride = Align(Count * GetElementSize(Type));
+
+                    sections.push_back(entry);
+                    end = entry.offset + entry.stride * Components;
+                    open = true;
+
+                    for (std::uint32_t i = 0; i < SectionMaximumComponents; i++)
+                    {
+                        written[i] = 0;
+                        checksums[i] = Crc32c();
+                    }
+
+                    return true;
+                };
+
+                // Appends Count elements to one component stream of the open section.
+                bool Write(std::uint32_t Component, const void *Data, std::uint64_t Count)
+                {
+                    if (!open || failed)
+                        return Fail();
+
+                    SectionEntry &entry = sections.back();
+
+                    if (Component >= entry.components || written[Component] + Count > entry.count)
+                        return Fail();
+
+                    const std::uint64_t elementSize = GetElementSize(entry.type);
+                    const std::uint64_t position = entry.offset + Component * entry.stride + written[Component] * elementSize;
+
+                    checksums[Component].Update(Data, static_cast<std::size_t>(Count * elementSize));
+                    written[Component] += Count;
+
+                    return WriteAt(position, Data, static_cast<std::size_t>(Count * elementSize));
+                };
+
+                template <typename T> bool Write(std::uint32_t Component, const T *Data, std::uint64_t Count)
+                {
+                    if (!open || sections.back().type != ElementTypeOf<T>::value)
+                        return Fail();
+
+                    return Write(Component, static_cast<const void *>(Data), Count);
+                };
+
+                // Closes the open section; every stream must have received all its elements.
+                bool EndSection()
+                {
+                    if (!open || failed)
+                        return Fail();
+
+                    SectionEntry &entry = sections.back();
+
+                    for (std::uint32_t i = 0; i < entry.components; i++)
+                    {
+                        if (written[i] != entry.count)
+                            return Fail();
+
+                        entry.checksums[i] = checksums[i].Value();
+                    }
+
+                    open = false;
+                    return true;
+                };
+
+                template <typename T> bool WriteSection(const char *Name, const T *Values, std::uint64_t Count)
+                {
+                    return BeginSection(Name, ElementTypeOf<T>::value, 1, Count) && Write(0, Values, Count) && EndSection();
+                };
+
+                // Splits an array of vectors into x, y and z streams a block at a time.
+                template <typename T> bool WriteSection(const char *Name, const Math::Vector3<T> *Values, std::uint64_t Count)
+                {
+                    if (!BeginSection(Name, ElementTypeOf<T>::value, 3, Count))
+                        return false;
+
+                    std::vector<T> block(3 * BlockSize);
+
+                    for (std::uint64_t first = 0; first < Count; first += BlockSize)
+                    {
+                        const std::size_t size = static_cast<std::size_t>(std::min<std::uint64_t>(BlockSize, Count - first));
+
+                        for (std::size_t i = 0; i < size; i++)
+                        {
+                            block[i] = Values[first + i].x;
+                            block[BlockSize + i] = Values[first + i].y;
+                            block[2 * BlockSize + i] = Values[first + i].z;
+                        }
+
+                        for (std::uint32_t component = 0; component < 3; component++)
+                        {
+                            if (!Write(component, block.data() + component * BlockSize, size))
+                                return false;
+                        }
+                    }
+
+                    return EndSection();
+                };
+
+                // Splits an array of matrices into one stream per element, row major.
+                template <typename T> bool WriteSection(const char *Name, const Math::Matrix2<T> *Values, std::uint64_t Count)
+                {
+                    if (!BeginSection(Name, ElementTypeOf<T>::value, 4, Count))
+                        return false;
+
+                    std::vector<T> block(4 * BlockSize);
+
+                    for (std::uint64_t first = 0; first < Count; first += BlockSize)
+                    {
+                        const std::size_t size = static_cast<std::size_t>(std::min<std::uint64_t>(BlockSize, Count - first));
+
+                        for (std::size_t i = 0; i < size; i++)
+                        {
+                            for (std::size_t element = 0; element < 4; element++)
+                                block[element * BlockSize + i] = Values[first + i].m[element >> 1][element & 1];
+                        }
+
+                        for (std::uint32_t component = 0; component < 4; component++)
+                        {
+                            if (!Write(component, block.data() + component * BlockSize, size))
+                                return false;
+                        }
+                    }
+
+                    return EndSection();
+                };
+
+                // Writes the section table and header. Returns false if anything failed since
+                // Open(), in which case the file must not be trusted.
+                bool Close()
+                {
+                    if (!file)
+                        return false;
+
+                    if (open)
+                        Fail();
+
+                    FileHeader header = {};
+                    header.magic = BinaryMagic;
+                    header.versionMajor = BinaryVersionMajor;
+                    header.versionMinor = BinaryVersionMinor;
+                    header.headerSize = sizeof(FileHeader);
+                    header.sectionCount = static_cast<std::uint32_t>(sections.size());
+                    header.tableOffset = Align(end);
+                    header.fileSize = header.tableOffset + sections.size() * sizeof(SectionEntry);
+                    header.tableChecksum = Crc32c::Compute(sections.data(), sections.size() * sizeof(SectionEntry));
+                    header.headerChecksum = Crc32c::Compute(&header, sizeof(header));
+
+                    if (!failed)
+                        WriteAt(header.tableOffset, sections.data(), sections.size() * sizeof(SectionEntry));
+
+                    if (!failed)
+                        WriteAt(0, &header, sizeof(header));
+
+                    if (std::fclose(file) != 0)
+                        failed = true;
+
+                    file = nullptr;
+                    open = false;
+                    sections.clear();
+
+                    return !failed;
+                };
+
+            private:
+                static std::uint64_t Align(std::uint64_t Value)
+                {
+                    return (Value + SectionAlignment - 1) & ~static_cast<std::uint64_t>(SectionAlignment - 1);
+                };
+
+                bool Fail()
+                {
+                    failed = true;
+                    return false;
+                };
+
+                bool WriteAt(std::uint64_t Position, const void *Data, std::size_t Size)
+                {
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                    int seek = _fseeki64(file, static_cast<long long>(Position), SEEK_SET);
+#else
+                    int seek = fseeko(file, static_cast<off_t>(Position), SEEK_SET);
+#endif
+
+                    // Seeking past the end leaves a zero filled gap, which is the alignment padding.
+                    if (seek != 0 || std::fwrite(Data, 1, Size, file) != Size)
+                        return Fail();
+
+                    return true;
+                };
+
+                std::FILE *file;
+                std::vector<SectionEntry> sections;
+                std::uint64_t end;
+                std::uint64_t written[SectionMaximumComponents];
+                Crc32c checksums[SectionMaximumComponents];
+                bool open;
+                bool failed;
+        };
+    };
+};
+
+#endif // WARLOCK_IO_BINARYWRITER_HPP
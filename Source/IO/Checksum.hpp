@@ -0,0 +1,109 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/IO/Checksum.hpp
+// Description: Incremental CRC-32C checksums.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_IO_CHECKSUM_HPP
+#define WARLOCK_IO_CHECKSUM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Warlock
+{
+    namespace IO
+    {
+        namespace Detail
+        {
+            // Slicing by 8 tables for the reflected Castagnoli polynomial, built at compile time.
+            struct Crc32cTable
+            {
+                constexpr Crc32cTable() : entries()
+                {
+                    for (std::uint32_t i = 0; i < 256; i++)
+                    {
+                        std::uint32_t crc = i;
+
+                        for (int bit = 0; bit < 8; bit++)
+                            crc = (crc >> 1) ^ (0x82F63B78u & (0u - (crc & 1u)));
+
+                        entries[0][i] = crc;
+                    }
+
+                    for (std::uint32_t i = 0; i < 256; i++)
+                    {
+                        for (int slice = 1; slice < 8; slice++)
+                            entries[slice][i] = (entries[slice - 1][i] >> 8) ^ entries[0][entries[slice - 1][i] & 0xFF];
+                    }
+                };
+
+                std::uint32_t entries[8][256];
+            };
+        };
+
+        // Feed data in any number of pieces; Value() returns the checksum of everything so far.
+        class Crc32c
+        {
+            public:
+                Crc32c() : state(0xFFFFFFFFu) {};
+
+                void Update(const void *Data, std::size_t Size)
+                {
+                    static constexpr Detail::Crc32cTable table;
+                    const unsigned char *bytes = static_cast<const unsigned char *>(Data);
+                    std::uint32_t crc = state;
+
+                    for (; Size >= 8; Size -= 8, bytes += 8)
+                    {
+                        std::uint32_t low, high;
+                        std::memcpy(&low, bytes, 4);
+                        std::memcpy(&high, bytes + 4, 4);
+
+                        // The tables are built for little endian loads, matching the file format.
+                        low ^= crc;
+                        crc = table.entries[7][low & 0xFF] ^ table.entries[6][(low >> 8) & 0xFF] ^ table.entries[5][(low >> 16) & 0xFF] ^
+                              table.entries[4][low >> 24] ^ table.entries[3][high & 0xFF] ^ table.entries[2][(high >> 8) & 0xFF] ^
+                              table.entries[1][(high >> 16) & 0xFF] ^ table.entries[0][high >> 24];
+                    }
+
+                    for (; Size > 0; Size--, bytes++)
+                        crc = (crc >> 8) ^ table.entries[0][(crc ^ *bytes) & 0xFF];
+
+                    state = crc;
+                };
+
+                std::uint32_t Value() const
+                {
+                    return state ^ 0xFFFFFFFFu;
+                };
+
+                static std::uint32_t Compute(const void *Data, std::size_t Size)
+                {
+                    Crc32c crc;
+                    crc.Update(Data, Size);
+
+                    return crc.Value();
+                };
+
+            private:
+                std::uint32_t state;
+        };
+    };
+};
+
+#endif // WARLOCK_IO_CHECKSUM_HPP
@@ -0,0 +1,201 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/IO/MappedFile.hpp
+// Description: Read only memory mapping of whole files.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_IO_MAPPEDFILE_HPP
+#define WARLOCK_IO_MAPPEDFILE_HPP
+
+#include "Platform/Platform.hpp"
+#include <cstddef>
+#include <cstdint>
+
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Warlock
+{
+    namespace IO
+    {
+        // Maps a file read only. Nothing is read up front: pages are faulted in by the system as
+        // they are first touched, and stay shared with the page cache.
+        class MappedFile
+        {
+            public:
+                MappedFile() : data(nullptr), size(0)
+                {
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                    file = INVALID_HANDLE_VALUE;
+                    mapping = nullptr;
+#endif
+                };
+
+                ~MappedFile()
+                {
+                    Close();
+                };
+
+                MappedFile(const MappedFile &) = delete;
+                MappedFile &operator =(const MappedFile &) = delete;
+
+                bool Open(const char *Path)
+                {
+                    Close();
+
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                    file = CreateFileA(Path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+                    if (file == INVALID_HANDLE_VALUE)
+                        return false;
+
+                    LARGE_INTEGER length;
+
+                    if (!GetFileSizeEx(file, &length) || length.QuadPart == 0)
+                    {
+                        Close();
+                        return false;
+                    }
+
+                    mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+                    if (!mapping)
+                    {
+                        Close();
+                        return false;
+                    }
+
+                    data = static_cast<const unsigned char *>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+                    size = static_cast<std::size_t>(length.QuadPart);
+#else
+                    int descriptor = open(Path, O_RDONLY);
+
+                    if (descriptor < 0)
+                        return false;
+
+                    struct stat status;
+
+                    if (fstat(descriptor, &status) != 0 || status.st_size == 0)
+                    {
+                        close(descriptor);
+                        return false;
+                    }
+
+                    void *view = mmap(nullptr, static_cast<std::size_t>(status.st_size), PROT_READ, MAP_SHARED, descriptor, 0);
+
+                    // The mapping keeps its own reference to the file.
+                    close(descriptor);
+
+                    if (view == MAP_FAILED)
+                        return false;
+
+                    data = static_cast<const unsigned char *>(view);
+                    size = static_cast<std::size_t>(status.st_size);
+#endif
+
+                    if (!data)
+                    {
+                        Close();
+                        return false;
+                    }
+
+                    return true;
+                };
+
+                void Close()
+                {
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                    if (data)
+                        UnmapViewOfFile(data);
+
+                    if (mapping)
+                        CloseHandle(mapping);
+
+                    if (file != INVALID_HANDLE_VALUE)
+                        CloseHandle(file);
+
+                    file = INVALID_HANDLE_VALUE;
+                    mapping = nullptr;
+#else
+                    if (data)
+                        munmap(const_cast<unsigned char *>(data), size);
+#endif
+
+                    data = nullptr;
+                    size = 0;
+                };
+
+                bool IsOpen() const
+                {
+                    return (data != nullptr);
+                };
+
+                const unsigned char *GetData() const
+                {
+                    return data;
+                };
+
+                std::size_t GetSize() const
+                {
+                    return size;
+                };
+
+                // Hints that a range will be read soon, so the system can start reading it in.
+                void Prefetch(std::size_t Offset, std::size_t Length) const
+                {
+                    if (!data || Offset >= size)
+                        return;
+
+                    if (Length > size - Offset)
+                        Length = size - Offset;
+
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                    WIN32_MEMORY_RANGE_ENTRY range;
+                    range.VirtualAddress = const_cast<unsigned char *>(data + Offset);
+                    range.NumberOfBytes = Length;
+                    PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+                    // madvise wants a page aligned start.
+                    std::uintptr_t page = static_cast<std::uintptr_t>(sysconf(_SC_PAGESIZE));
+                    std::uintptr_t start = reinterpret_cast<std::uintptr_t>(data + Offset) & ~(page - 1);
+                    std::uintptr_t end = reinterpret_cast<std::uintptr_t>(data + Offset + Length);
+
+                    madvise(reinterpret_cast<void *>(start), end - start, MADV_WILLNEED);
+#endif
+                };
+
+            private:
+                const unsigned char *data;
+                std::size_t size;
+
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                HANDLE file;
+                HANDLE mapping;
+#endif
+        };
+    };
+};
+
+#endif // WARLOCK_IO_MAPPEDFILE_HPP
@@ -0,0 +1,285 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/IO/SharedMemory.hpp
+// Description: Memory regions shared between processes.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_IO_SHAREDMEMORY_HPP
+#define WARLOCK_IO_SHAREDMEMORY_HPP
+
+#include "Platform/Platform.hpp"
+#include <cstddef>
+#include <cstdint>
+
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace Warlock
+{
+    namespace IO
+    {
+        // A read write mapping of memory that other processes can map too. Named regions go
+        // through shm_open (a "/name" on POSIX) or a named file mapping on Windows and outlive the
+        // creator until unlinked. Anonymous regions are a memfd on Linux, handed to other
+        // processes over a Unix socket, to forked children, or across exec when created
+        // inheritable, and vanish with the last mapping.
+        class SharedMemory
+        {
+            public:
+                SharedMemory() : data(nullptr), size(0)
+                {
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                    mapping = nullptr;
+#else
+                    descriptor = -1;
+#endif
+                };
+
+                ~SharedMemory()
+                {
+                    Close();
+                };
+
+                SharedMemory(const SharedMemory &) = delete;
+                SharedMemory &operator =(const SharedMemory &) = delete;
+
+                // Fails if a region with this name already exists.
+                bool Create(const char *Name, std::size_t Size)
+                {
+                    Close();
+
+                    if (Size == 0)
+                        return false;
+
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                    mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, static_cast<DWORD>(static_cast<std::uint64_t>(Size) >> 32), static_cast<DWORD>(Size), Name);
+
+                    if (mapping && GetLastError() == ERROR_ALREADY_EXISTS)
+                    {
+                        Close();
+                        return false;
+                    }
+
+                    return Map(Size);
+#else
+                    descriptor = shm_open(Name, O_RDWR | O_CREAT | O_EXCL, 0600);
+
+                    if (descriptor < 0)
+                        return false;
+
+                    if (ftruncate(descriptor, static_cast<off_t>(Size)) != 0)
+                    {
+                        Close();
+                        shm_unlink(Name);
+                        return false;
+                    }
+
+                    if (!Map(Size))
+                    {
+                        shm_unlink(Name);
+                        return false;
+                    }
+
+                    return true;
+#endif
+                };
+
+                bool Open(const char *Name)
+                {
+                    Close();
+
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                    mapping = OpenFileMappingA(FILE_MAP_ALL_ACCESS, FALSE, Name);
+
+                    // The size of a named mapping is only known once a view of it exists.
+                    if (!Map(0))
+                        return false;
+
+                    MEMORY_BASIC_INFORMATION information;
+
+                    if (VirtualQuery(data, &information, sizeof(information)) == 0)
+                    {
+                        Close();
+                        return false;
+                    }
+
+                    size = information.RegionSize;
+
+                    return true;
+#else
+                    descriptor = shm_open(Name, O_RDWR, 0);
+
+                    return MapDescriptor();
+#endif
+                };
+
+                // Anonymous region, only available where memfd_create is. The descriptor is closed
+                // on exec unless Inheritable, which lets a spawned program Attach() it by number.
+                bool CreateAnonymous(std::size_t Size, bool Inheritable = false)
+                {
+                    Close();
+
+#if WARLOCK_SYSTEM_LINUX
+                    if (Size == 0)
+                        return false;
+
+                    descriptor = memfd_create("warlock", (Inheritable ? 0u : MFD_CLOEXEC));
+
+                    if (descriptor < 0)
+                        return false;
+
+                    if (ftruncate(descriptor, static_cast<off_t>(Size)) != 0)
+                    {
+                        Close();
+                        return false;
+                    }
+
+                    return Map(Size);
+#else
+                    (void)Size;
+                    (void)Inheritable;
+
+                    return false;
+#endif
+                };
+
+#if !(WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                // Maps a descriptor received from another process and takes ownership of it.
+                bool Attach(int Descriptor)
+                {
+                    Close();
+                    descriptor = Descriptor;
+
+                    return MapDescriptor();
+                };
+
+                // The descriptor to pass to another process; stays owned by this object.
+                int GetDescriptor() const
+                {
+                    return descriptor;
+                };
+#endif
+
+                // Removes the name; processes that have the region mapped keep it.
+                static void Unlink(const char *Name)
+                {
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                    (void)Name;
+#else
+                    shm_unlink(Name);
+#endif
+                };
+
+                void Close()
+                {
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                    if (data)
+                        UnmapViewOfFile(data);
+
+                    if (mapping)
+                        CloseHandle(mapping);
+
+                    mapping = nullptr;
+#else
+                    if (data)
+                        munmap(data, size);
+
+                    if (descriptor >= 0)
+                        close(descriptor);
+
+                    descriptor = -1;
+#endif
+
+                    data = nullptr;
+                    size = 0;
+                };
+
+                bool IsOpen() const
+                {
+                    return (data != nullptr);
+                };
+
+                unsigned char *GetData() const
+                {
+                    return data;
+                };
+
+                std::size_t GetSize() const
+                {
+                    return size;
+                };
+
+            private:
+                bool Map(std::size_t Size)
+                {
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                    if (mapping)
+                        data = static_cast<unsigned char *>(MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, Size));
+#else
+                    void *view = mmap(nullptr, Size, PROT_READ | PROT_WRITE, MAP_SHARED, descriptor, 0);
+
+                    if (view != MAP_FAILED)
+                        data = static_cast<unsigned char *>(view);
+#endif
+
+                    if (!data)
+                    {
+                        Close();
+                        return false;
+                    }
+
+                    size = Size;
+
+                    return true;
+                };
+
+#if !(WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                bool MapDescriptor()
+                {
+                    struct stat status;
+
+                    if (descriptor < 0 || fstat(descriptor, &status) != 0 || status.st_size == 0)
+                    {
+                        Close();
+                        return false;
+                    }
+
+                    return Map(static_cast<std::size_t>(status.st_size));
+                };
+#endif
+
+                unsigned char *data;
+                std::size_t size;
+
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                HANDLE mapping;
+#else
+                int descriptor;
+#endif
+        };
+    };
+};
+
+#endif // WARLOCK_IO_SHAREDMEMORY_HPP
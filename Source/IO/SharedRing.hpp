@@ -0,0 +1,742 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/IO/SharedRing.hpp
+// Description: Single writer, multiple reader message ring in shared memory.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_IO_SHAREDRING_HPP
+#define WARLOCK_IO_SHAREDRING_HPP
+
+#include "BinaryFormat.hpp"
+#include "SharedMemory.hpp"
+#include "Math/Vector3.hpp"
+#include "Platform/Platform.hpp"
+#include <atomic>
+#include <chrono>
+#include <climits>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+
+#if WARLOCK_SYSTEM_LINUX
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Warlock
+{
+    namespace IO
+    {
+        // The region is a header, then the ring on a page boundary:
+        //
+        //   RingHeader | reader slots | ring of capacity bytes
+        //
+        // Messages are a 64 byte record followed by the payload, padded to the next record, so a
+        // payload always starts on a cache line. A message never wraps: when one does not fit
+        // before the end of the ring a wrap record fills the rest and it goes at the start.
+        //
+        // The writer publishes by storing the end of the last message; every reader sees every
+        // message and keeps its own position, and the writer does not overwrite what the slowest
+        // attached reader has not released. Positions are byte counts since creation, so the
+        // slot of a position is position & (capacity - 1).
+        constexpr std::uint32_t RingMagic = 0x474E5257; // "WRNG"
+        constexpr std::uint32_t RingVersion = 1;
+        constexpr std::size_t RingAlignment = 64;
+        constexpr std::uint32_t RingMaximumReaders = 16;
+
+        // Yields before falling back to sleeping on the futex.
+        constexpr unsigned int RingSpinCount = 64;
+
+        static_assert(std::atomic<std::uint32_t>::is_always_lock_free && std::atomic<std::uint64_t>::is_always_lock_free, "Shared ring atomics must be address free");
+
+        namespace Detail
+        {
+            constexpr std::uint64_t RingWrapMarker = ~static_cast<std::uint64_t>(0);
+
+            enum RingReaderState : std::uint32_t
+            {
+                RingReaderFree,
+                RingReaderJoining,
+                RingReaderActive
+            };
+
+            struct alignas(RingAlignment) RingReaderSlot
+            {
+                std::atomic<std::uint32_t> state;
+                std::atomic<std::uint64_t> position;
+            };
+
+            struct RingHeader
+            {
+                std::uint32_t magic;
+                std::uint32_t version;
+                std::uint64_t capacity;
+                std::uint64_t dataOffset;
+
+                // Written by the writer.
+                alignas(RingAlignment) std::atomic<std::uint64_t> written;
+                std::atomic<std::uint32_t> writeSignal;
+                std::atomic<std::uint32_t> readersWaiting;
+                std::atomic<std::uint32_t> closed;
+
+                // Written by the readers.
+                alignas(RingAlignment) std::atomic<std::uint32_t> readSignal;
+                std::atomic<std::uint32_t> writerWaiting;
+
+                RingReaderSlot readers[RingMaximumReaders];
+            };
+
+            struct RingRecord
+            {
+                // Payload bytes, or RingWrapMarker.
+                std::uint64_t size;
+                std::uint32_t tag;
+                ElementType type;
+
+                // Zero for raw bytes; otherwise the payload is this many component streams of
+                // count elements, stride bytes apart.
+                std::uint32_t components;
+                std::uint32_t reserved0;
+                std::uint64_t count;
+                std::uint64_t stride;
+                std::uint64_t reserved[3];
+            };
+
+            static_assert(sizeof(RingRecord) == RingAlignment, "RingRecord layout changed");
+
+            inline std::uint64_t AlignRing(std::uint64_t Value)
+            {
+                return (Value + RingAlignment - 1) & ~static_cast<std::uint64_t>(RingAlignment - 1);
+            };
+
+            // Sleeps while Word holds Expected, for at most Milliseconds when that is not
+            // negative; may return early. Elsewhere than Linux this polls.
+            inline void WaitOnWord(std::atomic<std::uint32_t> &Word, std::uint32_t Expected, int Milliseconds)
+            {
+#if WARLOCK_SYSTEM_LINUX
+                // Not FUTEX_PRIVATE_FLAG: the word is shared with other processes.
+                struct timespec timeout = {Milliseconds / 1000, (Milliseconds % 1000) * 1000000L};
+                syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&Word), FUTEX_WAIT, Expected, Milliseconds < 0 ? nullptr : &timeout, nullptr, 0);
+#else
+                if (Word.load() == Expected)
+                    std::this_thread::sleep_for(std::chrono::microseconds(Milliseconds == 0 ? 0 : 100));
+#endif
+            };
+
+            inline void WakeWord(std::atomic<std::uint32_t> &Word)
+            {
+#if WARLOCK_SYSTEM_LINUX
+                syscall(SYS_futex, reinterpret_cast<std::uint32_t *>(&Word), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+#else
+                (void)Word;
+#endif
+            };
+
+            // Milliseconds left until Deadline, or -1 for no deadline.
+            class RingTimeout
+            {
+                public:
+                    RingTimeout(int Milliseconds) : infinite(Milliseconds < 0), deadline(std::chrono::steady_clock::now() + std::chrono::milliseconds(Milliseconds < 0 ? 0 : Milliseconds)) {};
+
+                    bool IsExpired() const
+                    {
+                        return (!infinite && std::chrono::steady_clock::now() >= deadline);
+                    };
+
+                    int GetRemaining() const
+                    {
+                        if (infinite)
+                            return -1;
+
+                        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count();
+
+                        return static_cast<int>(remaining < 0 ? 0 : remaining + 1);
+                    };
+
+                private:
+                    bool infinite;
+                    std::chrono::steady_clock::time_point deadline;
+            };
+
+            inline std::size_t GetRingRegionSize(std::uint64_t Capacity)
+            {
+                return static_cast<std::size_t>(((sizeof(RingHeader) + 4095) & ~static_cast<std::size_t>(4095)) + Capacity);
+            };
+        };
+
+        // Component streams of a batch laid out in the ring, read or filled in place.
+        template <typename T> class RingBatch
+        {
+            public:
+                RingBatch() : data(nullptr), count(0), stride(0), components(0) {};
+                RingBatch(T *Data, std::uint64_t Count, std::uint64_t Stride, std::uint32_t Components) : data(Data), count(Count), stride(Stride), components(Components) {};
+
+                bool IsValid() const
+                {
+                    return (data != nullptr);
+                };
+
+                // Each stream starts on a 64 byte boundary.
+                T *GetComponent(std::uint32_t Component) const
+                {
+                    return data + Component * stride;
+                };
+
+                std::uint64_t GetCount() const
+                {
+                    return count;
+                };
+
+                std::uint32_t GetComponentCount() const
+                {
+                    return components;
+                };
+
+            private:
+                T *data;
+                std::uint64_t count;
+
+                // In elements.
+                std::uint64_t stride;
+                std::uint32_t components;
+        };
+
+        // A message as seen by a reader; the data stays in the ring until Release().
+        struct RingMessage
+        {
+            std::uint32_t tag;
+            ElementType type;
+            std::uint32_t components;
+            std::uint64_t count;
+            std::uint64_t stride;
+            const unsigned char *data;
+            std::size_t size;
+
+            // Empty unless the message is a batch of T.
+            template <typename T> RingBatch<const T> GetBatch() const
+            {
+                if (components == 0 || type != ElementTypeOf<T>::value)
+                    return RingBatch<const T>();
+
+                return RingBatch<const T>(reinterpret_cast<const T *>(data), count, stride / sizeof(T), components);
+            };
+        };
+
+        // Only one writer per ring. Without attached readers nothing holds the writer back and
+        // messages are simply overwritten.
+        class SharedRingWriter
+        {
+            public:
+                SharedRingWriter() : header(nullptr), ring(nullptr), capacity(0), cursor(0), pending(nullptr), pendingEnd(0) {};
+
+                ~SharedRingWriter()
+                {
+                    Close();
+                };
+
+                SharedRingWriter(const SharedRingWriter &) = delete;
+                SharedRingWriter &operator =(const SharedRingWriter &) = delete;
+
+                // Capacity is rounded up to a power of two of at least 4 KiB; the largest message
+                // is half of it. The name is unlinked on Close().
+                bool Create(const char *Name, std::size_t Capacity)
+                {
+                    Close();
+
+                    if (!memory.Create(Name, Detail::GetRingRegionSize(RoundCapacity(Capacity))))
+                        return false;
+
+                    name = Name;
+
+                    return Initialize(RoundCapacity(Capacity));
+                };
+
+                // Over a memfd, for readers that get the descriptor from GetMemory().
+                bool CreateAnonymous(std::size_t Capacity)
+                {
+                    Close();
+
+                    if (!memory.CreateAnonymous(Detail::GetRingRegionSize(RoundCapacity(Capacity))))
+                        return false;
+
+                    return Initialize(RoundCapacity(Capacity));
+                };
+
+                // Wakes readers, which drain what was published and then see the ring closed.
+                void Close()
+                {
+                    if (header)
+                    {
+                        header->closed.store(1);
+                        header->writeSignal.fetch_add(1);
+                        Detail::WakeWord(header->writeSignal);
+                    }
+
+                    if (!name.empty())
+                        SharedMemory::Unlink(name.c_str());
+
+                    memory.Close();
+                    name.clear();
+                    header = nullptr;
+                    ring = nullptr;
+                    capacity = 0;
+                    cursor = 0;
+                    pending = nullptr;
+                };
+
+                // Space for a raw message of Size bytes, filled in place and published by
+                // Commit(). Returns nullptr on timeout, when a message is already pending or
+                // when Size is over GetMaximumMessageSize(). Pass a timeout when readers may
+                // die attached, as they hold the writer back.
+                void *Reserve(std::size_t Size, std::uint32_t Tag, int TimeoutMilliseconds = -1)
+                {
+                    Detail::RingRecord *record = ReserveRecord(Size, TimeoutMilliseconds);
+
+                    if (!record)
+                        return nullptr;
+
+                    record->tag = Tag;
+                    record->type = ElementType::UInt8;
+                    record->components = 0;
+                    record->count = Size;
+                    record->stride = 0;
+
+                    return record + 1;
+                };
+
+                // Space for Components streams of Count elements of T.
+                template <typename T> RingBatch<T> ReserveBatch(std::uint64_t Count, std::uint32_t Components, std::uint32_t Tag, int TimeoutMilliseconds = -1)
+                {
+                    const std::uint64_t stride = Detail::AlignRing(Count * sizeof(T));
+                    Detail::RingRecord *record = ReserveRecord(static_cast<std::size_t>(stride * Components), TimeoutMilliseconds);
+
+                    if (!record)
+                        return RingBatch<T>();
+
+                    record->tag = Tag;
+                    record->type = ElementTypeOf<T>::value;
+                    record->components = Components;
+                    record->count = Count;
+                    record->stride = stride;
+
+                    return RingBatch<T>(reinterpret_cast<T *>(record + 1), Count, stride / sizeof(T), Components);
+                };
+
+                // Publishes the pending message and wakes sleeping readers.
+                void Commit()
+                {
+                    if (!pending)
+                        return;
+
+                    pending = nullptr;
+                    cursor = pendingEnd;
+                    header->written.store(cursor);
+
+                    if (header->readersWaiting.load() != 0)
+                    {
+                        header->writeSignal.fetch_add(1);
+                        Detail::WakeWord(header->writeSignal);
+                    }
+                };
+
+                bool Publish(const void *Data, std::size_t Size, std::uint32_t Tag, int TimeoutMilliseconds = -1)
+                {
+                    void *payload = Reserve(Size, Tag, TimeoutMilliseconds);
+
+                    if (!payload)
+                        return false;
+
+                    std::memcpy(payload, Data, Size);
+                    Commit();
+
+                    return true;
+                };
+
+                // Splits the vectors into x, y and z streams straight into the ring.
+                template <typename T> bool Publish(const Math::Vector3<T> *Values, std::uint64_t Count, std::uint32_t Tag, int TimeoutMilliseconds = -1)
+                {
+                    RingBatch<T> batch = ReserveBatch<T>(Count, 3, Tag, TimeoutMilliseconds);
+
+                    if (!batch.IsValid())
+                        return false;
+
+                    T *x = batch.GetComponent(0), *y = batch.GetComponent(1), *z = batch.GetComponent(2);
+
+                    for (std::uint64_t i = 0; i < Count; i++)
+                    {
+                        x[i] = Values[i].x;
+                        y[i] = Values[i].y;
+                        z[i] = Values[i].z;
+                    }
+
+                    Commit();
+
+                    return true;
+                };
+
+                std::size_t GetMaximumMessageSize() const
+                {
+                    return static_cast<std::size_t>(capacity / 2 - sizeof(Detail::RingRecord));
+                };
+
+                const SharedMemory &GetMemory() const
+                {
+                    return memory;
+                };
+
+            private:
+                static std::uint64_t RoundCapacity(std::size_t Capacity)
+                {
+                    std::uint64_t capacity = 4096;
+
+                    while (capacity < Capacity)
+                        capacity <<= 1;
+
+                    return capacity;
+                };
+
+                bool Initialize(std::uint64_t Capacity)
+                {
+                    header = new (memory.GetData()) Detail::RingHeader();
+                    header->version = RingVersion;
+                    header->capacity = Capacity;
+                    header->dataOffset = memory.GetSize() - Capacity;
+
+                    for (Detail::RingReaderSlot &slot : header->readers)
+                    {
+                        slot.state.store(Detail::RingReaderFree);
+                        slot.position.store(0);
+                    }
+
+                    // Readers check the magic first, so it goes in last.
+                    std::atomic_thread_fence(std::memory_order_release);
+                    header->magic = RingMagic;
+
+                    ring = memory.GetData() + header->dataOffset;
+                    capacity = Capacity;
+                    cursor = 0;
+
+                    return true;
+                };
+
+                std::uint64_t GetSlowestPosition() const
+                {
+                    std::uint64_t slowest = cursor;
+
+                    for (const Detail::RingReaderSlot &slot : header->readers)
+                    {
+                        if (slot.state.load() == Detail::RingReaderActive)
+                        {
+                            std::uint64_t position = slot.position.load();
+
+                            if (position < slowest)
+                                slowest = position;
+                        }
+                    }
+
+                    return slowest;
+                };
+
+                Detail::RingRecord *ReserveRecord(std::size_t Size, int TimeoutMilliseconds)
+                {
+                    if (!header || pending || Size > GetMaximumMessageSize())
+                        return nullptr;
+
+                    const std::uint64_t span = Detail::AlignRing(sizeof(Detail::RingRecord) + Size);
+                    const std::uint64_t offset = cursor & (capacity - 1);
+                    const std::uint64_t padding = (offset + span > capacity ? capacity - offset : 0);
+
+                    if (!WaitForSpace(padding + span, TimeoutMilliseconds))
+                        return nullptr;
+
+                    std::uint64_t start = cursor;
+
+                    if (padding)
+                    {
+                        reinterpret_cast<Detail::RingRecord *>(ring + offset)->size = Detail::RingWrapMarker;
+                        start += padding;
+                    }
+
+                    pending = reinterpret_cast<Detail::RingRecord *>(ring + (start & (capacity - 1)));
+                    pending->size = Size;
+                    pendingEnd = start + span;
+
+                    return pending;
+                };
+
+                bool WaitForSpace(std::uint64_t Bytes, int TimeoutMilliseconds)
+                {
+                    Detail::RingTimeout timeout(TimeoutMilliseconds);
+
+                    for (unsigned int attempt = 0; ; attempt++)
+                    {
+                        if (cursor + Bytes - GetSlowestPosition() <= capacity)
+                            return true;
+
+                        if (timeout.IsExpired())
+                            return false;
+
+                        if (attempt < RingSpinCount)
+                        {
+                            std::this_thread::yield();
+                            continue;
+                        }
+
+                        // Load the signal before checking again, so a release in between is
+                        // not slept through.
+                        header->writerWaiting.store(1);
+                        const std::uint32_t signal = header->readSignal.load();
+
+                        if (cursor + Bytes - GetSlowestPosition() <= capacity)
+                            break;
+
+                        Detail::WaitOnWord(header->readSignal, signal, timeout.GetRemaining());
+                    }
+
+                    header->writerWaiting.store(0);
+
+                    return true;
+                };
+
+                SharedMemory memory;
+                std::string name;
+                Detail::RingHeader *header;
+                unsigned char *ring;
+                std::uint64_t capacity;
+
+                // End of the last published message.
+                std::uint64_t cursor;
+                Detail::RingRecord *pending;
+                std::uint64_t pendingEnd;
+        };
+
+        // Each reader sees every message published after it attached.
+        class SharedRingReader
+        {
+            public:
+                SharedRingReader() : header(nullptr), slot(nullptr), ring(nullptr), capacity(0), position(0), acquiredEnd(0), acquired(false) {};
+
+                ~SharedRingReader()
+                {
+                    Close();
+                };
+
+                SharedRingReader(const SharedRingReader &) = delete;
+                SharedRingReader &operator =(const SharedRingReader &) = delete;
+
+                // Fails when the region is not a ring or all reader slots are taken.
+                bool Open(const char *Name)
+                {
+                    Close();
+
+                    return memory.Open(Name) && Join();
+                };
+
+#if !(WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                // Takes ownership of a ring descriptor received from the writer's process.
+                bool Attach(int Descriptor)
+                {
+                    Close();
+
+                    return memory.Attach(Descriptor) && Join();
+                };
+#endif
+
+                void Close()
+                {
+                    if (slot)
+                        slot->state.store(Detail::RingReaderFree);
+
+                    // The writer may be waiting on this reader.
+                    if (header)
+                        SignalWriter();
+
+                    memory.Close();
+                    header = nullptr;
+                    slot = nullptr;
+                    ring = nullptr;
+                    acquired = false;
+                };
+
+                // Waits for the next message; false on timeout, or once the writer has closed
+                // and everything it published has been read. The message stays valid until
+                // Release(), which must come before the next Acquire().
+                bool Acquire(RingMessage &Message, int TimeoutMilliseconds = -1)
+                {
+                    if (!header || acquired)
+                        return false;
+
+                    Detail::RingTimeout timeout(TimeoutMilliseconds);
+
+                    for (;;)
+                    {
+                        if (!WaitForData(timeout))
+                            return false;
+
+                        const std::uint64_t offset = position & (capacity - 1);
+                        const Detail::RingRecord *record = reinterpret_cast<const Detail::RingRecord *>(ring + offset);
+
+                        if (record->size == Detail::RingWrapMarker)
+                        {
+                            position += capacity - offset;
+                            slot->position.store(position);
+                            continue;
+                        }
+
+                        const std::uint64_t span = Detail::AlignRing(sizeof(Detail::RingRecord) + record->size);
+
+                        // A record running off the ring means the region is not what it claims.
+                        if (record->size > capacity || span > capacity - offset)
+                            return false;
+
+                        Message.tag = record->tag;
+                        Message.type = record->type;
+                        Message.components = record->components;
+                        Message.count = record->count;
+                        Message.stride = record->stride;
+                        Message.data = reinterpret_cast<const unsigned char *>(record + 1);
+                        Message.size = static_cast<std::size_t>(record->size);
+
+                        if (Message.components != 0 && (Message.stride < Message.count * GetElementSize(Message.type) || Message.stride * Message.components > record->size))
+                            Message.components = 0;
+
+                        acquiredEnd = position + span;
+                        acquired = true;
+
+                        return true;
+                    }
+                };
+
+                // Hands the space of the acquired message back to the writer.
+                void Release()
+                {
+                    if (!acquired)
+                        return;
+
+                    acquired = false;
+                    position = acquiredEnd;
+                    slot->position.store(position);
+                    SignalWriter();
+                };
+
+                bool IsClosed() const
+                {
+                    return (!header || header->closed.load() != 0);
+                };
+
+            private:
+                bool Join()
+                {
+                    const std::size_t size = memory.GetSize();
+
+                    if (size < sizeof(Detail::RingHeader))
+                        return Fail();
+
+                    header = reinterpret_cast<Detail::RingHeader *>(memory.GetData());
+
+                    if (header->magic != RingMagic || header->version != RingVersion)
+                        return Fail();
+
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    capacity = header->capacity;
+
+                    if (capacity < 4096 || (capacity & (capacity - 1)) != 0 || header->dataOffset < sizeof(Detail::RingHeader) || header->dataOffset > size || size - header->dataOffset < capacity)
+                        return Fail();
+
+                    ring = memory.GetData() + header->dataOffset;
+
+                    for (Detail::RingReaderSlot &candidate : header->readers)
+                    {
+                        std::uint32_t free = Detail::RingReaderFree;
+
+                        if (!candidate.state.compare_exchange_strong(free, Detail::RingReaderJoining))
+                            continue;
+
+                        // The writer ignores joining slots, so the position is only binding
+                        // once the slot is active; store it again after that so nothing the
+                        // writer published in between is lost.
+                        candidate.position.store(header->written.load());
+                        candidate.state.store(Detail::RingReaderActive);
+                        position = header->written.load();
+                        candidate.position.store(position);
+                        slot = &candidate;
+
+                        return true;
+                    }
+
+                    return Fail();
+                };
+
+                bool Fail()
+                {
+                    header = nullptr;
+                    memory.Close();
+
+                    return false;
+                };
+
+                bool WaitForData(const Detail::RingTimeout &Timeout)
+                {
+                    for (unsigned int attempt = 0; ; attempt++)
+                    {
+                        if (header->written.load() != position)
+                            return true;
+
+                        if (header->closed.load() != 0 || Timeout.IsExpired())
+                            return false;
+
+                        if (attempt < RingSpinCount)
+                        {
+                            std::this_thread::yield();
+                            continue;
+                        }
+
+                        const std::uint32_t signal = header->writeSignal.load();
+                        header->readersWaiting.fetch_add(1);
+
+                        if (header->written.load() == position && header->closed.load() == 0)
+                            Detail::WaitOnWord(header->writeSignal, signal, Timeout.GetRemaining());
+
+                        header->readersWaiting.fetch_sub(1);
+                    }
+                };
+
+                void SignalWriter()
+                {
+                    if (header->writerWaiting.load() != 0)
+                    {
+                        header->readSignal.fetch_add(1);
+                        Detail::WakeWord(header->readSignal);
+                    }
+                };
+
+                SharedMemory memory;
+                Detail::RingHeader *header;
+                Detail::RingReaderSlot *slot;
+                const unsigned char *ring;
+                std::uint64_t capacity;
+                std::uint64_t position;
+                std::uint64_t acquiredEnd;
+                bool acquired;
+        };
+    };
+};
+
+#endif // WARLOCK_IO_SHAREDRING_HPP
@@ -0,0 +1,250 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Math/Half.hpp
+// Description: IEEE 754 half precision type and conversions.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_MATH_HALF_HPP
+#define WARLOCK_MATH_HALF_HPP
+
+#include "Simd.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+namespace Warlock
+{
+    namespace Math
+    {
+        // Rounds to nearest even; overflow becomes infinity, NaNs stay quiet NaNs and small
+        // values become denormals.
+        inline std::uint16_t FloatToHalf(float Value)
+        {
+            std::uint32_t bits;
+            std::memcpy(&bits, &Value, sizeof(bits));
+
+            const std::uint32_t sign = (bits >> 16) & 0x8000u;
+            std::uint32_t magnitude = bits & 0x7FFFFFFFu;
+            std::uint32_t result;
+
+            if (magnitude >= 0x47800000u)
+                result = (magnitude > 0x7F800000u ? 0x7E00u : 0x7C00u);
+            else if (magnitude < 0x38800000u)
+            {
+                // Adding 0.5 lines the denormal mantissa up with the low bits, and the FPU does
+                // the rounding.
+                float shifted, magic = 0.5f;
+                std::memcpy(&shifted, &magnitude, sizeof(shifted));
+                shifted += magic;
+                std::memcpy(&result, &shifted, sizeof(result));
+                result -= 0x3F000000u;
+            }
+            else
+            {
+                std::uint32_t odd = (magnitude >> 13) & 1u;
+                magnitude += 0xC8000FFFu + odd;
+                result = magnitude >> 13;
+            }
+
+            return static_cast<std::uint16_t>(sign | result);
+        };
+
+        inline float HalfToFloat(std::uint16_t Value)
+        {
+            std::uint32_t bits = (static_cast<std::uint32_t>(Value) & 0x7FFFu) << 13;
+            const std::uint32_t exponent = bits & 0x0F800000u;
+            float result;
+
+            bits += 0x38000000u;
+
+            if (exponent == 0x0F800000u)
+                bits += 0x38000000u;
+            else if (exponent == 0)
+            {
+                // Denormal: let the FPU renormalize by subtracting the implicit one.
+                float magic = 6.10351562e-05f;
+                bits += 0x00800000u;
+                std::memcpy(&result, &bits, sizeof(result));
+                result -= magic;
+                std::memcpy(&bits, &result, sizeof(bits));
+            }
+
+            bits |= (static_cast<std::uint32_t>(Value) & 0x8000u) << 16;
+            std::memcpy(&result, &bits, sizeof(result));
+
+            return result;
+        };
+
+        namespace Detail
+        {
+            // The scalar algorithms above, a register at a time, for targets without hardware
+            // conversions.
+            inline SimdFloat HalfToFloat(SimdInt Value)
+            {
+                SimdInt bits = (Value & SimdInt(0x7FFF)) << 13;
+                SimdInt exponent = bits & SimdInt(0x0F800000);
+                SimdInt biased = bits + SimdInt(0x38000000);
+                SimdInt special = biased + SimdInt(0x38000000);
+                SimdInt denormal = AsInt(AsFloat(biased + SimdInt(0x00800000)) - SimdFloat(6.10351562e-05f));
+
+                bits = Select(exponent == SimdInt(0x0F800000), special, Select(exponent == SimdInt::Zero(), denormal, biased));
+
+                return AsFloat(bits | ((Value & SimdInt(0x8000)) << 16));
+            };
+
+            inline SimdInt FloatToHalf(SimdFloat Value)
+            {
+                SimdInt bits = AsInt(Value);
+                SimdInt sign = (bits >> 16) & SimdInt(0x8000);
+                SimdInt magnitude = bits & SimdInt(0x7FFFFFFF);
+
+                SimdInt overflow = Select(magnitude > SimdInt(0x7F800000), SimdInt(0x7E00), SimdInt(0x7C00));
+                SimdInt denormal = AsInt(AsFloat(magnitude) + SimdFloat(0.5f)) - SimdInt(0x3F000000);
+                SimdInt normal = (magnitude + SimdInt(static_cast<std::int32_t>(0xC8000FFFu)) + ((magnitude >> 13) & SimdInt(1))) >> 13;
+
+                SimdInt result = Select(magnitude < SimdInt(0x38800000), denormal, normal);
+                result = Select(magnitude < SimdInt(0x47800000), result, overflow);
+
+                return result | sign;
+            };
+        };
+
+        // Half precision scalar for storage. Arithmetic converts to float, so expressions are
+        // evaluated in single precision and rounded once when stored back.
+        struct half
+        {
+            half() = default;
+            half(float Value) : bits(FloatToHalf(Value)) {};
+
+            operator float() const
+            {
+                return HalfToFloat(bits);
+            };
+
+            static half FromBits(std::uint16_t Bits)
+            {
+                half value;
+                value.bits = Bits;
+
+                return value;
+            };
+
+            half &operator +=(float Value)
+            {
+                return (*this = half(float(*this) + Value));
+            };
+
+            half &operator -=(float Value)
+            {
+                return (*this = half(float(*this) - Value));
+            };
+
+            half &operator *=(float Value)
+            {
+                return (*this = half(float(*this) * Value));
+            };
+
+            half &operator /=(float Value)
+            {
+                return (*this = half(float(*this) / Value));
+            };
+
+            std::uint16_t bits;
+        };
+
+        static_assert(sizeof(half) == 2, "half must pack to 16 bits");
+
+        // Loads and stores a register of halves, widened to float.
+        inline SimdFloat LoadHalf(const std::uint16_t *Values)
+        {
+#if (WARLOCK_SIMD_AVX2 && WARLOCK_INSTRUCTION_SET_F16C)
+            return _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(Values)));
+#elif (WARLOCK_SIMD_SSE2 && WARLOCK_INSTRUCTION_SET_F16C)
+            return _mm_cvtph_ps(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(Values)));
+#elif (WARLOCK_SIMD_NEON && WARLOCK_ARCHITECTURE_ARM64)
+            return vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(Values)));
+#else
+            return Detail::HalfToFloat(SimdInt::Load(Values));
+#endif
+        };
+
+        inline void StoreHalf(SimdFloat Value, std::uint16_t *Values)
+        {
+#if (WARLOCK_SIMD_AVX2 && WARLOCK_INSTRUCTION_SET_F16C)
+            _mm_storeu_si128(reinterpret_cast<__m128i *>(Values), _mm256_cvtps_ph(Value.v, _MM_FROUND_TO_NEAREST_INT));
+#elif (WARLOCK_SIMD_SSE2 && WARLOCK_INSTRUCTION_SET_F16C)
+            _mm_storel_epi64(reinterpret_cast<__m128i *>(Values), _mm_cvtps_ph(Value.v, _MM_FROUND_TO_NEAREST_INT));
+#elif (WARLOCK_SIMD_NEON && WARLOCK_ARCHITECTURE_ARM64)
+            vst1_u16(Values, vreinterpret_u16_f16(vcvt_f16_f32(Value.v)));
+#else
+            alignas(32) std::int32_t narrow[WARLOCK_SIMD_WIDTH];
+            Detail::FloatToHalf(Value).Store(narrow);
+
+            for (int lane = 0; lane < WARLOCK_SIMD_WIDTH; lane++)
+                Values[lane] = static_cast<std::uint16_t>(narrow[lane]);
+#endif
+        };
+
+        // Bulk conversions: F16C or NEON instructions where available, otherwise the integer
+        // algorithm in SIMD registers.
+        inline void ConvertToHalf(const float *Input, std::uint16_t *Output, std::size_t Count)
+        {
+            std::size_t i = 0;
+
+#if WARLOCK_INSTRUCTION_SET_F16C
+            for (; i + 8 <= Count; i += 8)
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(Output + i), _mm256_cvtps_ph(_mm256_loadu_ps(Input + i), _MM_FROUND_TO_NEAREST_INT));
+#elif (WARLOCK_INSTRUCTION_SET_NEON && WARLOCK_ARCHITECTURE_ARM64)
+            for (; i + 4 <= Count; i += 4)
+                vst1_u16(Output + i, vreinterpret_u16_f16(vcvt_f16_f32(vld1q_f32(Input + i))));
+#else
+            alignas(32) std::int32_t narrow[WARLOCK_SIMD_WIDTH];
+
+            for (; i + WARLOCK_SIMD_WIDTH <= Count; i += WARLOCK_SIMD_WIDTH)
+            {
+                Detail::FloatToHalf(SimdFloat::Load(Input + i)).Store(narrow);
+
+                for (int lane = 0; lane < WARLOCK_SIMD_WIDTH; lane++)
+                    Output[i + lane] = static_cast<std::uint16_t>(narrow[lane]);
+            }
+#endif
+
+            for (; i < Count; i++)
+                Output[i] = FloatToHalf(Input[i]);
+        };
+
+        inline void ConvertFromHalf(const std::uint16_t *Input, float *Output, std::size_t Count)
+        {
+            std::size_t i = 0;
+
+#if WARLOCK_INSTRUCTION_SET_F16C
+            for (; i + 8 <= Count; i += 8)
+                _mm256_storeu_ps(Output + i, _mm256_cvtph_ps(_mm_loadu_si128(reinterpret_cast<const __m128i *>(Input + i))));
+#elif (WARLOCK_INSTRUCTION_SET_NEON && WARLOCK_ARCHITECTURE_ARM64)
+            for (; i + 4 <= Count; i += 4)
+                vst1q_f32(Output + i, vcvt_f32_f16(vreinterpret_f16_u16(vld1_u16(Input + i))));
+#else
+            for (; i + WARLOCK_SIMD_WIDTH <= Count; i += WARLOCK_SIMD_WIDTH)
+                Detail::HalfToFloat(SimdInt::Load(Input + i)).Store(Output + i);
+#endif
+
+            for (; i < Count; i++)
+                Output[i] = HalfToFloat(Input[i]);
+        };
+    };
+};
+
+#endif // WARLOCK_MATH_HALF_HPP
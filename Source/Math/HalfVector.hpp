@@ -0,0 +1,266 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Math/HalfVector.hpp
+// Description: Half precision Vector2 and Vector3 storage and bulk operations.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_MATH_HALFVECTOR_HPP
+#define WARLOCK_MATH_HALFVECTOR_HPP
+
+#include "Half.hpp"
+#include "Simd.hpp"
+#include "Vector2.hpp"
+#include "Vector3.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+namespace Warlock
+{
+    namespace Math
+    {
+        // Storage only: components widen to float for any arithmetic and the result is rounded
+        // back once. Arrays of these are plain runs of halves, which is what the bulk functions
+        // below rely on.
+        template <> struct Vector<2, half>
+        {
+            Vector() : x(0.0f), y(0.0f) {};
+            Vector(float Value) : x(Value), y(Value) {};
+            Vector(float cx, float cy) : x(cx), y(cy) {};
+            Vector(const Vector2<float> &Value) : x(Value.x), y(Value.y) {};
+
+            Vector2<float> ToFloat() const
+            {
+                return Vector2<float>(x, y);
+            };
+
+            Vector operator +(const Vector &Other) const
+            {
+                return Vector(x + Other.x, y + Other.y);
+            };
+
+            Vector operator -(const Vector &Other) const
+            {
+                return Vector(x - Other.x, y - Other.y);
+            };
+
+            Vector operator *(float Scalar) const
+            {
+                return Vector(x * Scalar, y * Scalar);
+            };
+
+            bool operator ==(const Vector &Other) const
+            {
+                return (x == Other.x && y == Other.y);
+            };
+
+            bool operator !=(const Vector &Other) const
+            {
+                return (x != Other.x || y != Other.y);
+            };
+
+            float Magnitude() const
+            {
+                return std::sqrt(float(x) * x + float(y) * y);
+            };
+
+            half x;
+            half y;
+        };
+
+        template <> struct Vector<3, half>
+        {
+            Vector() : x(0.0f), y(0.0f), z(0.0f) {};
+            Vector(float Value) : x(Value), y(Value), z(Value) {};
+            Vector(float cx, float cy, float cz) : x(cx), y(cy), z(cz) {};
+            Vector(const Vector3<float> &Value) : x(Value.x), y(Value.y), z(Value.z) {};
+
+            Vector3<float> ToFloat() const
+            {
+                return Vector3<float>(x, y, z);
+            };
+
+            Vector operator +(const Vector &Other) const
+            {
+                return Vector(x + Other.x, y + Other.y, z + Other.z);
+            };
+
+            Vector operator -(const Vector &Other) const
+            {
+                return Vector(x - Other.x, y - Other.y, z - Other.z);
+            };
+
+            Vector operator *(float Scalar) const
+            {
+                return Vector(x * Scalar, y * Scalar, z * Scalar);
+            };
+
+            bool operator ==(const Vector &Other) const
+            {
+                return (x == Other.x && y == Other.y && z == Other.z);
+            };
+
+            bool operator !=(const Vector &Other) const
+            {
+                return (x != Other.x || y != Other.y || z != Other.z);
+            };
+
+            float Magnitude() const
+            {
+                return std::sqrt(float(x) * x + float(y) * y + float(z) * z);
+            };
+
+            half x;
+            half y;
+            half z;
+        };
+
+        static_assert(sizeof(Vector2<half>) == 4 && sizeof(Vector3<half>) == 6, "Half vectors must be tightly packed");
+        static_assert(sizeof(Vector2<float>) == 8 && sizeof(Vector3<float>) == 12, "Float vectors must be tightly packed");
+
+        namespace Detail
+        {
+            inline const std::uint16_t *HalfData(const half *Values)
+            {
+                return reinterpret_cast<const std::uint16_t *>(Values);
+            };
+
+            inline std::uint16_t *HalfData(half *Values)
+            {
+                return reinterpret_cast<std::uint16_t *>(Values);
+            };
+
+            // Runs Body over flat runs of Count halves a register at a time; the tail goes
+            // through a padded register so every lane uses the same float arithmetic.
+            template <typename Function> void ForEachHalfRegister(std::size_t Count, Function &&Body)
+            {
+                std::size_t i = 0;
+
+                for (; i + WARLOCK_SIMD_WIDTH <= Count; i += WARLOCK_SIMD_WIDTH)
+                    Body(i, static_cast<std::size_t>(WARLOCK_SIMD_WIDTH));
+
+                if (i < Count)
+                    Body(i, Count - i);
+            };
+
+            inline SimdFloat LoadHalf(const std::uint16_t *Values, std::size_t Count)
+            {
+                if (Count == static_cast<std::size_t>(WARLOCK_SIMD_WIDTH))
+                    return Math::LoadHalf(Values);
+
+                std::uint16_t padded[WARLOCK_SIMD_WIDTH] = {};
+
+                for (std::size_t lane = 0; lane < Count; lane++)
+                    padded[lane] = Values[lane];
+
+                return Math::LoadHalf(padded);
+            };
+
+            inline void StoreHalf(SimdFloat Value, std::uint16_t *Values, std::size_t Count)
+            {
+                if (Count == static_cast<std::size_t>(WARLOCK_SIMD_WIDTH))
+                    return Math::StoreHalf(Value, Values);
+
+                std::uint16_t padded[WARLOCK_SIMD_WIDTH];
+                Math::StoreHalf(Value, padded);
+
+                for (std::size_t lane = 0; lane < Count; lane++)
+                    Values[lane] = padded[lane];
+            };
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Bulk conversions
+        //-----------------------------------------------------------------------------------------
+
+        inline void ConvertToHalf(const Vector2<float> *Input, Vector2<half> *Output, std::size_t Count)
+        {
+            ConvertToHalf(&Input->x, Detail::HalfData(&Output->x), 2 * Count);
+        };
+
+        inline void ConvertToHalf(const Vector3<float> *Input, Vector3<half> *Output, std::size_t Count)
+        {
+            ConvertToHalf(&Input->x, Detail::HalfData(&Output->x), 3 * Count);
+        };
+
+        inline void ConvertToFloat(const Vector2<half> *Input, Vector2<float> *Output, std::size_t Count)
+        {
+            ConvertFromHalf(Detail::HalfData(&Input->x), &Output->x, 2 * Count);
+        };
+
+        inline void ConvertToFloat(const Vector3<half> *Input, Vector3<float> *Output, std::size_t Count)
+        {
+            ConvertFromHalf(Detail::HalfData(&Input->x), &Output->x, 3 * Count);
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Bulk arithmetic, widened to float in SIMD registers
+        //-----------------------------------------------------------------------------------------
+
+        // Output = First + Second, for arrays of Vector2<half> or Vector3<half>; any of the arrays
+        // may alias.
+        template <std::size_t N> void Add(const Vector<N, half> *First, const Vector<N, half> *Second, Vector<N, half> *Output, std::size_t Count)
+        {
+            const std::uint16_t *a = Detail::HalfData(&First->x), *b = Detail::HalfData(&Second->x);
+            std::uint16_t *output = Detail::HalfData(&Output->x);
+
+            Detail::ForEachHalfRegister(Count * (sizeof(Vector<N, half>) / sizeof(half)), [&](std::size_t Offset, std::size_t Lanes)
+            {
+                Detail::StoreHalf(Detail::LoadHalf(a + Offset, Lanes) + Detail::LoadHalf(b + Offset, Lanes), output + Offset, Lanes);
+            });
+        };
+
+        // Output = First - Second.
+        template <std::size_t N> void Subtract(const Vector<N, half> *First, const Vector<N, half> *Second, Vector<N, half> *Output, std::size_t Count)
+        {
+            const std::uint16_t *a = Detail::HalfData(&First->x), *b = Detail::HalfData(&Second->x);
+            std::uint16_t *output = Detail::HalfData(&Output->x);
+
+            Detail::ForEachHalfRegister(Count * (sizeof(Vector<N, half>) / sizeof(half)), [&](std::size_t Offset, std::size_t Lanes)
+            {
+                Detail::StoreHalf(Detail::LoadHalf(a + Offset, Lanes) - Detail::LoadHalf(b + Offset, Lanes), output + Offset, Lanes);
+            });
+        };
+
+        // Output = Input * Scalar.
+        template <std::size_t N> void Scale(const Vector<N, half> *Input, float Scalar, Vector<N, half> *Output, std::size_t Count)
+        {
+            const std::uint16_t *input = Detail::HalfData(&Input->x);
+            std::uint16_t *output = Detail::HalfData(&Output->x);
+            const SimdFloat scalar(Scalar);
+
+            Detail::ForEachHalfRegister(Count * (sizeof(Vector<N, half>) / sizeof(half)), [&](std::size_t Offset, std::size_t Lanes)
+            {
+                Detail::StoreHalf(Detail::LoadHalf(input + Offset, Lanes) * scalar, output + Offset, Lanes);
+            });
+        };
+
+        // Output = Input * Scalar + Addend, rounded once; e.g. positions advanced by velocities.
+        template <std::size_t N> void MulAdd(const Vector<N, half> *Input, float Scalar, const Vector<N, half> *Addend, Vector<N, half> *Output, std::size_t Count)
+        {
+            const std::uint16_t *input = Detail::HalfData(&Input->x), *addend = Detail::HalfData(&Addend->x);
+            std::uint16_t *output = Detail::HalfData(&Output->x);
+            const SimdFloat scalar(Scalar);
+
+            Detail::ForEachHalfRegister(Count * (sizeof(Vector<N, half>) / sizeof(half)), [&](std::size_t Offset, std::size_t Lanes)
+            {
+                Detail::StoreHalf(MulAdd(Detail::LoadHalf(input + Offset, Lanes), scalar, Detail::LoadHalf(addend + Offset, Lanes)), output + Offset, Lanes);
+            });
+        };
+    };
+};
+
+#endif // WARLOCK_MATH_HALFVECTOR_HPP
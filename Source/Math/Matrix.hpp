@@ -0,0 +1,605 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Math/Matrix.hpp
+// Description: Fixed size dense matrices with unrolled and vectorized operations.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_MATH_MATRIX_HPP
+#define WARLOCK_MATH_MATRIX_HPP
+
+#include "Vector.hpp"
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+
+#if WARLOCK_INSTRUCTION_SET_SSE2
+#include <emmintrin.h>
+#if WARLOCK_INSTRUCTION_SET_FMA
+#include <immintrin.h>
+#endif
+#elif WARLOCK_INSTRUCTION_SET_NEON
+#include <arm_neon.h>
+#endif
+
+namespace Warlock
+{
+    namespace Math
+    {
+        // An R by C matrix of T, row major, as m[Row][Column]. Element wise operations and
+        // products expand to straight line code; products of float matrices whose rows are a
+        // multiple of four wide run on SIMD registers, one output row per register block.
+        // Determinants and inverses are closed form up to 4x4 and pivoted elimination beyond.
+        template <std::size_t R, std::size_t C, typename T> struct Matrix
+        {
+            static_assert(R > 0 && C > 0, "Matrices need at least one row and column");
+
+            static constexpr std::size_t Rows = R;
+            static constexpr std::size_t Columns = C;
+
+            constexpr Matrix() : m{} {};
+
+            constexpr explicit Matrix(T Value) : m{}
+            {
+                Detail::Unroll<R * C>([&](auto I) { m[I / C][I % C] = Value; });
+            };
+
+            // Elements in row major order.
+            template <typename... Elements, typename = std::enable_if_t<(R * C > 1) && sizeof...(Elements) == R * C && (std::is_convertible_v<Elements, T> && ...)>>
+            constexpr Matrix(Elements... Values) : m{}
+            {
+                const T values[] = {static_cast<T>(Values)...};
+                Detail::Unroll<R * C>([&](auto I) { m[I / C][I % C] = values[I]; });
+            };
+
+            // One vector per row.
+            template <typename... RowVectors, typename = std::enable_if_t<sizeof...(RowVectors) == R && (std::is_same_v<RowVectors, Vector<C, T>> && ...)>>
+            constexpr Matrix(const RowVectors &... Values) : m{}
+            {
+                const Vector<C, T> *rows[] = {&Values...};
+                Detail::Unroll<R>([&](auto Row) { SetRow(Row, *rows[Row]); });
+            };
+
+            static constexpr Matrix Identity()
+            {
+                static_assert(R == C, "Only square matrices have an identity");
+
+                Matrix result;
+                Detail::Unroll<R>([&](auto I) { result.m[I][I] = T(1); });
+
+                return result;
+            };
+
+            // Elements in row major order.
+            static Matrix FromArray(const T *Values)
+            {
+                Matrix result;
+                Detail::Unroll<R * C>([&](auto I) { result.m[I / C][I % C] = Values[I]; });
+
+                return result;
+            };
+
+            constexpr T &operator ()(std::size_t Row, std::size_t Column)
+            {
+                return m[Row][Column];
+            };
+
+            constexpr const T &operator ()(std::size_t Row, std::size_t Column) const
+            {
+                return m[Row][Column];
+            };
+
+            constexpr Vector<C, T> GetRow(std::size_t Row) const
+            {
+                Vector<C, T> result;
+                Detail::Unroll<C>([&](auto I) { result.template Get<I>() = m[Row][I]; });
+
+                return result;
+            };
+
+            constexpr Vector<R, T> GetColumn(std::size_t Column) const
+            {
+                Vector<R, T> result;
+                Detail::Unroll<R>([&](auto I) { result.template Get<I>() = m[I][Column]; });
+
+                return result;
+            };
+
+            constexpr void SetRow(std::size_t Row, const Vector<C, T> &Value)
+            {
+                Detail::Unroll<C>([&](auto I) { m[Row][I] = Value.template Get<I>(); });
+            };
+
+            constexpr void SetColumn(std::size_t Column, const Vector<R, T> &Value)
+            {
+                Detail::Unroll<R>([&](auto I) { m[I][Column] = Value.template Get<I>(); });
+            };
+
+            constexpr Matrix &operator +=(const Matrix &Other)
+            {
+                Detail::Unroll<R * C>([&](auto I) { m[I / C][I % C] += Other.m[I / C][I % C]; });
+                return *this;
+            };
+
+            constexpr Matrix &operator -=(const Matrix &Other)
+            {
+                Detail::Unroll<R * C>([&](auto I) { m[I / C][I % C] -= Other.m[I / C][I % C]; });
+                return *this;
+            };
+
+            constexpr Matrix &operator *=(T Scalar)
+            {
+                Detail::Unroll<R * C>([&](auto I) { m[I / C][I % C] *= Scalar; });
+                return *this;
+            };
+
+            constexpr Matrix &operator /=(T Scalar)
+            {
+                Detail::Unroll<R * C>([&](auto I) { m[I / C][I % C] /= Scalar; });
+                return *this;
+            };
+
+            Matrix &operator *=(const Matrix<C, C, T> &Other)
+            {
+                return (*this = *this * Other);
+            };
+
+            constexpr Matrix<C, R, T> GetTransposed() const
+            {
+                Matrix<C, R, T> result;
+                Detail::Unroll<R * C>([&](auto I) { result.m[I % C][I / C] = m[I / C][I % C]; });
+
+                return result;
+            };
+
+            constexpr void Transpose()
+            {
+                static_assert(R == C, "Only square matrices transpose in place");
+
+                *this = GetTransposed();
+            };
+
+            constexpr T Trace() const
+            {
+                static_assert(R == C, "Only square matrices have a trace");
+
+                T result = T(0);
+                Detail::Unroll<R>([&](auto I) { result += m[I][I]; });
+
+                return result;
+            };
+
+            T Determinant() const
+            {
+                static_assert(R == C, "Only square matrices have a determinant");
+
+                if constexpr (R == 1)
+                    return m[0][0];
+                else if constexpr (R == 2)
+                    return m[0][0] * m[1][1] - m[0][1] * m[1][0];
+                else if constexpr (R == 3)
+                {
+                    return m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1]) -
+                           m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0]) +
+                           m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+                }
+                else if constexpr (R == 4)
+                {
+                    // Laplace expansion along the first two rows, as products of 2x2 minors.
+                    const T s0 = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+                    const T s1 = m[0][0] * m[1][2] - m[0][2] * m[1][0];
+                    const T s2 = m[0][0] * m[1][3] - m[0][3] * m[1][0];
+                    const T s3 = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+                    const T s4 = m[0][1] * m[1][3] - m[0][3] * m[1][1];
+                    const T s5 = m[0][2] * m[1][3] - m[0][3] * m[1][2];
+                    const T c5 = m[2][2] * m[3][3] - m[2][3] * m[3][2];
+                    const T c4 = m[2][1] * m[3][3] - m[2][3] * m[3][1];
+                    const T c3 = m[2][1] * m[3][2] - m[2][2] * m[3][1];
+                    const T c2 = m[2][0] * m[3][3] - m[2][3] * m[3][0];
+                    const T c1 = m[2][0] * m[3][2] - m[2][2] * m[3][0];
+                    const T c0 = m[2][0] * m[3][1] - m[2][1] * m[3][0];
+
+                    return s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+                }
+                else
+                {
+                    // Elimination with partial pivoting; the bounds are constants, so the loops
+                    // unroll as far as the optimizer finds worthwhile.
+                    Matrix lu = *this;
+                    T result = T(1);
+
+                    for (std::size_t k = 0; k < R; k++)
+                    {
+                        std::size_t pivot = k;
+
+                        for (std::size_t i = k + 1; i < R; i++)
+                        {
+                            if (std::abs(lu.m[i][k]) > std::abs(lu.m[pivot][k]))
+                                pivot = i;
+                        }
+
+                        if (lu.m[pivot][k] == T(0))
+                            return T(0);
+
+                        if (pivot != k)
+                        {
+                            for (std::size_t j = 0; j < C; j++)
+                                std::swap(lu.m[k][j], lu.m[pivot][j]);
+
+                            result = -result;
+                        }
+
+                        result *= lu.m[k][k];
+
+                        for (std::size_t i = k + 1; i < R; i++)
+                        {
+                            const T factor = lu.m[i][k] / lu.m[k][k];
+
+                            for (std::size_t j = k + 1; j < C; j++)
+                                lu.m[i][j] -= factor * lu.m[k][j];
+                        }
+                    }
+
+                    return result;
+                }
+            };
+
+            // Inverts in place; a singular matrix is left as it is and false returned.
+            bool Inverse()
+            {
+                static_assert(R == C, "Only square matrices have an inverse");
+
+                if constexpr (R <= 4)
+                {
+                    const T determinant = Determinant();
+
+                    if (determinant == T(0))
+                        return false;
+
+                    *this = GetAdjugate() * (T(1) / determinant);
+                    return true;
+                }
+                else
+                {
+                    // Gauss-Jordan with partial pivoting, reducing [A | I] to [I | A^-1].
+                    Matrix left = *this;
+                    Matrix right = Identity();
+
+                    for (std::size_t k = 0; k < R; k++)
+                    {
+                        std::size_t pivot = k;
+
+                        for (std::size_t i = k + 1; i < R; i++)
+                        {
+                            if (std::abs(left.m[i][k]) > std::abs(left.m[pivot][k]))
+                                pivot = i;
+                        }
+
+                        if (left.m[pivot][k] == T(0))
+                            return false;
+
+                        if (pivot != k)
+                        {
+                            for (std::size_t j = 0; j < C; j++)
+                            {
+                                std::swap(left.m[k][j], left.m[pivot][j]);
+                                std::swap(right.m[k][j], right.m[pivot][j]);
+                            }
+                        }
+
+                        const T scale = T(1) / left.m[k][k];
+
+                        for (std::size_t j = 0; j < C; j++)
+                        {
+                            left.m[k][j] *= scale;
+                            right.m[k][j] *= scale;
+                        }
+
+                        for (std::size_t i = 0; i < R; i++)
+                        {
+                            if (i == k || left.m[i][k] == T(0))
+                                continue;
+
+                            const T factor = left.m[i][k];
+
+                            for (std::size_t j = 0; j < C; j++)
+                            {
+                                left.m[i][j] -= factor * left.m[k][j];
+                                right.m[i][j] -= factor * right.m[k][j];
+                            }
+                        }
+                    }
+
+                    *this = right;
+                    return true;
+                }
+            };
+
+            // The inverse, or the matrix itself when singular.
+            Matrix GetInverse() const
+            {
+                Matrix result = *this;
+                result.Inverse();
+
+                return result;
+            };
+
+            // Transposed cofactors; the inverse times the determinant, defined for singular
+            // matrices too.
+            constexpr Matrix GetAdjugate() const
+            {
+                static_assert(R == C && R <= 4, "Adjugates are closed form up to 4x4");
+
+                Matrix result;
+
+                if constexpr (R == 1)
+                    result.m[0][0] = T(1);
+                else if constexpr (R == 2)
+                {
+                    result.m[0][0] = m[1][1];
+                    result.m[0][1] = -m[0][1];
+                    result.m[1][0] = -m[1][0];
+                    result.m[1][1] = m[0][0];
+                }
+                else if constexpr (R == 3)
+                {
+                    result.m[0][0] = m[1][1] * m[2][2] - m[1][2] * m[2][1];
+                    result.m[0][1] = m[0][2] * m[2][1] - m[0][1] * m[2][2];
+                    result.m[0][2] = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+                    result.m[1][0] = m[1][2] * m[2][0] - m[1][0] * m[2][2];
+                    result.m[1][1] = m[0][0] * m[2][2] - m[0][2] * m[2][0];
+                    result.m[1][2] = m[0][2] * m[1][0] - m[0][0] * m[1][2];
+                    result.m[2][0] = m[1][0] * m[2][1] - m[1][1] * m[2][0];
+                    result.m[2][1] = m[0][1] * m[2][0] - m[0][0] * m[2][1];
+                    result.m[2][2] = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+                }
+                else
+                {
+                    const T s0 = m[0][0] * m[1][1] - m[0][1] * m[1][0];
+                    const T s1 = m[0][0] * m[1][2] - m[0][2] * m[1][0];
+                    const T s2 = m[0][0] * m[1][3] - m[0][3] * m[1][0];
+                    const T s3 = m[0][1] * m[1][2] - m[0][2] * m[1][1];
+                    const T s4 = m[0][1] * m[1][3] - m[0][3] * m[1][1];
+                    const T s5 = m[0][2] * m[1][3] - m[0][3] * m[1][2];
+                    const T c5 = m[2][2] * m[3][3] - m[2][3] * m[3][2];
+                    const T c4 = m[2][1] * m[3][3] - m[2][3] * m[3][1];
+                    const T c3 = m[2][1] * m[3][2] - m[2][2] * m[3][1];
+                    const T c2 = m[2][0] * m[3][3] - m[2][3] * m[3][0];
+                    const T c1 = m[2][0] * m[3][2] - m[2][2] * m[3][0];
+                    const T c0 = m[2][0] * m[3][1] - m[2][1] * m[3][0];
+
+                    result.m[0][0] = m[1][1] * c5 - m[1][2] * c4 + m[1][3] * c3;
+                    result.m[0][1] = -m[0][1] * c5 + m[0][2] * c4 - m[0][3] * c3;
+                    result.m[0][2] = m[3][1] * s5 - m[3][2] * s4 + m[3][3] * s3;
+                    result.m[0][3] = -m[2][1] * s5 + m[2][2] * s4 - m[2][3] * s3;
+                    result.m[1][0] = -m[1][0] * c5 + m[1][2] * c2 - m[1][3] * c1;
+                    result.m[1][1] = m[0][0] * c5 - m[0][2] * c2 + m[0][3] * c1;
+                    result.m[1][2] = -m[3][0] * s5 + m[3][2] * s2 - m[3][3] * s1;
+                    result.m[1][3] = m[2][0] * s5 - m[2][2] * s2 + m[2][3] * s1;
+                    result.m[2][0] = m[1][0] * c4 - m[1][1] * c2 + m[1][3] * c0;
+                    result.m[2][1] = -m[0][0] * c4 + m[0][1] * c2 - m[0][3] * c0;
+                    result.m[2][2] = m[3][0] * s4 - m[3][1] * s2 + m[3][3] * s0;
+                    result.m[2][3] = -m[2][0] * s4 + m[2][1] * s2 - m[2][3] * s0;
+                    result.m[3][0] = -m[1][0] * c3 + m[1][1] * c1 - m[1][2] * c0;
+                    result.m[3][1] = m[0][0] * c3 - m[0][1] * c1 + m[0][2] * c0;
+                    result.m[3][2] = -m[3][0] * s3 + m[3][1] * s1 - m[3][2] * s0;
+                    result.m[3][3] = m[2][0] * s3 - m[2][1] * s1 + m[2][2] * s0;
+                }
+
+                return result;
+            };
+
+            constexpr bool IsNull() const
+            {
+                bool result = true;
+                Detail::Unroll<R * C>([&](auto I) { result = result && (m[I / C][I % C] == T(0)); });
+
+                return result;
+            };
+
+            constexpr bool IsIdentity() const
+            {
+                bool result = (R == C);
+                Detail::Unroll<R * C>([&](auto I) { result = result && (m[I / C][I % C] == ((I / C == I % C) ? T(1) : T(0))); });
+
+                return result;
+            };
+
+            T m[R][C];
+        };
+
+        namespace Detail
+        {
+#if (WARLOCK_INSTRUCTION_SET_SSE2 || WARLOCK_INSTRUCTION_SET_NEON)
+            // Four float lanes; the row block of the products below.
+#if WARLOCK_INSTRUCTION_SET_SSE2
+            using MatrixRow = __m128;
+
+            inline MatrixRow LoadRow(const float *Source) { return _mm_loadu_ps(Source); };
+            inline void StoreRow(float *Destination, MatrixRow Value) { _mm_storeu_ps(Destination, Value); };
+            inline MatrixRow BroadcastRow(float Value) { return _mm_set1_ps(Value); };
+            inline MatrixRow MultiplyRow(MatrixRow First, MatrixRow Second) { return _mm_mul_ps(First, Second); };
+
+#if WARLOCK_INSTRUCTION_SET_FMA
+            inline MatrixRow MultiplyAddRow(MatrixRow First, MatrixRow Second, MatrixRow Third) { return _mm_fmadd_ps(First, Second, Third); };
+#else
+            inline MatrixRow MultiplyAddRow(MatrixRow First, MatrixRow Second, MatrixRow Third) { return _mm_add_ps(_mm_mul_ps(First, Second), Third); };
+#endif
+#else
+            using MatrixRow = float32x4_t;
+
+            inline MatrixRow LoadRow(const float *Source) { return vld1q_f32(Source); };
+            inline void StoreRow(float *Destination, MatrixRow Value) { vst1q_f32(Destination, Value); };
+            inline MatrixRow BroadcastRow(float Value) { return vdupq_n_f32(Value); };
+            inline MatrixRow MultiplyRow(MatrixRow First, MatrixRow Second) { return vmulq_f32(First, Second); };
+            inline MatrixRow MultiplyAddRow(MatrixRow First, MatrixRow Second, MatrixRow Third) { return vmlaq_f32(Third, First, Second); };
+#endif
+
+            template <typename T, std::size_t C>
+            constexpr bool HasSimdRows = std::is_same_v<T, float> && (C % 4 == 0);
+
+            // Each output row block is the sum of the other matrix's row blocks scaled by one
+            // element each, so the right hand rows stay in registers across all output rows.
+            template <std::size_t R, std::size_t K, std::size_t C>
+            inline void MultiplySimdRows(const float (&First)[R][K], const float (&Second)[K][C], float (&Result)[R][C])
+            {
+                Unroll<C / 4>([&](auto Block)
+                {
+                    MatrixRow rows[K];
+                    Unroll<K>([&](auto k) { rows[k] = LoadRow(&Second[k][Block * 4]); });
+
+                    Unroll<R>([&](auto Row)
+                    {
+                        MatrixRow sum = MultiplyRow(BroadcastRow(First[Row][0]), rows[0]);
+                        Unroll<K - 1>([&](auto k) { sum = MultiplyAddRow(BroadcastRow(First[Row][k + 1]), rows[k + 1], sum); });
+
+                        StoreRow(&Result[Row][Block * 4], sum);
+                    });
+                });
+            };
+#else
+            template <typename T, std::size_t C>
+            constexpr bool HasSimdRows = false;
+
+            // Never selected without SIMD rows; keeps the products below well formed.
+            template <std::size_t R, std::size_t K, std::size_t C>
+            inline void MultiplySimdRows(const float (&First)[R][K], const float (&Second)[K][C], float (&Result)[R][C])
+            {
+                Unroll<R * C>([&](auto I)
+                {
+                    float sum = First[I / C][0] * Second[0][I % C];
+                    Unroll<K - 1>([&](auto k) { sum += First[I / C][k + 1] * Second[k + 1][I % C]; });
+
+                    Result[I / C][I % C] = sum;
+                });
+            };
+#endif
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Arithmetic
+        //-----------------------------------------------------------------------------------------
+        template <std::size_t R, std::size_t C, typename T>
+        constexpr Matrix<R, C, T> operator -(const Matrix<R, C, T> &Value)
+        {
+            Matrix<R, C, T> result;
+            Detail::Unroll<R * C>([&](auto I) { result.m[I / C][I % C] = -Value.m[I / C][I % C]; });
+
+            return result;
+        };
+
+        template <std::size_t R, std::size_t C, typename T>
+        constexpr Matrix<R, C, T> operator +(Matrix<R, C, T> First, const Matrix<R, C, T> &Second)
+        {
+            return (First += Second);
+        };
+
+        template <std::size_t R, std::size_t C, typename T>
+        constexpr Matrix<R, C, T> operator -(Matrix<R, C, T> First, const Matrix<R, C, T> &Second)
+        {
+            return (First -= Second);
+        };
+
+        template <std::size_t R, std::size_t C, typename T>
+        constexpr Matrix<R, C, T> operator *(Matrix<R, C, T> Value, typename Detail::NonDeduced<T>::Type Scalar)
+        {
+            return (Value *= Scalar);
+        };
+
+        template <std::size_t R, std::size_t C, typename T>
+        constexpr Matrix<R, C, T> operator *(typename Detail::NonDeduced<T>::Type Scalar, Matrix<R, C, T> Value)
+        {
+            return (Value *= Scalar);
+        };
+
+        template <std::size_t R, std::size_t C, typename T>
+        constexpr Matrix<R, C, T> operator /(Matrix<R, C, T> Value, typename Detail::NonDeduced<T>::Type Scalar)
+        {
+            return (Value /= Scalar);
+        };
+
+        template <std::size_t R, std::size_t K, std::size_t C, typename T>
+        Matrix<R, C, T> operator *(const Matrix<R, K, T> &First, const Matrix<K, C, T> &Second)
+        {
+            Matrix<R, C, T> result;
+
+            if constexpr (Detail::HasSimdRows<T, C>)
+                Detail::MultiplySimdRows(First.m, Second.m, result.m);
+            else
+            {
+                Detail::Unroll<R * C>([&](auto I)
+                {
+                    T sum = First.m[I / C][0] * Second.m[0][I % C];
+                    Detail::Unroll<K - 1>([&](auto k) { sum += First.m[I / C][k + 1] * Second.m[k + 1][I % C]; });
+
+                    result.m[I / C][I % C] = sum;
+                });
+            }
+
+            return result;
+        };
+
+        // Matrix times column vector.
+        template <std::size_t R, std::size_t C, typename T>
+        constexpr Vector<R, T> operator *(const Matrix<R, C, T> &First, const Vector<C, T> &Second)
+        {
+            Vector<R, T> result;
+
+            Detail::Unroll<R>([&](auto Row)
+            {
+                T sum = T(0);
+                Detail::Unroll<C>([&](auto Column) { sum += First.m[Row][Column] * Second.template Get<Column>(); });
+
+                result.template Get<Row>() = sum;
+            });
+
+            return result;
+        };
+
+        // Row vector times matrix.
+        template <std::size_t R, std::size_t C, typename T>
+        constexpr Vector<C, T> operator *(const Vector<R, T> &First, const Matrix<R, C, T> &Second)
+        {
+            Vector<C, T> result;
+
+            Detail::Unroll<C>([&](auto Column)
+            {
+                T sum = T(0);
+                Detail::Unroll<R>([&](auto Row) { sum += First.template Get<Row>() * Second.m[Row][Column]; });
+
+                result.template Get<Column>() = sum;
+            });
+
+            return result;
+        };
+
+        template <std::size_t R, std::size_t C, typename T>
+        constexpr bool operator ==(const Matrix<R, C, T> &First, const Matrix<R, C, T> &Second)
+        {
+            bool result = true;
+            Detail::Unroll<R * C>([&](auto I) { result = result && (First.m[I / C][I % C] == Second.m[I / C][I % C]); });
+
+            return result;
+        };
+
+        template <std::size_t R, std::size_t C, typename T>
+        constexpr bool operator !=(const Matrix<R, C, T> &First, const Matrix<R, C, T> &Second)
+        {
+            return !(First == Second);
+        };
+    };
+};
+
+#endif // WARLOCK_MATH_MATRIX_HPP
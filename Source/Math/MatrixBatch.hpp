@@ -0,0 +1,595 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Math/MatrixBatch.hpp
+// Description: Batched factorizations and solves of small matrices interleaved across SIMD lanes.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_MATH_MATRIXBATCH_HPP
+#define WARLOCK_MATH_MATRIXBATCH_HPP
+
+#include "Matrix.hpp"
+#include "Simd.hpp"
+#include "Vector.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Math
+    {
+        // Pivots and diagonals at or below this fraction of a matrix's largest element mark it
+        // singular; a few float epsilons, so rank deficient matrices are caught through the
+        // rounding of their elimination.
+        constexpr float BatchSolveTolerance = 1.0e-6f;
+
+        // Count objects of Elements values each, interleaved a register at a time: the objects
+        // are grouped in blocks of WARLOCK_SIMD_WIDTH, and a block stores element e of all its
+        // objects together, so one load brings the same element of a whole block into a
+        // register and the kernels below run the scalar algorithm once per block.
+        //
+        //   block 0: e0[0..W) e1[0..W) ... | block 1: e0[W..2W) e1[W..2W) ...
+        //
+        // The last block is padded with zeros.
+        template <std::size_t Elements, typename T = float> class LaneBatch
+        {
+            public:
+                static constexpr std::size_t Width = WARLOCK_SIMD_WIDTH;
+
+                explicit LaneBatch(std::size_t Count = 0)
+                {
+                    Resize(Count);
+                };
+
+                void Resize(std::size_t Count)
+                {
+                    count = Count;
+                    blocks = (Count + Width - 1) / Width;
+                    data.assign(blocks * Elements * Width, T(0));
+                };
+
+                T &At(std::size_t Index, std::size_t Element)
+                {
+                    return data[((Index / Width) * Elements + Element) * Width + Index % Width];
+                };
+
+                const T &At(std::size_t Index, std::size_t Element) const
+                {
+                    return data[((Index / Width) * Elements + Element) * Width + Index % Width];
+                };
+
+                T *GetBlock(std::size_t Block)
+                {
+                    return data.data() + Block * Elements * Width;
+                };
+
+                const T *GetBlock(std::size_t Block) const
+                {
+                    return data.data() + Block * Elements * Width;
+                };
+
+                std::size_t GetCount() const
+                {
+                    return count;
+                };
+
+                std::size_t GetBlockCount() const
+                {
+                    return blocks;
+                };
+
+            private:
+                std::vector<T> data;
+                std::size_t count = 0;
+                std::size_t blocks = 0;
+        };
+
+        // N by N float matrices, element (r, c) stored as element r * N + c.
+        template <std::size_t N> class MatrixBatch : public LaneBatch<N * N>
+        {
+            public:
+                using LaneBatch<N * N>::LaneBatch;
+
+                void Set(std::size_t Index, const Matrix<N, N, float> &Value)
+                {
+                    for (std::size_t r = 0; r < N; r++)
+                    {
+                        for (std::size_t c = 0; c < N; c++)
+                            this->At(Index, r * N + c) = Value.m[r][c];
+                    }
+                };
+
+                Matrix<N, N, float> Get(std::size_t Index) const
+                {
+                    Matrix<N, N, float> result;
+
+                    for (std::size_t r = 0; r < N; r++)
+                    {
+                        for (std::size_t c = 0; c < N; c++)
+                            result.m[r][c] = this->At(Index, r * N + c);
+                    }
+
+                    return result;
+                };
+        };
+
+        template <std::size_t N> class VectorBatch : public LaneBatch<N>
+        {
+            public:
+                using LaneBatch<N>::LaneBatch;
+
+                void Set(std::size_t Index, const Vector<N, float> &Value)
+                {
+                    for (std::size_t i = 0; i < N; i++)
+                        this->At(Index, i) = Value[i];
+                };
+
+                Vector<N, float> Get(std::size_t Index) const
+                {
+                    Vector<N, float> result;
+
+                    for (std::size_t i = 0; i < N; i++)
+                        result[i] = this->At(Index, i);
+
+                    return result;
+                };
+        };
+
+        // Row exchanged into place k at step k of the LU factorization, per system.
+        template <std::size_t N> using PivotBatch = LaneBatch<N, std::int32_t>;
+
+        // One bit per system, set for the systems a factorization found singular or not
+        // positive definite. Their factors and solutions are finite but meaningless.
+        class BatchMask
+        {
+            public:
+                void Resize(std::size_t Count)
+                {
+                    count = Count;
+                    words.assign((Count + 31) / 32, 0);
+                };
+
+                bool Test(std::size_t Index) const
+                {
+                    return ((words[Index / 32] >> (Index % 32)) & 1) != 0;
+                };
+
+                std::size_t CountSet() const
+                {
+                    std::size_t result = 0;
+
+                    for (std::uint32_t word : words)
+                        result += static_cast<std::size_t>(PopCount(word));
+
+                    return result;
+                };
+
+                bool IsEmpty() const
+                {
+                    for (std::uint32_t word : words)
+                    {
+                        if (word != 0)
+                            return false;
+                    }
+
+                    return true;
+                };
+
+                // Lane bits of a block; lanes past the last system are dropped.
+                void SetBlock(std::size_t Block, int Bits)
+                {
+                    const std::size_t first = Block * WARLOCK_SIMD_WIDTH;
+                    std::uint32_t bits = static_cast<std::uint32_t>(Bits) & ((1u << WARLOCK_SIMD_WIDTH) - 1);
+
+                    if (first + WARLOCK_SIMD_WIDTH > count)
+                        bits &= (1u << (count - first)) - 1;
+
+                    words[first / 32] = (words[first / 32] & ~(((1u << WARLOCK_SIMD_WIDTH) - 1) << (first % 32))) | (bits << (first % 32));
+                };
+
+                std::size_t GetCount() const
+                {
+                    return count;
+                };
+
+            private:
+                std::vector<std::uint32_t> words;
+                std::size_t count = 0;
+        };
+
+        namespace Detail
+        {
+            // Calls Body(std::integral_constant<std::size_t, I>()) for I in [Begin, End). The
+            // kernels below nest these so every loop over a matrix dimension is expanded and
+            // the block's registers are addressed by constants, which the optimizer will not
+            // reliably do for the equivalent loops at -O2.
+            template <std::size_t Begin, std::size_t End, typename Function>
+            inline void UnrollRange(Function &&Body)
+            {
+                if constexpr (Begin < End)
+                {
+                    Body(std::integral_constant<std::size_t, Begin>());
+                    UnrollRange<Begin + 1, End>(Body);
+                }
+            };
+
+            template <std::size_t Elements>
+            inline void LoadBlock(const float *Block, SimdFloat (&Values)[Elements])
+            {
+                UnrollRange<0, Elements>([&](auto e) { Values[e] = SimdFloat::Load(Block + e * WARLOCK_SIMD_WIDTH); });
+            };
+
+            template <std::size_t Elements>
+            inline void StoreBlock(float *Block, const SimdFloat (&Values)[Elements])
+            {
+                UnrollRange<0, Elements>([&](auto e) { Values[e].Store(Block + e * WARLOCK_SIMD_WIDTH); });
+            };
+
+            // The largest magnitude of each lane's elements; tolerances are relative to it.
+            template <std::size_t Elements>
+            inline SimdFloat GetBlockScale(const SimdFloat (&Values)[Elements])
+            {
+                SimdFloat result = Abs(Values[0]);
+                UnrollRange<1, Elements>([&](auto e) { result = Max(result, Abs(Values[e])); });
+
+                return result;
+            };
+
+            inline SimdMask NoLanes()
+            {
+                return (SimdFloat::Zero() != SimdFloat::Zero());
+            };
+
+            // Exchanges First and Second in the lanes of Mask.
+            inline void SwapLanes(SimdMask Mask, SimdFloat &First, SimdFloat &Second)
+            {
+                const SimdFloat first = First;
+
+                First = Select(Mask, Second, first);
+                Second = Select(Mask, first, Second);
+            };
+
+            // Back substitution through the upper triangle of a factor.
+            template <std::size_t N>
+            inline void SolveUpper(const SimdFloat (&Factor)[N * N], SimdFloat (&Values)[N])
+            {
+                UnrollRange<0, N>([&](auto Step)
+                {
+                    constexpr std::size_t i = N - 1 - Step;
+
+                    UnrollRange<i + 1, N>([&](auto j) { Values[i] = NegMulAdd(Factor[i * N + j], Values[j], Values[i]); });
+                    Values[i] = Values[i] / Factor[i * N + i];
+                });
+            };
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // LU with partial pivoting
+        //-----------------------------------------------------------------------------------------
+        // Factors each matrix in place as P A = L U, L unit lower triangular below the diagonal
+        // and U on and above it, the same as one LAPACK getrf per system. Each lane picks its
+        // own pivot rows, and the row exchanges are selects, so lanes never diverge. A pivot
+        // at or below Tolerance times the matrix's largest element marks it singular.
+        template <std::size_t N>
+        void FactorLu(MatrixBatch<N> &Matrices, PivotBatch<N> &Pivots, BatchMask &Singular, float Tolerance = BatchSolveTolerance)
+        {
+            const SimdFloat one(1.0f);
+
+            Pivots.Resize(Matrices.GetCount());
+            Singular.Resize(Matrices.GetCount());
+
+            for (std::size_t b = 0; b < Matrices.GetBlockCount(); b++)
+            {
+                SimdFloat a[N * N];
+                SimdMask singular = Detail::NoLanes();
+
+                Detail::LoadBlock(Matrices.GetBlock(b), a);
+                const SimdFloat tolerance = Detail::GetBlockScale(a) * SimdFloat(Tolerance);
+
+                Detail::UnrollRange<0, N>([&](auto Column)
+                {
+                    constexpr std::size_t k = Column;
+
+                    SimdFloat best = Abs(a[k * N + k]);
+                    SimdInt pivot(static_cast<std::int32_t>(k));
+
+                    Detail::UnrollRange<k + 1, N>([&](auto i)
+                    {
+                        const SimdFloat magnitude = Abs(a[i * N + k]);
+                        const SimdMask greater = (magnitude > best);
+
+                        best = Select(greater, magnitude, best);
+                        pivot = Select(greater, SimdInt(static_cast<std::int32_t>(i)), pivot);
+                    });
+
+                    pivot.Store(Pivots.GetBlock(b) + k * WARLOCK_SIMD_WIDTH);
+
+                    Detail::UnrollRange<k + 1, N>([&](auto i)
+                    {
+                        const SimdMask exchange = (pivot == SimdInt(static_cast<std::int32_t>(i)));
+                        Detail::UnrollRange<0, N>([&](auto j) { Detail::SwapLanes(exchange, a[k * N + j], a[i * N + j]); });
+                    });
+
+                    const SimdMask tiny = (best <= tolerance);
+                    singular = singular | tiny;
+
+                    a[k * N + k] = Select(tiny, one, a[k * N + k]);
+                    const SimdFloat inverse = one / a[k * N + k];
+
+                    Detail::UnrollRange<k + 1, N>([&](auto i)
+                    {
+                        const SimdFloat factor = a[i * N + k] * inverse;
+                        a[i * N + k] = factor;
+
+                        Detail::UnrollRange<k + 1, N>([&](auto j) { a[i * N + j] = NegMulAdd(factor, a[k * N + j], a[i * N + j]); });
+                    });
+                });
+
+                Detail::StoreBlock(Matrices.GetBlock(b), a);
+                Singular.SetBlock(b, singular.Bits());
+            }
+        };
+
+        // Overwrites each right hand side with the solution of A x = b, from FactorLu output.
+        template <std::size_t N>
+        void SolveLu(const MatrixBatch<N> &Factors, const PivotBatch<N> &Pivots, VectorBatch<N> &Values)
+        {
+            for (std::size_t b = 0; b < Factors.GetBlockCount(); b++)
+            {
+                SimdFloat a[N * N], x[N];
+
+                Detail::LoadBlock(Factors.GetBlock(b), a);
+                Detail::LoadBlock(Values.GetBlock(b), x);
+
+                Detail::UnrollRange<0, N>([&](auto Column)
+                {
+                    constexpr std::size_t k = Column;
+                    const SimdInt pivot = SimdInt::Load(Pivots.GetBlock(b) + k * WARLOCK_SIMD_WIDTH);
+
+                    Detail::UnrollRange<k + 1, N>([&](auto i) { Detail::SwapLanes(pivot == SimdInt(static_cast<std::int32_t>(i)), x[k], x[i]); });
+                });
+
+                Detail::UnrollRange<1, N>([&](auto Row)
+                {
+                    constexpr std::size_t i = Row;
+                    Detail::UnrollRange<0, i>([&](auto j) { x[i] = NegMulAdd(a[i * N + j], x[j], x[i]); });
+                });
+
+                Detail::SolveUpper<N>(a, x);
+                Detail::StoreBlock(Values.GetBlock(b), x);
+            }
+        };
+
+        // Determinants from FactorLu output: the product of U's diagonal, negated per exchange.
+        template <std::size_t N>
+        void GetLuDeterminants(const MatrixBatch<N> &Factors, const PivotBatch<N> &Pivots, float *Determinants)
+        {
+            for (std::size_t b = 0; b < Factors.GetBlockCount(); b++)
+            {
+                SimdFloat determinant(1.0f);
+
+                for (std::size_t k = 0; k < N; k++)
+                {
+                    const SimdInt pivot = SimdInt::Load(Pivots.GetBlock(b) + k * WARLOCK_SIMD_WIDTH);
+                    const SimdFloat diagonal = SimdFloat::Load(Factors.GetBlock(b) + (k * N + k) * WARLOCK_SIMD_WIDTH);
+
+                    determinant = determinant * Select(pivot == SimdInt(static_cast<std::int32_t>(k)), diagonal, -diagonal);
+                }
+
+                float lanes[WARLOCK_SIMD_WIDTH];
+                determinant.Store(lanes);
+
+                for (std::size_t l = 0; l < WARLOCK_SIMD_WIDTH && b * WARLOCK_SIMD_WIDTH + l < Factors.GetCount(); l++)
+                    Determinants[b * WARLOCK_SIMD_WIDTH + l] = lanes[l];
+            }
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Cholesky
+        //-----------------------------------------------------------------------------------------
+        // Factors each symmetric positive definite matrix in place as A = L L^T, L on and below
+        // the diagonal; only the lower triangle of A is read. A matrix whose remaining diagonal
+        // falls to Tolerance times its largest element is not positive definite and is flagged.
+        template <std::size_t N>
+        void FactorCholesky(MatrixBatch<N> &Matrices, BatchMask &NotPositiveDefinite, float Tolerance = BatchSolveTolerance)
+        {
+            const SimdFloat one(1.0f);
+
+            NotPositiveDefinite.Resize(Matrices.GetCount());
+
+            for (std::size_t b = 0; b < Matrices.GetBlockCount(); b++)
+            {
+                SimdFloat a[N * N];
+                SimdMask failed = Detail::NoLanes();
+
+                Detail::LoadBlock(Matrices.GetBlock(b), a);
+                const SimdFloat tolerance = Detail::GetBlockScale(a) * SimdFloat(Tolerance);
+
+                Detail::UnrollRange<0, N>([&](auto Column)
+                {
+                    constexpr std::size_t j = Column;
+                    SimdFloat diagonal = a[j * N + j];
+
+                    Detail::UnrollRange<0, j>([&](auto k) { diagonal = NegMulAdd(a[j * N + k], a[j * N + k], diagonal); });
+
+                    const SimdMask bad = (diagonal <= tolerance);
+                    failed = failed | bad;
+
+                    a[j * N + j] = Sqrt(Select(bad, one, diagonal));
+                    const SimdFloat inverse = one / a[j * N + j];
+
+                    Detail::UnrollRange<j + 1, N>([&](auto i)
+                    {
+                        SimdFloat value = a[i * N + j];
+                        Detail::UnrollRange<0, j>([&](auto k) { value = NegMulAdd(a[i * N + k], a[j * N + k], value); });
+
+                        a[i * N + j] = value * inverse;
+                    });
+                });
+
+                Detail::StoreBlock(Matrices.GetBlock(b), a);
+                NotPositiveDefinite.SetBlock(b, failed.Bits());
+            }
+        };
+
+        // Overwrites each right hand side with the solution of A x = b, from FactorCholesky
+        // output: L y = b forward, then L^T x = y backward.
+        template <std::size_t N>
+        void SolveCholesky(const MatrixBatch<N> &Factors, VectorBatch<N> &Values)
+        {
+            for (std::size_t b = 0; b < Factors.GetBlockCount(); b++)
+            {
+                SimdFloat a[N * N], x[N];
+
+                Detail::LoadBlock(Factors.GetBlock(b), a);
+                Detail::LoadBlock(Values.GetBlock(b), x);
+
+                Detail::UnrollRange<0, N>([&](auto Row)
+                {
+                    constexpr std::size_t i = Row;
+
+                    Detail::UnrollRange<0, i>([&](auto j) { x[i] = NegMulAdd(a[i * N + j], x[j], x[i]); });
+                    x[i] = x[i] / a[i * N + i];
+                });
+
+                Detail::UnrollRange<0, N>([&](auto Step)
+                {
+                    constexpr std::size_t i = N - 1 - Step;
+
+                    Detail::UnrollRange<i + 1, N>([&](auto j) { x[i] = NegMulAdd(a[j * N + i], x[j], x[i]); });
+                    x[i] = x[i] / a[i * N + i];
+                });
+
+                Detail::StoreBlock(Values.GetBlock(b), x);
+            }
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Householder QR
+        //-----------------------------------------------------------------------------------------
+        // Factors each matrix in place as A = Q R, R on and above the diagonal and Q kept as its
+        // reflectors: reflector k is I - tau[k] u u^T with u[k] = 1 and u below the diagonal of
+        // column k, as LAPACK geqrf stores them. Slower than LU, but stable without pivoting; a
+        // column with nothing left to reflect, relative to the matrix norm and the condition of
+        // the columns before it, is rank deficient and flagged.
+        template <std::size_t N>
+        void FactorQr(MatrixBatch<N> &Matrices, VectorBatch<N> &Tau, BatchMask &Singular, float Tolerance = BatchSolveTolerance)
+        {
+            const SimdFloat zero = SimdFloat::Zero(), one(1.0f), two(2.0f);
+
+            Tau.Resize(Matrices.GetCount());
+            Singular.Resize(Matrices.GetCount());
+
+            for (std::size_t b = 0; b < Matrices.GetBlockCount(); b++)
+            {
+                SimdFloat a[N * N], tau[N];
+                SimdMask singular = Detail::NoLanes();
+
+                Detail::LoadBlock(Matrices.GetBlock(b), a);
+
+                // Roundoff left in a column scales with the whole matrix, by its Frobenius norm, and
+                // with the condition of the columns reflected before it, estimated by how little of
+                // each was left to reflect; a rank deficient matrix is then flagged wherever LU
+                // flags it.
+                SimdFloat frobenius = zero;
+                Detail::UnrollRange<0, N * N>([&](auto e) { frobenius = MulAdd(a[e], a[e], frobenius); });
+
+                const SimdFloat base = Sqrt(frobenius) * SimdFloat(Tolerance * static_cast<float>(N));
+                SimdFloat tolerance = base;
+
+                Detail::UnrollRange<0, N>([&](auto Column)
+                {
+                    constexpr std::size_t k = Column;
+
+                    const SimdFloat head = a[k * N + k];
+                    SimdFloat tail = zero, above = zero;
+
+                    Detail::UnrollRange<k + 1, N>([&](auto i) { tail = MulAdd(a[i * N + k], a[i * N + k], tail); });
+                    Detail::UnrollRange<0, k>([&](auto i) { above = MulAdd(a[i * N + k], a[i * N + k], above); });
+
+                    // Reflect onto -sign(head) |x| so v[0] = head - alpha never cancels.
+                    const SimdFloat norm = Sqrt(MulAdd(head, head, tail));
+                    const SimdFloat alpha = Select(head < zero, norm, -norm);
+                    const SimdMask degenerate = (norm <= tolerance);
+                    const SimdFloat v0 = head - alpha;
+
+                    singular = singular | degenerate;
+
+                    // Reflections keep the column norm, so the rows above still hold the original.
+                    const SimdFloat column = Sqrt(MulAdd(head, head, tail) + above);
+                    tolerance = Select(degenerate, tolerance, Max(tolerance, base * column / norm));
+
+                    // With u = v / v0, tau = 2 v0^2 / (v . v).
+                    const SimdFloat scale = Select(degenerate, zero, one / v0);
+                    tau[k] = Select(degenerate, zero, two * v0 * v0 / MulAdd(v0, v0, tail));
+
+                    Detail::UnrollRange<k + 1, N>([&](auto i) { a[i * N + k] = a[i * N + k] * scale; });
+
+                    Detail::UnrollRange<k + 1, N>([&](auto j)
+                    {
+                        SimdFloat dot = a[k * N + j];
+                        Detail::UnrollRange<k + 1, N>([&](auto i) { dot = MulAdd(a[i * N + k], a[i * N + j], dot); });
+
+                        dot = dot * tau[k];
+                        a[k * N + j] = a[k * N + j] - dot;
+
+                        Detail::UnrollRange<k + 1, N>([&](auto i) { a[i * N + j] = NegMulAdd(dot, a[i * N + k], a[i * N + j]); });
+                    });
+
+                    a[k * N + k] = Select(degenerate, one, alpha);
+                });
+
+                Detail::StoreBlock(Matrices.GetBlock(b), a);
+                Detail::StoreBlock(Tau.GetBlock(b), tau);
+                Singular.SetBlock(b, singular.Bits());
+            }
+        };
+
+        // Overwrites each right hand side with the solution of A x = b, from FactorQr output:
+        // Q^T b by applying the reflectors in order, then R x = Q^T b backward.
+        template <std::size_t N>
+        void SolveQr(const MatrixBatch<N> &Factors, const VectorBatch<N> &Tau, VectorBatch<N> &Values)
+        {
+            for (std::size_t b = 0; b < Factors.GetBlockCount(); b++)
+            {
+                SimdFloat a[N * N], tau[N], x[N];
+
+                Detail::LoadBlock(Factors.GetBlock(b), a);
+                Detail::LoadBlock(Tau.GetBlock(b), tau);
+                Detail::LoadBlock(Values.GetBlock(b), x);
+
+                Detail::UnrollRange<0, N>([&](auto Column)
+                {
+                    constexpr std::size_t k = Column;
+                    SimdFloat dot = x[k];
+
+                    Detail::UnrollRange<k + 1, N>([&](auto i) { dot = MulAdd(a[i * N + k], x[i], dot); });
+
+                    dot = dot * tau[k];
+                    x[k] = x[k] - dot;
+
+                    Detail::UnrollRange<k + 1, N>([&](auto i) { x[i] = NegMulAdd(dot, a[i * N + k], x[i]); });
+                });
+
+                Detail::SolveUpper<N>(a, x);
+                Detail::StoreBlock(Values.GetBlock(b), x);
+            }
+        };
+    };
+};
+
+#endif // WARLOCK_MATH_MATRIXBATCH_HPP
@@ -0,0 +1,415 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Math/Morton.hpp
+// Description: Morton (Z-order) encoding and decoding of 2D and 3D grid coordinates.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_MATH_MORTON_HPP
+#define WARLOCK_MATH_MORTON_HPP
+
+#include "Simd.hpp"
+#include "Vector2.hpp"
+#include "Vector3.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+namespace Warlock
+{
+    namespace Math
+    {
+        //-----------------------------------------------------------------------------------------
+        // Bit interleaving
+        //-----------------------------------------------------------------------------------------
+        inline std::uint32_t MortonSpread2(std::uint32_t Value)
+        {
+            Value &= 0x0000FFFF;
+            Value = (Value | (Value << 8)) & 0x00FF00FF;
+            Value = (Value | (Value << 4)) & 0x0F0F0F0F;
+            Value = (Value | (Value << 2)) & 0x33333333;
+            Value = (Value | (Value << 1)) & 0x55555555;
+
+            return Value;
+        };
+
+        inline std::uint32_t MortonCompact2(std::uint32_t Value)
+        {
+            Value &= 0x55555555;
+            Value = (Value | (Value >> 1)) & 0x33333333;
+            Value = (Value | (Value >> 2)) & 0x0F0F0F0F;
+            Value = (Value | (Value >> 4)) & 0x00FF00FF;
+            Value = (Value | (Value >> 8)) & 0x0000FFFF;
+
+            return Value;
+        };
+
+        inline std::uint32_t MortonSpread3(std::uint32_t Value)
+        {
+            Value &= 0x000003FF;
+            Value = (Value | (Value << 16)) & 0x030000FF;
+            Value = (Value | (Value << 8)) & 0x0300F00F;
+            Value = (Value | (Value << 4)) & 0x030C30C3;
+            Value = (Value | (Value << 2)) & 0x09249249;
+
+            return Value;
+        };
+
+        inline std::uint32_t MortonCompact3(std::uint32_t Value)
+        {
+            Value &= 0x09249249;
+            Value = (Value | (Value >> 2)) & 0x030C30C3;
+            Value = (Value | (Value >> 4)) & 0x0300F00F;
+            Value = (Value | (Value >> 8)) & 0x030000FF;
+            Value = (Value | (Value >> 16)) & 0x000003FF;
+
+            return Value;
+        };
+
+#if (WARLOCK_INSTRUCTION_SET_BMI2 && WARLOCK_ARCHITECTURE_X64)
+        inline std::uint64_t MortonSpread2(std::uint64_t Value) { return _pdep_u64(Value, 0x5555555555555555ull); };
+        inline std::uint64_t MortonCompact2(std::uint64_t Value) { return _pext_u64(Value, 0x5555555555555555ull); };
+        inline std::uint64_t MortonSpread3(std::uint64_t Value) { return _pdep_u64(Value, 0x1249249249249249ull); };
+        inline std::uint64_t MortonCompact3(std::uint64_t Value) { return _pext_u64(Value, 0x1249249249249249ull); };
+#else
+        inline std::uint64_t MortonSpread2(std::uint64_t Value)
+        {
+            Value &= 0x00000000FFFFFFFFull;
+            Value = (Value | (Value << 16)) & 0x0000FFFF0000FFFFull;
+            Value = (Value | (Value << 8)) & 0x00FF00FF00FF00FFull;
+            Value = (Value | (Value << 4)) & 0x0F0F0F0F0F0F0F0Full;
+            Value = (Value | (Value << 2)) & 0x3333333333333333ull;
+            Value = (Value | (Value << 1)) & 0x5555555555555555ull;
+
+            return Value;
+        };
+
+        inline std::uint64_t MortonCompact2(std::uint64_t Value)
+        {
+            Value &= 0x5555555555555555ull;
+            Value = (Value | (Value >> 1)) & 0x3333333333333333ull;
+            Value = (Value | (Value >> 2)) & 0x0F0F0F0F0F0F0F0Full;
+            Value = (Value | (Value >> 4)) & 0x00FF00FF00FF00FFull;
+            Value = (Value | (Value >> 8)) & 0x0000FFFF0000FFFFull;
+            Value = (Value | (Value >> 16)) & 0x00000000FFFFFFFFull;
+
+            return Value;
+        };
+
+        inline std::uint64_t MortonSpread3(std::uint64_t Value)
+        {
+            Value &= 0x00000000001FFFFFull;
+            Value = (Value | (Value << 32)) & 0x001F00000000FFFFull;
+            Value = (Value | (Value << 16)) & 0x001F0000FF0000FFull;
+            Value = (Value | (Value << 8)) & 0x100F00F00F00F00Full;
+            Value = (Value | (Value << 4)) & 0x10C30C30C30C30C3ull;
+            Value = (Value | (Value << 2)) & 0x1249249249249249ull;
+
+            return Value;
+        };
+
+        inline std::uint64_t MortonCompact3(std::uint64_t Value)
+        {
+            Value &= 0x1249249249249249ull;
+            Value = (Value | (Value >> 2)) & 0x10C30C30C30C30C3ull;
+            Value = (Value | (Value >> 4)) & 0x100F00F00F00F00Full;
+            Value = (Value | (Value >> 8)) & 0x001F0000FF0000FFull;
+            Value = (Value | (Value >> 16)) & 0x001F00000000FFFFull;
+            Value = (Value | (Value >> 32)) & 0x00000000001FFFFFull;
+
+            return Value;
+        };
+#endif
+
+        inline SimdInt MortonSpread2(SimdInt Value)
+        {
+            Value = Value & SimdInt(0x0000FFFF);
+            Value = (Value | (Value << 8)) & SimdInt(0x00FF00FF);
+            Value = (Value | (Value << 4)) & SimdInt(0x0F0F0F0F);
+            Value = (Value | (Value << 2)) & SimdInt(0x33333333);
+            Value = (Value | (Value << 1)) & SimdInt(0x55555555);
+
+            return Value;
+        };
+
+        inline SimdInt MortonSpread3(SimdInt Value)
+        {
+            Value = Value & SimdInt(0x000003FF);
+            Value = (Value | (Value << 16)) & SimdInt(0x030000FF);
+            Value = (Value | (Value << 8)) & SimdInt(0x0300F00F);
+            Value = (Value | (Value << 4)) & SimdInt(0x030C30C3);
+            Value = (Value | (Value << 2)) & SimdInt(0x09249249);
+
+            return Value;
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Single code encoding; 32 bit codes hold 16 (2D) or 10 (3D) bits per axis and 64 bit
+        // codes hold 32 (2D) or 21 (3D) bits per axis.
+        //-----------------------------------------------------------------------------------------
+        template <typename Code> Code EncodeMorton2(std::uint32_t x, std::uint32_t y)
+        {
+            return static_cast<Code>(MortonSpread2(static_cast<Code>(x)) | (MortonSpread2(static_cast<Code>(y)) << 1));
+        };
+
+        template <typename Code> Code EncodeMorton3(std::uint32_t x, std::uint32_t y, std::uint32_t z)
+        {
+            return static_cast<Code>(MortonSpread3(static_cast<Code>(x)) |
+                                     (MortonSpread3(static_cast<Code>(y)) << 1) |
+                                     (MortonSpread3(static_cast<Code>(z)) << 2));
+        };
+
+        template <typename Code> void DecodeMorton2(Code Morton, std::uint32_t &x, std::uint32_t &y)
+        {
+            x = static_cast<std::uint32_t>(MortonCompact2(Morton));
+            y = static_cast<std::uint32_t>(MortonCompact2(static_cast<Code>(Morton >> 1)));
+        };
+
+        template <typename Code> void DecodeMorton3(Code Morton, std::uint32_t &x, std::uint32_t &y, std::uint32_t &z)
+        {
+            x = static_cast<std::uint32_t>(MortonCompact3(Morton));
+            y = static_cast<std::uint32_t>(MortonCompact3(static_cast<Code>(Morton >> 1)));
+            z = static_cast<std::uint32_t>(MortonCompact3(static_cast<Code>(Morton >> 2)));
+        };
+
+        template <typename Code> struct MortonTraits;
+
+        template <> struct MortonTraits<std::uint32_t>
+        {
+            static constexpr std::uint32_t Bits2 = 16;
+            static constexpr std::uint32_t Bits3 = 10;
+        };
+
+        template <> struct MortonTraits<std::uint64_t>
+        {
+            static constexpr std::uint32_t Bits2 = 32;
+            static constexpr std::uint32_t Bits3 = 21;
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Quantization of points inside a bounding box to the grid of a code width
+        //-----------------------------------------------------------------------------------------
+        template <typename Code> struct MortonGrid3
+        {
+            MortonGrid3(const Vector3<float> &Minimum, const Vector3<float> &Maximum) : minimum(Minimum)
+            {
+                const float cells = static_cast<float>((1u << MortonTraits<Code>::Bits3) - 1);
+
+                scale[0] = (Maximum.x > Minimum.x ? cells / (Maximum.x - Minimum.x) : 0.0f);
+                scale[1] = (Maximum.y > Minimum.y ? cells / (Maximum.y - Minimum.y) : 0.0f);
+                scale[2] = (Maximum.z > Minimum.z ? cells / (Maximum.z - Minimum.z) : 0.0f);
+
+                inverse[0] = (scale[0] > 0.0f ? 1.0f / scale[0] : 0.0f);
+                inverse[1] = (scale[1] > 0.0f ? 1.0f / scale[1] : 0.0f);
+                inverse[2] = (scale[2] > 0.0f ? 1.0f / scale[2] : 0.0f);
+            };
+
+            std::uint32_t Quantize(float Value, int Axis, float Minimum) const
+            {
+                const float cells = static_cast<float>((1u << MortonTraits<Code>::Bits3) - 1);
+                float q = std::nearbyint((Value - Minimum) * scale[Axis]);
+
+                return static_cast<std::uint32_t>(q < 0.0f ? 0.0f : (q > cells ? cells : q));
+            };
+
+            Code Encode(float x, float y, float z) const
+            {
+                return EncodeMorton3<Code>(Quantize(x, 0, minimum.x),
+                                           Quantize(y, 1, minimum.y),
+                                           Quantize(z, 2, minimum.z));
+            };
+
+            Vector3<float> Decode(Code Morton) const
+            {
+                std::uint32_t x, y, z;
+                DecodeMorton3(Morton, x, y, z);
+
+                return Vector3<float>(minimum.x + static_cast<float>(x) * inverse[0],
+                                      minimum.y + static_cast<float>(y) * inverse[1],
+                                      minimum.z + static_cast<float>(z) * inverse[2]);
+            };
+
+            Vector3<float> minimum;
+            float scale[3];
+            float inverse[3];
+        };
+
+        // Quantized in float like the batch encoders while a float can address every cell, and
+        // in double for the 32 bits per axis of 64 bit codes.
+        template <typename Code> struct MortonGrid2
+        {
+            using Real = typename std::conditional<(MortonTraits<Code>::Bits2 > 24), double, float>::type;
+
+            MortonGrid2(const Vector2<float> &Minimum, const Vector2<float> &Maximum) : minimum(Minimum)
+            {
+                const Real cells = static_cast<Real>((std::uint64_t(1) << MortonTraits<Code>::Bits2) - 1);
+
+                scale[0] = (Maximum.x > Minimum.x ? cells / (static_cast<Real>(Maximum.x) - static_cast<Real>(Minimum.x)) : Real(0));
+                scale[1] = (Maximum.y > Minimum.y ? cells / (static_cast<Real>(Maximum.y) - static_cast<Real>(Minimum.y)) : Real(0));
+
+                inverse[0] = (scale[0] > Real(0) ? Real(1) / scale[0] : Real(0));
+                inverse[1] = (scale[1] > Real(0) ? Real(1) / scale[1] : Real(0));
+            };
+
+            std::uint32_t Quantize(float Value, int Axis, float Minimum) const
+            {
+                const Real cells = static_cast<Real>((std::uint64_t(1) << MortonTraits<Code>::Bits2) - 1);
+                Real q = std::nearbyint((static_cast<Real>(Value) - static_cast<Real>(Minimum)) * scale[Axis]);
+
+                return static_cast<std::uint32_t>(q < Real(0) ? Real(0) : (q > cells ? cells : q));
+            };
+
+            Code Encode(float x, float y) const
+            {
+                return EncodeMorton2<Code>(Quantize(x, 0, minimum.x), Quantize(y, 1, minimum.y));
+            };
+
+            Vector2<float> Decode(Code Morton) const
+            {
+                std::uint32_t x, y;
+                DecodeMorton2(Morton, x, y);
+
+                return Vector2<float>(static_cast<float>(minimum.x + x * inverse[0]),
+                                      static_cast<float>(minimum.y + y * inverse[1]));
+            };
+
+            Vector2<float> minimum;
+            Real scale[2];
+            Real inverse[2];
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Batched encoding of structure of arrays streams
+        //-----------------------------------------------------------------------------------------
+        inline void EncodeMorton3(const float *X, const float *Y, const float *Z, std::size_t Count,
+                                  const Vector3<float> &Minimum, const Vector3<float> &Maximum, std::uint32_t *Codes)
+        {
+            const MortonGrid3<std::uint32_t> grid(Minimum, Maximum);
+            const SimdFloat cells(static_cast<float>((1u << MortonTraits<std::uint32_t>::Bits3) - 1));
+            const SimdFloat zero = SimdFloat::Zero();
+            const SimdFloat mx(Minimum.x), my(Minimum.y), mz(Minimum.z);
+            const SimdFloat sx(grid.scale[0]), sy(grid.scale[1]), sz(grid.scale[2]);
+            std::size_t i = 0;
+
+            for (; i + WARLOCK_SIMD_WIDTH <= Count; i += WARLOCK_SIMD_WIDTH)
+            {
+                SimdInt qx = ToInt(Clamp(Round((SimdFloat::Load(X + i) - mx) * sx), zero, cells));
+                SimdInt qy = ToInt(Clamp(Round((SimdFloat::Load(Y + i) - my) * sy), zero, cells));
+                SimdInt qz = ToInt(Clamp(Round((SimdFloat::Load(Z + i) - mz) * sz), zero, cells));
+
+                (MortonSpread3(qx) | (MortonSpread3(qy) << 1) | (MortonSpread3(qz) << 2)).Store(Codes + i);
+            }
+
+            for (; i < Count; i++)
+                Codes[i] = grid.Encode(X[i], Y[i], Z[i]);
+        };
+
+        inline void EncodeMorton3(const float *X, const float *Y, const float *Z, std::size_t Count,
+                                  const Vector3<float> &Minimum, const Vector3<float> &Maximum, std::uint64_t *Codes)
+        {
+            const MortonGrid3<std::uint64_t> grid(Minimum, Maximum);
+            const SimdFloat cells(static_cast<float>((1u << MortonTraits<std::uint64_t>::Bits3) - 1));
+            const SimdFloat zero = SimdFloat::Zero();
+            const SimdFloat mx(Minimum.x), my(Minimum.y), mz(Minimum.z);
+            const SimdFloat sx(grid.scale[0]), sy(grid.scale[1]), sz(grid.scale[2]);
+            std::int32_t qx[WARLOCK_SIMD_WIDTH], qy[WARLOCK_SIMD_WIDTH], qz[WARLOCK_SIMD_WIDTH];
+            std::size_t i = 0;
+
+            for (; i + WARLOCK_SIMD_WIDTH <= Count; i += WARLOCK_SIMD_WIDTH)
+            {
+                ToInt(Clamp(Round((SimdFloat::Load(X + i) - mx) * sx), zero, cells)).Store(qx);
+                ToInt(Clamp(Round((SimdFloat::Load(Y + i) - my) * sy), zero, cells)).Store(qy);
+                ToInt(Clamp(Round((SimdFloat::Load(Z + i) - mz) * sz), zero, cells)).Store(qz);
+
+                for (int j = 0; j < WARLOCK_SIMD_WIDTH; j++)
+                    Codes[i + j] = EncodeMorton3<std::uint64_t>(qx[j], qy[j], qz[j]);
+            }
+
+            for (; i < Count; i++)
+                Codes[i] = grid.Encode(X[i], Y[i], Z[i]);
+        };
+
+        inline void EncodeMorton2(const float *X, const float *Y, std::size_t Count,
+                                  const Vector2<float> &Minimum, const Vector2<float> &Maximum, std::uint32_t *Codes)
+        {
+            const MortonGrid2<std::uint32_t> grid(Minimum, Maximum);
+            const SimdFloat cells(static_cast<float>((1u << MortonTraits<std::uint32_t>::Bits2) - 1));
+            const SimdFloat zero = SimdFloat::Zero();
+            const SimdFloat mx(Minimum.x), my(Minimum.y);
+            const SimdFloat sx(grid.scale[0]), sy(grid.scale[1]);
+            std::size_t i = 0;
+
+            for (; i + WARLOCK_SIMD_WIDTH <= Count; i += WARLOCK_SIMD_WIDTH)
+            {
+                SimdInt qx = ToInt(Clamp(Round((SimdFloat::Load(X + i) - mx) * sx), zero, cells));
+                SimdInt qy = ToInt(Clamp(Round((SimdFloat::Load(Y + i) - my) * sy), zero, cells));
+
+                (MortonSpread2(qx) | (MortonSpread2(qy) << 1)).Store(Codes + i);
+            }
+
+            for (; i < Count; i++)
+                Codes[i] = grid.Encode(X[i], Y[i]);
+        };
+
+        // A float carries 24 significant bits, so the 32 bit per axis grid is quantized in double
+        // precision and only the interleaving benefits from BMI2.
+        inline void EncodeMorton2(const float *X, const float *Y, std::size_t Count,
+                                  const Vector2<float> &Minimum, const Vector2<float> &Maximum, std::uint64_t *Codes)
+        {
+            const MortonGrid2<std::uint64_t> grid(Minimum, Maximum);
+
+            for (std::size_t i = 0; i < Count; i++)
+                Codes[i] = grid.Encode(X[i], Y[i]);
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Batched decoding to the grid points of structure of arrays streams
+        //-----------------------------------------------------------------------------------------
+        template <typename Code> void DecodeMorton3(const Code *Codes, std::size_t Count,
+                                                    const Vector3<float> &Minimum, const Vector3<float> &Maximum,
+                                                    float *X, float *Y, float *Z)
+        {
+            const MortonGrid3<Code> grid(Minimum, Maximum);
+
+            for (std::size_t i = 0; i < Count; i++)
+            {
+                std::uint32_t x, y, z;
+                DecodeMorton3(Codes[i], x, y, z);
+
+                X[i] = Minimum.x + static_cast<float>(x) * grid.inverse[0];
+                Y[i] = Minimum.y + static_cast<float>(y) * grid.inverse[1];
+                Z[i] = Minimum.z + static_cast<float>(z) * grid.inverse[2];
+            }
+        };
+
+        template <typename Code> void DecodeMorton2(const Code *Codes, std::size_t Count,
+                                                    const Vector2<float> &Minimum, const Vector2<float> &Maximum,
+                                                    float *X, float *Y)
+        {
+            const MortonGrid2<Code> grid(Minimum, Maximum);
+
+            for (std::size_t i = 0; i < Count; i++)
+            {
+                std::uint32_t x, y;
+                DecodeMorton2(Codes[i], x, y);
+
+                X[i] = static_cast<float>(Minimum.x + x * grid.inverse[0]);
+                Y[i] = static_cast<float>(Minimum.y + y * grid.inverse[1]);
+            }
+        };
+    };
+};
+
+#endif // WARLOCK_MATH_MORTON_HPP
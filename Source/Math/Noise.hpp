@@ -0,0 +1,518 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Math/Noise.hpp
+// Description: Value, Perlin and simplex noise with fractal sums over SIMD lanes and grids.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_MATH_NOISE_HPP
+#define WARLOCK_MATH_NOISE_HPP
+
+#include "Simd.hpp"
+#include "SimdMath.hpp"
+#include "Vector.hpp"
+#include "Vector2.hpp"
+#include "Vector3.hpp"
+#include "Core/ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace Warlock
+{
+    namespace Math
+    {
+        // All kinds span about [-1, 1] and average zero. Each is a function of the lattice hash
+        // alone, so no permutation table is kept and the seed is free to change per call. Value
+        // noise interpolates random values at lattice points and is the cheapest and blockiest;
+        // Perlin noise interpolates random gradients; simplex noise sums gradients over the
+        // corners of a simplex, about as fast as Perlin in 2D and faster in 3D, with no axis
+        // aligned artifacts.
+        enum class NoiseKind
+        {
+            Value,
+            Perlin,
+            Simplex
+        };
+
+        // Octave o samples at frequency * lacunarity^o with weight gain^o and seed + o; the sum
+        // is divided by the total weight.
+        struct FractalSettings
+        {
+            std::int32_t seed = 0;
+            float frequency = 1.0f;
+            float lacunarity = 2.0f;
+            float gain = 0.5f;
+        };
+
+        // A regular grid of samples at origin + (i, j, k) * spacing, stored with x fastest.
+        struct NoiseGrid2
+        {
+            Vector2<float> origin;
+            Vector2<float> spacing = Vector2<float>(1.0f);
+            std::size_t sizeX = 0;
+            std::size_t sizeY = 0;
+        };
+
+        struct NoiseGrid3
+        {
+            Vector3<float> origin;
+            Vector3<float> spacing = Vector3<float>(1.0f);
+            std::size_t sizeX = 0;
+            std::size_t sizeY = 0;
+            std::size_t sizeZ = 0;
+        };
+
+        // Samples per task in the whole stream and grid evaluations.
+        constexpr std::size_t NoiseChunkSize = 4096;
+
+        namespace Detail
+        {
+            // Large odd multipliers that spread lattice coordinates over the hash input; a
+            // lattice point is hashed from its coordinates times these, so neighbours cost an
+            // add.
+            constexpr std::int32_t NoisePrimeX = 501125321;
+            constexpr std::int32_t NoisePrimeY = 1136930381;
+            constexpr std::int32_t NoisePrimeZ = 1720413743;
+
+            inline SimdInt NoiseHash(SimdInt Seed, SimdInt X, SimdInt Y)
+            {
+                const SimdInt hash = (Seed ^ X ^ Y) * SimdInt(0x27D4EB2D);
+
+                return hash ^ (hash >> 15);
+            };
+
+            inline SimdInt NoiseHash(SimdInt Seed, SimdInt X, SimdInt Y, SimdInt Z)
+            {
+                const SimdInt hash = (Seed ^ X ^ Y ^ Z) * SimdInt(0x27D4EB2D);
+
+                return hash ^ (hash >> 15);
+            };
+
+            // A hash as a value in [-1, 1).
+            inline SimdFloat HashValue(SimdInt Hash)
+            {
+                return ToFloat(Hash) * SimdFloat(4.656612873077392578125e-10f);
+            };
+
+            // 6t^5 - 15t^4 + 10t^3, flat in value, slope and curvature at both ends.
+            inline SimdFloat Fade(SimdFloat T)
+            {
+                return T * T * T * MulAdd(T, MulAdd(T, SimdFloat(6.0f), SimdFloat(-15.0f)), SimdFloat(10.0f));
+            };
+
+            inline SimdFloat Lerp(SimdFloat A, SimdFloat B, SimdFloat T)
+            {
+                return MulAdd(B - A, T, A);
+            };
+
+            inline SimdMask HashBit(SimdInt Hash, std::int32_t Bit)
+            {
+                return ((Hash & SimdInt(Bit)) == SimdInt(Bit));
+            };
+
+            // One of (±1, ±2) and (±2, ±1) dotted with (X, Y).
+            inline SimdFloat Gradient(SimdInt Hash, SimdFloat X, SimdFloat Y)
+            {
+                const SimdMask swap = HashBit(Hash, 4);
+                const SimdFloat u = Select(swap, Y, X);
+                const SimdFloat v = Select(swap, X, Y);
+
+                return FlipSign(u, (Hash & SimdInt(1)) << 31) + FlipSign(v + v, (Hash & SimdInt(2)) << 30);
+            };
+
+            // One of the twelve cube edge directions dotted with (X, Y, Z), from the low four
+            // bits as Perlin's improved noise picks them; the four spare codes repeat edges.
+            inline SimdFloat Gradient(SimdInt Hash, SimdFloat X, SimdFloat Y, SimdFloat Z)
+            {
+                const SimdInt h = Hash & SimdInt(15);
+                const SimdFloat u = Select(h < SimdInt(8), X, Y);
+                const SimdFloat v = Select(h < SimdInt(4), Y, Select((h == SimdInt(12)) | (h == SimdInt(14)), X, Z));
+
+                return FlipSign(u, (h & SimdInt(1)) << 31) + FlipSign(v, (h & SimdInt(2)) << 30);
+            };
+
+            // The cell of a coordinate, premultiplied for hashing, and the offset into it.
+            inline SimdInt Cell(SimdFloat Coordinate, std::int32_t Prime, SimdFloat &Offset)
+            {
+                const SimdFloat cell = Floor(Coordinate);
+                Offset = Coordinate - cell;
+
+                return ToInt(cell) * SimdInt(Prime);
+            };
+
+            // Scales to [-1, 1], from the largest magnitudes found over millions of random
+            // samples. Perlin noise in 3D is already within it.
+            constexpr float PerlinScale2 = 0.66f;
+            constexpr float SimplexScale2 = 45.2308f;
+            constexpr float SimplexScale3 = 76.7406f;
+
+            //-------------------------------------------------------------------------------------
+            // Two dimensions
+            //-------------------------------------------------------------------------------------
+            inline SimdFloat ValueNoise(SimdFloat X, SimdFloat Y, SimdInt Seed)
+            {
+                SimdFloat fx, fy;
+                const SimdInt x0 = Cell(X, NoisePrimeX, fx), y0 = Cell(Y, NoisePrimeY, fy);
+                const SimdInt x1 = x0 + SimdInt(NoisePrimeX), y1 = y0 + SimdInt(NoisePrimeY);
+                const SimdFloat u = Fade(fx), v = Fade(fy);
+
+                return Lerp(Lerp(HashValue(NoiseHash(Seed, x0, y0)), HashValue(NoiseHash(Seed, x1, y0)), u),
+                            Lerp(HashValue(NoiseHash(Seed, x0, y1)), HashValue(NoiseHash(Seed, x1, y1)), u), v);
+            };
+
+            inline SimdFloat PerlinNoise(SimdFloat X, SimdFloat Y, SimdInt Seed)
+            {
+                SimdFloat fx, fy;
+                const SimdInt x0 = Cell(X, NoisePrimeX, fx), y0 = Cell(Y, NoisePrimeY, fy);
+                const SimdInt x1 = x0 + SimdInt(NoisePrimeX), y1 = y0 + SimdInt(NoisePrimeY);
+                const SimdFloat gx = fx - SimdFloat(1.0f), gy = fy - SimdFloat(1.0f);
+                const SimdFloat u = Fade(fx), v = Fade(fy);
+
+                const SimdFloat bottom = Lerp(Gradient(NoiseHash(Seed, x0, y0), fx, fy), Gradient(NoiseHash(Seed, x1, y0), gx, fy), u);
+                const SimdFloat top = Lerp(Gradient(NoiseHash(Seed, x0, y1), fx, gy), Gradient(NoiseHash(Seed, x1, y1), gx, gy), u);
+
+                return Lerp(bottom, top, v) * SimdFloat(PerlinScale2);
+            };
+
+            // One simplex corner's falloff (r^2 - d^2)^4 times its gradient.
+            inline SimdFloat SimplexCorner(SimdInt Hash, SimdFloat X, SimdFloat Y)
+            {
+                const SimdFloat t = Max(SimdFloat(0.5f) - X * X - Y * Y, SimdFloat::Zero());
+                const SimdFloat t2 = t * t;
+
+                return t2 * t2 * Gradient(Hash, X, Y);
+            };
+
+            inline SimdFloat SimplexNoise(SimdFloat X, SimdFloat Y, SimdInt Seed)
+            {
+                // Skew to the lattice of squares whose diagonals split them into the triangles.
+                const float skew = 0.366025403784438647f, unskew = 0.211324865405187118f;
+                const SimdFloat s = (X + Y) * SimdFloat(skew);
+                const SimdFloat i = Floor(X + s), j = Floor(Y + s);
+                const SimdFloat t = (i + j) * SimdFloat(unskew);
+                const SimdFloat x0 = X - (i - t), y0 = Y - (j - t);
+
+                // The lower or upper triangle of the square.
+                const SimdMask lower = (x0 > y0);
+                const SimdFloat i1 = Select(lower, SimdFloat(1.0f), SimdFloat::Zero());
+                const SimdFloat j1 = Select(lower, SimdFloat::Zero(), SimdFloat(1.0f));
+
+                const SimdInt xi = ToInt(i) * SimdInt(NoisePrimeX), yi = ToInt(j) * SimdInt(NoisePrimeY);
+                const SimdInt xi2 = xi + SimdInt(NoisePrimeX), yi2 = yi + SimdInt(NoisePrimeY);
+                const SimdInt xi1 = Select(lower, xi2, xi), yi1 = Select(lower, yi, yi2);
+
+                const SimdFloat x1 = x0 - i1 + SimdFloat(unskew), y1 = y0 - j1 + SimdFloat(unskew);
+                const SimdFloat x2 = x0 + SimdFloat(2.0f * unskew - 1.0f), y2 = y0 + SimdFloat(2.0f * unskew - 1.0f);
+
+                const SimdFloat sum = SimplexCorner(NoiseHash(Seed, xi, yi), x0, y0) + SimplexCorner(NoiseHash(Seed, xi1, yi1), x1, y1) +
+                                      SimplexCorner(NoiseHash(Seed, xi2, yi2), x2, y2);
+
+                return sum * SimdFloat(SimplexScale2);
+            };
+
+            //-------------------------------------------------------------------------------------
+            // Three dimensions
+            //-------------------------------------------------------------------------------------
+            inline SimdFloat ValueNoise(SimdFloat X, SimdFloat Y, SimdFloat Z, SimdInt Seed)
+            {
+                SimdFloat fx, fy, fz;
+                const SimdInt x0 = Cell(X, NoisePrimeX, fx), y0 = Cell(Y, NoisePrimeY, fy), z0 = Cell(Z, NoisePrimeZ, fz);
+                const SimdInt x1 = x0 + SimdInt(NoisePrimeX), y1 = y0 + SimdInt(NoisePrimeY), z1 = z0 + SimdInt(NoisePrimeZ);
+                const SimdFloat u = Fade(fx), v = Fade(fy), w = Fade(fz);
+
+                const SimdFloat near = Lerp(Lerp(HashValue(NoiseHash(Seed, x0, y0, z0)), HashValue(NoiseHash(Seed, x1, y0, z0)), u),
+                                            Lerp(HashValue(NoiseHash(Seed, x0, y1, z0)), HashValue(NoiseHash(Seed, x1, y1, z0)), u), v);
+                const SimdFloat far = Lerp(Lerp(HashValue(NoiseHash(Seed, x0, y0, z1)), HashValue(NoiseHash(Seed, x1, y0, z1)), u),
+                                           Lerp(HashValue(NoiseHash(Seed, x0, y1, z1)), HashValue(NoiseHash(Seed, x1, y1, z1)), u), v);
+
+                return Lerp(near, far, w);
+            };
+
+            inline SimdFloat PerlinNoise(SimdFloat X, SimdFloat Y, SimdFloat Z, SimdInt Seed)
+            {
+                SimdFloat fx, fy, fz;
+                const SimdInt x0 = Cell(X, NoisePrimeX, fx), y0 = Cell(Y, NoisePrimeY, fy), z0 = Cell(Z, NoisePrimeZ, fz);
+                const SimdInt x1 = x0 + SimdInt(NoisePrimeX), y1 = y0 + SimdInt(NoisePrimeY), z1 = z0 + SimdInt(NoisePrimeZ);
+                const SimdFloat gx = fx - SimdFloat(1.0f), gy = fy - SimdFloat(1.0f), gz = fz - SimdFloat(1.0f);
+                const SimdFloat u = Fade(fx), v = Fade(fy), w = Fade(fz);
+
+                const SimdFloat near = Lerp(Lerp(Gradient(NoiseHash(Seed, x0, y0, z0), fx, fy, fz), Gradient(NoiseHash(Seed, x1, y0, z0), gx, fy, fz), u),
+                                            Lerp(Gradient(NoiseHash(Seed, x0, y1, z0), fx, gy, fz), Gradient(NoiseHash(Seed, x1, y1, z0), gx, gy, fz), u), v);
+                const SimdFloat far = Lerp(Lerp(Gradient(NoiseHash(Seed, x0, y0, z1), fx, fy, gz), Gradient(NoiseHash(Seed, x1, y0, z1), gx, fy, gz), u),
+                                           Lerp(Gradient(NoiseHash(Seed, x0, y1, z1), fx, gy, gz), Gradient(NoiseHash(Seed, x1, y1, z1), gx, gy, gz), u), v);
+
+                return Lerp(near, far, w);
+            };
+
+            inline SimdFloat SimplexCorner(SimdInt Hash, SimdFloat X, SimdFloat Y, SimdFloat Z)
+            {
+                const SimdFloat t = Max(SimdFloat(0.5f) - X * X - Y * Y - Z * Z, SimdFloat::Zero());
+                const SimdFloat t2 = t * t;
+
+                return t2 * t2 * Gradient(Hash, X, Y, Z);
+            };
+
+            inline SimdFloat SimplexNoise(SimdFloat X, SimdFloat Y, SimdFloat Z, SimdInt Seed)
+            {
+                const float skew = 1.0f / 3.0f, unskew = 1.0f / 6.0f;
+                const SimdFloat one(1.0f), zero = SimdFloat::Zero();
+                const SimdFloat s = (X + Y + Z) * SimdFloat(skew);
+                const SimdFloat i = Floor(X + s), j = Floor(Y + s), k = Floor(Z + s);
+                const SimdFloat t = (i + j + k) * SimdFloat(unskew);
+                const SimdFloat x0 = X - (i - t), y0 = Y - (j - t), z0 = Z - (k - t);
+
+                // Which of the cube's six tetrahedra, from the order of the offsets: the second
+                // corner steps along the largest axis, the third along the two largest.
+                const SimdMask xy = (x0 >= y0), yz = (y0 >= z0), xz = (x0 >= z0);
+                const SimdMask i1 = xy & xz, j1 = yz & ~xy, k1 = ~xz & ~yz;
+                const SimdMask i2 = xy | xz, j2 = ~xy | yz, k2 = ~(xz & yz);
+
+                const SimdInt xi = ToInt(i) * SimdInt(NoisePrimeX), yi = ToInt(j) * SimdInt(NoisePrimeY), zi = ToInt(k) * SimdInt(NoisePrimeZ);
+                const SimdInt xn = xi + SimdInt(NoisePrimeX), yn = yi + SimdInt(NoisePrimeY), zn = zi + SimdInt(NoisePrimeZ);
+
+                const SimdFloat x1 = x0 - Select(i1, one, zero) + SimdFloat(unskew);
+                const SimdFloat y1 = y0 - Select(j1, one, zero) + SimdFloat(unskew);
+                const SimdFloat z1 = z0 - Select(k1, one, zero) + SimdFloat(unskew);
+                const SimdFloat x2 = x0 - Select(i2, one, zero) + SimdFloat(2.0f * unskew);
+                const SimdFloat y2 = y0 - Select(j2, one, zero) + SimdFloat(2.0f * unskew);
+                const SimdFloat z2 = z0 - Select(k2, one, zero) + SimdFloat(2.0f * unskew);
+                const SimdFloat x3 = x0 + SimdFloat(3.0f * unskew - 1.0f);
+                const SimdFloat y3 = y0 + SimdFloat(3.0f * unskew - 1.0f);
+                const SimdFloat z3 = z0 + SimdFloat(3.0f * unskew - 1.0f);
+
+                const SimdFloat sum = SimplexCorner(NoiseHash(Seed, xi, yi, zi), x0, y0, z0) +
+                                      SimplexCorner(NoiseHash(Seed, Select(i1, xn, xi), Select(j1, yn, yi), Select(k1, zn, zi)), x1, y1, z1) +
+                                      SimplexCorner(NoiseHash(Seed, Select(i2, xn, xi), Select(j2, yn, yi), Select(k2, zn, zi)), x2, y2, z2) +
+                                      SimplexCorner(NoiseHash(Seed, xn, yn, zn), x3, y3, z3);
+
+                return sum * SimdFloat(SimplexScale3);
+            };
+
+            //-------------------------------------------------------------------------------------
+            // Fractal sums
+            //-------------------------------------------------------------------------------------
+            // Per octave constants, broadcast once per call rather than once per sample.
+            template <unsigned int Octaves> struct FractalOctaves
+            {
+                static_assert(Octaves > 0, "a fractal sum needs at least one octave");
+
+                explicit FractalOctaves(const FractalSettings &Settings)
+                {
+                    float frequency = Settings.frequency, amplitude = 1.0f, total = 0.0f;
+
+                    for (unsigned int o = 0; o < Octaves; o++)
+                    {
+                        frequencies[o] = SimdFloat(frequency);
+                        amplitudes[o] = SimdFloat(amplitude);
+                        seeds[o] = SimdInt(static_cast<std::int32_t>(static_cast<std::uint32_t>(Settings.seed) + o));
+
+                        total += amplitude;
+                        frequency *= Settings.lacunarity;
+                        amplitude *= Settings.gain;
+                    }
+
+                    normalizer = SimdFloat(1.0f / total);
+                };
+
+                SimdFloat frequencies[Octaves];
+                SimdFloat amplitudes[Octaves];
+                SimdInt seeds[Octaves];
+                SimdFloat normalizer;
+            };
+
+            template <NoiseKind Kind, typename... Coordinates>
+            inline SimdFloat Noise(SimdInt Seed, Coordinates... Position)
+            {
+                if constexpr (Kind == NoiseKind::Value)
+                    return ValueNoise(Position..., Seed);
+                else if constexpr (Kind == NoiseKind::Perlin)
+                    return PerlinNoise(Position..., Seed);
+                else
+                    return SimplexNoise(Position..., Seed);
+            };
+
+            template <NoiseKind Kind, unsigned int Octaves, typename... Coordinates>
+            inline SimdFloat Fractal(const FractalOctaves<Octaves> &Constants, Coordinates... Position)
+            {
+                SimdFloat sum = SimdFloat::Zero();
+
+                Unroll<Octaves>([&](auto O) { sum = MulAdd(Noise<Kind>(Constants.seeds[O], (Position * Constants.frequencies[O])...), Constants.amplitudes[O], sum); });
+
+                return sum * Constants.normalizer;
+            };
+
+            // Stores the first Count lanes of Value, all of them when a whole register fits.
+            inline void StoreNoise(SimdFloat Value, float *Output, std::size_t Count)
+            {
+                if (Count >= WARLOCK_SIMD_WIDTH)
+                {
+                    Value.Store(Output);
+                    return;
+                }
+
+                float lanes[WARLOCK_SIMD_WIDTH];
+                Value.Store(lanes);
+
+                for (std::size_t l = 0; l < Count; l++)
+                    Output[l] = lanes[l];
+            };
+
+            // Loads Count values, padding a partial register by repeating the last one.
+            inline SimdFloat LoadCoordinates(const float *Values, std::size_t Count)
+            {
+                if (Count >= WARLOCK_SIMD_WIDTH)
+                    return SimdFloat::Load(Values);
+
+                float lanes[WARLOCK_SIMD_WIDTH];
+
+                for (std::size_t l = 0; l < WARLOCK_SIMD_WIDTH; l++)
+                    lanes[l] = Values[l < Count ? l : Count - 1];
+
+                return SimdFloat::Load(lanes);
+            };
+
+            // Evaluates a grid row by row, x across lanes; each task takes whole rows.
+            template <typename Function>
+            inline void EvaluateRows(std::size_t Rows, std::size_t SizeX, float *Output, Core::ThreadPool &Pool, Function &&Row)
+            {
+                if (Rows == 0 || SizeX == 0)
+                    return;
+
+                const SimdFloat steps = ToFloat(SimdInt::Index());
+                const std::size_t rowsPerTask = (SizeX >= NoiseChunkSize ? 1 : NoiseChunkSize / SizeX);
+
+                Pool.ParallelFor(0, Rows, rowsPerTask, [&](std::size_t First, std::size_t Last)
+                {
+                    for (std::size_t r = First; r < Last; r++)
+                    {
+                        float *output = Output + r * SizeX;
+
+                        for (std::size_t i = 0; i < SizeX; i += WARLOCK_SIMD_WIDTH)
+                            StoreNoise(Row(r, steps + SimdFloat(static_cast<float>(i))), output + i, SizeX - i);
+                    }
+                });
+            };
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Single samples per lane
+        //-----------------------------------------------------------------------------------------
+        template <NoiseKind Kind>
+        inline SimdFloat Noise(SimdFloat X, SimdFloat Y, SimdInt Seed = SimdInt::Zero())
+        {
+            return Detail::Noise<Kind>(Seed, X, Y);
+        };
+
+        template <NoiseKind Kind>
+        inline SimdFloat Noise(SimdFloat X, SimdFloat Y, SimdFloat Z, SimdInt Seed = SimdInt::Zero())
+        {
+            return Detail::Noise<Kind>(Seed, X, Y, Z);
+        };
+
+        // Fractal Brownian motion of Octaves octaves, expanded at compile time; kernels over
+        // many samples below set the octave constants up once instead.
+        template <NoiseKind Kind, unsigned int Octaves>
+        inline SimdFloat Fractal(SimdFloat X, SimdFloat Y, const FractalSettings &Settings = FractalSettings())
+        {
+            return Detail::Fractal<Kind>(Detail::FractalOctaves<Octaves>(Settings), X, Y);
+        };
+
+        template <NoiseKind Kind, unsigned int Octaves>
+        inline SimdFloat Fractal(SimdFloat X, SimdFloat Y, SimdFloat Z, const FractalSettings &Settings = FractalSettings())
+        {
+            return Detail::Fractal<Kind>(Detail::FractalOctaves<Octaves>(Settings), X, Y, Z);
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Range kernels over coordinate streams, for callers that already run inside a job.
+        //-----------------------------------------------------------------------------------------
+        template <NoiseKind Kind, unsigned int Octaves>
+        inline void EvaluateFractal(const float *X, const float *Y, float *Output, std::size_t First, std::size_t Last, const FractalSettings &Settings)
+        {
+            const Detail::FractalOctaves<Octaves> constants(Settings);
+
+            for (std::size_t i = First; i < Last; i += WARLOCK_SIMD_WIDTH)
+            {
+                const SimdFloat x = Detail::LoadCoordinates(X + i, Last - i), y = Detail::LoadCoordinates(Y + i, Last - i);
+
+                Detail::StoreNoise(Detail::Fractal<Kind>(constants, x, y), Output + i, Last - i);
+            }
+        };
+
+        template <NoiseKind Kind, unsigned int Octaves>
+        inline void EvaluateFractal(const float *X, const float *Y, const float *Z, float *Output, std::size_t First, std::size_t Last, const FractalSettings &Settings)
+        {
+            const Detail::FractalOctaves<Octaves> constants(Settings);
+
+            for (std::size_t i = First; i < Last; i += WARLOCK_SIMD_WIDTH)
+            {
+                const SimdFloat x = Detail::LoadCoordinates(X + i, Last - i), y = Detail::LoadCoordinates(Y + i, Last - i);
+                const SimdFloat z = Detail::LoadCoordinates(Z + i, Last - i);
+
+                Detail::StoreNoise(Detail::Fractal<Kind>(constants, x, y, z), Output + i, Last - i);
+            }
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Whole streams and grids split across the thread pool.
+        //-----------------------------------------------------------------------------------------
+        template <NoiseKind Kind, unsigned int Octaves>
+        inline void EvaluateFractal(const float *X, const float *Y, float *Output, std::size_t Count, const FractalSettings &Settings,
+                                    Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            Pool.ParallelFor(0, Count, NoiseChunkSize, [&](std::size_t First, std::size_t Last) { EvaluateFractal<Kind, Octaves>(X, Y, Output, First, Last, Settings); });
+        };
+
+        template <NoiseKind Kind, unsigned int Octaves>
+        inline void EvaluateFractal(const float *X, const float *Y, const float *Z, float *Output, std::size_t Count, const FractalSettings &Settings,
+                                    Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            Pool.ParallelFor(0, Count, NoiseChunkSize, [&](std::size_t First, std::size_t Last) { EvaluateFractal<Kind, Octaves>(X, Y, Z, Output, First, Last, Settings); });
+        };
+
+        // Output holds sizeX * sizeY samples, row y at y * sizeX.
+        template <NoiseKind Kind, unsigned int Octaves>
+        inline void EvaluateFractal(const NoiseGrid2 &Grid, float *Output, const FractalSettings &Settings, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            const Detail::FractalOctaves<Octaves> constants(Settings);
+            const SimdFloat originX(Grid.origin.x), spacingX(Grid.spacing.x);
+
+            Detail::EvaluateRows(Grid.sizeY, Grid.sizeX, Output, Pool, [&](std::size_t Row, SimdFloat Columns)
+            {
+                const SimdFloat y(Grid.origin.y + static_cast<float>(Row) * Grid.spacing.y);
+
+                return Detail::Fractal<Kind>(constants, MulAdd(Columns, spacingX, originX), y);
+            });
+        };
+
+        // Output holds sizeX * sizeY * sizeZ samples, (x, y, z) at (z * sizeY + y) * sizeX + x.
+        template <NoiseKind Kind, unsigned int Octaves>
+        inline void EvaluateFractal(const NoiseGrid3 &Grid, float *Output, const FractalSettings &Settings, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            const Detail::FractalOctaves<Octaves> constants(Settings);
+            const SimdFloat originX(Grid.origin.x), spacingX(Grid.spacing.x);
+
+            Detail::EvaluateRows(Grid.sizeY * Grid.sizeZ, Grid.sizeX, Output, Pool, [&](std::size_t Row, SimdFloat Columns)
+            {
+                const SimdFloat y(Grid.origin.y + static_cast<float>(Row % Grid.sizeY) * Grid.spacing.y);
+                const SimdFloat z(Grid.origin.z + static_cast<float>(Row / Grid.sizeY) * Grid.spacing.z);
+
+                return Detail::Fractal<Kind>(constants, MulAdd(Columns, spacingX, originX), y, z);
+            });
+        };
+    };
+};
+
+#endif // WARLOCK_MATH_NOISE_HPP
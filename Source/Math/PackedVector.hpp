@@ -0,0 +1,392 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Math/PackedVector.hpp
+// Description: Compressed storage for large arrays of 3D vectors.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_MATH_PACKEDVECTOR_HPP
+#define WARLOCK_MATH_PACKEDVECTOR_HPP
+
+#include "Half.hpp"
+#include "Simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Math
+    {
+        // Elements decoded per block by ForEachBlock(); three streams of them stay in L1.
+        constexpr std::size_t PackedBlockSize = 1024;
+
+        //-----------------------------------------------------------------------------------------
+        // Octahedral unit vectors (32 bits)
+        //-----------------------------------------------------------------------------------------
+
+        // Folds the unit sphere onto the octahedron |x| + |y| + |z| = 1 and unfolds its lower
+        // half over the corners of the square, then stores both coordinates as 16 bit signed
+        // normalized values. The worst case angular error is under 0.004 degrees.
+        inline std::uint32_t EncodeOctahedral(float X, float Y, float Z)
+        {
+            float inverse = 1.0f / (std::fabs(X) + std::fabs(Y) + std::fabs(Z));
+            float u = X * inverse, v = Y * inverse;
+
+            if (Z < 0.0f)
+            {
+                float foldU = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+                float foldV = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+                u = foldU;
+                v = foldV;
+            }
+
+            std::int32_t qu = static_cast<std::int32_t>(std::nearbyint(std::fmin(std::fmax(u, -1.0f), 1.0f) * 32767.0f));
+            std::int32_t qv = static_cast<std::int32_t>(std::nearbyint(std::fmin(std::fmax(v, -1.0f), 1.0f) * 32767.0f));
+
+            return (static_cast<std::uint32_t>(qu) & 0xFFFFu) | (static_cast<std::uint32_t>(qv) << 16);
+        };
+
+        inline void DecodeOctahedral(std::uint32_t Packed, float &X, float &Y, float &Z)
+        {
+            float u = static_cast<float>(static_cast<std::int16_t>(Packed & 0xFFFFu)) * (1.0f / 32767.0f);
+            float v = static_cast<float>(static_cast<std::int16_t>(Packed >> 16)) * (1.0f / 32767.0f);
+            float z = 1.0f - std::fabs(u) - std::fabs(v);
+            float t = std::fmax(-z, 0.0f);
+
+            u += (u >= 0.0f ? -t : t);
+            v += (v >= 0.0f ? -t : t);
+
+            float inverse = 1.0f / std::sqrt(u * u + v * v + z * z);
+
+            X = u * inverse;
+            Y = v * inverse;
+            Z = z * inverse;
+        };
+
+        namespace Detail
+        {
+            // Magnitude of a with the sign of b.
+            inline SimdFloat CopySign(SimdFloat a, SimdFloat b)
+            {
+                return AsFloat(AsInt(Abs(a)) | (AsInt(b) & SimdInt(static_cast<std::int32_t>(0x80000000u))));
+            };
+        };
+
+        inline void EncodeOctahedral(const float *X, const float *Y, const float *Z, std::uint32_t *Packed, std::size_t Count)
+        {
+            std::size_t i = 0;
+
+            for (; i + WARLOCK_SIMD_WIDTH <= Count; i += WARLOCK_SIMD_WIDTH)
+            {
+                SimdFloat x = SimdFloat::Load(X + i), y = SimdFloat::Load(Y + i), z = SimdFloat::Load(Z + i);
+                SimdFloat inverse = SimdFloat(1.0f) / (Abs(x) + Abs(y) + Abs(z));
+                SimdFloat u = x * inverse, v = y * inverse;
+
+                // The sign of +0 and -0 differs from the scalar path, but both land on the edge
+                // of the fold where either choice decodes to the same vector.
+                SimdMask lower = z < SimdFloat::Zero();
+                SimdFloat foldU = Detail::CopySign(SimdFloat(1.0f) - Abs(v), u);
+                SimdFloat foldV = Detail::CopySign(SimdFloat(1.0f) - Abs(u), v);
+
+                u = Min(Max(Select(lower, foldU, u), SimdFloat(-1.0f)), SimdFloat(1.0f));
+                v = Min(Max(Select(lower, foldV, v), SimdFloat(-1.0f)), SimdFloat(1.0f));
+
+                SimdInt qu = ToInt(Round(u * SimdFloat(32767.0f)));
+                SimdInt qv = ToInt(Round(v * SimdFloat(32767.0f)));
+
+                ((qu & SimdInt(0xFFFF)) | (qv << 16)).Store(Packed + i);
+            }
+
+            for (; i < Count; i++)
+                Packed[i] = EncodeOctahedral(X[i], Y[i], Z[i]);
+        };
+
+        inline void DecodeOctahedral(const std::uint32_t *Packed, float *X, float *Y, float *Z, std::size_t Count)
+        {
+            std::size_t i = 0;
+
+            for (; i + WARLOCK_SIMD_WIDTH <= Count; i += WARLOCK_SIMD_WIDTH)
+            {
+                SimdInt packed = SimdInt::Load(Packed + i);
+
+                // Sign extend each 16 bit half by shifting it to the top first.
+                SimdFloat u = ToFloat(ShiftRightArithmetic(packed << 16, 16)) * SimdFloat(1.0f / 32767.0f);
+                SimdFloat v = ToFloat(ShiftRightArithmetic(packed, 16)) * SimdFloat(1.0f / 32767.0f);
+                SimdFloat z = SimdFloat(1.0f) - Abs(u) - Abs(v);
+                SimdFloat t = Max(-z, SimdFloat::Zero());
+
+                u = u - Detail::CopySign(t, u);
+                v = v - Detail::CopySign(t, v);
+
+                SimdFloat inverse = SimdFloat(1.0f) / Sqrt(MulAdd(u, u, MulAdd(v, v, z * z)));
+
+                (u * inverse).Store(X + i);
+                (v * inverse).Store(Y + i);
+                (z * inverse).Store(Z + i);
+            }
+
+            for (; i < Count; i++)
+                DecodeOctahedral(Packed[i], X[i], Y[i], Z[i]);
+        };
+
+        namespace Detail
+        {
+            // Decodes [0, Count) a block at a time into aligned scratch streams and passes each
+            // block to Body(First, Count, X, Y, Z), so packed data feeds stream kernels without
+            // ever being fully expanded.
+            template <typename Decoder, typename Function> void ForEachDecodedBlock(std::size_t Count, Decoder &&Decode, Function &&Body)
+            {
+                alignas(64) float x[PackedBlockSize];
+                alignas(64) float y[PackedBlockSize];
+                alignas(64) float z[PackedBlockSize];
+
+                for (std::size_t first = 0; first < Count; first += PackedBlockSize)
+                {
+                    std::size_t size = std::min(PackedBlockSize, Count - first);
+
+                    Decode(first, size, x, y, z);
+                    Body(first, size, static_cast<const float *>(x), static_cast<const float *>(y), static_cast<const float *>(z));
+                }
+            };
+        };
+
+        // Unit vectors at 4 bytes each instead of 12.
+        class PackedNormalArray
+        {
+            public:
+                void Encode(const float *X, const float *Y, const float *Z, std::size_t Count)
+                {
+                    data.resize(Count);
+                    EncodeOctahedral(X, Y, Z, data.data(), Count);
+                };
+
+                void Decode(std::size_t First, std::size_t Count, float *X, float *Y, float *Z) const
+                {
+                    DecodeOctahedral(data.data() + First, X, Y, Z, Count);
+                };
+
+                template <typename Function> void ForEachBlock(Function &&Body) const
+                {
+                    Detail::ForEachDecodedBlock(data.size(), [this](std::size_t First, std::size_t Count, float *X, float *Y, float *Z)
+                    {
+                        Decode(First, Count, X, Y, Z);
+                    }, Body);
+                };
+
+                std::size_t GetCount() const
+                {
+                    return data.size();
+                };
+
+                std::size_t GetMemorySize() const
+                {
+                    return data.size() * sizeof(std::uint32_t);
+                };
+
+                const std::uint32_t *GetData() const
+                {
+                    return data.data();
+                };
+
+            private:
+                std::vector<std::uint32_t> data;
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Bounded positions (16 bits per axis)
+        //-----------------------------------------------------------------------------------------
+
+        // Stores each axis as a 16 bit fraction of the bounding box, at 6 bytes per position. The
+        // error per axis is half a step, GetStep() / 2, plus float rounding of the result.
+        class PackedPositionArray
+        {
+            public:
+                PackedPositionArray() : minimum{0.0f, 0.0f, 0.0f}, step{0.0f, 0.0f, 0.0f} {};
+
+                // Fits the box to the input. Positions added later must stay inside it.
+                void Encode(const float *X, const float *Y, const float *Z, std::size_t Count)
+                {
+                    const float *streams[3] = {X, Y, Z};
+
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        float low = (Count ? streams[axis][0] : 0.0f), high = low;
+
+                        for (std::size_t i = 1; i < Count; i++)
+                        {
+                            low = std::fmin(low, streams[axis][i]);
+                            high = std::fmax(high, streams[axis][i]);
+                        }
+
+                        minimum[axis] = low;
+                        step[axis] = (high - low) / 65535.0f;
+                    }
+
+                    Encode(X, Y, Z, Count, minimum, step);
+                };
+
+                // Uses a fixed box, so several arrays can share a quantization grid.
+                void Encode(const float *X, const float *Y, const float *Z, std::size_t Count, const float Minimum[3], const float Step[3])
+                {
+                    const float *streams[3] = {X, Y, Z};
+
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        minimum[axis] = Minimum[axis];
+                        step[axis] = Step[axis];
+                        data[axis].resize(Count);
+
+                        const float inverse = (step[axis] > 0.0f ? 1.0f / step[axis] : 0.0f);
+                        const SimdFloat low(minimum[axis]), scale(inverse);
+                        std::uint16_t *output = data[axis].data();
+                        std::size_t i = 0;
+
+                        alignas(32) std::int32_t narrow[WARLOCK_SIMD_WIDTH];
+
+                        for (; i + WARLOCK_SIMD_WIDTH <= Count; i += WARLOCK_SIMD_WIDTH)
+                        {
+                            SimdFloat q = Round((SimdFloat::Load(streams[axis] + i) - low) * scale);
+                            ToInt(Min(Max(q, SimdFloat::Zero()), SimdFloat(65535.0f))).Store(narrow);
+
+                            for (int lane = 0; lane < WARLOCK_SIMD_WIDTH; lane++)
+                                output[i + lane] = static_cast<std::uint16_t>(narrow[lane]);
+                        }
+
+                        for (; i < Count; i++)
+                        {
+                            float q = std::nearbyint((streams[axis][i] - minimum[axis]) * inverse);
+                            output[i] = static_cast<std::uint16_t>(std::fmin(std::fmax(q, 0.0f), 65535.0f));
+                        }
+                    }
+                };
+
+                void Decode(std::size_t First, std::size_t Count, float *X, float *Y, float *Z) const
+                {
+                    float *streams[3] = {X, Y, Z};
+
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        const std::uint16_t *input = data[axis].data() + First;
+                        const SimdFloat low(minimum[axis]), scale(step[axis]);
+                        float *output = streams[axis];
+                        std::size_t i = 0;
+
+                        for (; i + WARLOCK_SIMD_WIDTH <= Count; i += WARLOCK_SIMD_WIDTH)
+                            MulAdd(ToFloat(SimdInt::Load(input + i)), scale, low).Store(output + i);
+
+                        for (; i < Count; i++)
+                            output[i] = static_cast<float>(input[i]) * step[axis] + minimum[axis];
+                    }
+                };
+
+                template <typename Function> void ForEachBlock(Function &&Body) const
+                {
+                    Detail::ForEachDecodedBlock(GetCount(), [this](std::size_t First, std::size_t Count, float *X, float *Y, float *Z)
+                    {
+                        Decode(First, Count, X, Y, Z);
+                    }, Body);
+                };
+
+                std::size_t GetCount() const
+                {
+                    return data[0].size();
+                };
+
+                std::size_t GetMemorySize() const
+                {
+                    return 3 * data[0].size() * sizeof(std::uint16_t);
+                };
+
+                const float *GetMinimum() const
+                {
+                    return minimum;
+                };
+
+                const float *GetStep() const
+                {
+                    return step;
+                };
+
+                const std::uint16_t *GetData(int Axis) const
+                {
+                    return data[Axis].data();
+                };
+
+            private:
+                float minimum[3];
+                float step[3];
+                std::vector<std::uint16_t> data[3];
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Half precision vectors (16 bits per axis)
+        //-----------------------------------------------------------------------------------------
+
+        // Unbounded vectors with 11 significant bits, at 6 bytes each; suited to values with a
+        // wide range that do not need a box, like velocities.
+        class HalfVectorArray
+        {
+            public:
+                void Encode(const float *X, const float *Y, const float *Z, std::size_t Count)
+                {
+                    const float *streams[3] = {X, Y, Z};
+
+                    for (int axis = 0; axis < 3; axis++)
+                    {
+                        data[axis].resize(Count);
+                        ConvertToHalf(streams[axis], data[axis].data(), Count);
+                    }
+                };
+
+                void Decode(std::size_t First, std::size_t Count, float *X, float *Y, float *Z) const
+                {
+                    ConvertFromHalf(data[0].data() + First, X, Count);
+                    ConvertFromHalf(data[1].data() + First, Y, Count);
+                    ConvertFromHalf(data[2].data() + First, Z, Count);
+                };
+
+                template <typename Function> void ForEachBlock(Function &&Body) const
+                {
+                    Detail::ForEachDecodedBlock(GetCount(), [this](std::size_t First, std::size_t Count, float *X, float *Y, float *Z)
+                    {
+                        Decode(First, Count, X, Y, Z);
+                    }, Body);
+                };
+
+                std::size_t GetCount() const
+                {
+                    return data[0].size();
+                };
+
+                std::size_t GetMemorySize() const
+                {
+                    return 3 * data[0].size() * sizeof(std::uint16_t);
+                };
+
+                const std::uint16_t *GetData(int Axis) const
+                {
+                    return data[Axis].data();
+                };
+
+            private:
+                std::vector<std::uint16_t> data[3];
+        };
+    };
+};
+
+#endif // WARLOCK_MATH_PACKEDVECTOR_HPP
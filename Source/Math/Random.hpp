@@ -0,0 +1,338 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Math/Random.hpp
+// Description: Pseudo random generator across SIMD lanes and bulk distributions over streams.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_MATH_RANDOM_HPP
+#define WARLOCK_MATH_RANDOM_HPP
+
+#include "Simd.hpp"
+#include "SimdMath.hpp"
+#include "Vector2.hpp"
+#include "Vector3.hpp"
+#include "VectorStream.hpp"
+#include "Core/ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+
+namespace Warlock
+{
+    namespace Math
+    {
+        // Elements per generator in the whole stream distributions; see SimdRandom.
+        constexpr std::size_t RandomChunkSize = 4096;
+
+        namespace Detail
+        {
+            inline std::uint64_t SplitMix64(std::uint64_t &State)
+            {
+                std::uint64_t z = (State += 0x9E3779B97F4A7C15ull);
+                z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+                z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+
+                return z ^ (z >> 31);
+            };
+
+            inline SimdInt RotateLeft(SimdInt Value, int Count)
+            {
+                return (Value << Count) | (Value >> (32 - Count));
+            };
+        };
+
+        // xoshiro128** with one independent generator per lane, 2^128 - 1 values each.
+        //
+        // A generator is named by a seed and a stream number, and every lane is seeded from
+        // SplitMix64 over both and its index, so streams are reproducible without sharing
+        // state: a thread, or a fixed size chunk of a parallel loop, takes the stream of its
+        // index and produces the same values on every run whatever the thread count. Values
+        // depend on WARLOCK_SIMD_WIDTH, since that sets how many lanes a stream has.
+        //
+        // Not for cryptography.
+        class SimdRandom
+        {
+            public:
+                explicit SimdRandom(std::uint64_t Seed = 0, std::uint64_t Stream = 0)
+                {
+                    Reset(Seed, Stream);
+                };
+
+                void Reset(std::uint64_t Seed, std::uint64_t Stream)
+                {
+                    std::uint32_t words[4][WARLOCK_SIMD_WIDTH];
+                    std::uint64_t key = Seed;
+                    const std::uint64_t base = Detail::SplitMix64(key) ^ Stream;
+
+                    for (std::size_t l = 0; l < WARLOCK_SIMD_WIDTH; l++)
+                    {
+                        std::uint64_t state = base + Detail::SplitMix64(key);
+                        const std::uint64_t first = Detail::SplitMix64(state);
+                        const std::uint64_t second = Detail::SplitMix64(state);
+
+                        words[0][l] = static_cast<std::uint32_t>(first);
+                        words[1][l] = static_cast<std::uint32_t>(first >> 32);
+                        words[2][l] = static_cast<std::uint32_t>(second);
+                        words[3][l] = static_cast<std::uint32_t>(second >> 32);
+
+                        // The one state the generator cannot leave.
+                        if ((first | second) == 0)
+                            words[0][l] = 1;
+                    }
+
+                    s0 = SimdInt::Load(words[0]);
+                    s1 = SimdInt::Load(words[1]);
+                    s2 = SimdInt::Load(words[2]);
+                    s3 = SimdInt::Load(words[3]);
+                };
+
+                // 32 random bits per lane.
+                SimdInt NextBits()
+                {
+                    // (s1 * 5) rotated by 7, times 9; the multiplies as shifts and adds.
+                    const SimdInt five = (s1 << 2) + s1;
+                    const SimdInt rotated = Detail::RotateLeft(five, 7);
+                    const SimdInt result = (rotated << 3) + rotated;
+                    const SimdInt t = s1 << 9;
+
+                    s2 = s2 ^ s0;
+                    s3 = s3 ^ s1;
+                    s1 = s1 ^ s2;
+                    s0 = s0 ^ s3;
+                    s2 = s2 ^ t;
+                    s3 = Detail::RotateLeft(s3, 11);
+
+                    return result;
+                };
+
+                // Uniform in [0, 1), in steps of 2^-24.
+                SimdFloat NextFloat()
+                {
+                    return ToFloat(NextBits() >> 8) * SimdFloat(5.9604644775390625e-8f);
+                };
+
+                SimdFloat NextFloat(SimdFloat Low, SimdFloat High)
+                {
+                    return MulAdd(NextFloat(), High - Low, Low);
+                };
+
+                // Two registers of independent standard normal values, by the Box-Muller
+                // transform.
+                void NextGaussian(SimdFloat &First, SimdFloat &Second)
+                {
+                    // 1 - u is in (0, 1], so the logarithm is finite.
+                    const SimdFloat radius = Sqrt(SimdFloat(-2.0f) * Log(SimdFloat(1.0f) - NextFloat()));
+                    SimdFloat sine, cosine;
+
+                    SinCos(NextFloat() * SimdFloat(6.28318530717958648f), sine, cosine);
+
+                    First = radius * cosine;
+                    Second = radius * sine;
+                };
+
+                // Advances every lane by 2^64 values, as 2^64 calls to NextBits would; another
+                // way to split one stream into non overlapping parts.
+                void Jump()
+                {
+                    static const std::uint32_t jump[4] = {0x8764000B, 0xF542D2D3, 0x6FA035C3, 0x77F2DB5B};
+                    SimdInt t0 = SimdInt::Zero(), t1 = SimdInt::Zero(), t2 = SimdInt::Zero(), t3 = SimdInt::Zero();
+
+                    for (std::uint32_t word : jump)
+                    {
+                        for (int b = 0; b < 32; b++)
+                        {
+                            if (word & (1u << b))
+                            {
+                                t0 = t0 ^ s0;
+                                t1 = t1 ^ s1;
+                                t2 = t2 ^ s2;
+                                t3 = t3 ^ s3;
+                            }
+
+                            NextBits();
+                        }
+                    }
+
+                    s0 = t0;
+                    s1 = t1;
+                    s2 = t2;
+                    s3 = t3;
+                };
+
+            private:
+                SimdInt s0;
+                SimdInt s1;
+                SimdInt s2;
+                SimdInt s3;
+        };
+
+        namespace Detail
+        {
+            // Stores the first Count lanes of Value, all of them when a whole register fits.
+            inline void StoreLanes(SimdFloat Value, float *Output, std::size_t Count)
+            {
+                if (Count >= WARLOCK_SIMD_WIDTH)
+                {
+                    Value.Store(Output);
+                    return;
+                }
+
+                float lanes[WARLOCK_SIMD_WIDTH];
+                Value.Store(lanes);
+
+                for (std::size_t l = 0; l < Count; l++)
+                    Output[l] = lanes[l];
+            };
+
+            // Runs Kernel(Random, First, Last) over [0, Count) in chunks of RandomChunkSize,
+            // chunk c with the generator of stream c.
+            template <typename Function>
+            inline void GenerateChunks(std::uint64_t Seed, std::size_t Count, Core::ThreadPool &Pool, Function &&Kernel)
+            {
+                Pool.ParallelFor(0, Count, RandomChunkSize, [&](std::size_t First, std::size_t Last)
+                {
+                    SimdRandom random(Seed, First / RandomChunkSize);
+                    Kernel(random, First, Last);
+                });
+            };
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Range kernels, drawing from a caller's generator.
+        //-----------------------------------------------------------------------------------------
+        // Uniform in [Low, High); rounding can give High itself when the range is wide.
+        inline void GenerateUniform(SimdRandom &Random, float *Values, std::size_t First, std::size_t Last, float Low = 0.0f, float High = 1.0f)
+        {
+            const SimdFloat low(Low), high(High);
+
+            for (std::size_t i = First; i < Last; i += WARLOCK_SIMD_WIDTH)
+                Detail::StoreLanes(Random.NextFloat(low, high), Values + i, Last - i);
+        };
+
+        // Normal with the given mean and standard deviation.
+        inline void GenerateGaussian(SimdRandom &Random, float *Values, std::size_t First, std::size_t Last, float Mean = 0.0f, float Deviation = 1.0f)
+        {
+            const SimdFloat mean(Mean), deviation(Deviation);
+            SimdFloat a, b;
+
+            for (std::size_t i = First; i < Last; i += 2 * WARLOCK_SIMD_WIDTH)
+            {
+                Random.NextGaussian(a, b);
+                Detail::StoreLanes(MulAdd(a, deviation, mean), Values + i, Last - i);
+
+                if (i + WARLOCK_SIMD_WIDTH < Last)
+                    Detail::StoreLanes(MulAdd(b, deviation, mean), Values + i + WARLOCK_SIMD_WIDTH, Last - i - WARLOCK_SIMD_WIDTH);
+            }
+        };
+
+        // Uniform in the rectangle or box from Minimum to Maximum.
+        inline void GenerateInBox(SimdRandom &Random, Vector2Stream Points, std::size_t First, std::size_t Last, const Vector2<float> &Minimum, const Vector2<float> &Maximum)
+        {
+            const SimdFloat minimumX(Minimum.x), minimumY(Minimum.y);
+            const SimdFloat maximumX(Maximum.x), maximumY(Maximum.y);
+
+            for (std::size_t i = First; i < Last; i += WARLOCK_SIMD_WIDTH)
+            {
+                Detail::StoreLanes(Random.NextFloat(minimumX, maximumX), Points.x + i, Last - i);
+                Detail::StoreLanes(Random.NextFloat(minimumY, maximumY), Points.y + i, Last - i);
+            }
+        };
+
+        inline void GenerateInBox(SimdRandom &Random, Vector3Stream Points, std::size_t First, std::size_t Last, const Vector3<float> &Minimum, const Vector3<float> &Maximum)
+        {
+            const SimdFloat minimumX(Minimum.x), minimumY(Minimum.y), minimumZ(Minimum.z);
+            const SimdFloat maximumX(Maximum.x), maximumY(Maximum.y), maximumZ(Maximum.z);
+
+            for (std::size_t i = First; i < Last; i += WARLOCK_SIMD_WIDTH)
+            {
+                Detail::StoreLanes(Random.NextFloat(minimumX, maximumX), Points.x + i, Last - i);
+                Detail::StoreLanes(Random.NextFloat(minimumY, maximumY), Points.y + i, Last - i);
+                Detail::StoreLanes(Random.NextFloat(minimumZ, maximumZ), Points.z + i, Last - i);
+            }
+        };
+
+        // Uniform over the area of a disk around the origin: the radius goes as the square root
+        // of a uniform value so that equal areas are equally likely.
+        inline void GenerateInDisk(SimdRandom &Random, Vector2Stream Points, std::size_t First, std::size_t Last, float Radius = 1.0f)
+        {
+            const SimdFloat radius(Radius), turn(6.28318530717958648f);
+            SimdFloat sine, cosine;
+
+            for (std::size_t i = First; i < Last; i += WARLOCK_SIMD_WIDTH)
+            {
+                const SimdFloat distance = Sqrt(Random.NextFloat()) * radius;
+
+                SinCos(Random.NextFloat() * turn, sine, cosine);
+                Detail::StoreLanes(distance * cosine, Points.x + i, Last - i);
+                Detail::StoreLanes(distance * sine, Points.y + i, Last - i);
+            }
+        };
+
+        // Uniform over the surface of a sphere around the origin: z uniform in [-1, 1] and the
+        // angle around z uniform, by Archimedes' hat box theorem.
+        inline void GenerateOnSphere(SimdRandom &Random, Vector3Stream Points, std::size_t First, std::size_t Last, float Radius = 1.0f)
+        {
+            const SimdFloat radius(Radius), one(1.0f), turn(6.28318530717958648f);
+            SimdFloat sine, cosine;
+
+            for (std::size_t i = First; i < Last; i += WARLOCK_SIMD_WIDTH)
+            {
+                const SimdFloat z = Random.NextFloat(-one, one);
+                const SimdFloat ring = Sqrt(Max(NegMulAdd(z, z, one), SimdFloat::Zero())) * radius;
+
+                SinCos(Random.NextFloat() * turn, sine, cosine);
+                Detail::StoreLanes(ring * cosine, Points.x + i, Last - i);
+                Detail::StoreLanes(ring * sine, Points.y + i, Last - i);
+                Detail::StoreLanes(z * radius, Points.z + i, Last - i);
+            }
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Whole stream distributions split across the thread pool. Chunk c of RandomChunkSize
+        // elements draws from SimdRandom(Seed, c), so the output depends only on Seed.
+        //-----------------------------------------------------------------------------------------
+        inline void GenerateUniform(std::uint64_t Seed, float *Values, std::size_t Count, float Low = 0.0f, float High = 1.0f, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            Detail::GenerateChunks(Seed, Count, Pool, [&](SimdRandom &Random, std::size_t First, std::size_t Last) { GenerateUniform(Random, Values, First, Last, Low, High); });
+        };
+
+        inline void GenerateGaussian(std::uint64_t Seed, float *Values, std::size_t Count, float Mean = 0.0f, float Deviation = 1.0f, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            Detail::GenerateChunks(Seed, Count, Pool, [&](SimdRandom &Random, std::size_t First, std::size_t Last) { GenerateGaussian(Random, Values, First, Last, Mean, Deviation); });
+        };
+
+        inline void GenerateInBox(std::uint64_t Seed, Vector2Stream Points, std::size_t Count, const Vector2<float> &Minimum, const Vector2<float> &Maximum, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            Detail::GenerateChunks(Seed, Count, Pool, [&](SimdRandom &Random, std::size_t First, std::size_t Last) { GenerateInBox(Random, Points, First, Last, Minimum, Maximum); });
+        };
+
+        inline void GenerateInBox(std::uint64_t Seed, Vector3Stream Points, std::size_t Count, const Vector3<float> &Minimum, const Vector3<float> &Maximum, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            Detail::GenerateChunks(Seed, Count, Pool, [&](SimdRandom &Random, std::size_t First, std::size_t Last) { GenerateInBox(Random, Points, First, Last, Minimum, Maximum); });
+        };
+
+        inline void GenerateInDisk(std::uint64_t Seed, Vector2Stream Points, std::size_t Count, float Radius = 1.0f, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            Detail::GenerateChunks(Seed, Count, Pool, [&](SimdRandom &Random, std::size_t First, std::size_t Last) { GenerateInDisk(Random, Points, First, Last, Radius); });
+        };
+
+        inline void GenerateOnSphere(std::uint64_t Seed, Vector3Stream Points, std::size_t Count, float Radius = 1.0f, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            Detail::GenerateChunks(Seed, Count, Pool, [&](SimdRandom &Random, std::size_t First, std::size_t Last) { GenerateOnSphere(Random, Points, First, Last, Radius); });
+        };
+    };
+};
+
+#endif // WARLOCK_MATH_RANDOM_HPP
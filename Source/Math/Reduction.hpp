@@ -0,0 +1,556 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Math/Reduction.hpp
+// Description: Parallel sums, extremes, means and covariances over scalar and vector streams.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_MATH_REDUCTION_HPP
+#define WARLOCK_MATH_REDUCTION_HPP
+
+#include "Matrix.hpp"
+#include "Simd.hpp"
+#include "Vector.hpp"
+#include "Vector3.hpp"
+#include "VectorStream.hpp"
+#include "Core/ThreadPool.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Math
+    {
+        // How the whole stream sums group their partial results. Sums are accumulated per
+        // block of ReductionChunkSize elements and the block totals added in double precision,
+        // so both orders are equally accurate; they differ in how reproducible they are.
+        enum class ReductionOrder
+        {
+            // Chunks follow the size of the pool; the last bits can change with the thread
+            // count.
+            Fast,
+
+            // Chunks of exactly ReductionChunkSize elements joined in stream order; the same
+            // result for any thread count.
+            Deterministic
+        };
+
+        // Elements per block of the range kernels and per chunk of deterministic reductions.
+        constexpr std::size_t ReductionChunkSize = 16384;
+
+        //-----------------------------------------------------------------------------------------
+        // Generic parallel reduction. Range(First, Last) reduces a chunk of [0, Count) to a
+        // Partial and Join(Result, Partial) folds it in; chunks are joined in stream order into
+        // Identity whatever thread ran them, so only the chunk size decides the grouping.
+        //-----------------------------------------------------------------------------------------
+        template <typename Partial, typename Kernel, typename Function>
+        inline Partial ParallelReduce(std::size_t Count, std::size_t ChunkSize, Core::ThreadPool &Pool, Partial Identity, Kernel &&Range, Function &&Join)
+        {
+            const std::size_t chunks = (Count + ChunkSize - 1) / ChunkSize;
+            std::vector<Partial> partials(chunks, Identity);
+
+            Pool.ParallelFor(0, chunks, 1, [&](std::size_t FirstChunk, std::size_t LastChunk)
+            {
+                for (std::size_t c = FirstChunk; c < LastChunk; c++)
+                {
+                    const std::size_t first = c * ChunkSize;
+                    const std::size_t last = (Count - first > ChunkSize ? first + ChunkSize : Count);
+
+                    partials[c] = Range(first, last);
+                }
+            });
+
+            for (std::size_t c = 0; c < chunks; c++)
+                Join(Identity, partials[c]);
+
+            return Identity;
+        };
+
+        namespace Detail
+        {
+            // A chunk of whole blocks; deterministic chunks are single blocks so that the
+            // grouping never depends on the pool.
+            inline std::size_t GetReductionChunk(std::size_t Count, ReductionOrder Order, const Core::ThreadPool &Pool)
+            {
+                if (Order == ReductionOrder::Deterministic)
+                    return ReductionChunkSize;
+
+                const std::size_t blocks = Count / (std::size_t(Pool.GetConcurrency()) * 4 * ReductionChunkSize);
+                return (blocks > 1 ? blocks : 1) * ReductionChunkSize;
+            };
+
+            // Joins Block(First, Last) over the blocks of [First, Last) in order, so a range
+            // kernel groups its sums like a run of deterministic chunks.
+            template <typename Partial, typename Kernel, typename Function>
+            inline Partial ReduceBlocks(std::size_t First, std::size_t Last, Partial Identity, Kernel &&Block, Function &&Join)
+            {
+                for (std::size_t i = First; i < Last; i += ReductionChunkSize)
+                    Join(Identity, Block(i, (Last - i > ReductionChunkSize ? i + ReductionChunkSize : Last)));
+
+                return Identity;
+            };
+
+            // The first Count values, all of them when a whole register fits; missing lanes
+            // hold Padding.
+            inline SimdFloat LoadLanes(const float *Values, std::size_t Count, float Padding = 0.0f)
+            {
+                if (Count >= WARLOCK_SIMD_WIDTH)
+                    return SimdFloat::Load(Values);
+
+                float lanes[WARLOCK_SIMD_WIDTH];
+
+                for (std::size_t l = 0; l < WARLOCK_SIMD_WIDTH; l++)
+                    lanes[l] = (l < Count ? Values[l] : Padding);
+
+                return SimdFloat::Load(lanes);
+            };
+
+            // Sums K terms over a block with Registers independent accumulators per term, to
+            // hide the latency of the adds. Terms(Index, Available, Output) writes the terms of
+            // the register at Index, of which Available lanes (or more) are in the block; lanes
+            // past the block are cleared here. The accumulator lanes are folded pairwise in a
+            // fixed order and returned in double precision.
+            template <std::size_t K, std::size_t Registers, typename Function>
+            inline Vector<K, double> SumBlock(std::size_t First, std::size_t Last, Function &&Terms)
+            {
+                constexpr std::size_t width = WARLOCK_SIMD_WIDTH;
+                constexpr std::size_t step = Registers * width;
+
+                SimdFloat sums[K][Registers];
+                Unroll<K * Registers>([&](auto I) { sums[I / Registers][I % Registers] = SimdFloat::Zero(); });
+
+                std::size_t i = First;
+
+                for (; i + step <= Last; i += step)
+                {
+                    Unroll<Registers>([&](auto R)
+                    {
+                        SimdFloat terms[K];
+                        Terms(i + R * width, width, terms);
+                        Unroll<K>([&](auto k) { sums[k][R] = sums[k][R] + terms[k]; });
+                    });
+                }
+
+                for (; i < Last; i += width)
+                {
+                    const SimdMask inside = SimdInt::Index() < SimdInt(static_cast<std::int32_t>(Last - i));
+
+                    SimdFloat terms[K];
+                    Terms(i, Last - i, terms);
+                    Unroll<K>([&](auto k) { sums[k][0] = sums[k][0] + Select(inside, terms[k], SimdFloat::Zero()); });
+                }
+
+                Vector<K, double> result;
+
+                Unroll<K>([&](auto k)
+                {
+                    float lanes[step];
+
+                    for (std::size_t r = 0; r < Registers; r++)
+                        sums[k][r].Store(lanes + r * width);
+
+                    for (std::size_t half = step / 2; half > 0; half /= 2)
+                    {
+                        for (std::size_t l = 0; l < half; l++)
+                            lanes[l] += lanes[l + half];
+                    }
+
+                    result.template Get<k>() = lanes[0];
+                });
+
+                return result;
+            };
+
+            template <std::size_t K, std::size_t Registers, typename Function>
+            inline Vector<K, double> SumBlocks(std::size_t First, std::size_t Last, Function &&Terms)
+            {
+                return ReduceBlocks(First, Last, Vector<K, double>(), [&](std::size_t BlockFirst, std::size_t BlockLast)
+                {
+                    return SumBlock<K, Registers>(BlockFirst, BlockLast, Terms);
+                }, [](Vector<K, double> &Result, const Vector<K, double> &Block) { Result += Block; });
+            };
+
+            inline double SumRange(const float *Values, std::size_t First, std::size_t Last)
+            {
+                return SumBlocks<1, 4>(First, Last, [&](std::size_t Index, std::size_t Available, SimdFloat *Terms)
+                {
+                    Terms[0] = LoadLanes(Values + Index, Available);
+                })[0];
+            };
+
+            inline Vector3<double> SumRange(const ConstVector3Stream &Points, std::size_t First, std::size_t Last)
+            {
+                return SumBlocks<3, 2>(First, Last, [&](std::size_t Index, std::size_t Available, SimdFloat *Terms)
+                {
+                    Terms[0] = LoadLanes(Points.x + Index, Available);
+                    Terms[1] = LoadLanes(Points.y + Index, Available);
+                    Terms[2] = LoadLanes(Points.z + Index, Available);
+                });
+            };
+
+            // Sums of the offsets from Shift and of their products, x y z then xx xy xz yy yz
+            // zz. Shifting by a point of the stream keeps the sums small when the points sit
+            // far from the origin, so the covariance does not cancel away in one pass.
+            inline Vector<9, double> SumMoments(const ConstVector3Stream &Points, std::size_t First, std::size_t Last, const Vector3<float> &Shift)
+            {
+                const SimdFloat sx(Shift.x);
+                const SimdFloat sy(Shift.y);
+                const SimdFloat sz(Shift.z);
+
+                return SumBlocks<9, 1>(First, Last, [&](std::size_t Index, std::size_t Available, SimdFloat *Terms)
+                {
+                    const SimdFloat x = LoadLanes(Points.x + Index, Available, Shift.x) - sx;
+                    const SimdFloat y = LoadLanes(Points.y + Index, Available, Shift.y) - sy;
+                    const SimdFloat z = LoadLanes(Points.z + Index, Available, Shift.z) - sz;
+
+                    Terms[0] = x;
+                    Terms[1] = y;
+                    Terms[2] = z;
+                    Terms[3] = x * x;
+                    Terms[4] = x * y;
+                    Terms[5] = x * z;
+                    Terms[6] = y * y;
+                    Terms[7] = y * z;
+                    Terms[8] = z * z;
+                });
+            };
+
+            inline Matrix<3, 3, float> GetCovariance(const Vector<9, double> &Moments, std::size_t Count, const Vector3<float> &Shift, Vector3<float> &Mean)
+            {
+                const double inverse = 1.0 / double(Count);
+                const double mx = Moments[0] * inverse;
+                const double my = Moments[1] * inverse;
+                const double mz = Moments[2] * inverse;
+
+                const float xx = static_cast<float>(Moments[3] * inverse - mx * mx);
+                const float xy = static_cast<float>(Moments[4] * inverse - mx * my);
+                const float xz = static_cast<float>(Moments[5] * inverse - mx * mz);
+                const float yy = static_cast<float>(Moments[6] * inverse - my * my);
+                const float yz = static_cast<float>(Moments[7] * inverse - my * mz);
+                const float zz = static_cast<float>(Moments[8] * inverse - mz * mz);
+
+                Mean = Vector3<float>(static_cast<float>(Shift.x + mx), static_cast<float>(Shift.y + my), static_cast<float>(Shift.z + mz));
+
+                return Matrix<3, 3, float>(xx, xy, xz, xy, yy, yz, xz, yz, zz);
+            };
+
+            struct Extremes
+            {
+                SimdFloat minimum;
+                SimdFloat maximum;
+            };
+
+            inline void Include(Extremes &Bounds, SimdFloat Value)
+            {
+                Bounds.minimum = Min(Bounds.minimum, Value);
+                Bounds.maximum = Max(Bounds.maximum, Value);
+            };
+
+            // An extreme value and its index; ties go to the lower index, so extremes are
+            // exact and the same in any order.
+            struct ArgExtreme
+            {
+                float value;
+                std::size_t index;
+            };
+
+            template <bool Maximum> inline void Join(ArgExtreme &Result, const ArgExtreme &Other)
+            {
+                const bool better = (Maximum ? Other.value > Result.value : Other.value < Result.value);
+
+                if (better || (Other.value == Result.value && Other.index < Result.index))
+                    Result = Other;
+            };
+
+            template <bool Maximum> inline ArgExtreme GetArgExtreme(const float *Values, std::size_t First, std::size_t Last)
+            {
+                constexpr float worst = (Maximum ? -std::numeric_limits<float>::infinity() : std::numeric_limits<float>::infinity());
+                constexpr std::size_t none = std::numeric_limits<std::size_t>::max();
+
+                return ReduceBlocks(First, Last, ArgExtreme{worst, none}, [&](std::size_t BlockFirst, std::size_t BlockLast)
+                {
+                    // Two sets of lanes, the even and odd registers, to overlap the compares.
+                    SimdFloat best[2] = {SimdFloat(worst), SimdFloat(worst)};
+                    SimdInt bestIndex[2] = {SimdInt(std::numeric_limits<std::int32_t>::max()), SimdInt(std::numeric_limits<std::int32_t>::max())};
+
+                    const auto include = [&](std::size_t Set, std::size_t Index, SimdFloat Value)
+                    {
+                        const SimdMask better = (Maximum ? Value > best[Set] : Value < best[Set]);
+
+                        best[Set] = (Maximum ? Max(Value, best[Set]) : Min(Value, best[Set]));
+                        bestIndex[Set] = Select(better, SimdInt::Index() + SimdInt(static_cast<std::int32_t>(Index - BlockFirst)), bestIndex[Set]);
+                    };
+
+                    std::size_t i = BlockFirst;
+
+                    for (; i + 2 * WARLOCK_SIMD_WIDTH <= BlockLast; i += 2 * WARLOCK_SIMD_WIDTH)
+                    {
+                        include(0, i, SimdFloat::Load(Values + i));
+                        include(1, i + WARLOCK_SIMD_WIDTH, SimdFloat::Load(Values + i + WARLOCK_SIMD_WIDTH));
+                    }
+
+                    for (; i < BlockLast; i += WARLOCK_SIMD_WIDTH)
+                        include(0, i, LoadLanes(Values + i, BlockLast - i, worst));
+
+                    float values[2][WARLOCK_SIMD_WIDTH];
+                    std::int32_t indices[2][WARLOCK_SIMD_WIDTH];
+
+                    for (std::size_t r = 0; r < 2; r++)
+                    {
+                        best[r].Store(values[r]);
+                        bestIndex[r].Store(indices[r]);
+                    }
+
+                    ArgExtreme result{worst, none};
+
+                    for (std::size_t r = 0; r < 2; r++)
+                    {
+                        for (std::size_t l = 0; l < WARLOCK_SIMD_WIDTH; l++)
+                        {
+                            if (indices[r][l] != std::numeric_limits<std::int32_t>::max())
+                                Join<Maximum>(result, ArgExtreme{values[r][l], BlockFirst + std::size_t(indices[r][l])});
+                        }
+                    }
+
+                    return result;
+                }, Join<Maximum>);
+            };
+
+            // Lowest index of the extreme; First when every value is infinite the wrong way or
+            // NaN, Last when the range is empty.
+            inline std::size_t GetIndex(const ArgExtreme &Extreme, std::size_t First, std::size_t Last)
+            {
+                if (First >= Last)
+                    return Last;
+
+                return (Extreme.index == std::numeric_limits<std::size_t>::max() ? First : Extreme.index);
+            };
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Range kernels, for callers that already run inside a job. Sums are grouped per block
+        // of ReductionChunkSize from First, like deterministic whole stream sums.
+        //-----------------------------------------------------------------------------------------
+        inline float Sum(const float *Values, std::size_t First, std::size_t Last)
+        {
+            return static_cast<float>(Detail::SumRange(Values, First, Last));
+        };
+
+        inline Vector3<float> Sum(const ConstVector3Stream &Points, std::size_t First, std::size_t Last)
+        {
+            const Vector3<double> sum = Detail::SumRange(Points, First, Last);
+            return Vector3<float>(static_cast<float>(sum.x), static_cast<float>(sum.y), static_cast<float>(sum.z));
+        };
+
+        // Infinities of the wrong sign for an empty range; NaNs are not ordered and should not
+        // be in the stream.
+        inline void MinMax(const float *Values, std::size_t First, std::size_t Last, float &Minimum, float &Maximum)
+        {
+            Detail::Extremes bounds{SimdFloat(std::numeric_limits<float>::infinity()), SimdFloat(-std::numeric_limits<float>::infinity())};
+            Detail::Extremes other = bounds;
+            std::size_t i = First;
+
+            for (; i + 2 * WARLOCK_SIMD_WIDTH <= Last; i += 2 * WARLOCK_SIMD_WIDTH)
+            {
+                Detail::Include(bounds, SimdFloat::Load(Values + i));
+                Detail::Include(other, SimdFloat::Load(Values + i + WARLOCK_SIMD_WIDTH));
+            }
+
+            for (; i < Last; i += WARLOCK_SIMD_WIDTH)
+                Detail::Include(bounds, Detail::LoadLanes(Values + i, Last - i, Values[i]));
+
+            Minimum = ReduceMin(Min(bounds.minimum, other.minimum));
+            Maximum = ReduceMax(Max(bounds.maximum, other.maximum));
+        };
+
+        inline void MinMax(const ConstVector3Stream &Points, std::size_t First, std::size_t Last, Vector3<float> &Minimum, Vector3<float> &Maximum)
+        {
+            const SimdFloat low(std::numeric_limits<float>::infinity());
+            const SimdFloat high(-std::numeric_limits<float>::infinity());
+
+            Detail::Extremes x{low, high};
+            Detail::Extremes y{low, high};
+            Detail::Extremes z{low, high};
+
+            for (std::size_t i = First; i < Last; i += WARLOCK_SIMD_WIDTH)
+            {
+                Detail::Include(x, Detail::LoadLanes(Points.x + i, Last - i, Points.x[i]));
+                Detail::Include(y, Detail::LoadLanes(Points.y + i, Last - i, Points.y[i]));
+                Detail::Include(z, Detail::LoadLanes(Points.z + i, Last - i, Points.z[i]));
+            }
+
+            Minimum = Vector3<float>(ReduceMin(x.minimum), ReduceMin(y.minimum), ReduceMin(z.minimum));
+            Maximum = Vector3<float>(ReduceMax(x.maximum), ReduceMax(y.maximum), ReduceMax(z.maximum));
+        };
+
+        // Index of the lowest (highest) value, the first one on ties; Last for an empty range.
+        inline std::size_t ArgMin(const float *Values, std::size_t First, std::size_t Last)
+        {
+            return Detail::GetIndex(Detail::GetArgExtreme<false>(Values, First, Last), First, Last);
+        };
+
+        inline std::size_t ArgMax(const float *Values, std::size_t First, std::size_t Last)
+        {
+            return Detail::GetIndex(Detail::GetArgExtreme<true>(Values, First, Last), First, Last);
+        };
+
+        // Population covariance, divided by the point count, and the mean of the points; zero
+        // for an empty range.
+        inline Matrix<3, 3, float> Covariance(const ConstVector3Stream &Points, std::size_t First, std::size_t Last, Vector3<float> &Mean)
+        {
+            if (First >= Last)
+            {
+                Mean = Vector3<float>();
+                return Matrix<3, 3, float>();
+            }
+
+            const Vector3<float> shift(Points.x[First], Points.y[First], Points.z[First]);
+            return Detail::GetCovariance(Detail::SumMoments(Points, First, Last, shift), Last - First, shift, Mean);
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Whole stream reductions split across the thread pool. Extremes are exact and the same
+        // for any order, so only sums take a ReductionOrder.
+        //-----------------------------------------------------------------------------------------
+        inline float Sum(const float *Values, std::size_t Count, ReductionOrder Order = ReductionOrder::Fast, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            return static_cast<float>(ParallelReduce(Count, Detail::GetReductionChunk(Count, Order, Pool), Pool, 0.0, [&](std::size_t First, std::size_t Last)
+            {
+                return Detail::SumRange(Values, First, Last);
+            }, [](double &Result, double Chunk) { Result += Chunk; }));
+        };
+
+        inline Vector3<float> Sum(const ConstVector3Stream &Points, std::size_t Count, ReductionOrder Order = ReductionOrder::Fast, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            const Vector3<double> sum = ParallelReduce(Count, Detail::GetReductionChunk(Count, Order, Pool), Pool, Vector3<double>(), [&](std::size_t First, std::size_t Last)
+            {
+                return Detail::SumRange(Points, First, Last);
+            }, [](Vector3<double> &Result, const Vector3<double> &Chunk) { Result += Chunk; });
+
+            return Vector3<float>(static_cast<float>(sum.x), static_cast<float>(sum.y), static_cast<float>(sum.z));
+        };
+
+        // Zero for an empty stream.
+        inline Vector3<float> Mean(const ConstVector3Stream &Points, std::size_t Count, ReductionOrder Order = ReductionOrder::Fast, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            if (Count == 0)
+                return Vector3<float>();
+
+            const Vector3<double> sum = ParallelReduce(Count, Detail::GetReductionChunk(Count, Order, Pool), Pool, Vector3<double>(), [&](std::size_t First, std::size_t Last)
+            {
+                return Detail::SumRange(Points, First, Last);
+            }, [](Vector3<double> &Result, const Vector3<double> &Chunk) { Result += Chunk; });
+
+            const double inverse = 1.0 / double(Count);
+            return Vector3<float>(static_cast<float>(sum.x * inverse), static_cast<float>(sum.y * inverse), static_cast<float>(sum.z * inverse));
+        };
+
+        inline void MinMax(const float *Values, std::size_t Count, float &Minimum, float &Maximum, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            struct Bounds
+            {
+                float minimum;
+                float maximum;
+            };
+
+            const Bounds identity{std::numeric_limits<float>::infinity(), -std::numeric_limits<float>::infinity()};
+            const Bounds bounds = ParallelReduce(Count, Detail::GetReductionChunk(Count, ReductionOrder::Fast, Pool), Pool, identity, [&](std::size_t First, std::size_t Last)
+            {
+                Bounds chunk;
+                MinMax(Values, First, Last, chunk.minimum, chunk.maximum);
+                return chunk;
+            }, [](Bounds &Result, const Bounds &Chunk)
+            {
+                Result.minimum = (Chunk.minimum < Result.minimum ? Chunk.minimum : Result.minimum);
+                Result.maximum = (Chunk.maximum > Result.maximum ? Chunk.maximum : Result.maximum);
+            });
+
+            Minimum = bounds.minimum;
+            Maximum = bounds.maximum;
+        };
+
+        inline void MinMax(const ConstVector3Stream &Points, std::size_t Count, Vector3<float> &Minimum, Vector3<float> &Maximum, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            struct Bounds
+            {
+                Vector3<float> minimum;
+                Vector3<float> maximum;
+            };
+
+            const float infinity = std::numeric_limits<float>::infinity();
+            const Bounds identity{Vector3<float>(infinity, infinity, infinity), Vector3<float>(-infinity, -infinity, -infinity)};
+            const Bounds bounds = ParallelReduce(Count, Detail::GetReductionChunk(Count, ReductionOrder::Fast, Pool), Pool, identity, [&](std::size_t First, std::size_t Last)
+            {
+                Bounds chunk;
+                MinMax(Points, First, Last, chunk.minimum, chunk.maximum);
+                return chunk;
+            }, [](Bounds &Result, const Bounds &Chunk)
+            {
+                Detail::Unroll<3>([&](auto I)
+                {
+                    float &low = Result.minimum.template Get<I>();
+                    float &high = Result.maximum.template Get<I>();
+
+                    low = (Chunk.minimum.template Get<I>() < low ? Chunk.minimum.template Get<I>() : low);
+                    high = (Chunk.maximum.template Get<I>() > high ? Chunk.maximum.template Get<I>() : high);
+                });
+            });
+
+            Minimum = bounds.minimum;
+            Maximum = bounds.maximum;
+        };
+
+        inline std::size_t ArgMin(const float *Values, std::size_t Count, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            const Detail::ArgExtreme extreme = ParallelReduce(Count, Detail::GetReductionChunk(Count, ReductionOrder::Fast, Pool), Pool,
+                                                              Detail::ArgExtreme{std::numeric_limits<float>::infinity(), std::numeric_limits<std::size_t>::max()},
+                                                              [&](std::size_t First, std::size_t Last) { return Detail::GetArgExtreme<false>(Values, First, Last); }, Detail::Join<false>);
+
+            return Detail::GetIndex(extreme, 0, Count);
+        };
+
+        inline std::size_t ArgMax(const float *Values, std::size_t Count, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            const Detail::ArgExtreme extreme = ParallelReduce(Count, Detail::GetReductionChunk(Count, ReductionOrder::Fast, Pool), Pool,
+                                                              Detail::ArgExtreme{-std::numeric_limits<float>::infinity(), std::numeric_limits<std::size_t>::max()},
+                                                              [&](std::size_t First, std::size_t Last) { return Detail::GetArgExtreme<true>(Values, First, Last); }, Detail::Join<true>);
+
+            return Detail::GetIndex(extreme, 0, Count);
+        };
+
+        // One pass, with the offsets taken from the first point.
+        inline Matrix<3, 3, float> Covariance(const ConstVector3Stream &Points, std::size_t Count, Vector3<float> &Mean, ReductionOrder Order = ReductionOrder::Fast,
+                                              Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            if (Count == 0)
+            {
+                Mean = Vector3<float>();
+                return Matrix<3, 3, float>();
+            }
+
+            const Vector3<float> shift(Points.x[0], Points.y[0], Points.z[0]);
+            const Vector<9, double> moments = ParallelReduce(Count, Detail::GetReductionChunk(Count, Order, Pool), Pool, Vector<9, double>(), [&](std::size_t First, std::size_t Last)
+            {
+                return Detail::SumMoments(Points, First, Last, shift);
+            }, [](Vector<9, double> &Result, const Vector<9, double> &Chunk) { Result += Chunk; });
+
+            return Detail::GetCovariance(moments, Count, shift, Mean);
+        };
+    };
+};
+
+#endif // WARLOCK_MATH_REDUCTION_HPP
@@ -0,0 +1,847 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Math/Simd.hpp
+// Description: Portable wrappers over the SIMD registers of the target instruction set.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_MATH_SIMD_HPP
+#define WARLOCK_MATH_SIMD_HPP
+
+#include "Platform/Platform.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+//-------------------------------------------------------------------------------------------------
+// Register width selection
+//-------------------------------------------------------------------------------------------------
+#if WARLOCK_INSTRUCTION_SET_AVX2
+#include <immintrin.h>
+#define WARLOCK_SIMD_AVX2 1
+#define WARLOCK_SIMD_WIDTH 8
+#elif WARLOCK_INSTRUCTION_SET_SSE2
+#include <emmintrin.h>
+#if WARLOCK_INSTRUCTION_SET_SSE4_1
+#include <smmintrin.h>
+#endif
+#if (WARLOCK_INSTRUCTION_SET_FMA || WARLOCK_INSTRUCTION_SET_BMI2 || WARLOCK_INSTRUCTION_SET_F16C)
+#include <immintrin.h>
+#endif
+#define WARLOCK_SIMD_SSE2 1
+#define WARLOCK_SIMD_WIDTH 4
+#elif WARLOCK_INSTRUCTION_SET_NEON
+#include <arm_neon.h>
+#define WARLOCK_SIMD_NEON 1
+#define WARLOCK_SIMD_WIDTH 4
+#else
+#define WARLOCK_SIMD_SCALAR 1
+#define WARLOCK_SIMD_WIDTH 4
+#endif
+
+static constexpr auto WCS_SIMD_WIDTH = WARLOCK_SIMD_WIDTH;
+
+namespace Warlock
+{
+    namespace Math
+    {
+#if WARLOCK_SIMD_AVX2
+        //-----------------------------------------------------------------------------------------
+        // Intel AVX2 (8 lanes)
+        //-----------------------------------------------------------------------------------------
+        struct SimdMask
+        {
+            SimdMask() {};
+            SimdMask(__m256 Value) : v(Value) {};
+            SimdMask(__m256i Value) : v(_mm256_castsi256_ps(Value)) {};
+
+            int Bits() const { return _mm256_movemask_ps(v); };
+
+            __m256 v;
+        };
+
+        struct SimdFloat
+        {
+            static constexpr int Width = 8;
+
+            SimdFloat() {};
+            SimdFloat(float Value) : v(_mm256_set1_ps(Value)) {};
+            SimdFloat(__m256 Value) : v(Value) {};
+
+            static SimdFloat Load(const float *Values) { return _mm256_loadu_ps(Values); };
+            static SimdFloat LoadAligned(const float *Values) { return _mm256_load_ps(Values); };
+            static SimdFloat Zero() { return _mm256_setzero_ps(); };
+
+            void Store(float *Values) const { _mm256_storeu_ps(Values, v); };
+            void StoreAligned(float *Values) const { _mm256_store_ps(Values, v); };
+            void Stream(float *Values) const { _mm256_stream_ps(Values, v); };
+
+            __m256 v;
+        };
+
+        struct SimdInt
+        {
+            static constexpr int Width = 8;
+
+            SimdInt() {};
+            SimdInt(std::int32_t Value) : v(_mm256_set1_epi32(Value)) {};
+            SimdInt(__m256i Value) : v(Value) {};
+
+            static SimdInt Load(const std::int32_t *Values) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(Values)); };
+            static SimdInt Load(const std::uint32_t *Values) { return _mm256_loadu_si256(reinterpret_cast<const __m256i *>(Values)); };
+            static SimdInt Load(const std::uint8_t *Values) { return _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(Values))); };
+            static SimdInt Load(const std::uint16_t *Values) { return _mm256_cvtepu16_epi32(_mm_loadu_si128(reinterpret_cast<const __m128i *>(Values))); };
+            static SimdInt Zero() { return _mm256_setzero_si256(); };
+            static SimdInt Index() { return _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7); };
+
+            void Store(std::int32_t *Values) const { _mm256_storeu_si256(reinterpret_cast<__m256i *>(Values), v); };
+            void Store(std::uint32_t *Values) const { _mm256_storeu_si256(reinterpret_cast<__m256i *>(Values), v); };
+
+            __m256i v;
+        };
+
+        inline SimdFloat operator +(SimdFloat a, SimdFloat b) { return _mm256_add_ps(a.v, b.v); };
+        inline SimdFloat operator -(SimdFloat a, SimdFloat b) { return _mm256_sub_ps(a.v, b.v); };
+        inline SimdFloat operator *(SimdFloat a, SimdFloat b) { return _mm256_mul_ps(a.v, b.v); };
+        inline SimdFloat operator /(SimdFloat a, SimdFloat b) { return _mm256_div_ps(a.v, b.v); };
+        inline SimdFloat operator -(SimdFloat a) { return _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)); };
+
+        inline SimdMask operator <(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ); };
+        inline SimdMask operator <=(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ); };
+        inline SimdMask operator >(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ); };
+        inline SimdMask operator >=(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ); };
+        inline SimdMask operator ==(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ); };
+        inline SimdMask operator !=(SimdFloat a, SimdFloat b) { return _mm256_cmp_ps(a.v, b.v, _CMP_NEQ_UQ); };
+
+        inline SimdFloat Min(SimdFloat a, SimdFloat b) { return _mm256_min_ps(a.v, b.v); };
+        inline SimdFloat Max(SimdFloat a, SimdFloat b) { return _mm256_max_ps(a.v, b.v); };
+        inline SimdFloat Abs(SimdFloat a) { return _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v); };
+        inline SimdFloat Sqrt(SimdFloat a) { return _mm256_sqrt_ps(a.v); };
+        inline SimdFloat Floor(SimdFloat a) { return _mm256_floor_ps(a.v); };
+        inline SimdFloat Round(SimdFloat a) { return _mm256_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); };
+        inline SimdFloat Select(SimdMask Mask, SimdFloat a, SimdFloat b) { return _mm256_blendv_ps(b.v, a.v, Mask.v); };
+
+#if WARLOCK_INSTRUCTION_SET_FMA
+        inline SimdFloat MulAdd(SimdFloat a, SimdFloat b, SimdFloat c) { return _mm256_fmadd_ps(a.v, b.v, c.v); };
+        inline SimdFloat NegMulAdd(SimdFloat a, SimdFloat b, SimdFloat c) { return _mm256_fnmadd_ps(a.v, b.v, c.v); };
+#else
+        inline SimdFloat MulAdd(SimdFloat a, SimdFloat b, SimdFloat c) { return _mm256_add_ps(_mm256_mul_ps(a.v, b.v), c.v); };
+        inline SimdFloat NegMulAdd(SimdFloat a, SimdFloat b, SimdFloat c) { return _mm256_sub_ps(c.v, _mm256_mul_ps(a.v, b.v)); };
+#endif
+
+        inline float ReduceAdd(SimdFloat a)
+        {
+            __m128 x = _mm_add_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+            x = _mm_add_ps(x, _mm_movehl_ps(x, x));
+            x = _mm_add_ss(x, _mm_shuffle_ps(x, x, 0x55));
+
+            return _mm_cvtss_f32(x);
+        };
+
+        inline float ReduceMin(SimdFloat a)
+        {
+            __m128 x = _mm_min_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+            x = _mm_min_ps(x, _mm_movehl_ps(x, x));
+            x = _mm_min_ss(x, _mm_shuffle_ps(x, x, 0x55));
+
+            return _mm_cvtss_f32(x);
+        };
+
+        inline float ReduceMax(SimdFloat a)
+        {
+            __m128 x = _mm_max_ps(_mm256_castps256_ps128(a.v), _mm256_extractf128_ps(a.v, 1));
+            x = _mm_max_ps(x, _mm_movehl_ps(x, x));
+            x = _mm_max_ss(x, _mm_shuffle_ps(x, x, 0x55));
+
+            return _mm_cvtss_f32(x);
+        };
+
+        inline SimdInt operator +(SimdInt a, SimdInt b) { return _mm256_add_epi32(a.v, b.v); };
+        inline SimdInt operator -(SimdInt a, SimdInt b) { return _mm256_sub_epi32(a.v, b.v); };
+        inline SimdInt operator *(SimdInt a, SimdInt b) { return _mm256_mullo_epi32(a.v, b.v); };
+        inline SimdInt operator &(SimdInt a, SimdInt b) { return _mm256_and_si256(a.v, b.v); };
+        inline SimdInt operator |(SimdInt a, SimdInt b) { return _mm256_or_si256(a.v, b.v); };
+        inline SimdInt operator ^(SimdInt a, SimdInt b) { return _mm256_xor_si256(a.v, b.v); };
+        inline SimdInt operator <<(SimdInt a, int Count) { return _mm256_slli_epi32(a.v, Count); };
+        inline SimdInt operator >>(SimdInt a, int Count) { return _mm256_srli_epi32(a.v, Count); };
+        inline SimdInt ShiftRightArithmetic(SimdInt a, int Count) { return _mm256_srai_epi32(a.v, Count); };
+
+        inline SimdMask operator ==(SimdInt a, SimdInt b) { return _mm256_cmpeq_epi32(a.v, b.v); };
+        inline SimdMask operator >(SimdInt a, SimdInt b) { return _mm256_cmpgt_epi32(a.v, b.v); };
+        inline SimdMask operator <(SimdInt a, SimdInt b) { return _mm256_cmpgt_epi32(b.v, a.v); };
+
+        inline SimdInt Min(SimdInt a, SimdInt b) { return _mm256_min_epi32(a.v, b.v); };
+        inline SimdInt Max(SimdInt a, SimdInt b) { return _mm256_max_epi32(a.v, b.v); };
+        inline SimdInt Select(SimdMask Mask, SimdInt a, SimdInt b) { return _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b.v), _mm256_castsi256_ps(a.v), Mask.v)); };
+
+        inline SimdInt ToInt(SimdFloat a) { return _mm256_cvttps_epi32(a.v); };
+        inline SimdFloat ToFloat(SimdInt a) { return _mm256_cvtepi32_ps(a.v); };
+        inline SimdInt AsInt(SimdFloat a) { return _mm256_castps_si256(a.v); };
+        inline SimdFloat AsFloat(SimdInt a) { return _mm256_castsi256_ps(a.v); };
+
+        inline SimdMask operator &(SimdMask a, SimdMask b) { return _mm256_and_ps(a.v, b.v); };
+        inline SimdMask operator |(SimdMask a, SimdMask b) { return _mm256_or_ps(a.v, b.v); };
+        inline SimdMask operator ^(SimdMask a, SimdMask b) { return _mm256_xor_ps(a.v, b.v); };
+        inline SimdMask operator ~(SimdMask a) { return _mm256_xor_ps(a.v, _mm256_castsi256_ps(_mm256_set1_epi32(-1))); };
+#elif WARLOCK_SIMD_SSE2
+        //-----------------------------------------------------------------------------------------
+        // Intel SSE2 (4 lanes)
+        //-----------------------------------------------------------------------------------------
+        struct SimdMask
+        {
+            SimdMask() {};
+            SimdMask(__m128 Value) : v(Value) {};
+            SimdMask(__m128i Value) : v(_mm_castsi128_ps(Value)) {};
+
+            int Bits() const { return _mm_movemask_ps(v); };
+
+            __m128 v;
+        };
+
+        struct SimdFloat
+        {
+            static constexpr int Width = 4;
+
+            SimdFloat() {};
+            SimdFloat(float Value) : v(_mm_set1_ps(Value)) {};
+            SimdFloat(__m128 Value) : v(Value) {};
+
+            static SimdFloat Load(const float *Values) { return _mm_loadu_ps(Values); };
+            static SimdFloat LoadAligned(const float *Values) { return _mm_load_ps(Values); };
+            static SimdFloat Zero() { return _mm_setzero_ps(); };
+
+            void Store(float *Values) const { _mm_storeu_ps(Values, v); };
+            void StoreAligned(float *Values) const { _mm_store_ps(Values, v); };
+            void Stream(float *Values) const { _mm_stream_ps(Values, v); };
+
+            __m128 v;
+        };
+
+        struct SimdInt
+        {
+            static constexpr int Width = 4;
+
+            SimdInt() {};
+            SimdInt(std::int32_t Value) : v(_mm_set1_epi32(Value)) {};
+            SimdInt(__m128i Value) : v(Value) {};
+
+            static SimdInt Load(const std::int32_t *Values) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(Values)); };
+            static SimdInt Load(const std::uint32_t *Values) { return _mm_loadu_si128(reinterpret_cast<const __m128i *>(Values)); };
+
+            static SimdInt Load(const std::uint8_t *Values)
+            {
+                std::int32_t packed;
+                std::memcpy(&packed, Values, sizeof(packed));
+
+                __m128i zero = _mm_setzero_si128();
+                return _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero), zero);
+            };
+
+            static SimdInt Load(const std::uint16_t *Values)
+            {
+                return _mm_unpacklo_epi16(_mm_loadl_epi64(reinterpret_cast<const __m128i *>(Values)), _mm_setzero_si128());
+            };
+
+            static SimdInt Zero() { return _mm_setzero_si128(); };
+            static SimdInt Index() { return _mm_setr_epi32(0, 1, 2, 3); };
+
+            void Store(std::int32_t *Values) const { _mm_storeu_si128(reinterpret_cast<__m128i *>(Values), v); };
+            void Store(std::uint32_t *Values) const { _mm_storeu_si128(reinterpret_cast<__m128i *>(Values), v); };
+
+            __m128i v;
+        };
+
+        inline SimdFloat operator +(SimdFloat a, SimdFloat b) { return _mm_add_ps(a.v, b.v); };
+        inline SimdFloat operator -(SimdFloat a, SimdFloat b) { return _mm_sub_ps(a.v, b.v); };
+        inline SimdFloat operator *(SimdFloat a, SimdFloat b) { return _mm_mul_ps(a.v, b.v); };
+        inline SimdFloat operator /(SimdFloat a, SimdFloat b) { return _mm_div_ps(a.v, b.v); };
+        inline SimdFloat operator -(SimdFloat a) { return _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)); };
+
+        inline SimdMask operator <(SimdFloat a, SimdFloat b) { return _mm_cmplt_ps(a.v, b.v); };
+        inline SimdMask operator <=(SimdFloat a, SimdFloat b) { return _mm_cmple_ps(a.v, b.v); };
+        inline SimdMask operator >(SimdFloat a, SimdFloat b) { return _mm_cmpgt_ps(a.v, b.v); };
+        inline SimdMask operator >=(SimdFloat a, SimdFloat b) { return _mm_cmpge_ps(a.v, b.v); };
+        inline SimdMask operator ==(SimdFloat a, SimdFloat b) { return _mm_cmpeq_ps(a.v, b.v); };
+        inline SimdMask operator !=(SimdFloat a, SimdFloat b) { return _mm_cmpneq_ps(a.v, b.v); };
+
+        inline SimdFloat Min(SimdFloat a, SimdFloat b) { return _mm_min_ps(a.v, b.v); };
+        inline SimdFloat Max(SimdFloat a, SimdFloat b) { return _mm_max_ps(a.v, b.v); };
+        inline SimdFloat Abs(SimdFloat a) { return _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v); };
+        inline SimdFloat Sqrt(SimdFloat a) { return _mm_sqrt_ps(a.v); };
+
+#if WARLOCK_INSTRUCTION_SET_SSE4_1
+        inline SimdFloat Floor(SimdFloat a) { return _mm_floor_ps(a.v); };
+        inline SimdFloat Round(SimdFloat a) { return _mm_round_ps(a.v, _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC); };
+        inline SimdFloat Select(SimdMask Mask, SimdFloat a, SimdFloat b) { return _mm_blendv_ps(b.v, a.v, Mask.v); };
+#else
+        inline SimdFloat Select(SimdMask Mask, SimdFloat a, SimdFloat b) { return _mm_or_ps(_mm_and_ps(Mask.v, a.v), _mm_andnot_ps(Mask.v, b.v)); };
+
+        inline SimdFloat Floor(SimdFloat a)
+        {
+            __m128 t = _mm_cvtepi32_ps(_mm_cvttps_epi32(a.v));
+            __m128 r = _mm_sub_ps(t, _mm_and_ps(_mm_cmpgt_ps(t, a.v), _mm_set1_ps(1.0f)));
+
+            return _mm_or_ps(_mm_and_ps(_mm_cmplt_ps(Abs(a).v, _mm_set1_ps(8388608.0f)), r),
+                             _mm_andnot_ps(_mm_cmplt_ps(Abs(a).v, _mm_set1_ps(8388608.0f)), a.v));
+        };
+
+        inline SimdFloat Round(SimdFloat a)
+        {
+            __m128 r = _mm_cvtepi32_ps(_mm_cvtps_epi32(a.v));
+
+            return _mm_or_ps(_mm_and_ps(_mm_cmplt_ps(Abs(a).v, _mm_set1_ps(8388608.0f)), r),
+                             _mm_andnot_ps(_mm_cmplt_ps(Abs(a).v, _mm_set1_ps(8388608.0f)), a.v));
+        };
+#endif
+
+#if WARLOCK_INSTRUCTION_SET_FMA
+        inline SimdFloat MulAdd(SimdFloat a, SimdFloat b, SimdFloat c) { return _mm_fmadd_ps(a.v, b.v, c.v); };
+        inline SimdFloat NegMulAdd(SimdFloat a, SimdFloat b, SimdFloat c) { return _mm_fnmadd_ps(a.v, b.v, c.v); };
+#else
+        inline SimdFloat MulAdd(SimdFloat a, SimdFloat b, SimdFloat c) { return _mm_add_ps(_mm_mul_ps(a.v, b.v), c.v); };
+        inline SimdFloat NegMulAdd(SimdFloat a, SimdFloat b, SimdFloat c) { return _mm_sub_ps(c.v, _mm_mul_ps(a.v, b.v)); };
+#endif
+
+        inline float ReduceAdd(SimdFloat a)
+        {
+            __m128 x = _mm_add_ps(a.v, _mm_movehl_ps(a.v, a.v));
+            x = _mm_add_ss(x, _mm_shuffle_ps(x, x, 0x55));
+
+            return _mm_cvtss_f32(x);
+        };
+
+        inline float ReduceMin(SimdFloat a)
+        {
+            __m128 x = _mm_min_ps(a.v, _mm_movehl_ps(a.v, a.v));
+            x = _mm_min_ss(x, _mm_shuffle_ps(x, x, 0x55));
+
+            return _mm_cvtss_f32(x);
+        };
+
+        inline float ReduceMax(SimdFloat a)
+        {
+            __m128 x = _mm_max_ps(a.v, _mm_movehl_ps(a.v, a.v));
+            x = _mm_max_ss(x, _mm_shuffle_ps(x, x, 0x55));
+
+            return _mm_cvtss_f32(x);
+        };
+
+        inline SimdInt operator +(SimdInt a, SimdInt b) { return _mm_add_epi32(a.v, b.v); };
+        inline SimdInt operator -(SimdInt a, SimdInt b) { return _mm_sub_epi32(a.v, b.v); };
+        inline SimdInt operator &(SimdInt a, SimdInt b) { return _mm_and_si128(a.v, b.v); };
+        inline SimdInt operator |(SimdInt a, SimdInt b) { return _mm_or_si128(a.v, b.v); };
+        inline SimdInt operator ^(SimdInt a, SimdInt b) { return _mm_xor_si128(a.v, b.v); };
+        inline SimdInt operator <<(SimdInt a, int Count) { return _mm_slli_epi32(a.v, Count); };
+        inline SimdInt operator >>(SimdInt a, int Count) { return _mm_srli_epi32(a.v, Count); };
+        inline SimdInt ShiftRightArithmetic(SimdInt a, int Count) { return _mm_srai_epi32(a.v, Count); };
+
+        inline SimdMask operator ==(SimdInt a, SimdInt b) { return _mm_cmpeq_epi32(a.v, b.v); };
+        inline SimdMask operator >(SimdInt a, SimdInt b) { return _mm_cmpgt_epi32(a.v, b.v); };
+        inline SimdMask operator <(SimdInt a, SimdInt b) { return _mm_cmplt_epi32(a.v, b.v); };
+
+        inline SimdInt Select(SimdMask Mask, SimdInt a, SimdInt b)
+        {
+            __m128i m = _mm_castps_si128(Mask.v);
+
+            return _mm_or_si128(_mm_and_si128(m, a.v), _mm_andnot_si128(m, b.v));
+        };
+
+#if WARLOCK_INSTRUCTION_SET_SSE4_1
+        inline SimdInt operator *(SimdInt a, SimdInt b) { return _mm_mullo_epi32(a.v, b.v); };
+        inline SimdInt Min(SimdInt a, SimdInt b) { return _mm_min_epi32(a.v, b.v); };
+        inline SimdInt Max(SimdInt a, SimdInt b) { return _mm_max_epi32(a.v, b.v); };
+#else
+        inline SimdInt operator *(SimdInt a, SimdInt b)
+        {
+            __m128i even = _mm_mul_epu32(a.v, b.v);
+            __m128i odd = _mm_mul_epu32(_mm_shuffle_epi32(a.v, 0xF5), _mm_shuffle_epi32(b.v, 0xF5));
+
+            return _mm_unpacklo_epi32(_mm_shuffle_epi32(even, 0x08), _mm_shuffle_epi32(odd, 0x08));
+        };
+
+        inline SimdInt Min(SimdInt a, SimdInt b) { return Select(a < b, a, b); };
+        inline SimdInt Max(SimdInt a, SimdInt b) { return Select(a > b, a, b); };
+#endif
+
+        inline SimdInt ToInt(SimdFloat a) { return _mm_cvttps_epi32(a.v); };
+        inline SimdFloat ToFloat(SimdInt a) { return _mm_cvtepi32_ps(a.v); };
+        inline SimdInt AsInt(SimdFloat a) { return _mm_castps_si128(a.v); };
+        inline SimdFloat AsFloat(SimdInt a) { return _mm_castsi128_ps(a.v); };
+
+        inline SimdMask operator &(SimdMask a, SimdMask b) { return _mm_and_ps(a.v, b.v); };
+        inline SimdMask operator |(SimdMask a, SimdMask b) { return _mm_or_ps(a.v, b.v); };
+        inline SimdMask operator ^(SimdMask a, SimdMask b) { return _mm_xor_ps(a.v, b.v); };
+        inline SimdMask operator ~(SimdMask a) { return _mm_xor_ps(a.v, _mm_castsi128_ps(_mm_set1_epi32(-1))); };
+#elif WARLOCK_SIMD_NEON
+        //-----------------------------------------------------------------------------------------
+        // ARM NEON (4 lanes)
+        //-----------------------------------------------------------------------------------------
+        struct SimdMask
+        {
+            SimdMask() {};
+            SimdMask(uint32x4_t Value) : v(Value) {};
+
+            int Bits() const
+            {
+                static const std::uint32_t weights[4] = {1, 2, 4, 8};
+                uint32x4_t x = vandq_u32(v, vld1q_u32(weights));
+                uint32x2_t y = vadd_u32(vget_low_u32(x), vget_high_u32(x));
+
+                return static_cast<int>(vget_lane_u32(vpadd_u32(y, y), 0));
+            };
+
+            uint32x4_t v;
+        };
+
+        struct SimdFloat
+        {
+            static constexpr int Width = 4;
+
+            SimdFloat() {};
+            SimdFloat(float Value) : v(vdupq_n_f32(Value)) {};
+            SimdFloat(float32x4_t Value) : v(Value) {};
+
+            static SimdFloat Load(const float *Values) { return vld1q_f32(Values); };
+            static SimdFloat LoadAligned(const float *Values) { return vld1q_f32(Values); };
+            static SimdFloat Zero() { return vdupq_n_f32(0.0f); };
+
+            void Store(float *Values) const { vst1q_f32(Values, v); };
+            void StoreAligned(float *Values) const { vst1q_f32(Values, v); };
+            void Stream(float *Values) const { vst1q_f32(Values, v); };
+
+            float32x4_t v;
+        };
+
+        struct SimdInt
+        {
+            static constexpr int Width = 4;
+
+            SimdInt() {};
+            SimdInt(std::int32_t Value) : v(vdupq_n_s32(Value)) {};
+            SimdInt(int32x4_t Value) : v(Value) {};
+
+            static SimdInt Load(const std::int32_t *Values) { return vld1q_s32(Values); };
+            static SimdInt Load(const std::uint32_t *Values) { return vreinterpretq_s32_u32(vld1q_u32(Values)); };
+
+            static SimdInt Load(const std::uint8_t *Values)
+            {
+                std::uint32_t packed;
+                std::memcpy(&packed, Values, sizeof(packed));
+
+                uint16x8_t wide = vmovl_u8(vreinterpret_u8_u32(vdup_n_u32(packed)));
+                return vreinterpretq_s32_u32(vmovl_u16(vget_low_u16(wide)));
+            };
+
+            static SimdInt Load(const std::uint16_t *Values) { return vreinterpretq_s32_u32(vmovl_u16(vld1_u16(Values))); };
+
+            static SimdInt Zero() { return vdupq_n_s32(0); };
+
+            static SimdInt Index()
+            {
+                static const std::int32_t index[4] = {0, 1, 2, 3};
+
+                return vld1q_s32(index);
+            };
+
+            void Store(std::int32_t *Values) const { vst1q_s32(Values, v); };
+            void Store(std::uint32_t *Values) const { vst1q_u32(Values, vreinterpretq_u32_s32(v)); };
+
+            int32x4_t v;
+        };
+
+        inline SimdFloat operator +(SimdFloat a, SimdFloat b) { return vaddq_f32(a.v, b.v); };
+        inline SimdFloat operator -(SimdFloat a, SimdFloat b) { return vsubq_f32(a.v, b.v); };
+        inline SimdFloat operator *(SimdFloat a, SimdFloat b) { return vmulq_f32(a.v, b.v); };
+        inline SimdFloat operator -(SimdFloat a) { return vnegq_f32(a.v); };
+
+        inline SimdMask operator <(SimdFloat a, SimdFloat b) { return vcltq_f32(a.v, b.v); };
+        inline SimdMask operator <=(SimdFloat a, SimdFloat b) { return vcleq_f32(a.v, b.v); };
+        inline SimdMask operator >(SimdFloat a, SimdFloat b) { return vcgtq_f32(a.v, b.v); };
+        inline SimdMask operator >=(SimdFloat a, SimdFloat b) { return vcgeq_f32(a.v, b.v); };
+        inline SimdMask operator ==(SimdFloat a, SimdFloat b) { return vceqq_f32(a.v, b.v); };
+        inline SimdMask operator !=(SimdFloat a, SimdFloat b) { return vmvnq_u32(vceqq_f32(a.v, b.v)); };
+
+        inline SimdFloat Min(SimdFloat a, SimdFloat b) { return vminq_f32(a.v, b.v); };
+        inline SimdFloat Max(SimdFloat a, SimdFloat b) { return vmaxq_f32(a.v, b.v); };
+        inline SimdFloat Abs(SimdFloat a) { return vabsq_f32(a.v); };
+        inline SimdFloat Select(SimdMask Mask, SimdFloat a, SimdFloat b) { return vbslq_f32(Mask.v, a.v, b.v); };
+
+#if WARLOCK_ARCHITECTURE_ARM64
+        inline SimdFloat operator /(SimdFloat a, SimdFloat b) { return vdivq_f32(a.v, b.v); };
+        inline SimdFloat Sqrt(SimdFloat a) { return vsqrtq_f32(a.v); };
+        inline SimdFloat Floor(SimdFloat a) { return vrndmq_f32(a.v); };
+        inline SimdFloat Round(SimdFloat a) { return vrndnq_f32(a.v); };
+        inline SimdFloat MulAdd(SimdFloat a, SimdFloat b, SimdFloat c) { return vfmaq_f32(c.v, a.v, b.v); };
+        inline SimdFloat NegMulAdd(SimdFloat a, SimdFloat b, SimdFloat c) { return vfmsq_f32(c.v, a.v, b.v); };
+        inline float ReduceAdd(SimdFloat a) { return vaddvq_f32(a.v); };
+        inline float ReduceMin(SimdFloat a) { return vminvq_f32(a.v); };
+        inline float ReduceMax(SimdFloat a) { return vmaxvq_f32(a.v); };
+#else
+        inline SimdFloat operator /(SimdFloat a, SimdFloat b)
+        {
+            float32x4_t r = vrecpeq_f32(b.v);
+            r = vmulq_f32(r, vrecpsq_f32(b.v, r));
+            r = vmulq_f32(r, vrecpsq_f32(b.v, r));
+
+            return vmulq_f32(a.v, r);
+        };
+
+        inline SimdFloat Sqrt(SimdFloat a)
+        {
+            float32x4_t r = vrsqrteq_f32(a.v);
+            r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a.v, r), r));
+            r = vmulq_f32(r, vrsqrtsq_f32(vmulq_f32(a.v, r), r));
+
+            return vbslq_f32(vceqq_f32(a.v, vdupq_n_f32(0.0f)), a.v, vmulq_f32(a.v, r));
+        };
+
+        inline SimdFloat Floor(SimdFloat a)
+        {
+            float32x4_t t = vcvtq_f32_s32(vcvtq_s32_f32(a.v));
+            float32x4_t r = vsubq_f32(t, vbslq_f32(vcgtq_f32(t, a.v), vdupq_n_f32(1.0f), vdupq_n_f32(0.0f)));
+
+            return vbslq_f32(vcltq_f32(vabsq_f32(a.v), vdupq_n_f32(8388608.0f)), r, a.v);
+        };
+
+        inline SimdFloat Round(SimdFloat a)
+        {
+            return Floor(vaddq_f32(a.v, vdupq_n_f32(0.5f)));
+        };
+
+        inline SimdFloat MulAdd(SimdFloat a, SimdFloat b, SimdFloat c) { return vmlaq_f32(c.v, a.v, b.v); };
+        inline SimdFloat NegMulAdd(SimdFloat a, SimdFloat b, SimdFloat c) { return vmlsq_f32(c.v, a.v, b.v); };
+
+        inline float ReduceAdd(SimdFloat a)
+        {
+            float32x2_t x = vadd_f32(vget_low_f32(a.v), vget_high_f32(a.v));
+
+            return vget_lane_f32(vpadd_f32(x, x), 0);
+        };
+
+        inline float ReduceMin(SimdFloat a)
+        {
+            float32x2_t x = vmin_f32(vget_low_f32(a.v), vget_high_f32(a.v));
+
+            return vget_lane_f32(vpmin_f32(x, x), 0);
+        };
+
+        inline float ReduceMax(SimdFloat a)
+        {
+            float32x2_t x = vmax_f32(vget_low_f32(a.v), vget_high_f32(a.v));
+
+            return vget_lane_f32(vpmax_f32(x, x), 0);
+        };
+#endif
+
+        inline SimdInt operator +(SimdInt a, SimdInt b) { return vaddq_s32(a.v, b.v); };
+        inline SimdInt operator -(SimdInt a, SimdInt b) { return vsubq_s32(a.v, b.v); };
+        inline SimdInt operator *(SimdInt a, SimdInt b) { return vmulq_s32(a.v, b.v); };
+        inline SimdInt operator &(SimdInt a, SimdInt b) { return vandq_s32(a.v, b.v); };
+        inline SimdInt operator |(SimdInt a, SimdInt b) { return vorrq_s32(a.v, b.v); };
+        inline SimdInt operator ^(SimdInt a, SimdInt b) { return veorq_s32(a.v, b.v); };
+        inline SimdInt operator <<(SimdInt a, int Count) { return vshlq_s32(a.v, vdupq_n_s32(Count)); };
+        inline SimdInt operator >>(SimdInt a, int Count) { return vreinterpretq_s32_u32(vshlq_u32(vreinterpretq_u32_s32(a.v), vdupq_n_s32(-Count))); };
+        inline SimdInt ShiftRightArithmetic(SimdInt a, int Count) { return vshlq_s32(a.v, vdupq_n_s32(-Count)); };
+
+        inline SimdMask operator ==(SimdInt a, SimdInt b) { return vceqq_s32(a.v, b.v); };
+        inline SimdMask operator >(SimdInt a, SimdInt b) { return vcgtq_s32(a.v, b.v); };
+        inline SimdMask operator <(SimdInt a, SimdInt b) { return vcltq_s32(a.v, b.v); };
+
+        inline SimdInt Min(SimdInt a, SimdInt b) { return vminq_s32(a.v, b.v); };
+        inline SimdInt Max(SimdInt a, SimdInt b) { return vmaxq_s32(a.v, b.v); };
+        inline SimdInt Select(SimdMask Mask, SimdInt a, SimdInt b) { return vbslq_s32(Mask.v, a.v, b.v); };
+
+        inline SimdInt ToInt(SimdFloat a) { return vcvtq_s32_f32(a.v); };
+        inline SimdFloat ToFloat(SimdInt a) { return vcvtq_f32_s32(a.v); };
+        inline SimdInt AsInt(SimdFloat a) { return vreinterpretq_s32_f32(a.v); };
+        inline SimdFloat AsFloat(SimdInt a) { return vreinterpretq_f32_s32(a.v); };
+
+        inline SimdMask operator &(SimdMask a, SimdMask b) { return vandq_u32(a.v, b.v); };
+        inline SimdMask operator |(SimdMask a, SimdMask b) { return vorrq_u32(a.v, b.v); };
+        inline SimdMask operator ^(SimdMask a, SimdMask b) { return veorq_u32(a.v, b.v); };
+        inline SimdMask operator ~(SimdMask a) { return vmvnq_u32(a.v); };
+#else
+        //-----------------------------------------------------------------------------------------
+        // Portable scalar emulation (4 lanes)
+        //-----------------------------------------------------------------------------------------
+        struct SimdMask
+        {
+            int Bits() const
+            {
+                return ((v[0] ? 1 : 0) | (v[1] ? 2 : 0) | (v[2] ? 4 : 0) | (v[3] ? 8 : 0));
+            };
+
+            std::uint32_t v[4];
+        };
+
+        struct SimdFloat
+        {
+            static constexpr int Width = 4;
+
+            SimdFloat() {};
+            SimdFloat(float Value) : v{Value, Value, Value, Value} {};
+
+            static SimdFloat Load(const float *Values)
+            {
+                SimdFloat r;
+
+                for (int i = 0; i < 4; i++)
+                    r.v[i] = Values[i];
+
+                return r;
+            };
+
+            static SimdFloat LoadAligned(const float *Values) { return Load(Values); };
+            static SimdFloat Zero() { return SimdFloat(0.0f); };
+
+            void Store(float *Values) const
+            {
+                for (int i = 0; i < 4; i++)
+                    Values[i] = v[i];
+            };
+
+            void StoreAligned(float *Values) const { Store(Values); };
+            void Stream(float *Values) const { Store(Values); };
+
+            float v[4];
+        };
+
+        struct SimdInt
+        {
+            static constexpr int Width = 4;
+
+            SimdInt() {};
+            SimdInt(std::int32_t Value) : v{Value, Value, Value, Value} {};
+
+            static SimdInt Load(const std::int32_t *Values)
+            {
+                SimdInt r;
+
+                for (int i = 0; i < 4; i++)
+                    r.v[i] = Values[i];
+
+                return r;
+            };
+
+            static SimdInt Load(const std::uint32_t *Values)
+            {
+                SimdInt r;
+
+                for (int i = 0; i < 4; i++)
+                    r.v[i] = static_cast<std::int32_t>(Values[i]);
+
+                return r;
+            };
+
+            static SimdInt Load(const std::uint8_t *Values)
+            {
+                SimdInt r;
+
+                for (int i = 0; i < 4; i++)
+                    r.v[i] = Values[i];
+
+                return r;
+            };
+
+            static SimdInt Load(const std::uint16_t *Values)
+            {
+                SimdInt r;
+
+                for (int i = 0; i < 4; i++)
+                    r.v[i] = Values[i];
+
+                return r;
+            };
+
+            static SimdInt Zero() { return SimdInt(0); };
+
+            static SimdInt Index()
+            {
+                SimdInt r;
+
+                for (int i = 0; i < 4; i++)
+                    r.v[i] = i;
+
+                return r;
+            };
+
+            void Store(std::int32_t *Values) const
+            {
+                for (int i = 0; i < 4; i++)
+                    Values[i] = v[i];
+            };
+
+            void Store(std::uint32_t *Values) const
+            {
+                for (int i = 0; i < 4; i++)
+                    Values[i] = static_cast<std::uint32_t>(v[i]);
+            };
+
+            std::int32_t v[4];
+        };
+
+#define WARLOCK_SIMD_LANEWISE(Result, Expression) \
+        Result r; \
+        for (int i = 0; i < 4; i++) \
+            r.v[i] = Expression; \
+        return r;
+
+        inline SimdFloat operator +(SimdFloat a, SimdFloat b) { WARLOCK_SIMD_LANEWISE(SimdFloat, a.v[i] + b.v[i]) };
+        inline SimdFloat operator -(SimdFloat a, SimdFloat b) { WARLOCK_SIMD_LANEWISE(SimdFloat, a.v[i] - b.v[i]) };
+        inline SimdFloat operator *(SimdFloat a, SimdFloat b) { WARLOCK_SIMD_LANEWISE(SimdFloat, a.v[i] * b.v[i]) };
+        inline SimdFloat operator /(SimdFloat a, SimdFloat b) { WARLOCK_SIMD_LANEWISE(SimdFloat, a.v[i] / b.v[i]) };
+        inline SimdFloat operator -(SimdFloat a) { WARLOCK_SIMD_LANEWISE(SimdFloat, -a.v[i]) };
+
+        inline SimdMask operator <(SimdFloat a, SimdFloat b) { WARLOCK_SIMD_LANEWISE(SimdMask, a.v[i] < b.v[i] ? ~0u : 0u) };
+        inline SimdMask operator <=(SimdFloat a, SimdFloat b) { WARLOCK_SIMD_LANEWISE(SimdMask, a.v[i] <= b.v[i] ? ~0u : 0u) };
+        inline SimdMask operator >(SimdFloat a, SimdFloat b) { WARLOCK_SIMD_LANEWISE(SimdMask, a.v[i] > b.v[i] ? ~0u : 0u) };
+        inline SimdMask operator >=(SimdFloat a, SimdFloat b) { WARLOCK_SIMD_LANEWISE(SimdMask, a.v[i] >= b.v[i] ? ~0u : 0u) };
+        inline SimdMask operator ==(SimdFloat a, SimdFloat b) { WARLOCK_SIMD_LANEWISE(SimdMask, a.v[i] == b.v[i] ? ~0u : 0u) };
+        inline SimdMask operator !=(SimdFloat a, SimdFloat b) { WARLOCK_SIMD_LANEWISE(SimdMask, a.v[i] != b.v[i] ? ~0u : 0u) };
+
+        inline SimdFloat Min(SimdFloat a, SimdFloat b) { WARLOCK_SIMD_LANEWISE(SimdFloat, a.v[i] < b.v[i] ? a.v[i] : b.v[i]) };
+        inline SimdFloat Max(SimdFloat a, SimdFloat b) { WARLOCK_SIMD_LANEWISE(SimdFloat, a.v[i] > b.v[i] ? a.v[i] : b.v[i]) };
+        inline SimdFloat Abs(SimdFloat a) { WARLOCK_SIMD_LANEWISE(SimdFloat, std::fabs(a.v[i])) };
+        inline SimdFloat Sqrt(SimdFloat a) { WARLOCK_SIMD_LANEWISE(SimdFloat, std::sqrt(a.v[i])) };
+        inline SimdFloat Floor(SimdFloat a) { WARLOCK_SIMD_LANEWISE(SimdFloat, std::floor(a.v[i])) };
+        inline SimdFloat Round(SimdFloat a) { WARLOCK_SIMD_LANEWISE(SimdFloat, std::nearbyint(a.v[i])) };
+        inline SimdFloat Select(SimdMask Mask, SimdFloat a, SimdFloat b) { WARLOCK_SIMD_LANEWISE(SimdFloat, Mask.v[i] ? a.v[i] : b.v[i]) };
+        inline SimdFloat MulAdd(SimdFloat a, SimdFloat b, SimdFloat c) { WARLOCK_SIMD_LANEWISE(SimdFloat, a.v[i] * b.v[i] + c.v[i]) };
+        inline SimdFloat NegMulAdd(SimdFloat a, SimdFloat b, SimdFloat c) { WARLOCK_SIMD_LANEWISE(SimdFloat, c.v[i] - a.v[i] * b.v[i]) };
+
+        inline float ReduceAdd(SimdFloat a) { return (a.v[0] + a.v[2]) + (a.v[1] + a.v[3]); };
+        inline float ReduceMin(SimdFloat a) { return std::fmin(std::fmin(a.v[0], a.v[2]), std::fmin(a.v[1], a.v[3])); };
+        inline float ReduceMax(SimdFloat a) { return std::fmax(std::fmax(a.v[0], a.v[2]), std::fmax(a.v[1], a.v[3])); };
+
+        inline SimdInt operator +(SimdInt a, SimdInt b) { WARLOCK_SIMD_LANEWISE(SimdInt, static_cast<std::int32_t>(static_cast<std::uint32_t>(a.v[i]) + static_cast<std::uint32_t>(b.v[i]))) };
+        inline SimdInt operator -(SimdInt a, SimdInt b) { WARLOCK_SIMD_LANEWISE(SimdInt, static_cast<std::int32_t>(static_cast<std::uint32_t>(a.v[i]) - static_cast<std::uint32_t>(b.v[i]))) };
+        inline SimdInt operator *(SimdInt a, SimdInt b) { WARLOCK_SIMD_LANEWISE(SimdInt, static_cast<std::int32_t>(static_cast<std::uint32_t>(a.v[i]) * static_cast<std::uint32_t>(b.v[i]))) };
+        inline SimdInt operator &(SimdInt a, SimdInt b) { WARLOCK_SIMD_LANEWISE(SimdInt, a.v[i] & b.v[i]) };
+        inline SimdInt operator |(SimdInt a, SimdInt b) { WARLOCK_SIMD_LANEWISE(SimdInt, a.v[i] | b.v[i]) };
+        inline SimdInt operator ^(SimdInt a, SimdInt b) { WARLOCK_SIMD_LANEWISE(SimdInt, a.v[i] ^ b.v[i]) };
+        inline SimdInt operator <<(SimdInt a, int Count) { WARLOCK_SIMD_LANEWISE(SimdInt, static_cast<std::int32_t>(static_cast<std::uint32_t>(a.v[i]) << Count)) };
+        inline SimdInt operator >>(SimdInt a, int Count) { WARLOCK_SIMD_LANEWISE(SimdInt, static_cast<std::int32_t>(static_cast<std::uint32_t>(a.v[i]) >> Count)) };
+        inline SimdInt ShiftRightArithmetic(SimdInt a, int Count) { WARLOCK_SIMD_LANEWISE(SimdInt, a.v[i] >> Count) };
+
+        inline SimdMask operator ==(SimdInt a, SimdInt b) { WARLOCK_SIMD_LANEWISE(SimdMask, a.v[i] == b.v[i] ? ~0u : 0u) };
+        inline SimdMask operator >(SimdInt a, SimdInt b) { WARLOCK_SIMD_LANEWISE(SimdMask, a.v[i] > b.v[i] ? ~0u : 0u) };
+        inline SimdMask operator <(SimdInt a, SimdInt b) { WARLOCK_SIMD_LANEWISE(SimdMask, a.v[i] < b.v[i] ? ~0u : 0u) };
+
+        inline SimdInt Min(SimdInt a, SimdInt b) { WARLOCK_SIMD_LANEWISE(SimdInt, a.v[i] < b.v[i] ? a.v[i] : b.v[i]) };
+        inline SimdInt Max(SimdInt a, SimdInt b) { WARLOCK_SIMD_LANEWISE(SimdInt, a.v[i] > b.v[i] ? a.v[i] : b.v[i]) };
+        inline SimdInt Select(SimdMask Mask, SimdInt a, SimdInt b) { WARLOCK_SIMD_LANEWISE(SimdInt, Mask.v[i] ? a.v[i] : b.v[i]) };
+
+        inline SimdInt ToInt(SimdFloat a) { WARLOCK_SIMD_LANEWISE(SimdInt, static_cast<std::int32_t>(a.v[i])) };
+        inline SimdFloat ToFloat(SimdInt a) { WARLOCK_SIMD_LANEWISE(SimdFloat, static_cast<float>(a.v[i])) };
+
+        inline SimdInt AsInt(SimdFloat a)
+        {
+            SimdInt r;
+            std::memcpy(r.v, a.v, sizeof(r.v));
+
+            return r;
+        };
+
+        inline SimdFloat AsFloat(SimdInt a)
+        {
+            SimdFloat r;
+            std::memcpy(r.v, a.v, sizeof(r.v));
+
+            return r;
+        };
+
+        inline SimdMask operator &(SimdMask a, SimdMask b) { WARLOCK_SIMD_LANEWISE(SimdMask, a.v[i] & b.v[i]) };
+        inline SimdMask operator |(SimdMask a, SimdMask b) { WARLOCK_SIMD_LANEWISE(SimdMask, a.v[i] | b.v[i]) };
+        inline SimdMask operator ^(SimdMask a, SimdMask b) { WARLOCK_SIMD_LANEWISE(SimdMask, a.v[i] ^ b.v[i]) };
+        inline SimdMask operator ~(SimdMask a) { WARLOCK_SIMD_LANEWISE(SimdMask, ~a.v[i]) };
+
+#undef WARLOCK_SIMD_LANEWISE
+#endif
+
+        //-----------------------------------------------------------------------------------------
+        // Width independent helpers
+        //-----------------------------------------------------------------------------------------
+        inline int PopCount(std::uint32_t Value)
+        {
+            Value = Value - ((Value >> 1) & 0x55555555);
+            Value = (Value & 0x33333333) + ((Value >> 2) & 0x33333333);
+
+            return static_cast<int>((((Value + (Value >> 4)) & 0x0F0F0F0F) * 0x01010101) >> 24);
+        };
+
+        // Writes the lanes selected by Bits contiguously to Output and returns how many they were.
+        // All WARLOCK_SIMD_WIDTH slots of Output may be written, so a compaction loop that never
+        // has more outputs than inputs can store in place of the input it has already consumed.
+#if WARLOCK_SIMD_AVX2
+        struct SimdCompressTable
+        {
+            constexpr SimdCompressTable() : entries()
+            {
+                for (int mask = 0; mask < 256; mask++)
+                {
+                    std::uint32_t entry = 0;
+                    int count = 0;
+
+                    for (int lane = 0; lane < 8; lane++)
+                    {
+                        if (mask & (1 << lane))
+                            entry |= static_cast<std::uint32_t>(lane) << (4 * count++);
+                    }
+
+                    entries[mask] = entry;
+                }
+            };
+
+            std::uint32_t entries[256];
+        };
+
+        inline int CompressStore(SimdInt Values, int Bits, std::uint32_t *Output)
+        {
+            static constexpr SimdCompressTable table;
+            __m256i entry = _mm256_set1_epi32(static_cast<int>(table.entries[Bits & 0xFF]));
+            __m256i lanes = _mm256_and_si256(_mm256_srlv_epi32(entry, _mm256_setr_epi32(0, 4, 8, 12, 16, 20, 24, 28)), _mm256_set1_epi32(0xF));
+
+            SimdInt(_mm256_permutevar8x32_epi32(Values.v, lanes)).Store(Output);
+
+            return PopCount(static_cast<std::uint32_t>(Bits & 0xFF));
+        };
+#else
+        inline int CompressStore(SimdInt Values, int Bits, std::uint32_t *Output)
+        {
+            std::uint32_t lanes[WARLOCK_SIMD_WIDTH];
+            int count = 0;
+
+            Values.Store(lanes);
+
+            for (int i = 0; i < WARLOCK_SIMD_WIDTH; i++)
+            {
+                Output[count] = lanes[i];
+                count += (Bits >> i) & 1;
+            }
+
+            return count;
+        };
+#endif
+
+        inline bool Any(SimdMask Mask) { return Mask.Bits() != 0; };
+        inline bool All(SimdMask Mask) { return Mask.Bits() == ((1 << WARLOCK_SIMD_WIDTH) - 1); };
+        inline bool None(SimdMask Mask) { return Mask.Bits() == 0; };
+
+        inline SimdFloat Clamp(SimdFloat a, SimdFloat Low, SimdFloat High) { return Min(Max(a, Low), High); };
+        inline SimdInt Clamp(SimdInt a, SimdInt Low, SimdInt High) { return Min(Max(a, Low), High); };
+    };
+};
+
+#endif // WARLOCK_MATH_SIMD_HPP
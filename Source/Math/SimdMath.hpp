@@ -0,0 +1,325 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Math/SimdMath.hpp
+// Description: Polynomial transcendental functions over SIMD lanes and batched rotations.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_MATH_SIMDMATH_HPP
+#define WARLOCK_MATH_SIMDMATH_HPP
+
+#include "Matrix2.hpp"
+#include "Simd.hpp"
+#include "Vector2.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// Every lane of every function is computed the same way on every backend, so results match
+// between SIMD widths up to the fused multiply adds of the FMA builds. Errors are against the
+// correctly rounded result, the worst found over every float in the domain, or over a few
+// million random pairs for Atan2:
+//
+//   Sin, Cos, SinCos   |x| <= 8192          2.5 ulp
+//   Atan2              finite y, x          3 ulp
+//   Exp                all floats           1 ulp; 0 below -103.97, +inf above 88.72
+//   Log                all floats           1 ulp; -inf at 0, NaN below 0
+//   Sqrt (Simd.hpp)    all floats           correctly rounded; 2 ulp on 32 bit NEON
+//
+// Past 8192 the quadrant count outgrows the exact products of the pi / 2 reduction without
+// fused multiply adds and accuracy falls off; angles that large are better wrapped by the
+// caller in double. Exp scales in two steps, so subnormal results round correctly, and Log
+// accepts subnormal inputs. NaN inputs give NaN.
+namespace Warlock
+{
+    namespace Math
+    {
+        namespace Detail
+        {
+            // Pi / 2 in four parts, to 57 bits. The first three have at most 11 bits, so their
+            // products with a quadrant count below 2^13 are exact without fused multiply adds.
+            constexpr float HalfPi1 = 1.5703125f;
+            constexpr float HalfPi2 = 4.837512969970703125e-4f;
+            constexpr float HalfPi3 = 7.549533620476723e-8f;
+            constexpr float HalfPi4 = 2.5633440682570896e-12f;
+
+            // Ln 2 in two parts, the first exact in nine bits.
+            constexpr float Ln2High = 0.693359375f;
+            constexpr float Ln2Low = -2.12194440e-4f;
+
+            inline SimdFloat FlipSign(SimdFloat Value, SimdInt Sign)
+            {
+                return AsFloat(AsInt(Value) ^ Sign);
+            };
+
+            // Reduces X to R in [-pi / 4, pi / 4] with X = R + Quadrant * pi / 2.
+            inline SimdFloat ReduceHalfPi(SimdFloat X, SimdInt &Quadrant)
+            {
+                const SimdFloat count = Round(X * SimdFloat(0.636619772367581343f));
+                Quadrant = ToInt(count);
+
+                SimdFloat r = NegMulAdd(count, SimdFloat(HalfPi1), X);
+                r = NegMulAdd(count, SimdFloat(HalfPi2), r);
+                r = NegMulAdd(count, SimdFloat(HalfPi3), r);
+
+                return NegMulAdd(count, SimdFloat(HalfPi4), r);
+            };
+
+            // Minimax polynomials on [-pi / 4, pi / 4], from Cephes' sinf and cosf.
+            inline SimdFloat SinPolynomial(SimdFloat R, SimdFloat R2)
+            {
+                SimdFloat p = MulAdd(SimdFloat(-1.9515295891e-4f), R2, SimdFloat(8.3321608736e-3f));
+                p = MulAdd(p, R2, SimdFloat(-1.6666654611e-1f));
+
+                return MulAdd(p * R2, R, R);
+            };
+
+            inline SimdFloat CosPolynomial(SimdFloat R2)
+            {
+                SimdFloat p = MulAdd(SimdFloat(2.443315711809948e-5f), R2, SimdFloat(-1.388731625493765e-3f));
+                p = MulAdd(p, R2, SimdFloat(4.166664568298827e-2f));
+
+                return MulAdd(p * R2, R2, NegMulAdd(SimdFloat(0.5f), R2, SimdFloat(1.0f)));
+            };
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Trigonometry
+        //-----------------------------------------------------------------------------------------
+        // Both from one range reduction; the quadrant picks which polynomial each returns and
+        // its sign.
+        inline void SinCos(SimdFloat X, SimdFloat &Sine, SimdFloat &Cosine)
+        {
+            SimdInt quadrant;
+            const SimdFloat r = Detail::ReduceHalfPi(X, quadrant);
+            const SimdFloat r2 = r * r;
+            const SimdFloat s = Detail::SinPolynomial(r, r2);
+            const SimdFloat c = Detail::CosPolynomial(r2);
+            const SimdMask odd = ((quadrant & SimdInt(1)) == SimdInt(1));
+
+            Sine = Detail::FlipSign(Select(odd, c, s), (quadrant & SimdInt(2)) << 30);
+            Cosine = Detail::FlipSign(Select(odd, s, c), ((quadrant + SimdInt(1)) & SimdInt(2)) << 30);
+        };
+
+        inline SimdFloat Sin(SimdFloat X)
+        {
+            SimdInt quadrant;
+            const SimdFloat r = Detail::ReduceHalfPi(X, quadrant);
+            const SimdFloat r2 = r * r;
+            const SimdMask odd = ((quadrant & SimdInt(1)) == SimdInt(1));
+
+            return Detail::FlipSign(Select(odd, Detail::CosPolynomial(r2), Detail::SinPolynomial(r, r2)), (quadrant & SimdInt(2)) << 30);
+        };
+
+        inline SimdFloat Cos(SimdFloat X)
+        {
+            SimdInt quadrant;
+            const SimdFloat r = Detail::ReduceHalfPi(X, quadrant);
+            const SimdFloat r2 = r * r;
+            const SimdMask odd = ((quadrant & SimdInt(1)) == SimdInt(1));
+
+            return Detail::FlipSign(Select(odd, Detail::SinPolynomial(r, r2), Detail::CosPolynomial(r2)), ((quadrant + SimdInt(1)) & SimdInt(2)) << 30);
+        };
+
+        // The angle of (X, Y) in [-pi, pi], signed like std::atan2 including zeros. The smaller
+        // magnitude over the larger is reduced below tan(pi / 8) with one division, and the
+        // octant is restored afterwards.
+        inline SimdFloat Atan2(SimdFloat Y, SimdFloat X)
+        {
+            const SimdFloat zero = SimdFloat::Zero();
+            const SimdFloat ax = Abs(X), ay = Abs(Y);
+            const SimdFloat one(1.0f);
+
+            // Halved when large, so low + high cannot overflow; the ratio is unchanged.
+            const SimdFloat scale = Select(Max(ax, ay) > one, SimdFloat(0.5f), one);
+            const SimdFloat high = Max(ax, ay) * scale, low = Min(ax, ay) * scale;
+
+            // Past tan(pi / 8), atan(t) = pi / 4 + atan((t - 1) / (t + 1)).
+            const SimdMask reduce = (low > high * SimdFloat(0.414213562373095f));
+            const SimdFloat denominator = Select(reduce, low + high, high);
+            const SimdFloat t = Select(denominator == zero, zero, Select(reduce, low - high, low) / denominator);
+            const SimdFloat z = t * t;
+
+            // Cephes' atanf polynomial on [-tan(pi / 8), tan(pi / 8)].
+            SimdFloat p = MulAdd(SimdFloat(8.05374449538e-2f), z, SimdFloat(-1.38776856032e-1f));
+            p = MulAdd(p, z, SimdFloat(1.99777106478e-1f));
+            p = MulAdd(p, z, SimdFloat(-3.33329491539e-1f));
+
+            SimdFloat angle = MulAdd(p * z, t, t) + Select(reduce, SimdFloat(0.785398163397448f), zero);
+
+            angle = Select(ay > ax, SimdFloat(1.57079632679490f) - angle, angle);
+            angle = Select(AsInt(X) < SimdInt(0), SimdFloat(3.14159265358979f) - angle, angle);
+
+            return AsFloat(AsInt(angle) | (AsInt(Y) & SimdInt(std::numeric_limits<std::int32_t>::min())));
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Exponential and logarithm
+        //-----------------------------------------------------------------------------------------
+        inline SimdFloat Exp(SimdFloat X)
+        {
+            // Past these the result is +inf or below the smallest subnormal anyway.
+            const SimdFloat x = Clamp(X, SimdFloat(-104.0f), SimdFloat(89.0f));
+            const SimdFloat count = Round(x * SimdFloat(1.44269504088896341f));
+
+            SimdFloat r = NegMulAdd(count, SimdFloat(Detail::Ln2High), x);
+            r = NegMulAdd(count, SimdFloat(Detail::Ln2Low), r);
+
+            // e^r on [-ln 2 / 2, ln 2 / 2], from Cephes' expf.
+            SimdFloat p = MulAdd(SimdFloat(1.9875691500e-4f), r, SimdFloat(1.3981999507e-3f));
+            p = MulAdd(p, r, SimdFloat(8.3334519073e-3f));
+            p = MulAdd(p, r, SimdFloat(4.1665795894e-2f));
+            p = MulAdd(p, r, SimdFloat(1.6666665459e-1f));
+            p = MulAdd(p, r, SimdFloat(5.0000001201e-1f));
+            p = MulAdd(p, r * r, r) + SimdFloat(1.0f);
+
+            // 2^count in two halves, so the scale of results near the ends of the range is a
+            // normal float before the final multiply rounds it.
+            const SimdInt exponent = ToInt(count);
+            const SimdInt half = ShiftRightArithmetic(exponent, 1);
+
+            p = p * AsFloat((half + SimdInt(127)) << 23);
+            p = p * AsFloat((exponent - half + SimdInt(127)) << 23);
+
+            return Select(X != X, X, p);
+        };
+
+        inline SimdFloat Log(SimdFloat X)
+        {
+            const SimdFloat zero = SimdFloat::Zero(), one(1.0f);
+            const SimdFloat infinity(std::numeric_limits<float>::infinity());
+
+            // Subnormals are scaled into the normal range first.
+            const SimdMask subnormal = (X < SimdFloat(std::numeric_limits<float>::min()));
+            const SimdFloat x = Select(subnormal, X * SimdFloat(8388608.0f), X);
+            const SimdInt bits = AsInt(x);
+
+            // X = m 2^e with m in [sqrt(1 / 2), sqrt(2)).
+            SimdFloat m = AsFloat((bits & SimdInt(0x007FFFFF)) | SimdInt(0x3F000000));
+            SimdFloat e = ToFloat(((bits >> 23) & SimdInt(0xFF)) - SimdInt(126)) - Select(subnormal, SimdFloat(23.0f), zero);
+
+            const SimdMask low = (m < SimdFloat(0.707106781186547524f));
+            e = e - Select(low, one, zero);
+            m = Select(low, m + m, m) - one;
+
+            // log(1 + m) from Cephes' logf.
+            const SimdFloat z = m * m;
+
+            SimdFloat p = MulAdd(SimdFloat(7.0376836292e-2f), m, SimdFloat(-1.1514610310e-1f));
+            p = MulAdd(p, m, SimdFloat(1.1676998740e-1f));
+            p = MulAdd(p, m, SimdFloat(-1.2420140846e-1f));
+            p = MulAdd(p, m, SimdFloat(1.4249322787e-1f));
+            p = MulAdd(p, m, SimdFloat(-1.6668057665e-1f));
+            p = MulAdd(p, m, SimdFloat(2.0000714765e-1f));
+            p = MulAdd(p, m, SimdFloat(-2.4999993993e-1f));
+            p = MulAdd(p, m, SimdFloat(3.3333331174e-1f));
+            p = p * m * z;
+
+            p = MulAdd(e, SimdFloat(Detail::Ln2Low), p);
+            p = NegMulAdd(SimdFloat(0.5f), z, p);
+
+            SimdFloat result = MulAdd(e, SimdFloat(Detail::Ln2High), m + p);
+
+            result = Select(X == infinity, infinity, result);
+            result = Select(X == zero, -infinity, result);
+
+            return Select(X >= zero, result, SimdFloat(std::numeric_limits<float>::quiet_NaN()));
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Batched rotations
+        //-----------------------------------------------------------------------------------------
+        namespace Detail
+        {
+            // Calls Write(Index, Sines, Cosines, Lanes) for each register of Angles; the last
+            // is padded, and Lanes says how many of it are real.
+            template <typename Function>
+            inline void ForEachSinCos(const float *Angles, std::size_t Count, Function &&Write)
+            {
+                float sines[WARLOCK_SIMD_WIDTH], cosines[WARLOCK_SIMD_WIDTH];
+                SimdFloat s, c;
+                std::size_t i = 0;
+
+                for (; i + WARLOCK_SIMD_WIDTH <= Count; i += WARLOCK_SIMD_WIDTH)
+                {
+                    SinCos(SimdFloat::Load(Angles + i), s, c);
+                    s.Store(sines);
+                    c.Store(cosines);
+
+                    Write(i, sines, cosines, static_cast<std::size_t>(WARLOCK_SIMD_WIDTH));
+                }
+
+                if (i < Count)
+                {
+                    float tail[WARLOCK_SIMD_WIDTH] = {};
+
+                    for (std::size_t l = 0; i + l < Count; l++)
+                        tail[l] = Angles[i + l];
+
+                    SinCos(SimdFloat::Load(tail), s, c);
+                    s.Store(sines);
+                    c.Store(cosines);
+
+                    Write(i, sines, cosines, Count - i);
+                }
+            };
+        };
+
+        inline void SinCos(const float *Angles, float *Sines, float *Cosines, std::size_t Count)
+        {
+            Detail::ForEachSinCos(Angles, Count, [&](std::size_t Index, const float *s, const float *c, std::size_t Lanes)
+            {
+                for (std::size_t l = 0; l < Lanes; l++)
+                {
+                    Sines[Index + l] = s[l];
+                    Cosines[Index + l] = c[l];
+                }
+            });
+        };
+
+        // Counterclockwise rotations by Angles radians, (cos, -sin; sin, cos), for column
+        // vectors multiplied on the right.
+        inline void GetRotations(const float *Angles, Matrix2F *Rotations, std::size_t Count)
+        {
+            Detail::ForEachSinCos(Angles, Count, [&](std::size_t Index, const float *s, const float *c, std::size_t Lanes)
+            {
+                for (std::size_t l = 0; l < Lanes; l++)
+                {
+                    Matrix2F &rotation = Rotations[Index + l];
+
+                    rotation.m[0][0] = c[l];
+                    rotation.m[0][1] = -s[l];
+                    rotation.m[1][0] = s[l];
+                    rotation.m[1][1] = c[l];
+                }
+            });
+        };
+
+        // Unit vectors at Angles radians from the x axis, (cos, sin).
+        inline void GetDirections(const float *Angles, Vector2F *Directions, std::size_t Count)
+        {
+            Detail::ForEachSinCos(Angles, Count, [&](std::size_t Index, const float *s, const float *c, std::size_t Lanes)
+            {
+                for (std::size_t l = 0; l < Lanes; l++)
+                {
+                    Directions[Index + l].x = c[l];
+                    Directions[Index + l].y = s[l];
+                }
+            });
+        };
+    };
+};
+
+#endif // WARLOCK_MATH_SIMDMATH_HPP
@@ -0,0 +1,408 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Math/Vector.hpp
+// Description: Fixed size vectors of any dimension with unrolled operations.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_MATH_VECTOR_HPP
+#define WARLOCK_MATH_VECTOR_HPP
+
+#include "Platform/Platform.hpp"
+#include <cmath>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace Warlock
+{
+    namespace Math
+    {
+        namespace Detail
+        {
+            // Keeps a parameter out of template argument deduction, so Vector<3, float> * 2
+            // converts the 2 instead of failing to deduce T.
+            template <typename T> struct NonDeduced
+            {
+                using Type = T;
+            };
+
+            template <typename Function, std::size_t... Indices>
+            constexpr void UnrollSequence(Function &&Body, std::index_sequence<Indices...>)
+            {
+                (Body(std::integral_constant<std::size_t, Indices>()), ...);
+            };
+
+            // Calls Body(std::integral_constant<std::size_t, I>()) for I in [0, Count), expanded
+            // at compile time, so every index is a constant and no loop is left for the
+            // optimizer to decide about.
+            template <std::size_t Count, typename Function>
+            constexpr void Unroll(Function &&Body)
+            {
+                UnrollSequence(Body, std::make_index_sequence<Count>());
+            };
+
+            // Components are an array, or named members for two to four dimensions. Get<I>
+            // reaches either form in constant expressions; operator[] indexes the named members
+            // as an array, which their layout allows.
+            template <std::size_t N, typename T> struct VectorStorage
+            {
+                constexpr VectorStorage() : data{} {};
+
+                template <typename... Components>
+                constexpr VectorStorage(Components... Values) : data{Values...} {};
+
+                template <std::size_t I> constexpr T &Get() { return data[I]; };
+                template <std::size_t I> constexpr const T &Get() const { return data[I]; };
+
+                constexpr T &operator [](std::size_t Index) { return data[Index]; };
+                constexpr const T &operator [](std::size_t Index) const { return data[Index]; };
+
+                T data[N];
+            };
+
+            template <typename T> struct VectorStorage<2, T>
+            {
+                constexpr VectorStorage() : x(0), y(0) {};
+                constexpr VectorStorage(T cx, T cy) : x(cx), y(cy) {};
+
+                template <std::size_t I> constexpr T &Get()
+                {
+                    if constexpr (I == 0) return x; else return y;
+                };
+
+                template <std::size_t I> constexpr const T &Get() const
+                {
+                    if constexpr (I == 0) return x; else return y;
+                };
+
+                T &operator [](std::size_t Index) { return (&x)[Index]; };
+                const T &operator [](std::size_t Index) const { return (&x)[Index]; };
+
+                T x;
+                T y;
+            };
+
+            template <typename T> struct VectorStorage<3, T>
+            {
+                constexpr VectorStorage() : x(0), y(0), z(0) {};
+                constexpr VectorStorage(T cx, T cy, T cz) : x(cx), y(cy), z(cz) {};
+
+                template <std::size_t I> constexpr T &Get()
+                {
+                    if constexpr (I == 0) return x; else if constexpr (I == 1) return y; else return z;
+                };
+
+                template <std::size_t I> constexpr const T &Get() const
+                {
+                    if constexpr (I == 0) return x; else if constexpr (I == 1) return y; else return z;
+                };
+
+                T &operator [](std::size_t Index) { return (&x)[Index]; };
+                const T &operator [](std::size_t Index) const { return (&x)[Index]; };
+
+                T x;
+                T y;
+                T z;
+            };
+
+            template <typename T> struct VectorStorage<4, T>
+            {
+                constexpr VectorStorage() : x(0), y(0), z(0), w(0) {};
+                constexpr VectorStorage(T cx, T cy, T cz, T cw) : x(cx), y(cy), z(cz), w(cw) {};
+
+                template <std::size_t I> constexpr T &Get()
+                {
+                    if constexpr (I == 0) return x; else if constexpr (I == 1) return y; else if constexpr (I == 2) return z; else return w;
+                };
+
+                template <std::size_t I> constexpr const T &Get() const
+                {
+                    if constexpr (I == 0) return x; else if constexpr (I == 1) return y; else if constexpr (I == 2) return z; else return w;
+                };
+
+                T &operator [](std::size_t Index) { return (&x)[Index]; };
+                const T &operator [](std::size_t Index) const { return (&x)[Index]; };
+
+                T x;
+                T y;
+                T z;
+                T w;
+            };
+        };
+
+        // An N dimensional vector of T. Every operation expands to straight line code over the
+        // components, and the type is exactly N packed components, so arrays of vectors are
+        // plain arrays of T.
+        template <std::size_t N, typename T> struct Vector : Detail::VectorStorage<N, T>
+        {
+            static_assert(N > 0, "Vectors need at least one component");
+
+            static constexpr std::size_t Size = N;
+
+            constexpr Vector() : Detail::VectorStorage<N, T>() {};
+
+            constexpr explicit Vector(T Value) : Vector(Value, std::make_index_sequence<N>()) {};
+
+            template <typename... Components, typename = std::enable_if_t<(N > 1) && sizeof...(Components) == N && (std::is_convertible_v<Components, T> && ...)>>
+            constexpr Vector(Components... Values) : Detail::VectorStorage<N, T>(static_cast<T>(Values)...) {};
+
+            template <typename U>
+            constexpr explicit Vector(const Vector<N, U> &Value) : Vector(Value, std::make_index_sequence<N>()) {};
+
+            constexpr Vector &operator +=(const Vector &Other)
+            {
+                Detail::Unroll<N>([&](auto I) { this->template Get<I>() += Other.template Get<I>(); });
+                return *this;
+            };
+
+            constexpr Vector &operator -=(const Vector &Other)
+            {
+                Detail::Unroll<N>([&](auto I) { this->template Get<I>() -= Other.template Get<I>(); });
+                return *this;
+            };
+
+            constexpr Vector &operator *=(const Vector &Other)
+            {
+                Detail::Unroll<N>([&](auto I) { this->template Get<I>() *= Other.template Get<I>(); });
+                return *this;
+            };
+
+            constexpr Vector &operator /=(const Vector &Other)
+            {
+                Detail::Unroll<N>([&](auto I) { this->template Get<I>() /= Other.template Get<I>(); });
+                return *this;
+            };
+
+            constexpr Vector &operator +=(T Value)
+            {
+                Detail::Unroll<N>([&](auto I) { this->template Get<I>() += Value; });
+                return *this;
+            };
+
+            constexpr Vector &operator -=(T Value)
+            {
+                Detail::Unroll<N>([&](auto I) { this->template Get<I>() -= Value; });
+                return *this;
+            };
+
+            constexpr Vector &operator *=(T Scalar)
+            {
+                Detail::Unroll<N>([&](auto I) { this->template Get<I>() *= Scalar; });
+                return *this;
+            };
+
+            constexpr Vector &operator /=(T Scalar)
+            {
+                Detail::Unroll<N>([&](auto I) { this->template Get<I>() /= Scalar; });
+                return *this;
+            };
+
+            T *GetData()
+            {
+                return &(*this)[0];
+            };
+
+            const T *GetData() const
+            {
+                return &(*this)[0];
+            };
+
+            T MagnitudeSquared() const
+            {
+                T result = T(0);
+                Detail::Unroll<N>([&](auto I) { result += this->template Get<I>() * this->template Get<I>(); });
+
+                return result;
+            };
+
+            T Magnitude() const
+            {
+                return static_cast<T>(std::sqrt(MagnitudeSquared()));
+            };
+
+            // Scales to unit length; a null vector is left as it is.
+            void Normalize()
+            {
+                const T length = Magnitude();
+
+                if (length != T(0))
+                    *this *= T(1) / length;
+            };
+
+            Vector GetNormalized() const
+            {
+                Vector result = *this;
+                result.Normalize();
+
+                return result;
+            };
+
+            constexpr bool IsNull() const
+            {
+                bool result = true;
+                Detail::Unroll<N>([&](auto I) { result = result && (this->template Get<I>() == T(0)); });
+
+                return result;
+            };
+
+            bool IsUnit(T Tolerance = T(0)) const
+            {
+                return (std::abs(MagnitudeSquared() - T(1)) <= Tolerance);
+            };
+
+            private:
+                template <std::size_t... Indices>
+                constexpr Vector(T Value, std::index_sequence<Indices...>) : Detail::VectorStorage<N, T>(((void)Indices, Value)...) {};
+
+                template <typename U, std::size_t... Indices>
+                constexpr Vector(const Vector<N, U> &Value, std::index_sequence<Indices...>) : Detail::VectorStorage<N, T>(static_cast<T>(Value.template Get<Indices>())...) {};
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Arithmetic
+        //-----------------------------------------------------------------------------------------
+        template <std::size_t N, typename T>
+        constexpr Vector<N, T> operator -(const Vector<N, T> &Value)
+        {
+            Vector<N, T> result;
+            Detail::Unroll<N>([&](auto I) { result.template Get<I>() = -Value.template Get<I>(); });
+
+            return result;
+        };
+
+        template <std::size_t N, typename T>
+        constexpr Vector<N, T> operator +(Vector<N, T> First, const Vector<N, T> &Second)
+        {
+            return (First += Second);
+        };
+
+        template <std::size_t N, typename T>
+        constexpr Vector<N, T> operator -(Vector<N, T> First, const Vector<N, T> &Second)
+        {
+            return (First -= Second);
+        };
+
+        // Component wise.
+        template <std::size_t N, typename T>
+        constexpr Vector<N, T> operator *(Vector<N, T> First, const Vector<N, T> &Second)
+        {
+            return (First *= Second);
+        };
+
+        template <std::size_t N, typename T>
+        constexpr Vector<N, T> operator /(Vector<N, T> First, const Vector<N, T> &Second)
+        {
+            return (First /= Second);
+        };
+
+        template <std::size_t N, typename T>
+        constexpr Vector<N, T> operator +(Vector<N, T> Value, typename Detail::NonDeduced<T>::Type Scalar)
+        {
+            return (Value += Scalar);
+        };
+
+        template <std::size_t N, typename T>
+        constexpr Vector<N, T> operator -(Vector<N, T> Value, typename Detail::NonDeduced<T>::Type Scalar)
+        {
+            return (Value -= Scalar);
+        };
+
+        template <std::size_t N, typename T>
+        constexpr Vector<N, T> operator *(Vector<N, T> Value, typename Detail::NonDeduced<T>::Type Scalar)
+        {
+            return (Value *= Scalar);
+        };
+
+        template <std::size_t N, typename T>
+        constexpr Vector<N, T> operator *(typename Detail::NonDeduced<T>::Type Scalar, Vector<N, T> Value)
+        {
+            return (Value *= Scalar);
+        };
+
+        template <std::size_t N, typename T>
+        constexpr Vector<N, T> operator /(Vector<N, T> Value, typename Detail::NonDeduced<T>::Type Scalar)
+        {
+            return (Value /= Scalar);
+        };
+
+        template <std::size_t N, typename T>
+        constexpr bool operator ==(const Vector<N, T> &First, const Vector<N, T> &Second)
+        {
+            bool result = true;
+            Detail::Unroll<N>([&](auto I) { result = result && (First.template Get<I>() == Second.template Get<I>()); });
+
+            return result;
+        };
+
+        template <std::size_t N, typename T>
+        constexpr bool operator !=(const Vector<N, T> &First, const Vector<N, T> &Second)
+        {
+            return !(First == Second);
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Products and metrics
+        //-----------------------------------------------------------------------------------------
+        template <std::size_t N, typename T>
+        constexpr T ScalarProduct(const Vector<N, T> &First, const Vector<N, T> &Second)
+        {
+            T result = T(0);
+            Detail::Unroll<N>([&](auto I) { result += First.template Get<I>() * Second.template Get<I>(); });
+
+            return result;
+        };
+
+        template <typename T>
+        constexpr Vector<3, T> VectorProduct(const Vector<3, T> &First, const Vector<3, T> &Second)
+        {
+            return Vector<3, T>(First.y * Second.z - First.z * Second.y,
+                                First.z * Second.x - First.x * Second.z,
+                                First.x * Second.y - First.y * Second.x);
+        };
+
+        template <std::size_t N, typename T>
+        T Distance(const Vector<N, T> &First, const Vector<N, T> &Second)
+        {
+            return (Second - First).Magnitude();
+        };
+
+        template <std::size_t N, typename T>
+        constexpr Vector<N, T> Min(const Vector<N, T> &First, const Vector<N, T> &Second)
+        {
+            Vector<N, T> result;
+            Detail::Unroll<N>([&](auto I) { result.template Get<I>() = (Second.template Get<I>() < First.template Get<I>()) ? Second.template Get<I>() : First.template Get<I>(); });
+
+            return result;
+        };
+
+        template <std::size_t N, typename T>
+        constexpr Vector<N, T> Max(const Vector<N, T> &First, const Vector<N, T> &Second)
+        {
+            Vector<N, T> result;
+            Detail::Unroll<N>([&](auto I) { result.template Get<I>() = (First.template Get<I>() < Second.template Get<I>()) ? Second.template Get<I>() : First.template Get<I>(); });
+
+            return result;
+        };
+
+        template <std::size_t N, typename T>
+        constexpr Vector<N, T> Lerp(const Vector<N, T> &First, const Vector<N, T> &Second, typename Detail::NonDeduced<T>::Type Factor)
+        {
+            return First + (Second - First) * Factor;
+        };
+    };
+};
+
+#endif // WARLOCK_MATH_VECTOR_HPP
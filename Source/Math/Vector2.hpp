@@ -3,7 +3,7 @@
 // Copyright © 2019 Miguel Nischor
 //
 // File: Source/Math/Vector2.hpp
-// Description: Class to implement a 2D cartesian vector.
+// Description: Two dimensional cartesian vector.
 //-------------------------------------------------------------------------------------------------
 // Licensed under the Apache License, Version 2.0 (the "License");
 // you may not use this file except in compliance with the License.
@@ -20,229 +20,18 @@
 #ifndef WARLOCK_MATH_VECTOR2_HPP
 #define WARLOCK_MATH_VECTOR2_HPP
 
-#include "Platform/Platform.hpp"
-#include <cmath>
+#include "Vector.hpp"
 
 namespace Warlock
 {
     namespace Math
     {
-        template <typename T> struct Vector2
-        {
-            Vector2() : x(0.0), y(0.0) {};
-            Vector2(T Value), x(Value), y(Value) {};
-            Vector2(T cx, T cy) : x(cx), y(cy) {};
-            Vector2(const Vector2<T> &Value) : x(Value.x), y(Value.y) {};
+        template <typename T> using Vector2 = Vector<2, T>;
 
-            Vector2 &operator +(T Value)
-            {
-                return Vector2<T>(x + Value, y + Value);
-            };
-
-            Vector2 &operator +(const Vector2<T> &Vector)
-            {
-                return Vector2<T>(x + Vector.x, y + Vector.y);
-            };
-
-            Vector2 &operator -(T Value)
-            {
-                return Vector2<T>(x - Value, y - Value);
-            };
-
-            Vector2 &operator -(const Vector2<T> &Vector)
-            {
-                return Vector2<T>(x - Vector.x, y - Vector.y);
-            };
-
-            Vector2 &operator *(T Scalar)
-            {
-                return Vector2<T>(x * Scalar, y * Scalar);
-            };
-
-            bool operator >(const Vector2<T> &Vector)
-            {
-                return (Magnitude() > Magnitude(Vector));
-            };
-
-            bool operator <(const Vector2<T> &Vector)
-            {
-                return (Magnitude() < Magnitude(Vector));
-            };
-
-            T operator [](int Index)
-            {
-                static_assert(Index >= 0, "Vector index must be zero or higher");
-
-                switch (Index)
-                {
-                    case 0:
-                        return x;
-                        break;
-
-                    case 1:
-                        return y;
-                        break;
-
-                    default:
-                        return x;
-                        break;
-                };
-            };
-
-            void operator +=(T Value)
-            {
-                x += Value;
-                y += Value;
-            };
-
-            void operator +=(const Vector2<T> &Vector)
-            {
-                x += Vector.x;
-                y += Vector.y;
-            };
-
-            void operator -=(T Value)
-            {
-                x -= Value;
-                y -= Value;
-            };
-
-            void operator -=(const Vector2<T> &Vector)
-            {
-                x -= Vector.x;
-                y -= Vector.y;
-            };
-
-            void operator *=(T Scalar)
-            {
-                x *= Scalar;
-                y *= Scalar;
-            };
-
-            bool operator >=(const Vector2<T> &Vector)
-            {
-                return (Magnitude() >= Magnitude(Vector));
-            };
-
-            bool operator <=(const Vector2<T> &Vector)
-            {
-                return (Magnitude() <= Magnitude(Vector));
-            };
-
-            bool operator ==(T Value)
-            {
-                return (x == Value && y == Value);
-            };
-
-            bool operator ==(const Vector2<T> &Vector)
-            {
-                return (x == Vector.x && y == Vector.y);
-            };
-
-            bool operator !=(T Value)
-            {
-                return (x != Value || y != Value);
-            };
-
-            bool operator !=(const Vector2<T> &Vector)
-            {
-                return (x != Vector.x || y != Vector.y);
-            };
-
-            T Area()
-            {
-                static_assert(x >= 0.0 && y >= 0.0, "Coordinates must be zero or higher");
-
-                return (x * y);
-            };
-
-            T Area(T cx, T cy)
-            {
-                static_assert(cx >= 0.0 && cy >= 0.0, "Coordinates must be zero or higher");
-
-                return (cx * cy);
-            };
-
-            T Area(const Vector2<T> &Vector)
-            {
-                static_assert(Vector.x >= 0.0 && Vector.y >= 0.0, "Coordinates must be zero or higher");
-
-                return (Vector.x * Vector.y);
-            };
-
-            T Magnitude()
-            {
-                return std::sqrt(std::pow(x, 2) + std::pow(y, 2));
-            };
-
-            T Magnitude(T cx, T cy)
-            {
-                return std::sqrt(std::pow(cx, 2) + std::pow(cy, 2));
-            };
-
-            T Magnitude(const Vector2<T> &Vector)
-            {
-                return std::sqrt(std::pow(Vector.x, 2) + std::pow(Vector.y, 2));
-            };
-
-            T ScalarProduct(T cx, T cy)
-            {
-                return (x + cx * y + cy);
-            };
-
-            T ScalarProduct(const Vector2<T> &Vector)
-            {
-                return (x + Vector.x * y + Vector.y);
-            };
-
-            T Distance(T cx, T cy)
-            {
-                return Magnitude(cx - x, cy - y);
-            };
-
-            T Distance(const Vector2<T> &Vector)
-            {
-                return Magnitude(Vector.x - x, Vector.y - y);
-            };
-
-            bool IsNull()
-            {
-                return (x == 0.0 && y == 0.0);
-            };
-
-            bool IsNull(T cx, T cy)
-            {
-                return (cx == 0.0 && cy == 0.0);
-            };
-
-            bool IsNull(const Vector2<T> &Vector)
-            {
-                return (Vector.x == 0.0 && Vector.y == 0.0);
-            };
-
-            bool IsUnit()
-            {
-                return (Magnitude() == 1.0);
-            };
-
-            bool IsUnit(T cx, T cy)
-            {
-                return (Magnitude(cx, cy) == 1.0);
-            };
-
-            bool IsUnit(const Vector2<T> &Vector)
-            {
-                return (Magnitude(Vector.x, Vector.y) == 1.0);
-            };
-
-            T x;
-            T y;
-        };
-
-        Vector2<int> Vector2I;
-        Vector2<float> Vector2F;
-        Vector2<short> Vector2S;
-        Vector2<double> Vector2D;
+        using Vector2I = Vector2<int>;
+        using Vector2F = Vector2<float>;
+        using Vector2S = Vector2<short>;
+        using Vector2D = Vector2<double>;
     };
 };
 
@@ -0,0 +1,57 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Math/VectorStream.hpp
+// Description: Streams of vectors stored as component arrays.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_MATH_VECTORSTREAM_HPP
+#define WARLOCK_MATH_VECTORSTREAM_HPP
+
+namespace Warlock
+{
+    namespace Math
+    {
+        // Read only stream of vectors stored as component arrays.
+        struct ConstVector3Stream
+        {
+            const float *x;
+            const float *y;
+            const float *z;
+        };
+
+        // Streams of vectors stored as component arrays. A writable stream passes wherever a
+        // read only one is taken.
+        struct Vector2Stream
+        {
+            float *x;
+            float *y;
+        };
+
+        struct Vector3Stream
+        {
+            operator ConstVector3Stream() const
+            {
+                return {x, y, z};
+            };
+
+            float *x;
+            float *y;
+            float *z;
+        };
+    };
+};
+
+#endif // WARLOCK_MATH_VECTORSTREAM_HPP
@@ -0,0 +1,196 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Network/BitStream.hpp
+// Description: Bit level packet writer and reader.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_NETWORK_BITSTREAM_HPP
+#define WARLOCK_NETWORK_BITSTREAM_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Network
+    {
+        // Widths selected by the two bit prefix of a variable length field.
+        constexpr unsigned int VariableFieldBits[4] = {4, 8, 16, 32};
+
+        // Maps signed values to unsigned ones with small magnitudes first: 0, -1, 1, -2, ...
+        inline std::uint32_t ZigZag(std::int32_t Value)
+        {
+            return (static_cast<std::uint32_t>(Value) << 1) ^ static_cast<std::uint32_t>(Value >> 31);
+        };
+
+        inline std::int32_t UnZigZag(std::uint32_t Value)
+        {
+            return static_cast<std::int32_t>(Value >> 1) ^ -static_cast<std::int32_t>(Value & 1u);
+        };
+
+        // Packs fields least significant bit first into little endian bytes.
+        class BitWriter
+        {
+            public:
+                BitWriter() : size(0), accumulator(0), pending(0) {};
+
+                // Bits goes up to 32; the bits of Value above it must be clear.
+                void Write(std::uint32_t Value, unsigned int Bits)
+                {
+                    accumulator |= static_cast<std::uint64_t>(Value) << pending;
+                    pending += Bits;
+
+                    if (pending >= 32)
+                    {
+                        if (size + 4 > data.size())
+                            data.resize(data.size() < 64 ? 64 : 2 * data.size());
+
+                        std::uint32_t word = static_cast<std::uint32_t>(accumulator);
+                        data[size] = static_cast<std::uint8_t>(word);
+                        data[size + 1] = static_cast<std::uint8_t>(word >> 8);
+                        data[size + 2] = static_cast<std::uint8_t>(word >> 16);
+                        data[size + 3] = static_cast<std::uint8_t>(word >> 24);
+
+                        size += 4;
+                        accumulator >>= 32;
+                        pending -= 32;
+                    }
+                };
+
+                void WriteBit(bool Value)
+                {
+                    Write(Value ? 1u : 0u, 1);
+                };
+
+                // A two bit width class followed by the value in the narrowest width that holds it.
+                void WriteVariable(std::uint32_t Value)
+                {
+                    unsigned int selector = (Value < 16u ? 0 : Value < 256u ? 1 : Value < 65536u ? 2 : 3);
+
+                    if (selector < 3)
+                        Write(selector | (Value << 2), 2 + VariableFieldBits[selector]);
+                    else
+                    {
+                        Write(selector, 2);
+                        Write(Value, 32);
+                    }
+                };
+
+                // Pads the last byte with zeroes and trims the buffer; call once before GetData().
+                void Flush()
+                {
+                    data.resize(size);
+
+                    while (pending > 0)
+                    {
+                        data.push_back(static_cast<std::uint8_t>(accumulator));
+                        accumulator >>= 8;
+                        pending = (pending > 8 ? pending - 8 : 0);
+                    }
+
+                    size = data.size();
+                    accumulator = 0;
+                };
+
+                void Clear()
+                {
+                    size = 0;
+                    accumulator = 0;
+                    pending = 0;
+                };
+
+                std::size_t GetBitCount() const
+                {
+                    return size * 8 + pending;
+                };
+
+                const std::vector<std::uint8_t> &GetData() const
+                {
+                    return data;
+                };
+
+                void Reserve(std::size_t Bytes)
+                {
+                    if (data.size() < Bytes)
+                        data.resize(Bytes);
+                };
+
+            private:
+                // Grown ahead of use; only the first size bytes are written.
+                std::vector<std::uint8_t> data;
+                std::size_t size;
+                std::uint64_t accumulator;
+                unsigned int pending;
+        };
+
+        // Reading past the end yields zeroes and marks the reader overflowed, so decoders can
+        // parse untrusted packets without bounds checks per field and reject them at the end.
+        class BitReader
+        {
+            public:
+                BitReader(const std::uint8_t *Data, std::size_t Size) : data(Data), size(Size), position(0), accumulator(0), available(0), overflowed(false) {};
+
+                std::uint32_t Read(unsigned int Bits)
+                {
+                    if (Bits == 0)
+                        return 0;
+
+                    while (available < Bits)
+                    {
+                        if (position < size)
+                            accumulator |= static_cast<std::uint64_t>(data[position]) << available;
+                        else
+                            overflowed = true;
+
+                        position++;
+                        available += 8;
+                    }
+
+                    std::uint32_t value = static_cast<std::uint32_t>(accumulator & ((static_cast<std::uint64_t>(1) << Bits) - 1));
+                    accumulator >>= Bits;
+                    available -= Bits;
+
+                    return value;
+                };
+
+                bool ReadBit()
+                {
+                    return (Read(1) != 0);
+                };
+
+                std::uint32_t ReadVariable()
+                {
+                    return Read(VariableFieldBits[Read(2)]);
+                };
+
+                bool IsOverflowed() const
+                {
+                    return overflowed;
+                };
+
+            private:
+                const std::uint8_t *data;
+                std::size_t size;
+                std::size_t position;
+                std::uint64_t accumulator;
+                unsigned int available;
+                bool overflowed;
+        };
+    };
+};
+
+#endif // WARLOCK_NETWORK_BITSTREAM_HPP
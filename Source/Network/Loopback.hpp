@@ -0,0 +1,135 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Network/Loopback.hpp
+// Description: In process packet link with simulated latency and loss.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_NETWORK_LOOPBACK_HPP
+#define WARLOCK_NETWORK_LOOPBACK_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Network
+    {
+        struct LoopbackSettings
+        {
+            // Ticks a packet spends in flight.
+            std::uint32_t latency = 0;
+
+            // Extra random delay of up to this many ticks, which reorders packets.
+            std::uint32_t jitter = 0;
+
+            // Probability in [0, 1] of dropping a packet.
+            float loss = 0.0f;
+
+            std::uint32_t seed = 1;
+        };
+
+        // One direction of a datagram link that lives in memory, for exercising protocols in
+        // tests and tools without sockets. Time only moves on Tick(), and the random drops and
+        // delays come from a seeded generator, so runs are reproducible.
+        class LoopbackLink
+        {
+            public:
+                LoopbackLink(const LoopbackSettings &Settings = LoopbackSettings()) : settings(Settings), state(Settings.seed ? Settings.seed : 1), now(0), sent(0), dropped(0) {};
+
+                void Send(const std::uint8_t *Data, std::size_t Size)
+                {
+                    sent++;
+
+                    if (Random() < settings.loss)
+                    {
+                        dropped++;
+                        return;
+                    }
+
+                    std::uint32_t delay = settings.latency + (settings.jitter ? static_cast<std::uint32_t>(Random() * static_cast<float>(settings.jitter + 1)) : 0);
+                    Packet packet = {now + delay, std::vector<std::uint8_t>(Data, Data + Size)};
+
+                    // Keep the queue sorted by arrival; equal arrivals stay in send order.
+                    auto position = queue.end();
+
+                    while (position != queue.begin() && (position - 1)->arrival > packet.arrival)
+                        --position;
+
+                    queue.insert(position, std::move(packet));
+                };
+
+                void Send(const std::vector<std::uint8_t> &Data)
+                {
+                    Send(Data.data(), Data.size());
+                };
+
+                // Pops the next packet that has arrived by now.
+                bool Receive(std::vector<std::uint8_t> &Data)
+                {
+                    if (queue.empty() || queue.front().arrival > now)
+                        return false;
+
+                    Data.swap(queue.front().data);
+                    queue.pop_front();
+
+                    return true;
+                };
+
+                void Tick()
+                {
+                    now++;
+                };
+
+                std::size_t GetSentCount() const
+                {
+                    return sent;
+                };
+
+                std::size_t GetDroppedCount() const
+                {
+                    return dropped;
+                };
+
+            private:
+                struct Packet
+                {
+                    std::uint64_t arrival;
+                    std::vector<std::uint8_t> data;
+                };
+
+                // Xorshift32, uniform in [0, 1).
+                float Random()
+                {
+                    state ^= state << 13;
+                    state ^= state >> 17;
+                    state ^= state << 5;
+
+                    return static_cast<float>(state >> 8) * (1.0f / 16777216.0f);
+                };
+
+                LoopbackSettings settings;
+                std::deque<Packet> queue;
+                std::uint32_t state;
+                std::uint64_t now;
+                std::size_t sent;
+                std::size_t dropped;
+        };
+    };
+};
+
+#endif // WARLOCK_NETWORK_LOOPBACK_HPP
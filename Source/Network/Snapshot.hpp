@@ -0,0 +1,403 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Network/Snapshot.hpp
+// Description: Quantized entity snapshots and their delta encoding.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_NETWORK_SNAPSHOT_HPP
+#define WARLOCK_NETWORK_SNAPSHOT_HPP
+
+#include "BitStream.hpp"
+#include "Math/Simd.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Network
+    {
+        // Bits per component of a smallest three rotation; with the two bit index it fills 32.
+        constexpr unsigned int RotationComponentBits = 10;
+        constexpr std::uint32_t RotationComponentMask = (1u << RotationComponentBits) - 1;
+
+        struct SnapshotSettings
+        {
+            // World units per position step. Positions must stay within 2^31 steps of the origin.
+            float positionPrecision = 1.0f / 512.0f;
+        };
+
+        // Stores the three smallest components of a unit quaternion, negated if needed so the
+        // dropped largest one is positive, each scaled from [-1/sqrt(2), 1/sqrt(2)].
+        inline std::uint32_t QuantizeRotation(float X, float Y, float Z, float W)
+        {
+            const float components[4] = {X, Y, Z, W};
+            std::uint32_t largest = 0;
+
+            for (std::uint32_t i = 1; i < 4; i++)
+            {
+                if (std::fabs(components[i]) > std::fabs(components[largest]))
+                    largest = i;
+            }
+
+            const float sign = (components[largest] < 0.0f ? -1.0f : 1.0f);
+            std::uint32_t packed = largest << (3 * RotationComponentBits);
+            unsigned int shift = 2 * RotationComponentBits;
+
+            for (std::uint32_t i = 0; i < 4; i++)
+            {
+                if (i == largest)
+                    continue;
+
+                float unit = components[i] * sign * 0.70710678f + 0.5f;
+                float q = std::nearbyint(std::fmin(std::fmax(unit, 0.0f), 1.0f) * static_cast<float>(RotationComponentMask));
+
+                packed |= static_cast<std::uint32_t>(q) << shift;
+                shift -= RotationComponentBits;
+            }
+
+            return packed;
+        };
+
+        inline void DequantizeRotation(std::uint32_t Packed, float &X, float &Y, float &Z, float &W)
+        {
+            const std::uint32_t largest = Packed >> (3 * RotationComponentBits);
+            float components[4];
+            float sum = 0.0f;
+            unsigned int shift = 2 * RotationComponentBits;
+
+            for (std::uint32_t i = 0; i < 4; i++)
+            {
+                if (i == largest)
+                    continue;
+
+                float unit = static_cast<float>((Packed >> shift) & RotationComponentMask) / static_cast<float>(RotationComponentMask);
+                components[i] = (unit - 0.5f) * 1.41421356f;
+                sum += components[i] * components[i];
+                shift -= RotationComponentBits;
+            }
+
+            components[largest] = std::sqrt(std::fmax(1.0f - sum, 0.0f));
+
+            X = components[0];
+            Y = components[1];
+            Z = components[2];
+            W = components[3];
+        };
+
+        // QuantizeRotation(0, 0, 0, 1): w dropped, the others at the midpoint of their range.
+        constexpr std::uint32_t IdentityRotation = (3u << 30) | (512u << 20) | (512u << 10) | 512u;
+
+        // Quantized state of every entity, indexed by entity slot. Encoding works on integers
+        // only, so the sender and the receiver reconstruct bit identical baselines.
+        struct Snapshot
+        {
+            void Resize(std::size_t Count)
+            {
+                x.resize(Count, 0);
+                y.resize(Count, 0);
+                z.resize(Count, 0);
+                rotation.resize(Count, IdentityRotation);
+            };
+
+            std::size_t GetCount() const
+            {
+                return x.size();
+            };
+
+            // Positions as SoA streams, rotations as x, y, z, w streams of unit quaternions.
+            void Quantize(const float *X, const float *Y, const float *Z, const float *const Rotation[4], std::size_t Count, const SnapshotSettings &Settings = SnapshotSettings())
+            {
+                using namespace Math;
+
+                Resize(Count);
+
+                const float *input[3] = {X, Y, Z};
+                std::int32_t *output[3] = {x.data(), y.data(), z.data()};
+                const SimdFloat scale(1.0f / Settings.positionPrecision);
+                const float inverse = 1.0f / Settings.positionPrecision;
+
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    std::size_t i = 0;
+
+                    for (; i + WARLOCK_SIMD_WIDTH <= Count; i += WARLOCK_SIMD_WIDTH)
+                        ToInt(Round(SimdFloat::Load(input[axis] + i) * scale)).Store(output[axis] + i);
+
+                    for (; i < Count; i++)
+                        output[axis][i] = static_cast<std::int32_t>(std::nearbyint(input[axis][i] * inverse));
+                }
+
+                // QuantizeRotation a register at a time: the largest component is tracked with
+                // the same strict comparisons, then the three kept ones are picked by index.
+                const SimdFloat half(0.5f), range(static_cast<float>(RotationComponentMask));
+                std::size_t i = 0;
+
+                for (; i + WARLOCK_SIMD_WIDTH <= Count; i += WARLOCK_SIMD_WIDTH)
+                {
+                    SimdFloat qx = SimdFloat::Load(Rotation[0] + i), qy = SimdFloat::Load(Rotation[1] + i);
+                    SimdFloat qz = SimdFloat::Load(Rotation[2] + i), qw = SimdFloat::Load(Rotation[3] + i);
+                    SimdFloat largestValue = qx, largestMagnitude = Abs(qx);
+                    SimdInt largest = SimdInt::Zero();
+                    const SimdFloat others[3] = {qy, qz, qw};
+
+                    for (int c = 0; c < 3; c++)
+                    {
+                        SimdMask greater = Abs(others[c]) > largestMagnitude;
+
+                        largest = Select(greater, SimdInt(c + 1), largest);
+                        largestValue = Select(greater, others[c], largestValue);
+                        largestMagnitude = Max(Abs(others[c]), largestMagnitude);
+                    }
+
+                    SimdFloat sign = Select(largestValue < SimdFloat::Zero(), SimdFloat(-0.70710678f), SimdFloat(0.70710678f));
+                    SimdFloat a = Select(largest == SimdInt::Zero(), qy, qx);
+                    SimdFloat b = Select(largest < SimdInt(2), qz, qy);
+                    SimdFloat c = Select(largest < SimdInt(3), qw, qz);
+
+                    SimdInt qa = ToInt(Round(Min(Max(MulAdd(a, sign, half), SimdFloat::Zero()), SimdFloat(1.0f)) * range));
+                    SimdInt qb = ToInt(Round(Min(Max(MulAdd(b, sign, half), SimdFloat::Zero()), SimdFloat(1.0f)) * range));
+                    SimdInt qc = ToInt(Round(Min(Max(MulAdd(c, sign, half), SimdFloat::Zero()), SimdFloat(1.0f)) * range));
+
+                    ((largest << (3 * RotationComponentBits)) | (qa << (2 * RotationComponentBits)) | (qb << RotationComponentBits) | qc).Store(rotation.data() + i);
+                }
+
+                for (; i < Count; i++)
+                    rotation[i] = QuantizeRotation(Rotation[0][i], Rotation[1][i], Rotation[2][i], Rotation[3][i]);
+            };
+
+            void Dequantize(float *X, float *Y, float *Z, float *const Rotation[4], const SnapshotSettings &Settings = SnapshotSettings()) const
+            {
+                using namespace Math;
+
+                const std::int32_t *input[3] = {x.data(), y.data(), z.data()};
+                float *output[3] = {X, Y, Z};
+                const SimdFloat scale(Settings.positionPrecision);
+                const std::size_t count = GetCount();
+
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    std::size_t i = 0;
+
+                    for (; i + WARLOCK_SIMD_WIDTH <= count; i += WARLOCK_SIMD_WIDTH)
+                        (ToFloat(SimdInt::Load(input[axis] + i)) * scale).Store(output[axis] + i);
+
+                    for (; i < count; i++)
+                        output[axis][i] = static_cast<float>(input[axis][i]) * Settings.positionPrecision;
+                }
+
+                for (std::size_t i = 0; i < count; i++)
+                    DequantizeRotation(rotation[i], Rotation[0][i], Rotation[1][i], Rotation[2][i], Rotation[3][i]);
+            };
+
+            std::vector<std::int32_t> x;
+            std::vector<std::int32_t> y;
+            std::vector<std::int32_t> z;
+            std::vector<std::uint32_t> rotation;
+        };
+
+        // Writes only the entities that differ from the baseline. A SIMD pass diffs every
+        // stream, zigzags the position deltas and compresses the indices of changed entities;
+        // the bit packing then touches changed entities only:
+        //
+        //   count:32 changed:32 { gap:var position:1 rotation:1 [dx dy dz:var]
+        //                         [same largest:1 (d0 d1 d2:var | packed:32)] }
+        //
+        // where gap is the number of unchanged entities skipped. Keep one encoder per thread.
+        class SnapshotEncoder
+        {
+            public:
+                // A null Baseline, or entities past its end, encode against zero positions and
+                // identity rotations.
+                void Encode(const Snapshot &Current, const Snapshot *Baseline, BitWriter &Writer)
+                {
+                    using namespace Math;
+
+                    const std::size_t count = Current.GetCount();
+                    const std::size_t shared = (Baseline ? std::min(count, Baseline->GetCount()) : 0);
+                    std::size_t changedCount = 0;
+
+                    changed.resize(count + WARLOCK_SIMD_WIDTH);
+                    deltas[0].resize(count);
+                    deltas[1].resize(count);
+                    deltas[2].resize(count);
+
+                    std::size_t i = 0;
+
+                    for (; i + WARLOCK_SIMD_WIDTH <= shared; i += WARLOCK_SIMD_WIDTH)
+                    {
+                        SimdInt dx = SimdInt::Load(Current.x.data() + i) - SimdInt::Load(Baseline->x.data() + i);
+                        SimdInt dy = SimdInt::Load(Current.y.data() + i) - SimdInt::Load(Baseline->y.data() + i);
+                        SimdInt dz = SimdInt::Load(Current.z.data() + i) - SimdInt::Load(Baseline->z.data() + i);
+                        SimdInt dr = SimdInt::Load(Current.rotation.data() + i) ^ SimdInt::Load(Baseline->rotation.data() + i);
+
+                        ((dx << 1) ^ ShiftRightArithmetic(dx, 31)).Store(deltas[0].data() + i);
+                        ((dy << 1) ^ ShiftRightArithmetic(dy, 31)).Store(deltas[1].data() + i);
+                        ((dz << 1) ^ ShiftRightArithmetic(dz, 31)).Store(deltas[2].data() + i);
+
+                        int bits = (~((dx | dy | dz | dr) == SimdInt::Zero())).Bits();
+
+                        if (bits)
+                            changedCount += CompressStore(SimdInt(static_cast<std::int32_t>(i)) + SimdInt::Index(), bits, changed.data() + changedCount);
+                    }
+
+                    for (; i < count; i++)
+                    {
+                        const bool based = (i < shared);
+                        const std::int32_t *current[3] = {Current.x.data(), Current.y.data(), Current.z.data()};
+                        const std::int32_t *base[3] = {based ? Baseline->x.data() : nullptr, based ? Baseline->y.data() : nullptr, based ? Baseline->z.data() : nullptr};
+                        bool different = (Current.rotation[i] != (based ? Baseline->rotation[i] : IdentityRotation));
+
+                        for (int axis = 0; axis < 3; axis++)
+                        {
+                            std::int32_t delta = static_cast<std::int32_t>(static_cast<std::uint32_t>(current[axis][i]) - static_cast<std::uint32_t>(based ? base[axis][i] : 0));
+
+                            deltas[axis][i] = ZigZag(delta);
+                            different |= (delta != 0);
+                        }
+
+                        if (different)
+                            changed[changedCount++] = static_cast<std::uint32_t>(i);
+                    }
+
+                    Writer.Write(static_cast<std::uint32_t>(count), 32);
+                    Writer.Write(static_cast<std::uint32_t>(changedCount), 32);
+
+                    std::uint32_t next = 0;
+
+                    for (std::size_t k = 0; k < changedCount; k++)
+                    {
+                        const std::uint32_t index = changed[k];
+                        const std::uint32_t packed = Current.rotation[index];
+                        const std::uint32_t reference = (index < shared ? Baseline->rotation[index] : IdentityRotation);
+                        const bool moved = ((deltas[0][index] | deltas[1][index] | deltas[2][index]) != 0);
+                        const bool turned = (packed != reference);
+
+                        Writer.WriteVariable(index - next);
+                        Writer.Write((moved ? 1u : 0u) | (turned ? 2u : 0u), 2);
+                        next = index + 1;
+
+                        if (moved)
+                        {
+                            Writer.WriteVariable(deltas[0][index]);
+                            Writer.WriteVariable(deltas[1][index]);
+                            Writer.WriteVariable(deltas[2][index]);
+                        }
+
+                        if (!turned)
+                            continue;
+
+                        // Small rotations keep the same largest component, so the three stored
+                        // ones change by a few steps each.
+                        if ((packed >> (3 * RotationComponentBits)) == (reference >> (3 * RotationComponentBits)))
+                        {
+                            Writer.WriteBit(true);
+
+                            for (unsigned int shift = 0; shift < 3 * RotationComponentBits; shift += RotationComponentBits)
+                            {
+                                std::int32_t delta = static_cast<std::int32_t>((packed >> shift) & RotationComponentMask) - static_cast<std::int32_t>((reference >> shift) & RotationComponentMask);
+                                Writer.WriteVariable(ZigZag(delta));
+                            }
+                        }
+                        else
+                        {
+                            Writer.WriteBit(false);
+                            Writer.Write(packed, 32);
+                        }
+                    }
+                };
+
+            private:
+                std::vector<std::uint32_t> changed;
+                std::vector<std::uint32_t> deltas[3];
+        };
+
+        // Rebuilds a snapshot from a packet body and the same baseline the encoder used.
+        // Returns false, with Output in an unspecified state, on a truncated or malformed body.
+        // Output must not be the baseline itself.
+        inline bool DecodeSnapshot(BitReader &Reader, const Snapshot *Baseline, Snapshot &Output, std::size_t MaximumCount = 1u << 24)
+        {
+            const std::size_t count = Reader.Read(32);
+            const std::size_t changedCount = Reader.Read(32);
+
+            if (Reader.IsOverflowed() || count > MaximumCount || changedCount > count)
+                return false;
+
+            const std::size_t shared = (Baseline ? std::min(count, Baseline->GetCount()) : 0);
+
+            Output.x.clear();
+            Output.y.clear();
+            Output.z.clear();
+            Output.rotation.clear();
+
+            if (Baseline)
+            {
+                Output.x.assign(Baseline->x.begin(), Baseline->x.begin() + shared);
+                Output.y.assign(Baseline->y.begin(), Baseline->y.begin() + shared);
+                Output.z.assign(Baseline->z.begin(), Baseline->z.begin() + shared);
+                Output.rotation.assign(Baseline->rotation.begin(), Baseline->rotation.begin() + shared);
+            }
+
+            Output.Resize(count);
+
+            std::size_t next = 0;
+
+            for (std::size_t k = 0; k < changedCount; k++)
+            {
+                const std::size_t index = next + Reader.ReadVariable();
+
+                if (index >= count)
+                    return false;
+
+                const bool moved = Reader.ReadBit();
+                const bool turned = Reader.ReadBit();
+                next = index + 1;
+
+                if (moved)
+                {
+                    Output.x[index] = static_cast<std::int32_t>(static_cast<std::uint32_t>(Output.x[index]) + static_cast<std::uint32_t>(UnZigZag(Reader.ReadVariable())));
+                    Output.y[index] = static_cast<std::int32_t>(static_cast<std::uint32_t>(Output.y[index]) + static_cast<std::uint32_t>(UnZigZag(Reader.ReadVariable())));
+                    Output.z[index] = static_cast<std::int32_t>(static_cast<std::uint32_t>(Output.z[index]) + static_cast<std::uint32_t>(UnZigZag(Reader.ReadVariable())));
+                }
+
+                if (!turned)
+                    continue;
+
+                if (Reader.ReadBit())
+                {
+                    std::uint32_t reference = Output.rotation[index];
+                    std::uint32_t packed = reference & ~((1u << (3 * RotationComponentBits)) - 1);
+
+                    for (unsigned int shift = 0; shift < 3 * RotationComponentBits; shift += RotationComponentBits)
+                    {
+                        std::int32_t component = static_cast<std::int32_t>((reference >> shift) & RotationComponentMask) + UnZigZag(Reader.ReadVariable());
+                        packed |= (static_cast<std::uint32_t>(component) & RotationComponentMask) << shift;
+                    }
+
+                    Output.rotation[index] = packed;
+                }
+                else
+                    Output.rotation[index] = Reader.Read(32);
+            }
+
+            return !Reader.IsOverflowed();
+        };
+    };
+};
+
+#endif // WARLOCK_NETWORK_SNAPSHOT_HPP
@@ -0,0 +1,170 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Network/SnapshotChannel.hpp
+// Description: Snapshot streams delta encoded against acknowledged baselines.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_NETWORK_SNAPSHOTCHANNEL_HPP
+#define WARLOCK_NETWORK_SNAPSHOTCHANNEL_HPP
+
+#include "BitStream.hpp"
+#include "Snapshot.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Network
+    {
+        // Snapshots kept on both ends to serve as baselines; at 60 ticks per second this covers
+        // about half a second of round trip.
+        constexpr std::uint32_t SnapshotHistorySize = 32;
+        constexpr std::uint32_t NoBaseline = 0xFFFFFFFFu;
+
+        // Packets are: sequence:32 baseline:32 body, with baseline NoBaseline for a full state.
+        class SnapshotSender
+        {
+            public:
+                SnapshotSender() : sequence(0), acknowledged(NoBaseline)
+                {
+                    history.resize(SnapshotHistorySize);
+                    sequences.assign(SnapshotHistorySize, NoBaseline);
+                };
+
+                // Encodes Current against the newest acknowledged snapshot still held, keeps it
+                // as a future baseline and returns the packet, valid until the next call.
+                const std::vector<std::uint8_t> &Send(const Snapshot &Current)
+                {
+                    const Snapshot *baseline = nullptr;
+                    std::uint32_t baselineSequence = NoBaseline;
+
+                    if (acknowledged != NoBaseline && sequence - acknowledged < SnapshotHistorySize && sequences[acknowledged % SnapshotHistorySize] == acknowledged)
+                    {
+                        baseline = &history[acknowledged % SnapshotHistorySize];
+                        baselineSequence = acknowledged;
+                    }
+
+                    writer.Clear();
+                    writer.Write(sequence, 32);
+                    writer.Write(baselineSequence, 32);
+                    encoder.Encode(Current, baseline, writer);
+                    writer.Flush();
+
+                    // The baseline slot is never the one being overwritten: it is less than
+                    // SnapshotHistorySize sequences old.
+                    history[sequence % SnapshotHistorySize] = Current;
+                    sequences[sequence % SnapshotHistorySize] = sequence;
+                    sequence++;
+
+                    return writer.GetData();
+                };
+
+                // Acknowledgements may arrive late, repeated or out of order.
+                void Acknowledge(std::uint32_t Sequence)
+                {
+                    if (Sequence >= sequence)
+                        return;
+
+                    if (acknowledged == NoBaseline || Sequence - acknowledged < 0x80000000u)
+                        acknowledged = Sequence;
+                };
+
+                std::uint32_t GetSequence() const
+                {
+                    return sequence;
+                };
+
+            private:
+                SnapshotEncoder encoder;
+                BitWriter writer;
+                std::vector<Snapshot> history;
+                std::vector<std::uint32_t> sequences;
+                std::uint32_t sequence;
+                std::uint32_t acknowledged;
+        };
+
+        class SnapshotReceiver
+        {
+            public:
+                SnapshotReceiver() : latest(NoBaseline)
+                {
+                    history.resize(SnapshotHistorySize);
+                    sequences.assign(SnapshotHistorySize, NoBaseline);
+                };
+
+                // Returns true when the packet produced a new latest snapshot. Stale, corrupt
+                // packets and those whose baseline is no longer held are dropped.
+                bool Receive(const std::uint8_t *Data, std::size_t Size)
+                {
+                    BitReader reader(Data, Size);
+                    const std::uint32_t sequence = reader.Read(32);
+                    const std::uint32_t baselineSequence = reader.Read(32);
+
+                    if (reader.IsOverflowed() || sequence == NoBaseline)
+                        return false;
+
+                    if (latest != NoBaseline && sequence - latest - 1 >= 0x80000000u)
+                        return false;
+
+                    const Snapshot *baseline = nullptr;
+
+                    if (baselineSequence != NoBaseline)
+                    {
+                        if (sequences[baselineSequence % SnapshotHistorySize] != baselineSequence)
+                            return false;
+
+                        baseline = &history[baselineSequence % SnapshotHistorySize];
+                    }
+
+                    // Decode aside, so a bad packet cannot damage a baseline or the latest state.
+                    if (!DecodeSnapshot(reader, baseline, scratch))
+                        return false;
+
+                    std::swap(history[sequence % SnapshotHistorySize], scratch);
+                    sequences[sequence % SnapshotHistorySize] = sequence;
+                    latest = sequence;
+
+                    return true;
+                };
+
+                bool HasSnapshot() const
+                {
+                    return (latest != NoBaseline);
+                };
+
+                const Snapshot &GetLatest() const
+                {
+                    return history[latest % SnapshotHistorySize];
+                };
+
+                // The sequence to acknowledge back to the sender.
+                std::uint32_t GetLatestSequence() const
+                {
+                    return latest;
+                };
+
+            private:
+                std::vector<Snapshot> history;
+                std::vector<std::uint32_t> sequences;
+                Snapshot scratch;
+                std::uint32_t latest;
+        };
+    };
+};
+
+#endif // WARLOCK_NETWORK_SNAPSHOTCHANNEL_HPP
@@ -0,0 +1,665 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Physics/Gjk.hpp
+// Description: GJK distance and EPA penetration queries between convex shapes.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_PHYSICS_GJK_HPP
+#define WARLOCK_PHYSICS_GJK_HPP
+
+#include "Shapes.hpp"
+#include "Core/ThreadPool.hpp"
+#include "Math/Vector3.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace Warlock
+{
+    namespace Physics
+    {
+        static constexpr int GjkMaximumIterations = 64;
+        static constexpr int EpaMaximumIterations = 64;
+        static constexpr int EpaMaximumVertices = EpaMaximumIterations + 4;
+        static constexpr int EpaMaximumFaces = 2 * EpaMaximumVertices;
+        static constexpr float GjkTolerance = 1.0e-6f;
+        static constexpr float GjkRelativeTolerance = 1.0e-4f;
+        static constexpr float EpaTolerance = 1.0e-4f;
+
+        // Search directions of the last simplex of a pair; feeding them back on the next frame
+        // restarts GJK next to the previous answer, which usually converges in one or two steps
+        // for coherent motion.
+        struct GjkCache
+        {
+            GjkCache() : count(0) {};
+
+            Math::Vector3<float> directions[4];
+            int count;
+        };
+
+        // Distance is the separation when the shapes are disjoint and the penetration depth when
+        // they intersect. Normal is a unit vector pointing from A towards B, and translating B by
+        // Normal * depth resolves an intersection.
+        struct CollisionResult
+        {
+            CollisionResult() : intersecting(false), distance(0.0f), normal(0.0f), pointA(0.0f), pointB(0.0f), iterations(0) {};
+
+            bool intersecting;
+            float distance;
+            Math::Vector3<float> normal;
+            Math::Vector3<float> pointA;
+            Math::Vector3<float> pointB;
+            int iterations;
+        };
+
+        namespace Detail
+        {
+            using Vector = Math::Vector3<float>;
+
+            inline Vector Add(const Vector &First, const Vector &Second)
+            {
+                return Vector(First.x + Second.x, First.y + Second.y, First.z + Second.z);
+            };
+
+            inline Vector Subtract(const Vector &First, const Vector &Second)
+            {
+                return Vector(First.x - Second.x, First.y - Second.y, First.z - Second.z);
+            };
+
+            inline Vector Scale(const Vector &Value, float Scalar)
+            {
+                return Vector(Value.x * Scalar, Value.y * Scalar, Value.z * Scalar);
+            };
+
+            inline Vector Negate(const Vector &Value)
+            {
+                return Vector(-Value.x, -Value.y, -Value.z);
+            };
+
+            inline float LengthSquared(const Vector &Value)
+            {
+                return Math::ScalarProduct(Value, Value);
+            };
+
+            // A vertex of the Minkowski difference A - B together with the points of A and B it
+            // came from, which are needed to recover the witness points.
+            struct SupportPoint
+            {
+                Vector w;
+                Vector a;
+                Vector b;
+                Vector direction;
+            };
+
+            inline SupportPoint Support(const ConvexShape &A, const ConvexShape &B, const Vector &Direction)
+            {
+                SupportPoint point;
+                point.direction = Direction;
+                point.a = A.Support(Direction);
+                point.b = B.Support(Negate(Direction));
+                point.w = Subtract(point.a, point.b);
+
+                return point;
+            };
+
+            // Closest point to the origin on the current simplex. The simplex is reduced in place
+            // to the smallest sub simplex containing that point and Weights receives its
+            // barycentric coordinates.
+            struct Simplex
+            {
+                Simplex() : count(0) {};
+
+                void Keep(int First)
+                {
+                    points[0] = points[First];
+                    weights[0] = 1.0f;
+                    count = 1;
+                };
+
+                void Keep(int First, int Second, float t)
+                {
+                    SupportPoint a = points[First], b = points[Second];
+
+                    points[0] = a;
+                    points[1] = b;
+                    weights[0] = 1.0f - t;
+                    weights[1] = t;
+                    count = 2;
+                };
+
+                void Keep(int First, int Second, int Third, float v, float w)
+                {
+                    SupportPoint a = points[First], b = points[Second], c = points[Third];
+
+                    points[0] = a;
+                    points[1] = b;
+                    points[2] = c;
+                    weights[0] = 1.0f - v - w;
+                    weights[1] = v;
+                    weights[2] = w;
+                    count = 3;
+                };
+
+                Vector Closest() const
+                {
+                    Vector result(0.0f);
+
+                    for (int i = 0; i < count; i++)
+                        result = Add(result, Scale(points[i].w, weights[i]));
+
+                    return result;
+                };
+
+                void Witness(Vector &A, Vector &B) const
+                {
+                    A = Vector(0.0f);
+                    B = Vector(0.0f);
+
+                    for (int i = 0; i < count; i++)
+                    {
+                        A = Add(A, Scale(points[i].a, weights[i]));
+                        B = Add(B, Scale(points[i].b, weights[i]));
+                    }
+                };
+
+                void SolveSegment()
+                {
+                    Vector ab = Subtract(points[1].w, points[0].w);
+                    float length = LengthSquared(ab);
+                    float t = (length > 0.0f ? -Math::ScalarProduct(points[0].w, ab) / length : 0.0f);
+
+                    if (t <= 0.0f)
+                        Keep(0);
+                    else if (t >= 1.0f)
+                        Keep(1);
+                    else
+                        Keep(0, 1, t);
+                };
+
+                // Voronoi region tests of Ericson, Real-Time Collision Detection 5.1.5, for the
+                // origin against the triangle (First, Second, Third).
+                void SolveTriangle(int First, int Second, int Third)
+                {
+                    const Vector &a = points[First].w, &b = points[Second].w, &c = points[Third].w;
+                    Vector ab = Subtract(b, a), ac = Subtract(c, a);
+
+                    float d1 = -Math::ScalarProduct(ab, a), d2 = -Math::ScalarProduct(ac, a);
+
+                    if (d1 <= 0.0f && d2 <= 0.0f)
+                        return Keep(First);
+
+                    float d3 = -Math::ScalarProduct(ab, b), d4 = -Math::ScalarProduct(ac, b);
+
+                    if (d3 >= 0.0f && d4 <= d3)
+                        return Keep(Second);
+
+                    float vc = d1 * d4 - d3 * d2;
+
+                    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+                        return Keep(First, Second, d1 / (d1 - d3));
+
+                    float d5 = -Math::ScalarProduct(ab, c), d6 = -Math::ScalarProduct(ac, c);
+
+                    if (d6 >= 0.0f && d5 <= d6)
+                        return Keep(Third);
+
+                    float vb = d5 * d2 - d1 * d6;
+
+                    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+                        return Keep(First, Third, d2 / (d2 - d6));
+
+                    float va = d3 * d6 - d5 * d4;
+
+                    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+                        return Keep(Second, Third, (d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+                    float denominator = va + vb + vc;
+
+                    if (!(denominator > 0.0f))
+                        return Keep(First);
+
+                    Keep(First, Second, Third, vb / denominator, vc / denominator);
+                };
+
+                // Returns true when the origin lies inside the tetrahedron; otherwise reduces to
+                // the closest face on whose outer side the origin lies.
+                bool SolveTetrahedron()
+                {
+                    static constexpr int faces[4][4] = {{0, 1, 2, 3}, {0, 2, 3, 1}, {0, 3, 1, 2}, {1, 3, 2, 0}};
+                    Simplex best;
+                    float bestDistance = std::numeric_limits<float>::infinity();
+                    bool outside = false;
+
+                    for (int f = 0; f < 4; f++)
+                    {
+                        const Vector &a = points[faces[f][0]].w;
+                        Vector normal = Math::VectorProduct(Subtract(points[faces[f][1]].w, a), Subtract(points[faces[f][2]].w, a));
+                        float origin = -Math::ScalarProduct(normal, a);
+                        float opposite = Math::ScalarProduct(normal, Subtract(points[faces[f][3]].w, a));
+
+                        // A flat tetrahedron has no inside; every face is then a candidate.
+                        if (origin * opposite > 0.0f)
+                            continue;
+
+                        Simplex face;
+                        face.points[0] = points[faces[f][0]];
+                        face.points[1] = points[faces[f][1]];
+                        face.points[2] = points[faces[f][2]];
+                        face.count = 3;
+                        face.SolveTriangle(0, 1, 2);
+
+                        float distance = LengthSquared(face.Closest());
+
+                        if (distance < bestDistance)
+                        {
+                            bestDistance = distance;
+                            best = face;
+                        }
+
+                        outside = true;
+                    }
+
+                    if (!outside)
+                    {
+                        weights[0] = weights[1] = weights[2] = weights[3] = 0.25f;
+                        return true;
+                    }
+
+                    *this = best;
+                    return false;
+                };
+
+                // Reduces the simplex and returns true when it encloses the origin.
+                bool Solve()
+                {
+                    switch (count)
+                    {
+                        case 1:
+                            weights[0] = 1.0f;
+                            return false;
+
+                        case 2:
+                            SolveSegment();
+                            return false;
+
+                        case 3:
+                            SolveTriangle(0, 1, 2);
+                            return false;
+
+                        default:
+                            return SolveTetrahedron();
+                    };
+                };
+
+                SupportPoint points[4];
+                float weights[4];
+                int count;
+            };
+
+            // Runs GJK and leaves the final simplex in Result; returns true on intersection.
+            inline bool RunGjk(const ConvexShape &A, const ConvexShape &B, Simplex &Result, int &Iterations, GjkCache *Cache)
+            {
+                Simplex &simplex = Result;
+                simplex.count = 0;
+
+                if (Cache)
+                {
+                    for (int i = 0; i < Cache->count; i++)
+                        simplex.points[simplex.count++] = Support(A, B, Cache->directions[i]);
+                }
+
+                if (simplex.count == 0)
+                {
+                    Vector direction = Subtract(B.position, A.position);
+
+                    if (LengthSquared(direction) == 0.0f)
+                        direction = Vector(1.0f, 0.0f, 0.0f);
+
+                    simplex.points[simplex.count++] = Support(A, B, direction);
+                }
+
+                bool intersecting = false;
+                bool solved = false;
+                Iterations = 0;
+
+                while (Iterations < GjkMaximumIterations)
+                {
+                    Iterations++;
+                    solved = true;
+
+                    if (simplex.Solve())
+                    {
+                        intersecting = true;
+                        break;
+                    }
+
+                    Vector v = simplex.Closest();
+                    float length = LengthSquared(v);
+
+                    if (length <= GjkTolerance * GjkTolerance)
+                    {
+                        intersecting = true;
+                        break;
+                    }
+
+                    SupportPoint w = Support(A, B, Negate(v));
+
+                    // No progress towards the origin: |v| is within a relative tolerance of the
+                    // distance, which curved shapes only ever approach asymptotically.
+                    if (length - Math::ScalarProduct(v, w.w) <= GjkRelativeTolerance * length)
+                        break;
+
+                    bool duplicate = false;
+
+                    for (int i = 0; i < simplex.count; i++)
+                        duplicate = duplicate || (LengthSquared(Subtract(simplex.points[i].w, w.w)) <= GjkTolerance * GjkTolerance * length);
+
+                    if (duplicate)
+                        break;
+
+                    simplex.points[simplex.count++] = w;
+                    solved = false;
+                }
+
+                if (!solved)
+                    intersecting = simplex.Solve() || LengthSquared(simplex.Closest()) <= GjkTolerance * GjkTolerance;
+
+                if (Cache)
+                {
+                    Cache->count = simplex.count;
+
+                    for (int i = 0; i < simplex.count; i++)
+                        Cache->directions[i] = simplex.points[i].direction;
+                }
+
+                return intersecting;
+            };
+
+            // Adds support points until the simplex is a tetrahedron with non zero volume; needed
+            // when GJK stops early because the origin lies on a vertex, edge or face.
+            inline bool InflateSimplex(const ConvexShape &A, const ConvexShape &B, Simplex &Polytope)
+            {
+                static const Vector axes[6] = {Vector(1.0f, 0.0f, 0.0f), Vector(-1.0f, 0.0f, 0.0f), Vector(0.0f, 1.0f, 0.0f),
+                                               Vector(0.0f, -1.0f, 0.0f), Vector(0.0f, 0.0f, 1.0f), Vector(0.0f, 0.0f, -1.0f)};
+                const float epsilon = 1.0e-10f;
+
+                if (Polytope.count == 1)
+                {
+                    for (int i = 0; i < 6 && Polytope.count == 1; i++)
+                    {
+                        SupportPoint point = Support(A, B, axes[i]);
+
+                        if (LengthSquared(Subtract(point.w, Polytope.points[0].w)) > epsilon)
+                            Polytope.points[Polytope.count++] = point;
+                    }
+                }
+
+                if (Polytope.count == 2)
+                {
+                    Vector edge = Subtract(Polytope.points[1].w, Polytope.points[0].w);
+                    float ax = std::fabs(edge.x), ay = std::fabs(edge.y), az = std::fabs(edge.z);
+                    const Vector &axis = (ax <= ay && ax <= az ? axes[0] : (ay <= az ? axes[2] : axes[4]));
+                    Vector normal = Math::VectorProduct(edge, axis);
+
+                    for (int i = 0; i < 2 && Polytope.count == 2; i++)
+                    {
+                        SupportPoint point = Support(A, B, (i == 0 ? normal : Negate(normal)));
+                        Vector cross = Math::VectorProduct(edge, Subtract(point.w, Polytope.points[0].w));
+
+                        if (LengthSquared(cross) > epsilon)
+                            Polytope.points[Polytope.count++] = point;
+                    }
+                }
+
+                if (Polytope.count == 3)
+                {
+                    const Vector &a = Polytope.points[0].w;
+                    Vector normal = Math::VectorProduct(Subtract(Polytope.points[1].w, a), Subtract(Polytope.points[2].w, a));
+
+                    for (int i = 0; i < 2 && Polytope.count == 3; i++)
+                    {
+                        SupportPoint point = Support(A, B, (i == 0 ? normal : Negate(normal)));
+
+                        if (std::fabs(Math::ScalarProduct(normal, Subtract(point.w, a))) > epsilon)
+                            Polytope.points[Polytope.count++] = point;
+                    }
+                }
+
+                return (Polytope.count == 4);
+            };
+
+            struct EpaFace
+            {
+                int vertex[3];
+                Vector normal;
+                float distance;
+            };
+
+            inline bool MakeFace(const SupportPoint *Vertices, int First, int Second, int Third, EpaFace &Face)
+            {
+                const Vector &a = Vertices[First].w;
+                Vector normal = Math::VectorProduct(Subtract(Vertices[Second].w, a), Subtract(Vertices[Third].w, a));
+                float length = std::sqrt(LengthSquared(normal));
+
+                if (!(length > 0.0f))
+                    return false;
+
+                Face.vertex[0] = First;
+                Face.vertex[1] = Second;
+                Face.vertex[2] = Third;
+                Face.normal = Scale(normal, 1.0f / length);
+                Face.distance = Math::ScalarProduct(Face.normal, a);
+
+                return true;
+            };
+
+            // Expanding polytope algorithm over a tetrahedron enclosing the origin; the face of
+            // the final polytope closest to the origin gives the penetration normal and depth.
+            inline void RunEpa(const ConvexShape &A, const ConvexShape &B, const Simplex &Start, CollisionResult &Result)
+            {
+                SupportPoint vertices[EpaMaximumVertices];
+                EpaFace faces[EpaMaximumFaces];
+                int edges[3 * EpaMaximumFaces][2];
+                int vertexCount = 4;
+                int faceCount = 0;
+
+                for (int i = 0; i < 4; i++)
+                    vertices[i] = Start.points[i];
+
+                // Wind the tetrahedron so that every face normal points away from the opposite
+                // vertex, and so away from the enclosed origin.
+                {
+                    Vector normal = Math::VectorProduct(Subtract(vertices[1].w, vertices[0].w), Subtract(vertices[2].w, vertices[0].w));
+
+                    if (Math::ScalarProduct(normal, Subtract(vertices[3].w, vertices[0].w)) > 0.0f)
+                    {
+                        SupportPoint swap = vertices[1];
+                        vertices[1] = vertices[2];
+                        vertices[2] = swap;
+                    }
+
+                    static constexpr int tetrahedron[4][3] = {{0, 1, 2}, {0, 3, 1}, {0, 2, 3}, {1, 3, 2}};
+
+                    for (int f = 0; f < 4; f++)
+                    {
+                        if (MakeFace(vertices, tetrahedron[f][0], tetrahedron[f][1], tetrahedron[f][2], faces[faceCount]))
+                            faceCount++;
+                    }
+                }
+
+                int closest = 0;
+
+                for (int iteration = 0; faceCount > 0; iteration++)
+                {
+                    closest = 0;
+
+                    for (int f = 1; f < faceCount; f++)
+                    {
+                        if (faces[f].distance < faces[closest].distance)
+                            closest = f;
+                    }
+
+                    if (iteration >= EpaMaximumIterations || vertexCount >= EpaMaximumVertices)
+                        break;
+
+                    const EpaFace face = faces[closest];
+                    SupportPoint point = Support(A, B, face.normal);
+                    float distance = Math::ScalarProduct(face.normal, point.w);
+
+                    if (distance - face.distance <= EpaTolerance * (face.distance > 1.0f ? face.distance : 1.0f))
+                        break;
+
+                    // Remove every face the new vertex can see and keep the boundary of the hole,
+                    // edges shared by two removed faces cancel out.
+                    int edgeCount = 0;
+
+                    for (int f = 0; f < faceCount;)
+                    {
+                        if (Math::ScalarProduct(faces[f].normal, Subtract(point.w, vertices[faces[f].vertex[0]].w)) <= 0.0f)
+                        {
+                            f++;
+                            continue;
+                        }
+
+                        for (int e = 0; e < 3; e++)
+                        {
+                            int from = faces[f].vertex[e], to = faces[f].vertex[(e + 1) % 3];
+                            bool shared = false;
+
+                            for (int k = 0; k < edgeCount; k++)
+                            {
+                                if (edges[k][0] == to && edges[k][1] == from)
+                                {
+                                    edges[k][0] = edges[edgeCount - 1][0];
+                                    edges[k][1] = edges[edgeCount - 1][1];
+                                    edgeCount--;
+                                    shared = true;
+                                    break;
+                                }
+                            }
+
+                            if (!shared)
+                            {
+                                edges[edgeCount][0] = from;
+                                edges[edgeCount][1] = to;
+                                edgeCount++;
+                            }
+                        }
+
+                        faces[f] = faces[--faceCount];
+                    }
+
+                    if (faceCount + edgeCount > EpaMaximumFaces)
+                        break;
+
+                    vertices[vertexCount] = point;
+
+                    for (int e = 0; e < edgeCount; e++)
+                    {
+                        if (MakeFace(vertices, edges[e][0], edges[e][1], vertexCount, faces[faceCount]))
+                            faceCount++;
+                    }
+
+                    vertexCount++;
+                }
+
+                Result.intersecting = true;
+                Result.distance = 0.0f;
+
+                if (faceCount == 0)
+                {
+                    Start.Witness(Result.pointA, Result.pointB);
+                    return;
+                }
+
+                // Barycentric coordinates of the origin projected onto the closest face map the
+                // contact back onto both shapes.
+                const EpaFace &face = faces[closest];
+                const Vector &a = vertices[face.vertex[0]].w, &b = vertices[face.vertex[1]].w, &c = vertices[face.vertex[2]].w;
+                Vector p = Scale(face.normal, face.distance);
+                Vector v0 = Subtract(b, a), v1 = Subtract(c, a), v2 = Subtract(p, a);
+                float d00 = Math::ScalarProduct(v0, v0), d01 = Math::ScalarProduct(v0, v1), d11 = Math::ScalarProduct(v1, v1);
+                float d20 = Math::ScalarProduct(v2, v0), d21 = Math::ScalarProduct(v2, v1);
+                float denominator = d00 * d11 - d01 * d01;
+                float v = (denominator != 0.0f ? (d11 * d20 - d01 * d21) / denominator : 0.0f);
+                float w = (denominator != 0.0f ? (d00 * d21 - d01 * d20) / denominator : 0.0f);
+                float u = 1.0f - v - w;
+
+                Result.distance = face.distance;
+                Result.normal = face.normal;
+                Result.pointA = Add(Add(Scale(vertices[face.vertex[0]].a, u), Scale(vertices[face.vertex[1]].a, v)), Scale(vertices[face.vertex[2]].a, w));
+                Result.pointB = Add(Add(Scale(vertices[face.vertex[0]].b, u), Scale(vertices[face.vertex[1]].b, v)), Scale(vertices[face.vertex[2]].b, w));
+            };
+        };
+
+        // Boolean overlap test; cheaper than Collide since it stops as soon as the simplex
+        // encloses the origin or a separating direction is proven.
+        inline bool Intersect(const ConvexShape &A, const ConvexShape &B, GjkCache *Cache = nullptr)
+        {
+            Detail::Simplex simplex;
+            int iterations;
+
+            return Detail::RunGjk(A, B, simplex, iterations, Cache);
+        };
+
+        // Separation distance and closest points of disjoint shapes, or penetration depth, normal
+        // and contact points of intersecting ones.
+        inline CollisionResult Collide(const ConvexShape &A, const ConvexShape &B, GjkCache *Cache = nullptr)
+        {
+            CollisionResult result;
+            Detail::Simplex simplex;
+
+            if (!Detail::RunGjk(A, B, simplex, result.iterations, Cache))
+            {
+                Detail::Vector v = simplex.Closest();
+                float length = std::sqrt(Detail::LengthSquared(v));
+
+                simplex.Witness(result.pointA, result.pointB);
+                result.distance = length;
+                result.normal = (length > 0.0f ? Detail::Scale(v, -1.0f / length) : Detail::Vector(0.0f));
+
+                return result;
+            }
+
+            if (!Detail::InflateSimplex(A, B, simplex))
+            {
+                // Degenerate Minkowski difference, such as two touching flat shapes.
+                result.intersecting = true;
+                simplex.Witness(result.pointA, result.pointB);
+
+                return result;
+            }
+
+            Detail::RunEpa(A, B, simplex, result);
+            return result;
+        };
+
+        // Batched narrow phase over pairs of indices into Shapes. Caches is optional and holds
+        // one warm start cache per pair, kept by the caller across frames.
+        inline void Collide(const ConvexShape *Shapes, const CollisionPair *Pairs, std::size_t Count, CollisionResult *Results,
+                            GjkCache *Caches = nullptr, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            Pool.ParallelFor(0, Count, 64, [&](std::size_t First, std::size_t Last)
+            {
+                for (std::size_t i = First; i < Last; i++)
+                    Results[i] = Collide(Shapes[Pairs[i].a], Shapes[Pairs[i].b], (Caches ? Caches + i : nullptr));
+            });
+        };
+    };
+};
+
+#endif // WARLOCK_PHYSICS_GJK_HPP
@@ -0,0 +1,199 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Physics/Integrator.hpp
+// Description: Batched semi-implicit Euler and Verlet integration over vector streams.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_PHYSICS_INTEGRATOR_HPP
+#define WARLOCK_PHYSICS_INTEGRATOR_HPP
+
+#include "Core/ThreadPool.hpp"
+#include "Math/Simd.hpp"
+#include "Math/Vector3.hpp"
+#include "Math/VectorStream.hpp"
+#include <cstddef>
+
+namespace Warlock
+{
+    namespace Physics
+    {
+        // A stream of Vector3<float> values stored as three component arrays.
+        using VectorStream = Math::Vector3Stream;
+
+        // Gravity is added to every acceleration and Damping is a linear damping rate per
+        // second, applied as v / (1 + Damping * dt). Both are folded into per call constants, so
+        // disabling them costs a multiply by one rather than a branch per body.
+        struct IntegratorSettings
+        {
+            IntegratorSettings() : gravity(0.0f), damping(0.0f), clearAcceleration(false) {};
+
+            Math::Vector3<float> gravity;
+            float damping;
+
+            // Zeroes the acceleration stream after reading it, for use as a force accumulator.
+            bool clearAcceleration;
+        };
+
+        static constexpr std::size_t IntegratorChunkSize = 4096;
+
+        namespace Detail
+        {
+            struct IntegratorConstants
+            {
+                IntegratorConstants(float Step, const IntegratorSettings &Settings) : step(Step), damping(1.0f / (1.0f + Settings.damping * Step)),
+                                                                                      gx(Settings.gravity.x), gy(Settings.gravity.y), gz(Settings.gravity.z) {};
+
+                float step;
+                float damping;
+                float gx;
+                float gy;
+                float gz;
+            };
+
+            // v' = (v + (a + g) dt) * damping, x' = x + v' dt
+            inline void IntegrateEuler(VectorStream Position, VectorStream Velocity, VectorStream Acceleration, std::size_t First, std::size_t Last,
+                                       const IntegratorConstants &Constants, bool Clear)
+            {
+                using namespace Math;
+
+                const SimdFloat step(Constants.step), damping(Constants.damping);
+                const SimdFloat gx(Constants.gx), gy(Constants.gy), gz(Constants.gz);
+                float *const positions[3] = {Position.x, Position.y, Position.z};
+                float *const velocities[3] = {Velocity.x, Velocity.y, Velocity.z};
+                float *const accelerations[3] = {Acceleration.x, Acceleration.y, Acceleration.z};
+                const SimdFloat gravity[3] = {gx, gy, gz};
+                const float scalarGravity[3] = {Constants.gx, Constants.gy, Constants.gz};
+
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    float *x = positions[axis];
+                    float *v = velocities[axis];
+                    float *a = accelerations[axis];
+                    std::size_t i = First;
+
+                    for (; i + WARLOCK_SIMD_WIDTH <= Last; i += WARLOCK_SIMD_WIDTH)
+                    {
+                        SimdFloat velocity = MulAdd(SimdFloat::Load(a + i) + gravity[axis], step, SimdFloat::Load(v + i)) * damping;
+
+                        velocity.Store(v + i);
+                        MulAdd(velocity, step, SimdFloat::Load(x + i)).Store(x + i);
+                    }
+
+                    for (; i < Last; i++)
+                    {
+                        v[i] = (v[i] + (a[i] + scalarGravity[axis]) * Constants.step) * Constants.damping;
+                        x[i] += v[i] * Constants.step;
+                    }
+
+                    if (Clear)
+                    {
+                        for (i = First; i < Last; i++)
+                            a[i] = 0.0f;
+                    }
+                }
+            };
+
+            // x' = x + (x - x_previous) * damping + (a + g) dt², x_previous' = x
+            inline void IntegrateVerlet(VectorStream Position, VectorStream Previous, VectorStream Acceleration, std::size_t First, std::size_t Last,
+                                        const IntegratorConstants &Constants, bool Clear)
+            {
+                using namespace Math;
+
+                const float squared = Constants.step * Constants.step;
+                const SimdFloat step(squared), damping(Constants.damping);
+                float *const positions[3] = {Position.x, Position.y, Position.z};
+                float *const previous[3] = {Previous.x, Previous.y, Previous.z};
+                float *const accelerations[3] = {Acceleration.x, Acceleration.y, Acceleration.z};
+                const float gravity[3] = {Constants.gx, Constants.gy, Constants.gz};
+
+                for (int axis = 0; axis < 3; axis++)
+                {
+                    float *x = positions[axis];
+                    float *p = previous[axis];
+                    float *a = accelerations[axis];
+                    const SimdFloat g(gravity[axis]);
+                    std::size_t i = First;
+
+                    for (; i + WARLOCK_SIMD_WIDTH <= Last; i += WARLOCK_SIMD_WIDTH)
+                    {
+                        SimdFloat current = SimdFloat::Load(x + i);
+                        SimdFloat next = MulAdd(current - SimdFloat::Load(p + i), damping, MulAdd(SimdFloat::Load(a + i) + g, step, current));
+
+                        current.Store(p + i);
+                        next.Store(x + i);
+                    }
+
+                    for (; i < Last; i++)
+                    {
+                        float current = x[i];
+
+                        x[i] = current + (current - p[i]) * Constants.damping + (a[i] + gravity[axis]) * squared;
+                        p[i] = current;
+                    }
+
+                    if (Clear)
+                    {
+                        for (i = First; i < Last; i++)
+                            a[i] = 0.0f;
+                    }
+                }
+            };
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Range kernels for callers that already run inside a job.
+        //-----------------------------------------------------------------------------------------
+        inline void IntegrateEuler(VectorStream Position, VectorStream Velocity, VectorStream Acceleration, std::size_t First, std::size_t Last,
+                                   float Step, const IntegratorSettings &Settings = IntegratorSettings())
+        {
+            Detail::IntegrateEuler(Position, Velocity, Acceleration, First, Last, Detail::IntegratorConstants(Step, Settings), Settings.clearAcceleration);
+        };
+
+        inline void IntegrateVerlet(VectorStream Position, VectorStream Previous, VectorStream Acceleration, std::size_t First, std::size_t Last,
+                                    float Step, const IntegratorSettings &Settings = IntegratorSettings())
+        {
+            Detail::IntegrateVerlet(Position, Previous, Acceleration, First, Last, Detail::IntegratorConstants(Step, Settings), Settings.clearAcceleration);
+        };
+
+        //-----------------------------------------------------------------------------------------
+        // Whole stream kernels split in chunks across the thread pool. Chunks are a multiple of
+        // the register width, so only the last one runs a scalar tail.
+        //-----------------------------------------------------------------------------------------
+        inline void IntegrateEuler(VectorStream Position, VectorStream Velocity, VectorStream Acceleration, std::size_t Count, float Step,
+                                   const IntegratorSettings &Settings, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            const Detail::IntegratorConstants constants(Step, Settings);
+
+            Pool.ParallelFor(0, Count, IntegratorChunkSize, [&](std::size_t First, std::size_t Last)
+            {
+                Detail::IntegrateEuler(Position, Velocity, Acceleration, First, Last, constants, Settings.clearAcceleration);
+            });
+        };
+
+        inline void IntegrateVerlet(VectorStream Position, VectorStream Previous, VectorStream Acceleration, std::size_t Count, float Step,
+                                    const IntegratorSettings &Settings, Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+        {
+            const Detail::IntegratorConstants constants(Step, Settings);
+
+            Pool.ParallelFor(0, Count, IntegratorChunkSize, [&](std::size_t First, std::size_t Last)
+            {
+                Detail::IntegrateVerlet(Position, Previous, Acceleration, First, Last, constants, Settings.clearAcceleration);
+            });
+        };
+    };
+};
+
+#endif // WARLOCK_PHYSICS_INTEGRATOR_HPP
@@ -0,0 +1,238 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Physics/Shapes.hpp
+// Description: Convex collision shapes and their support mappings.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_PHYSICS_SHAPES_HPP
+#define WARLOCK_PHYSICS_SHAPES_HPP
+
+#include "Math/Simd.hpp"
+#include "Math/Vector3.hpp"
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+namespace Warlock
+{
+    namespace Physics
+    {
+        enum class ShapeType
+        {
+            Sphere,
+            Box,
+            Capsule,
+            Hull
+        };
+
+        // Pair of shape or proxy indices, as emitted by the broadphase and consumed by the
+        // narrow phase.
+        struct CollisionPair
+        {
+            std::uint32_t a;
+            std::uint32_t b;
+        };
+
+        // Vertices of a convex hull in local space, as structure of arrays streams owned by the
+        // caller.
+        struct ConvexHull
+        {
+            const float *x;
+            const float *y;
+            const float *z;
+            std::size_t count;
+        };
+
+        // Returns the index of the hull vertex farthest along the direction, scanning a register
+        // of vertices per step and reducing the per lane winners at the end.
+        inline std::size_t SupportIndex(const ConvexHull &Hull, float dx, float dy, float dz)
+        {
+            using namespace Math;
+
+            const SimdFloat sx(dx), sy(dy), sz(dz);
+            SimdFloat best(-std::numeric_limits<float>::infinity());
+            SimdInt bestIndex = SimdInt::Zero();
+            SimdInt index = SimdInt::Index();
+            std::size_t i = 0;
+
+            for (; i + WARLOCK_SIMD_WIDTH <= Hull.count; i += WARLOCK_SIMD_WIDTH)
+            {
+                SimdFloat dot = MulAdd(SimdFloat::Load(Hull.x + i), sx, MulAdd(SimdFloat::Load(Hull.y + i), sy, SimdFloat::Load(Hull.z + i) * sz));
+                SimdMask greater = (dot > best);
+
+                best = Select(greater, dot, best);
+                bestIndex = Select(greater, index, bestIndex);
+                index = index + SimdInt(WARLOCK_SIMD_WIDTH);
+            }
+
+            float lanes[WARLOCK_SIMD_WIDTH];
+            std::int32_t indices[WARLOCK_SIMD_WIDTH];
+            float maximum = -std::numeric_limits<float>::infinity();
+            std::size_t result = 0;
+
+            best.Store(lanes);
+            bestIndex.Store(indices);
+
+            for (int j = 0; j < WARLOCK_SIMD_WIDTH; j++)
+            {
+                if (lanes[j] > maximum)
+                {
+                    maximum = lanes[j];
+                    result = static_cast<std::size_t>(indices[j]);
+                }
+            }
+
+            for (; i < Hull.count; i++)
+            {
+                float dot = Hull.x[i] * dx + Hull.y[i] * dy + Hull.z[i] * dz;
+
+                if (dot > maximum)
+                {
+                    maximum = dot;
+                    result = i;
+                }
+            }
+
+            return result;
+        };
+
+        // A convex shape placed in the world by a position and a row major rotation matrix, so
+        // that world = rotation * local + position.
+        struct ConvexShape
+        {
+            ConvexShape() : type(ShapeType::Sphere), position(0.0f), extent(0.0f), radius(0.0f), hull{nullptr, nullptr, nullptr, 0}
+            {
+                for (int i = 0; i < 3; i++)
+                {
+                    for (int j = 0; j < 3; j++)
+                        rotation[i][j] = (i == j ? 1.0f : 0.0f);
+                }
+            };
+
+            static ConvexShape Sphere(const Math::Vector3<float> &Centre, float Radius)
+            {
+                ConvexShape shape;
+                shape.type = ShapeType::Sphere;
+                shape.position = Centre;
+                shape.radius = Radius;
+
+                return shape;
+            };
+
+            static ConvexShape Box(const Math::Vector3<float> &Centre, const Math::Vector3<float> &HalfExtents)
+            {
+                ConvexShape shape;
+                shape.type = ShapeType::Box;
+                shape.position = Centre;
+                shape.extent = HalfExtents;
+
+                return shape;
+            };
+
+            static ConvexShape Capsule(const Math::Vector3<float> &First, const Math::Vector3<float> &Second, float Radius)
+            {
+                ConvexShape shape;
+                shape.type = ShapeType::Capsule;
+                shape.position = Math::Vector3<float>(0.5f * (First.x + Second.x), 0.5f * (First.y + Second.y), 0.5f * (First.z + Second.z));
+                shape.extent = Math::Vector3<float>(0.5f * (Second.x - First.x), 0.5f * (Second.y - First.y), 0.5f * (Second.z - First.z));
+                shape.radius = Radius;
+
+                return shape;
+            };
+
+            static ConvexShape Hull(const ConvexHull &Points, const Math::Vector3<float> &Position)
+            {
+                ConvexShape shape;
+                shape.type = ShapeType::Hull;
+                shape.position = Position;
+                shape.hull = Points;
+
+                return shape;
+            };
+
+            void SetRotation(const float Matrix[9])
+            {
+                for (int i = 0; i < 3; i++)
+                {
+                    for (int j = 0; j < 3; j++)
+                        rotation[i][j] = Matrix[3 * i + j];
+                }
+            };
+
+            Math::Vector3<float> Support(const Math::Vector3<float> &Direction) const
+            {
+                float dx = rotation[0][0] * Direction.x + rotation[1][0] * Direction.y + rotation[2][0] * Direction.z;
+                float dy = rotation[0][1] * Direction.x + rotation[1][1] * Direction.y + rotation[2][1] * Direction.z;
+                float dz = rotation[0][2] * Direction.x + rotation[1][2] * Direction.y + rotation[2][2] * Direction.z;
+                float px = 0.0f, py = 0.0f, pz = 0.0f;
+
+                switch (type)
+                {
+                    case ShapeType::Box:
+                        px = (dx >= 0.0f ? extent.x : -extent.x);
+                        py = (dy >= 0.0f ? extent.y : -extent.y);
+                        pz = (dz >= 0.0f ? extent.z : -extent.z);
+                        break;
+
+                    case ShapeType::Capsule:
+                    {
+                        float side = (dx * extent.x + dy * extent.y + dz * extent.z >= 0.0f ? 1.0f : -1.0f);
+
+                        px = side * extent.x;
+                        py = side * extent.y;
+                        pz = side * extent.z;
+                    }
+                    [[fallthrough]];
+
+                    case ShapeType::Sphere:
+                    {
+                        float length = std::sqrt(dx * dx + dy * dy + dz * dz);
+                        float scale = (length > 0.0f ? radius / length : 0.0f);
+
+                        px += dx * scale;
+                        py += dy * scale;
+                        pz += dz * scale;
+                    }
+                    break;
+
+                    case ShapeType::Hull:
+                    {
+                        std::size_t index = SupportIndex(hull, dx, dy, dz);
+
+                        px = hull.x[index];
+                        py = hull.y[index];
+                        pz = hull.z[index];
+                    }
+                    break;
+                };
+
+                return Math::Vector3<float>(rotation[0][0] * px + rotation[0][1] * py + rotation[0][2] * pz + position.x,
+                                            rotation[1][0] * px + rotation[1][1] * py + rotation[1][2] * pz + position.y,
+                                            rotation[2][0] * px + rotation[2][1] * py + rotation[2][2] * pz + position.z);
+            };
+
+            ShapeType type;
+            Math::Vector3<float> position;
+            Math::Vector3<float> extent;
+            float radius;
+            float rotation[3][3];
+            ConvexHull hull;
+        };
+    };
+};
+
+#endif // WARLOCK_PHYSICS_SHAPES_HPP
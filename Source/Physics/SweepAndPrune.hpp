@@ -0,0 +1,445 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Physics/SweepAndPrune.hpp
+// Description: Incremental sweep and prune broadphase over axis aligned bounding boxes.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_PHYSICS_SWEEPANDPRUNE_HPP
+#define WARLOCK_PHYSICS_SWEEPANDPRUNE_HPP
+
+#include "Shapes.hpp"
+#include "Math/Simd.hpp"
+#include "Math/Vector3.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Physics
+    {
+        // Endpoint arrays are kept sorted between frames with insertion sort, which costs close
+        // to O(n) when objects move little relative to each other.
+        //
+        // SingleAxis sorts the x axis only and sweeps it on every query, testing the y and z
+        // intervals of the active boxes a register at a time.
+        //
+        // MultiAxis sorts all three axes and tracks overlaps from the swaps themselves: every
+        // pair overlapping on at least one axis owns a three bit set, one bit per axis, and is a
+        // colliding pair while all three bits are set. Queries then only walk the pair table.
+        class SweepAndPrune
+        {
+            public:
+                enum class Mode
+                {
+                    SingleAxis,
+                    MultiAxis
+                };
+
+                explicit SweepAndPrune(Mode Sweep = Mode::MultiAxis) : mode(Sweep), proxyCount(0), tableCount(0)
+                {
+                    table.assign(64, PairEntry{EmptyKey, 0});
+                };
+
+                Mode GetMode() const
+                {
+                    return mode;
+                };
+
+                std::size_t GetProxyCount() const
+                {
+                    return proxyCount;
+                };
+
+                // Adds a box and returns its proxy. The endpoints start past the end of the sorted
+                // arrays and find their place, along with the overlaps they create, on the next
+                // Update.
+                std::uint32_t Add(const Math::Vector3<float> &Minimum, const Math::Vector3<float> &Maximum)
+                {
+                    std::uint32_t proxy;
+
+                    if (!freeProxies.empty())
+                    {
+                        proxy = freeProxies.back();
+                        freeProxies.pop_back();
+                    }
+                    else
+                    {
+                        proxy = static_cast<std::uint32_t>(alive.size());
+                        alive.push_back(false);
+
+                        for (int axis = 0; axis < 3; axis++)
+                        {
+                            minimum[axis].push_back(0.0f);
+                            maximum[axis].push_back(0.0f);
+                        }
+
+                        // Active lists are padded by a register so sweeps never read past them.
+                        for (int k = 0; k < 4; k++)
+                            active[k].resize(alive.size() + WARLOCK_SIMD_WIDTH, 0.0f);
+
+                        activeProxies.resize(alive.size() + WARLOCK_SIMD_WIDTH, 0);
+                        activeSlot.resize(alive.size(), 0);
+                    }
+
+                    alive[proxy] = true;
+                    proxyCount++;
+                    Update(proxy, Minimum, Maximum);
+
+                    for (int axis = 0; axis < Axes(); axis++)
+                    {
+                        endpoints[axis].push_back(Endpoint{minimum[axis][proxy], proxy << 1});
+                        endpoints[axis].push_back(Endpoint{maximum[axis][proxy], (proxy << 1) | 1});
+                    }
+
+                    return proxy;
+                };
+
+                void Remove(std::uint32_t Proxy)
+                {
+                    if (Proxy >= alive.size() || !alive[Proxy])
+                        return;
+
+                    for (int axis = 0; axis < Axes(); axis++)
+                    {
+                        std::vector<Endpoint> &list = endpoints[axis];
+                        std::size_t count = 0;
+
+                        for (std::size_t i = 0; i < list.size(); i++)
+                        {
+                            if ((list[i].data >> 1) != Proxy)
+                                list[count++] = list[i];
+                        }
+
+                        list.resize(count);
+                    }
+
+                    if (mode == Mode::MultiAxis)
+                    {
+                        for (std::size_t slot = 0; slot < table.size();)
+                        {
+                            std::uint64_t key = table[slot].key;
+
+                            if (key != EmptyKey && (static_cast<std::uint32_t>(key >> 32) == Proxy || static_cast<std::uint32_t>(key) == Proxy))
+                                Erase(slot);
+                            else
+                                slot++;
+                        }
+                    }
+
+                    alive[Proxy] = false;
+                    freeProxies.push_back(Proxy);
+                    proxyCount--;
+                };
+
+                // Stores new bounds; the endpoints are refreshed and resorted on the next Update.
+                void Update(std::uint32_t Proxy, const Math::Vector3<float> &Minimum, const Math::Vector3<float> &Maximum)
+                {
+                    minimum[0][Proxy] = Minimum.x;
+                    minimum[1][Proxy] = Minimum.y;
+                    minimum[2][Proxy] = Minimum.z;
+                    maximum[0][Proxy] = Maximum.x;
+                    maximum[1][Proxy] = Maximum.y;
+                    maximum[2][Proxy] = Maximum.z;
+                };
+
+                // Bulk form for proxies 0 to Count - 1, matching the usual case of one proxy per
+                // body added in order.
+                void Update(const Math::Vector3<float> *Minimum, const Math::Vector3<float> *Maximum, std::size_t Count)
+                {
+                    for (std::size_t i = 0; i < Count; i++)
+                        Update(static_cast<std::uint32_t>(i), Minimum[i], Maximum[i]);
+                };
+
+                void Update()
+                {
+                    for (int axis = 0; axis < Axes(); axis++)
+                    {
+                        std::vector<Endpoint> &list = endpoints[axis];
+                        const float *low = minimum[axis].data();
+                        const float *high = maximum[axis].data();
+
+                        for (Endpoint &point : list)
+                            point.value = ((point.data & 1) ? high[point.data >> 1] : low[point.data >> 1]);
+
+                        Sort(axis);
+                    }
+                };
+
+                // Writes up to Capacity overlapping pairs, with a < b, and returns the total
+                // number found so a caller can grow its buffer and query again.
+                std::size_t GetPairs(CollisionPair *Output, std::size_t Capacity)
+                {
+                    return (mode == Mode::MultiAxis ? GetTrackedPairs(Output, Capacity) : Sweep(Output, Capacity));
+                };
+
+            private:
+                static constexpr std::uint64_t EmptyKey = ~static_cast<std::uint64_t>(0);
+                static constexpr std::uint8_t AllAxes = 0x7;
+
+                // The low bit of data marks a maximum, the remaining bits hold the proxy.
+                struct Endpoint
+                {
+                    float value;
+                    std::uint32_t data;
+                };
+
+                struct PairEntry
+                {
+                    std::uint64_t key;
+                    std::uint8_t axes;
+                };
+
+                int Axes() const
+                {
+                    return (mode == Mode::MultiAxis ? 3 : 1);
+                };
+
+                // Minimums sort before maximums of equal value, so touching boxes overlap and the
+                // array order always agrees with the inclusive interval test.
+                static bool Precedes(const Endpoint &First, const Endpoint &Second)
+                {
+                    return (First.value < Second.value || (First.value == Second.value && !(First.data & 1) && (Second.data & 1)));
+                };
+
+                void Sort(int Axis)
+                {
+                    std::vector<Endpoint> &list = endpoints[Axis];
+                    const bool track = (mode == Mode::MultiAxis);
+
+                    for (std::size_t i = 1; i < list.size(); i++)
+                    {
+                        Endpoint key = list[i];
+                        std::size_t j = i;
+
+                        for (; j > 0 && Precedes(key, list[j - 1]); j--)
+                        {
+                            const Endpoint &previous = list[j - 1];
+
+                            if (track && ((key.data ^ previous.data) & 1))
+                            {
+                                std::uint32_t first = key.data >> 1, second = previous.data >> 1;
+
+                                // A minimum passing a maximum may start an overlap, a maximum
+                                // passing a minimum always ends one.
+                                if (!(key.data & 1))
+                                {
+                                    if (minimum[Axis][second] <= maximum[Axis][first])
+                                        SetAxis(first, second, Axis);
+                                }
+                                else
+                                    ClearAxis(first, second, Axis);
+                            }
+
+                            list[j] = previous;
+                        }
+
+                        list[j] = key;
+                    }
+                };
+
+                static std::uint64_t MakeKey(std::uint32_t First, std::uint32_t Second)
+                {
+                    return (First < Second ? (static_cast<std::uint64_t>(First) << 32) | Second : (static_cast<std::uint64_t>(Second) << 32) | First);
+                };
+
+                std::size_t Slot(std::uint64_t Key) const
+                {
+                    return static_cast<std::size_t>((Key * 0x9E3779B97F4A7C15ull) >> 32) & (table.size() - 1);
+                };
+
+                void SetAxis(std::uint32_t First, std::uint32_t Second, int Axis)
+                {
+                    std::uint64_t key = MakeKey(First, Second);
+                    std::size_t slot = Slot(key);
+
+                    while (table[slot].key != EmptyKey && table[slot].key != key)
+                        slot = (slot + 1) & (table.size() - 1);
+
+                    if (table[slot].key == key)
+                    {
+                        table[slot].axes |= static_cast<std::uint8_t>(1u << Axis);
+                        return;
+                    }
+
+                    table[slot] = PairEntry{key, static_cast<std::uint8_t>(1u << Axis)};
+
+                    if (++tableCount * 2 > table.size())
+                        Grow();
+                };
+
+                void ClearAxis(std::uint32_t First, std::uint32_t Second, int Axis)
+                {
+                    std::uint64_t key = MakeKey(First, Second);
+                    std::size_t slot = Slot(key);
+
+                    while (table[slot].key != EmptyKey && table[slot].key != key)
+                        slot = (slot + 1) & (table.size() - 1);
+
+                    if (table[slot].key != key)
+                        return;
+
+                    table[slot].axes &= static_cast<std::uint8_t>(~(1u << Axis));
+
+                    if (table[slot].axes == 0)
+                        Erase(slot);
+                };
+
+                // Backward shift deletion keeps the linear probing chains free of tombstones.
+                void Erase(std::size_t Position)
+                {
+                    const std::size_t mask = table.size() - 1;
+                    std::size_t hole = Position;
+
+                    for (std::size_t next = (hole + 1) & mask; table[next].key != EmptyKey; next = (next + 1) & mask)
+                    {
+                        std::size_t home = Slot(table[next].key);
+
+                        // Move the entry back unless its home lies cyclically in (hole, next].
+                        if (((next - home) & mask) >= ((next - hole) & mask))
+                        {
+                            table[hole] = table[next];
+                            hole = next;
+                        }
+                    }
+
+                    table[hole].key = EmptyKey;
+                    table[hole].axes = 0;
+                    tableCount--;
+                };
+
+                void Grow()
+                {
+                    std::vector<PairEntry> previous(table.size() * 2, PairEntry{EmptyKey, 0});
+                    previous.swap(table);
+
+                    for (const PairEntry &entry : previous)
+                    {
+                        if (entry.key == EmptyKey)
+                            continue;
+
+                        std::size_t slot = Slot(entry.key);
+
+                        while (table[slot].key != EmptyKey)
+                            slot = (slot + 1) & (table.size() - 1);
+
+                        table[slot] = entry;
+                    }
+                };
+
+                std::size_t GetTrackedPairs(CollisionPair *Output, std::size_t Capacity) const
+                {
+                    std::size_t count = 0;
+
+                    for (const PairEntry &entry : table)
+                    {
+                        if (entry.key == EmptyKey || entry.axes != AllAxes)
+                            continue;
+
+                        if (count < Capacity)
+                            Output[count] = CollisionPair{static_cast<std::uint32_t>(entry.key >> 32), static_cast<std::uint32_t>(entry.key)};
+
+                        count++;
+                    }
+
+                    return count;
+                };
+
+                std::size_t Sweep(CollisionPair *Output, std::size_t Capacity)
+                {
+                    using namespace Math;
+
+                    float *activeMinimumY = active[0].data();
+                    float *activeMaximumY = active[1].data();
+                    float *activeMinimumZ = active[2].data();
+                    float *activeMaximumZ = active[3].data();
+                    std::uint32_t *proxies = activeProxies.data();
+                    std::uint32_t overlaps[WARLOCK_SIMD_WIDTH];
+                    std::size_t activeCount = 0;
+                    std::size_t count = 0;
+
+                    for (const Endpoint &point : endpoints[0])
+                    {
+                        std::uint32_t proxy = point.data >> 1;
+
+                        if (point.data & 1)
+                        {
+                            std::uint32_t slot = activeSlot[proxy];
+                            std::uint32_t last = static_cast<std::uint32_t>(--activeCount);
+
+                            activeMinimumY[slot] = activeMinimumY[last];
+                            activeMaximumY[slot] = activeMaximumY[last];
+                            activeMinimumZ[slot] = activeMinimumZ[last];
+                            activeMaximumZ[slot] = activeMaximumZ[last];
+                            proxies[slot] = proxies[last];
+                            activeSlot[proxies[slot]] = slot;
+                            continue;
+                        }
+
+                        const SimdFloat minimumY(minimum[1][proxy]), maximumY(maximum[1][proxy]);
+                        const SimdFloat minimumZ(minimum[2][proxy]), maximumZ(maximum[2][proxy]);
+
+                        for (std::size_t i = 0; i < activeCount; i += WARLOCK_SIMD_WIDTH)
+                        {
+                            SimdMask overlap = (SimdFloat::Load(activeMinimumY + i) <= maximumY) & (minimumY <= SimdFloat::Load(activeMaximumY + i)) &
+                                               (SimdFloat::Load(activeMinimumZ + i) <= maximumZ) & (minimumZ <= SimdFloat::Load(activeMaximumZ + i));
+                            int bits = overlap.Bits();
+
+                            if (activeCount - i < WARLOCK_SIMD_WIDTH)
+                                bits &= (1 << (activeCount - i)) - 1;
+
+                            if (!bits)
+                                continue;
+
+                            int found = CompressStore(SimdInt::Load(proxies + i), bits, overlaps);
+
+                            for (int k = 0; k < found; k++)
+                            {
+                                if (count < Capacity)
+                                    Output[count] = (overlaps[k] < proxy ? CollisionPair{overlaps[k], proxy} : CollisionPair{proxy, overlaps[k]});
+
+                                count++;
+                            }
+                        }
+
+                        activeMinimumY[activeCount] = minimum[1][proxy];
+                        activeMaximumY[activeCount] = maximum[1][proxy];
+                        activeMinimumZ[activeCount] = minimum[2][proxy];
+                        activeMaximumZ[activeCount] = maximum[2][proxy];
+                        proxies[activeCount] = proxy;
+                        activeSlot[proxy] = static_cast<std::uint32_t>(activeCount++);
+                    }
+
+                    return count;
+                };
+
+                Mode mode;
+                std::size_t proxyCount;
+                std::size_t tableCount;
+                std::vector<bool> alive;
+                std::vector<std::uint32_t> freeProxies;
+                std::vector<float> minimum[3];
+                std::vector<float> maximum[3];
+                std::vector<Endpoint> endpoints[3];
+                std::vector<PairEntry> table;
+                std::vector<float> active[4];
+                std::vector<std::uint32_t> activeProxies;
+                std::vector<std::uint32_t> activeSlot;
+        };
+    };
+};
+
+#endif // WARLOCK_PHYSICS_SWEEPANDPRUNE_HPP
@@ -0,0 +1,377 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Platform/Clock.hpp
+// Description: Calibrated monotonic clock and precise sleeping.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_PLATFORM_CLOCK_HPP
+#define WARLOCK_PLATFORM_CLOCK_HPP
+
+#include "Platform.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+
+#if (WARLOCK_ARCHITECTURE_X86 || WARLOCK_ARCHITECTURE_X64)
+#if _MSC_VER
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#include <x86intrin.h>
+#endif
+#endif
+
+#if !(WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+#include <cerrno>
+#include <time.h>
+#endif
+
+namespace Warlock
+{
+    namespace Platform
+    {
+        constexpr std::int64_t NanosecondsPerSecond = 1000000000;
+
+        // How long the time stamp counter is measured against the system clock on first use.
+        constexpr std::int64_t ClockCalibrationNanoseconds = 20000000;
+
+        namespace Detail
+        {
+            // The system monotonic clock; a system call or a shared page read, tens of
+            // nanoseconds on current systems.
+            inline std::int64_t GetSystemNanoseconds()
+            {
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+                static const std::int64_t frequency = []()
+                {
+                    LARGE_INTEGER value;
+                    QueryPerformanceFrequency(&value);
+
+                    return static_cast<std::int64_t>(value.QuadPart);
+                }();
+
+                LARGE_INTEGER counter;
+                QueryPerformanceCounter(&counter);
+
+                const std::int64_t ticks = counter.QuadPart;
+
+                return (ticks / frequency) * NanosecondsPerSecond + (ticks % frequency) * NanosecondsPerSecond / frequency;
+#else
+                timespec now;
+                clock_gettime(CLOCK_MONOTONIC, &now);
+
+                return static_cast<std::int64_t>(now.tv_sec) * NanosecondsPerSecond + now.tv_nsec;
+#endif
+            };
+
+            // Sleeps for about Nanoseconds, usually a little longer; the overshoot is what the
+            // scheduler measures and spins away.
+            inline void SleepSystem(std::int64_t Nanoseconds)
+            {
+                if (Nanoseconds <= 0)
+                    return;
+
+#if (WARLOCK_SYSTEM_WINDOWS_X86 || WARLOCK_SYSTEM_WINDOWS_X64)
+#ifndef CREATE_WAITABLE_TIMER_HIGH_RESOLUTION
+#define CREATE_WAITABLE_TIMER_HIGH_RESOLUTION 0x00000002
+#endif
+                // High resolution timers wake within about half a millisecond of the due time;
+                // before Windows 10 1803 this falls back to Sleep and its scheduler tick.
+                thread_local HANDLE timer = CreateWaitableTimerExW(nullptr, nullptr, CREATE_WAITABLE_TIMER_HIGH_RESOLUTION, TIMER_ALL_ACCESS);
+
+                if (timer)
+                {
+                    LARGE_INTEGER due;
+                    due.QuadPart = -std::max<std::int64_t>(Nanoseconds / 100, 1);
+
+                    if (SetWaitableTimerEx(timer, &due, 0, nullptr, nullptr, nullptr, 0))
+                    {
+                        WaitForSingleObject(timer, INFINITE);
+                        return;
+                    }
+                }
+
+                Sleep(static_cast<DWORD>(Nanoseconds / 1000000));
+#else
+                timespec remaining;
+                remaining.tv_sec = static_cast<time_t>(Nanoseconds / NanosecondsPerSecond);
+                remaining.tv_nsec = static_cast<long>(Nanoseconds % NanosecondsPerSecond);
+
+                while (nanosleep(&remaining, &remaining) != 0 && errno == EINTR)
+                    continue;
+#endif
+            };
+
+            // Spin loop hint; lets the sibling hyper thread run and saves power while spinning.
+            inline void Pause()
+            {
+#if (WARLOCK_ARCHITECTURE_X86 || WARLOCK_ARCHITECTURE_X64)
+                _mm_pause();
+#elif (WARLOCK_ARCHITECTURE_ARM || WARLOCK_ARCHITECTURE_ARM64) && !_MSC_VER
+                __asm__ __volatile__("yield");
+#elif (WARLOCK_ARCHITECTURE_ARM || WARLOCK_ARCHITECTURE_ARM64)
+                __yield();
+#endif
+            };
+
+            // An invariant counter runs at a constant rate through frequency and power state
+            // changes, and is synchronized between cores on every processor that reports it.
+            inline bool HasInvariantTsc()
+            {
+#if (WARLOCK_ARCHITECTURE_X86 || WARLOCK_ARCHITECTURE_X64)
+#if _MSC_VER
+                int registers[4];
+                __cpuid(registers, 0x80000000);
+
+                if (static_cast<unsigned int>(registers[0]) < 0x80000007)
+                    return false;
+
+                __cpuid(registers, 0x80000007);
+
+                return ((registers[3] & (1 << 8)) != 0);
+#else
+                unsigned int eax, ebx, ecx, edx;
+
+                if (!__get_cpuid(0x80000007, &eax, &ebx, &ecx, &edx))
+                    return false;
+
+                return ((edx & (1u << 8)) != 0);
+#endif
+#else
+                return false;
+#endif
+            };
+
+            inline std::uint64_t ReadTsc()
+            {
+#if (WARLOCK_ARCHITECTURE_X86 || WARLOCK_ARCHITECTURE_X64)
+                return __rdtsc();
+#else
+                return 0;
+#endif
+            };
+
+            // Matches a system clock reading with a counter reading. Each try brackets the system
+            // clock with two counter reads and takes their midpoint; the narrowest bracket of a
+            // few wins, so a thread switch in the middle of one does not skew the pair.
+            inline void ReadClockPair(std::uint64_t &Tsc, std::int64_t &System)
+            {
+                std::uint64_t narrowest = ~static_cast<std::uint64_t>(0);
+
+                for (int i = 0; i < 4; i++)
+                {
+                    const std::uint64_t before = ReadTsc();
+                    const std::int64_t system = GetSystemNanoseconds();
+                    const std::uint64_t width = ReadTsc() - before;
+
+                    if (width < narrowest)
+                    {
+                        narrowest = width;
+                        Tsc = before + width / 2;
+                        System = system;
+                    }
+                }
+            };
+        };
+
+        // Monotonic nanoseconds, on the time base of the system monotonic clock.
+        //
+        // On x86 processors with an invariant time stamp counter the clock reads the counter, a
+        // few nanoseconds against tens for the system clock, scaled by a rate measured against
+        // the system clock when the clock is created. Elsewhere, or if the measured rate is not
+        // plausible, it reads the system clock directly. The 20 millisecond calibration leaves a
+        // rate error of tens of parts per million (30 to 70 measured), under a microsecond over a
+        // frame but milliseconds over minutes; Recalibrate measures over the whole time since
+        // creation instead, and a few seconds bring the error to ten parts per million or less.
+        // Readings of different clocks drift apart by the error, so compare intervals.
+        //
+        // The default clock calibrates on first use, which blocks for about 20 milliseconds.
+        class Clock
+        {
+            public:
+                explicit Clock(bool UseTsc = true)
+                {
+                    start = Detail::GetSystemNanoseconds();
+
+                    if (!UseTsc || !Detail::HasInvariantTsc())
+                        return;
+
+                    std::uint64_t firstTsc, lastTsc;
+                    std::int64_t firstSystem, lastSystem;
+
+                    Detail::ReadClockPair(firstTsc, firstSystem);
+                    Detail::SleepSystem(ClockCalibrationNanoseconds);
+                    Detail::ReadClockPair(lastTsc, lastSystem);
+
+                    const double elapsedTicks = static_cast<double>(lastTsc - firstTsc);
+                    const double elapsedNanoseconds = static_cast<double>(lastSystem - firstSystem);
+
+                    if (elapsedTicks <= 0.0 || elapsedNanoseconds <= 0.0)
+                        return;
+
+                    const double frequency = elapsedTicks * NanosecondsPerSecond / elapsedNanoseconds;
+
+                    // Below 100 MHz or above 10 GHz the counter is not what it claims to be.
+                    if (frequency < 1.0e8 || frequency > 1.0e10)
+                        return;
+
+                    ticksPerSecond.store(frequency, std::memory_order_relaxed);
+                    nanosecondsPerTick.store(elapsedNanoseconds / elapsedTicks, std::memory_order_relaxed);
+                    baseTsc.store(firstTsc, std::memory_order_relaxed);
+                    base.store(firstSystem, std::memory_order_relaxed);
+                    startTsc = firstTsc;
+                    start = firstSystem;
+                    useTsc = true;
+                };
+
+                Clock(const Clock &) = delete;
+                Clock &operator =(const Clock &) = delete;
+
+                // Measures the counter rate again over the time since the clock was created and
+                // continues from the current reading with it, so the clock never steps. Call it
+                // now and then, every few seconds at first, from any thread: the new calibration
+                // is published under a sequence count that readers retry around, and a call made
+                // while another is running returns at once.
+                void Recalibrate()
+                {
+                    if (!useTsc)
+                        return;
+
+                    std::uint32_t current = sequence.load(std::memory_order_relaxed);
+
+                    if ((current & 1) || !sequence.compare_exchange_strong(current, current + 1, std::memory_order_acquire))
+                        return;
+
+                    std::atomic_thread_fence(std::memory_order_release);
+
+                    std::uint64_t tsc;
+                    std::int64_t system;
+
+                    Detail::ReadClockPair(tsc, system);
+
+                    const double elapsedTicks = static_cast<double>(tsc - startTsc);
+                    const double elapsedNanoseconds = static_cast<double>(system - start);
+
+                    if (elapsedTicks > 0.0 && elapsedNanoseconds > 0.0)
+                    {
+                        const double scale = nanosecondsPerTick.load(std::memory_order_relaxed);
+                        const std::uint64_t originTsc = baseTsc.load(std::memory_order_relaxed);
+
+                        // Rounded, not truncated, so frequent calls do not lose time.
+                        base.store(base.load(std::memory_order_relaxed) + std::llround(static_cast<double>(tsc - originTsc) * scale), std::memory_order_relaxed);
+                        baseTsc.store(tsc, std::memory_order_relaxed);
+                        ticksPerSecond.store(elapsedTicks * NanosecondsPerSecond / elapsedNanoseconds, std::memory_order_relaxed);
+                        nanosecondsPerTick.store(elapsedNanoseconds / elapsedTicks, std::memory_order_relaxed);
+                    }
+
+                    sequence.store(current + 2, std::memory_order_release);
+                };
+
+                static Clock &GetDefault()
+                {
+                    static Clock clock;
+                    return clock;
+                };
+
+                std::int64_t GetNanoseconds() const
+                {
+                    if (!useTsc)
+                        return Detail::GetSystemNanoseconds();
+
+                    for (;;)
+                    {
+                        const std::uint32_t before = sequence.load(std::memory_order_acquire);
+                        const std::int64_t origin = base.load(std::memory_order_relaxed);
+                        const std::uint64_t originTsc = baseTsc.load(std::memory_order_relaxed);
+                        const double scale = nanosecondsPerTick.load(std::memory_order_relaxed);
+                        const std::uint64_t tsc = Detail::ReadTsc();
+
+                        std::atomic_thread_fence(std::memory_order_acquire);
+
+                        if (!(before & 1) && sequence.load(std::memory_order_relaxed) == before)
+                            return origin + static_cast<std::int64_t>(static_cast<double>(tsc - originTsc) * scale);
+
+                        Detail::Pause();
+                    }
+                };
+
+                // Seconds since the clock was created.
+                double GetSeconds() const
+                {
+                    return static_cast<double>(GetNanoseconds() - start) / NanosecondsPerSecond;
+                };
+
+                // The reading the clock started from; GetNanoseconds counts up from here.
+                std::int64_t GetStart() const
+                {
+                    return start;
+                };
+
+                bool IsUsingTsc() const
+                {
+                    return useTsc;
+                };
+
+                // The measured counter rate, or zero when the system clock is used.
+                double GetTscFrequency() const
+                {
+                    return ticksPerSecond.load(std::memory_order_relaxed);
+                };
+
+                // Sleeps through most of the wait and spins through the rest, returning at or
+                // just after Deadline. SpinNanoseconds is how early to stop sleeping; it must
+                // cover the system's wake up latency. Returns how far past its planned wake up
+                // the sleep ran, or zero if it did not sleep.
+                std::int64_t SleepUntil(std::int64_t Deadline, std::int64_t SpinNanoseconds) const
+                {
+                    std::int64_t now = GetNanoseconds();
+                    std::int64_t overshoot = 0;
+
+                    if (Deadline - now > SpinNanoseconds)
+                    {
+                        const std::int64_t wake = Deadline - SpinNanoseconds;
+
+                        Detail::SleepSystem(wake - now);
+                        now = GetNanoseconds();
+                        overshoot = std::max<std::int64_t>(now - wake, 0);
+                    }
+
+                    while (now < Deadline)
+                    {
+                        Detail::Pause();
+                        now = GetNanoseconds();
+                    }
+
+                    return overshoot;
+                };
+
+            private:
+                std::int64_t start = 0;
+                std::uint64_t startTsc = 0;
+                bool useTsc = false;
+
+                // The calibration in use; odd sequence counts mark a recalibration in progress.
+                std::atomic<std::uint32_t> sequence{0};
+                std::atomic<std::int64_t> base{0};
+                std::atomic<std::uint64_t> baseTsc{0};
+                std::atomic<double> nanosecondsPerTick{0.0};
+                std::atomic<double> ticksPerSecond{0.0};
+        };
+    };
+};
+
+#endif // WARLOCK_PLATFORM_CLOCK_HPP
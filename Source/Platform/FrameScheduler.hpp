@@ -0,0 +1,289 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Platform/FrameScheduler.hpp
+// Description: Fixed timestep frame loop with precise pacing and per frame budgets.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_PLATFORM_FRAMESCHEDULER_HPP
+#define WARLOCK_PLATFORM_FRAMESCHEDULER_HPP
+
+#include "Clock.hpp"
+#include <algorithm>
+#include <cstdint>
+
+namespace Warlock
+{
+    namespace Platform
+    {
+        struct FrameSchedulerSettings
+        {
+            // Simulation steps per second.
+            double stepRate = 60.0;
+
+            // Frames per second; zero runs frames back to back without pacing.
+            double frameRate = 60.0;
+
+            // Steps one frame may run to catch up; simulation time beyond is dropped so a slow
+            // frame does not make the next one slower.
+            unsigned int maximumSteps = 8;
+
+            // Bounds for how early the pacer stops sleeping and starts spinning. The pacer
+            // learns the system's wake up latency and spins twice that, within these bounds.
+            std::int64_t minimumSpinNanoseconds = 200000;
+            std::int64_t maximumSpinNanoseconds = 4000000;
+        };
+
+        // What a frame does, from FrameScheduler::BeginFrame.
+        struct FrameTime
+        {
+            std::uint64_t frame;
+
+            // Simulation steps to run this frame, each of stepSeconds.
+            unsigned int steps;
+            double stepSeconds;
+
+            // How far between the last step and the next the frame is, in [0, 1); renderers
+            // blend the previous and current simulation states by it.
+            double alpha;
+
+            // Scheduled time since the previous frame.
+            double deltaSeconds;
+
+            // When the frame was due and when it started, in clock nanoseconds.
+            std::int64_t deadline;
+            std::int64_t start;
+        };
+
+        struct FrameStatistics
+        {
+            std::uint64_t frames = 0;
+
+            // Frames whose work ran past the next frame's deadline.
+            std::uint64_t overruns = 0;
+
+            // Times the scheduler gave up on its frame grid after falling a whole frame behind.
+            std::uint64_t resynchronizations = 0;
+
+            std::uint64_t shedTasks = 0;
+            std::uint64_t droppedSteps = 0;
+
+            // How late frames started against their deadlines, and how long their work took.
+            std::int64_t maximumLateness = 0;
+            std::int64_t totalLateness = 0;
+            std::int64_t maximumWork = 0;
+            std::int64_t totalWork = 0;
+        };
+
+        // Optional work with a learned cost; see FrameScheduler::RunOptional.
+        struct FrameTask
+        {
+            std::int64_t estimate = 0;
+            std::uint64_t runs = 0;
+            std::uint64_t shed = 0;
+        };
+
+        // Runs a fixed timestep simulation at its own rate under paced frames:
+        //
+        //   FrameScheduler scheduler(settings);
+        //
+        //   while (running)
+        //   {
+        //       FrameTime time = scheduler.BeginFrame();
+        //
+        //       for (unsigned int i = 0; i < time.steps; i++)
+        //           Simulate(time.stepSeconds);
+        //
+        //       Render(time.alpha);
+        //       scheduler.RunOptional(statisticsTask, [&]() { UpdateStatistics(); });
+        //       scheduler.EndFrame();
+        //   }
+        //
+        // Frames are due on a fixed grid, frame n at the start plus n periods, so lateness in
+        // one frame does not push back the next. BeginFrame sleeps until just before the
+        // deadline and spins the rest, which keeps frame starts within tens of microseconds of
+        // the grid where the system's sleep overshoots by up to milliseconds. Simulation time
+        // advances by the scheduled period, not the measured one, so the step count of a paced
+        // frame does not jitter with its start. A frame that falls more than a period behind
+        // starts a new grid.
+        class FrameScheduler
+        {
+            public:
+                explicit FrameScheduler(const FrameSchedulerSettings &Settings = FrameSchedulerSettings(), const Clock &FrameClock = Clock::GetDefault()) : clock(FrameClock), settings(Settings)
+                {
+                    stepNanoseconds = std::max<std::int64_t>(static_cast<std::int64_t>(NanosecondsPerSecond / settings.stepRate), 1);
+                    frameNanoseconds = (settings.frameRate > 0.0) ? std::max<std::int64_t>(static_cast<std::int64_t>(NanosecondsPerSecond / settings.frameRate), 1) : 0;
+                    wakeLatency = settings.minimumSpinNanoseconds / 2;
+
+                    Reset();
+                };
+
+                // Starts a new grid at the current time, with an empty step accumulator.
+                void Reset()
+                {
+                    nextDeadline = clock.GetNanoseconds();
+                    previousDeadline = nextDeadline;
+                    frameStart = nextDeadline;
+                    accumulator = 0;
+                    frame = 0;
+                };
+
+                // Waits for the next frame's deadline and works out its steps.
+                FrameTime BeginFrame()
+                {
+                    std::int64_t deadline = nextDeadline;
+                    std::int64_t now = clock.GetNanoseconds();
+
+                    if (frameNanoseconds == 0)
+                        deadline = now;
+                    else if (now - deadline > frameNanoseconds)
+                    {
+                        deadline = now;
+                        statistics.resynchronizations++;
+                    }
+                    else if (now < deadline)
+                    {
+                        const std::int64_t overshoot = clock.SleepUntil(deadline, GetSpinNanoseconds());
+
+                        // Rise to a new worst case at once, forget it over a few hundred frames.
+                        wakeLatency = std::max(overshoot, wakeLatency - wakeLatency / 64);
+                        now = clock.GetNanoseconds();
+                    }
+
+                    const std::int64_t lateness = std::max<std::int64_t>(now - deadline, 0);
+
+                    statistics.frames++;
+                    statistics.maximumLateness = std::max(statistics.maximumLateness, lateness);
+                    statistics.totalLateness += lateness;
+
+                    FrameTime time;
+                    time.frame = frame++;
+                    time.deadline = deadline;
+                    time.start = now;
+                    time.deltaSeconds = static_cast<double>(deadline - previousDeadline) / NanosecondsPerSecond;
+                    time.stepSeconds = static_cast<double>(stepNanoseconds) / NanosecondsPerSecond;
+
+                    accumulator += deadline - previousDeadline;
+
+                    std::int64_t steps = accumulator / stepNanoseconds;
+                    accumulator -= steps * stepNanoseconds;
+
+                    if (steps > static_cast<std::int64_t>(settings.maximumSteps))
+                    {
+                        statistics.droppedSteps += static_cast<std::uint64_t>(steps - settings.maximumSteps);
+                        steps = settings.maximumSteps;
+                    }
+
+                    time.steps = static_cast<unsigned int>(steps);
+                    time.alpha = static_cast<double>(accumulator) / static_cast<double>(stepNanoseconds);
+
+                    previousDeadline = deadline;
+                    nextDeadline = deadline + frameNanoseconds;
+                    frameStart = now;
+
+                    return time;
+                };
+
+                // Ends the frame's work; only the statistics depend on it.
+                void EndFrame()
+                {
+                    const std::int64_t now = clock.GetNanoseconds();
+                    const std::int64_t work = now - frameStart;
+
+                    if (frameNanoseconds != 0 && now > nextDeadline)
+                        statistics.overruns++;
+
+                    statistics.maximumWork = std::max(statistics.maximumWork, work);
+                    statistics.totalWork += work;
+                };
+
+                // Time left before the next frame is due; negative once the frame runs over.
+                // Unpaced frames are budgeted one step.
+                std::int64_t GetRemainingNanoseconds() const
+                {
+                    const std::int64_t end = (frameNanoseconds != 0) ? nextDeadline : frameStart + stepNanoseconds;
+
+                    return end - clock.GetNanoseconds();
+                };
+
+                bool IsOverBudget() const
+                {
+                    return (GetRemainingNanoseconds() < 0);
+                };
+
+                // Runs Work if what is left of the frame covers its expected cost, and learns the
+                // cost from the run; otherwise sheds it for this frame. The estimate follows a
+                // slower run at once and a faster one gradually, and decays while shed, so a task
+                // that was expensive once is tried again.
+                template <typename Function>
+                bool RunOptional(FrameTask &Task, Function &&Work)
+                {
+                    if (GetRemainingNanoseconds() < Task.estimate)
+                    {
+                        Task.estimate -= Task.estimate / 16;
+                        Task.shed++;
+                        statistics.shedTasks++;
+
+                        return false;
+                    }
+
+                    const std::int64_t start = clock.GetNanoseconds();
+                    Work();
+                    const std::int64_t cost = clock.GetNanoseconds() - start;
+
+                    Task.estimate = (cost > Task.estimate) ? cost : Task.estimate - (Task.estimate - cost) / 8;
+                    Task.runs++;
+
+                    return true;
+                };
+
+                // How early BeginFrame stops sleeping.
+                std::int64_t GetSpinNanoseconds() const
+                {
+                    return std::min(std::max(wakeLatency * 2, settings.minimumSpinNanoseconds), settings.maximumSpinNanoseconds);
+                };
+
+                const FrameStatistics &GetStatistics() const
+                {
+                    return statistics;
+                };
+
+                void ResetStatistics()
+                {
+                    statistics = FrameStatistics();
+                };
+
+                const FrameSchedulerSettings &GetSettings() const
+                {
+                    return settings;
+                };
+
+            private:
+                const Clock &clock;
+                FrameSchedulerSettings settings;
+                FrameStatistics statistics;
+                std::int64_t stepNanoseconds;
+                std::int64_t frameNanoseconds;
+                std::int64_t wakeLatency;
+                std::int64_t nextDeadline;
+                std::int64_t previousDeadline;
+                std::int64_t frameStart;
+                std::int64_t accumulator;
+                std::uint64_t frame;
+        };
+    };
+};
+
+#endif // WARLOCK_PLATFORM_FRAMESCHEDULER_HPP
@@ -100,6 +100,33 @@ static constexpr auto WCS_SIZE_UNSIGNED_LONG_LONG = WARLOCK_SIZE_UNSIGNED_LONG_L
 #define WARLOCK_ARCHITECTURE_MIPS 1
 #endif // WARLOCK_ARCHITECTURE_MIPS
 
+//-------------------------------------------------------------------------------------------------
+// Target instruction set detection
+//-------------------------------------------------------------------------------------------------
+#if (_M_AMD64 || _M_X64 || _M_IX86_FP >= 2)
+#define WARLOCK_INSTRUCTION_SET_SSE2 1
+#endif // WARLOCK_INSTRUCTION_SET_SSE2
+
+#if (__AVX__ || __AVX2__)
+#define WARLOCK_INSTRUCTION_SET_SSE4_1 1
+#define WARLOCK_INSTRUCTION_SET_AVX 1
+#endif // WARLOCK_INSTRUCTION_SET_AVX
+
+#if __AVX2__
+#define WARLOCK_INSTRUCTION_SET_AVX2 1
+#define WARLOCK_INSTRUCTION_SET_FMA 1
+#define WARLOCK_INSTRUCTION_SET_F16C 1
+#define WARLOCK_INSTRUCTION_SET_BMI2 1
+#endif // WARLOCK_INSTRUCTION_SET_AVX2
+
+#if __AVX512F__
+#define WARLOCK_INSTRUCTION_SET_AVX512F 1
+#endif // WARLOCK_INSTRUCTION_SET_AVX512F
+
+#if (_M_ARM64 || _M_ARM)
+#define WARLOCK_INSTRUCTION_SET_NEON 1
+#endif // WARLOCK_INSTRUCTION_SET_NEON
+
 //-------------------------------------------------------------------------------------------------
 // Target build type detection
 //-------------------------------------------------------------------------------------------------
@@ -306,6 +333,45 @@ static constexpr auto WCS_SIZE_UNSIGNED_LONG_LONG = WARLOCK_SIZE_UNSIGNED_LONG_L
 #define WARLOCK_ARCHITECTURE_MIPS 1
 #endif // WARLOCK_ARCHITECTURE_MIPS
 
+//-------------------------------------------------------------------------------------------------
+// Target instruction set detection
+//-------------------------------------------------------------------------------------------------
+#if __SSE2__
+#define WARLOCK_INSTRUCTION_SET_SSE2 1
+#endif // WARLOCK_INSTRUCTION_SET_SSE2
+
+#if __SSE4_1__
+#define WARLOCK_INSTRUCTION_SET_SSE4_1 1
+#endif // WARLOCK_INSTRUCTION_SET_SSE4_1
+
+#if __AVX__
+#define WARLOCK_INSTRUCTION_SET_AVX 1
+#endif // WARLOCK_INSTRUCTION_SET_AVX
+
+#if __AVX2__
+#define WARLOCK_INSTRUCTION_SET_AVX2 1
+#endif // WARLOCK_INSTRUCTION_SET_AVX2
+
+#if __FMA__
+#define WARLOCK_INSTRUCTION_SET_FMA 1
+#endif // WARLOCK_INSTRUCTION_SET_FMA
+
+#if __F16C__
+#define WARLOCK_INSTRUCTION_SET_F16C 1
+#endif // WARLOCK_INSTRUCTION_SET_F16C
+
+#if __BMI2__
+#define WARLOCK_INSTRUCTION_SET_BMI2 1
+#endif // WARLOCK_INSTRUCTION_SET_BMI2
+
+#if __AVX512F__
+#define WARLOCK_INSTRUCTION_SET_AVX512F 1
+#endif // WARLOCK_INSTRUCTION_SET_AVX512F
+
+#if (__ARM_NEON || __ARM_NEON__)
+#define WARLOCK_INSTRUCTION_SET_NEON 1
+#endif // WARLOCK_INSTRUCTION_SET_NEON
+
 //-------------------------------------------------------------------------------------------------
 // Target build type detection
 //-------------------------------------------------------------------------------------------------
@@ -0,0 +1,486 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Source/Scene/TransformHierarchy.hpp
+// Description: Parent/child transform hierarchy with lazy breadth-first world updates.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#ifndef WARLOCK_SCENE_TRANSFORMHIERARCHY_HPP
+#define WARLOCK_SCENE_TRANSFORMHIERARCHY_HPP
+
+#include "Core/ThreadPool.hpp"
+#include "Math/Simd.hpp"
+#include "Math/Vector3.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Warlock
+{
+    namespace Scene
+    {
+        // Row major 3x4 affine transform; the implied last row is (0, 0, 0, 1) and column 3
+        // holds the translation.
+        struct Transform
+        {
+            static Transform Identity()
+            {
+                return Translation(Math::Vector3<float>(0.0f));
+            };
+
+            static Transform Translation(const Math::Vector3<float> &Offset)
+            {
+                Transform result;
+
+                for (int r = 0; r < 3; r++)
+                {
+                    for (int c = 0; c < 3; c++)
+                        result.m[r][c] = (r == c ? 1.0f : 0.0f);
+                }
+
+                result.m[0][3] = Offset.x;
+                result.m[1][3] = Offset.y;
+                result.m[2][3] = Offset.z;
+
+                return result;
+            };
+
+            Math::Vector3<float> GetTranslation() const
+            {
+                return Math::Vector3<float>(m[0][3], m[1][3], m[2][3]);
+            };
+
+            float m[3][4];
+        };
+
+        inline Transform Multiply(const Transform &First, const Transform &Second)
+        {
+            Transform result;
+
+            for (int r = 0; r < 3; r++)
+            {
+                for (int c = 0; c < 4; c++)
+                    result.m[r][c] = First.m[r][0] * Second.m[0][c] + First.m[r][1] * Second.m[1][c] + First.m[r][2] * Second.m[2][c] + (c == 3 ? First.m[r][3] : 0.0f);
+            }
+
+            return result;
+        };
+
+        // Nodes are stored breadth first: every depth level is a contiguous slice of the arrays
+        // and the children of a node are contiguous in the next level, ordered like their
+        // parents. The descendants of a node therefore form one contiguous range per level,
+        // which is what lets a dirty subtree be updated as a handful of dense ranges.
+        //
+        // SetLocal only flags the node; Update walks the levels top down, recomputing world
+        // transforms for the flagged subtrees alone, so static parts of the scene cost nothing.
+        // Structural changes rebuild the layout on the next Update.
+        class TransformHierarchy
+        {
+            public:
+                typedef std::uint32_t Node;
+
+                static constexpr Node InvalidNode = 0xFFFFFFFF;
+                static constexpr std::size_t UpdateGrain = 1024;
+
+                TransformHierarchy() : layoutDirty(false)
+                {
+                    // Handle 0 is a hidden root with an identity transform that parents every
+                    // user root, so the update kernel never special cases missing parents.
+                    handles.push_back(HandleRecord{0, 0, true, false});
+                    AppendSlot(0, Transform::Identity());
+                    parentSlot[0] = 0;
+                    levels.assign(1, 0);
+                    levels.push_back(1);
+                };
+
+                Node Create(Node Parent = InvalidNode, const Transform &Local = Transform::Identity())
+                {
+                    Node node;
+
+                    if (!freeHandles.empty())
+                    {
+                        node = freeHandles.back();
+                        freeHandles.pop_back();
+                    }
+                    else
+                    {
+                        node = static_cast<Node>(handles.size());
+                        handles.push_back(HandleRecord{});
+                    }
+
+                    handles[node] = HandleRecord{(Parent == InvalidNode ? 0 : Parent), static_cast<std::uint32_t>(handleOf.size()), true, false};
+                    AppendSlot(node, Local);
+                    MarkDirty(node);
+                    layoutDirty = true;
+
+                    return node;
+                };
+
+                // Destroys the node along with its whole subtree; their handles are recycled by
+                // the next Update.
+                void Destroy(Node Target)
+                {
+                    if (!IsAlive(Target))
+                        return;
+
+                    handles[Target].alive = false;
+                    layoutDirty = true;
+                };
+
+                void SetParent(Node Target, Node Parent)
+                {
+                    if (!IsAlive(Target))
+                        return;
+
+                    handles[Target].parent = (Parent == InvalidNode ? 0 : Parent);
+                    MarkDirty(Target);
+                    layoutDirty = true;
+                };
+
+                bool IsAlive(Node Target) const
+                {
+                    return (Target != 0 && Target < handles.size() && handles[Target].alive);
+                };
+
+                void SetLocal(Node Target, const Transform &Local)
+                {
+                    if (!IsAlive(Target))
+                        return;
+
+                    std::uint32_t slot = handles[Target].slot;
+
+                    for (int k = 0; k < 12; k++)
+                        local[k][slot] = Local.m[k / 4][k % 4];
+
+                    MarkDirty(Target);
+                };
+
+                Transform GetLocal(Node Target) const
+                {
+                    return Read(local, handles[Target].slot);
+                };
+
+                // World transform as of the last Update.
+                Transform GetWorld(Node Target) const
+                {
+                    return Read(world, handles[Target].slot);
+                };
+
+                std::size_t GetLevelCount() const
+                {
+                    return levels.size() - 1;
+                };
+
+                void Update(Core::ThreadPool &Pool = Core::ThreadPool::GetDefault())
+                {
+                    if (layoutDirty)
+                        Rebuild();
+
+                    if (dirtyHandles.empty())
+                        return;
+
+                    pending.resize(levels.size() - 1);
+
+                    for (Node node : dirtyHandles)
+                    {
+                        if (node < handles.size() && handles[node].dirty)
+                        {
+                            handles[node].dirty = false;
+
+                            if (handles[node].alive)
+                            {
+                                std::uint32_t slot = handles[node].slot;
+                                pending[levelOf[slot]].push_back(Range{slot, slot + 1});
+                            }
+                        }
+                    }
+
+                    dirtyHandles.clear();
+
+                    for (std::size_t level = 1; level < pending.size(); level++)
+                    {
+                        std::vector<Range> &ranges = pending[level];
+
+                        if (ranges.empty())
+                            continue;
+
+                        // Overlapping ranges come from a dirty node inside a dirty subtree.
+                        std::sort(ranges.begin(), ranges.end(), [](const Range &First, const Range &Second) { return First.begin < Second.begin; });
+
+                        std::size_t merged = 0;
+
+                        for (std::size_t i = 1; i < ranges.size(); i++)
+                        {
+                            if (ranges[i].begin <= ranges[merged].end)
+                                ranges[merged].end = std::max(ranges[merged].end, ranges[i].end);
+                            else
+                                ranges[++merged] = ranges[i];
+                        }
+
+                        ranges.resize(merged + 1);
+                        work.clear();
+
+                        for (const Range &range : ranges)
+                        {
+                            for (std::uint32_t first = range.begin; first < range.end; first += UpdateGrain)
+                                work.push_back(Range{first, std::min<std::uint32_t>(range.end, first + static_cast<std::uint32_t>(UpdateGrain))});
+
+                            std::uint32_t childBegin = firstChild[range.begin];
+                            std::uint32_t childEnd = lastChild[range.end - 1];
+
+                            if (childBegin < childEnd && level + 1 < pending.size())
+                                pending[level + 1].push_back(Range{childBegin, childEnd});
+                        }
+
+                        Pool.ParallelFor(0, work.size(), 1, [&](std::size_t First, std::size_t Last)
+                        {
+                            for (std::size_t i = First; i < Last; i++)
+                                Compose(work[i].begin, work[i].end);
+                        });
+
+                        ranges.clear();
+                    }
+                };
+
+            private:
+                struct HandleRecord
+                {
+                    Node parent;
+                    std::uint32_t slot;
+                    bool alive;
+                    bool dirty;
+                };
+
+                struct Range
+                {
+                    std::uint32_t begin;
+                    std::uint32_t end;
+                };
+
+                static Transform Read(const std::vector<float> *Columns, std::uint32_t Slot)
+                {
+                    Transform result;
+
+                    for (int k = 0; k < 12; k++)
+                        result.m[k / 4][k % 4] = Columns[k][Slot];
+
+                    return result;
+                };
+
+                void AppendSlot(Node Owner, const Transform &Local)
+                {
+                    for (int k = 0; k < 12; k++)
+                    {
+                        local[k].push_back(Local.m[k / 4][k % 4]);
+                        world[k].push_back(Local.m[k / 4][k % 4]);
+                    }
+
+                    handleOf.push_back(Owner);
+                    parentSlot.push_back(0);
+                    firstChild.push_back(0);
+                    lastChild.push_back(0);
+                    levelOf.push_back(0);
+                };
+
+                void MarkDirty(Node Target)
+                {
+                    if (!handles[Target].dirty)
+                    {
+                        handles[Target].dirty = true;
+                        dirtyHandles.push_back(Target);
+                    }
+                };
+
+                // world = world(parent) * local over [First, Last) of one level. Parents sit in
+                // the previous level in the same order, so the gather reads a short, mostly
+                // sequential run of it.
+                void Compose(std::uint32_t First, std::uint32_t Last)
+                {
+                    using namespace Math;
+
+                    alignas(64) float parent[12][WARLOCK_SIMD_WIDTH];
+                    std::uint32_t i = First;
+
+                    for (; i + WARLOCK_SIMD_WIDTH <= Last; i += WARLOCK_SIMD_WIDTH)
+                    {
+                        for (int lane = 0; lane < WARLOCK_SIMD_WIDTH; lane++)
+                        {
+                            std::uint32_t p = parentSlot[i + lane];
+
+                            for (int k = 0; k < 12; k++)
+                                parent[k][lane] = world[k][p];
+                        }
+
+                        SimdFloat l[12];
+
+                        for (int k = 0; k < 12; k++)
+                            l[k] = SimdFloat::Load(local[k].data() + i);
+
+                        for (int r = 0; r < 3; r++)
+                        {
+                            SimdFloat p0 = SimdFloat::LoadAligned(parent[4 * r]);
+                            SimdFloat p1 = SimdFloat::LoadAligned(parent[4 * r + 1]);
+                            SimdFloat p2 = SimdFloat::LoadAligned(parent[4 * r + 2]);
+                            SimdFloat p3 = SimdFloat::LoadAligned(parent[4 * r + 3]);
+
+                            for (int c = 0; c < 4; c++)
+                            {
+                                SimdFloat value = MulAdd(p0, l[c], MulAdd(p1, l[4 + c], p2 * l[8 + c]));
+
+                                if (c == 3)
+                                    value = value + p3;
+
+                                value.Store(world[4 * r + c].data() + i);
+                            }
+                        }
+                    }
+
+                    for (; i < Last; i++)
+                    {
+                        Transform result = Multiply(Read(world, parentSlot[i]), Read(local, i));
+
+                        for (int k = 0; k < 12; k++)
+                            world[k][i] = result.m[k / 4][k % 4];
+                    }
+                };
+
+                // Breadth first traversal from the hidden root, dropping destroyed subtrees and
+                // permuting the slot arrays into level order.
+                void Rebuild()
+                {
+                    const std::size_t handleCount = handles.size();
+                    std::vector<std::uint32_t> childCount(handleCount + 1, 0);
+                    std::vector<Node> children(handleCount);
+                    std::vector<Node> order;
+
+                    for (Node node = 1; node < handleCount; node++)
+                    {
+                        if (handles[node].alive)
+                            childCount[handles[node].parent + 1]++;
+                    }
+
+                    for (std::size_t i = 1; i <= handleCount; i++)
+                        childCount[i] += childCount[i - 1];
+
+                    {
+                        std::vector<std::uint32_t> cursor(childCount.begin(), childCount.end() - 1);
+
+                        for (Node node = 1; node < handleCount; node++)
+                        {
+                            if (handles[node].alive)
+                                children[cursor[handles[node].parent]++] = node;
+                        }
+                    }
+
+                    std::vector<float> newLocal[12], newWorld[12];
+                    std::vector<std::uint32_t> newParent, newFirst, newLast, newLevel;
+                    std::vector<bool> reached(handleCount, false);
+
+                    order.reserve(handleCount);
+                    order.push_back(0);
+                    reached[0] = true;
+                    newLevel.push_back(0);
+                    levels.assign(1, 0);
+
+                    for (std::size_t s = 0; s < order.size(); s++)
+                    {
+                        Node node = order[s];
+
+                        if (s > 0 && newLevel[s] != newLevel[s - 1])
+                            levels.push_back(static_cast<std::uint32_t>(s));
+
+                        newFirst.push_back(static_cast<std::uint32_t>(order.size()));
+
+                        // A parent that is not alive is never expanded, so a cycle made with
+                        // SetParent simply drops out of the hierarchy.
+                        for (std::uint32_t c = childCount[node]; c < childCount[node + 1]; c++)
+                        {
+                            Node child = children[c];
+
+                            if (reached[child])
+                                continue;
+
+                            reached[child] = true;
+                            order.push_back(child);
+                            newLevel.push_back(newLevel[s] + 1);
+                        }
+
+                        newLast.push_back(static_cast<std::uint32_t>(order.size()));
+                    }
+
+                    levels.push_back(static_cast<std::uint32_t>(order.size()));
+
+                    for (int k = 0; k < 12; k++)
+                    {
+                        newLocal[k].resize(order.size());
+                        newWorld[k].resize(order.size());
+
+                        for (std::size_t s = 0; s < order.size(); s++)
+                        {
+                            newLocal[k][s] = local[k][handles[order[s]].slot];
+                            newWorld[k][s] = world[k][handles[order[s]].slot];
+                        }
+
+                        local[k].swap(newLocal[k]);
+                        world[k].swap(newWorld[k]);
+                    }
+
+                    for (std::size_t s = 0; s < order.size(); s++)
+                        handles[order[s]].slot = static_cast<std::uint32_t>(s);
+
+                    newParent.resize(order.size());
+
+                    for (std::size_t s = 0; s < order.size(); s++)
+                        newParent[s] = (s == 0 ? 0 : handles[handles[order[s]].parent].slot);
+
+                    // Unreached handles were destroyed or lost an ancestor; recycle them.
+                    for (Node node = 1; node < handleCount; node++)
+                    {
+                        if (!reached[node] && (handles[node].alive || handles[node].slot != InvalidNode))
+                        {
+                            handles[node].alive = false;
+                            handles[node].slot = InvalidNode;
+                            freeHandles.push_back(node);
+                        }
+                    }
+
+                    handleOf.swap(order);
+                    parentSlot.swap(newParent);
+                    firstChild.swap(newFirst);
+                    lastChild.swap(newLast);
+                    levelOf.swap(newLevel);
+                    layoutDirty = false;
+                };
+
+                bool layoutDirty;
+                std::vector<HandleRecord> handles;
+                std::vector<Node> freeHandles;
+                std::vector<Node> dirtyHandles;
+                std::vector<float> local[12];
+                std::vector<float> world[12];
+                std::vector<Node> handleOf;
+                std::vector<std::uint32_t> parentSlot;
+                std::vector<std::uint32_t> firstChild;
+                std::vector<std::uint32_t> lastChild;
+                std::vector<std::uint32_t> levelOf;
+                std::vector<std::uint32_t> levels;
+                std::vector<std::vector<Range>> pending;
+                std::vector<Range> work;
+        };
+    };
+};
+
+#endif // WARLOCK_SCENE_TRANSFORMHIERARCHY_HPP
@@ -0,0 +1,123 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Tests/IO/AsyncReader.cpp
+// Description: Asynchronous reader tests; queue overflow before submission and short reads.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#include "IO/AsyncReader.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <future>
+#include <vector>
+
+using namespace Warlock;
+
+static const char *TestPath = "AsyncReaderTest.bin";
+static constexpr std::size_t PieceSize = 4096;
+static constexpr unsigned int QueueDepth = 8;
+static constexpr unsigned int ReadCount = 48;
+
+static bool WriteTestFile(std::vector<std::uint8_t> &Contents)
+{
+    Contents.resize(PieceSize * ReadCount);
+
+    for (std::size_t i = 0; i < Contents.size(); i++)
+        Contents[i] = static_cast<std::uint8_t>((i * 31) ^ (i >> 8));
+
+    std::FILE *file = std::fopen(TestPath, "wb");
+
+    if (!file)
+        return false;
+
+    bool written = (std::fwrite(Contents.data(), 1, Contents.size(), file) == Contents.size());
+    std::fclose(file);
+
+    return written;
+};
+
+// Queues several times QueueDepth reads before the first Submit(); Read() must hand the
+// queued batch over by itself to free requests, on the io_uring path and the fallback alike.
+static bool TestQueueOverflow(const std::vector<std::uint8_t> &Contents)
+{
+    IO::AsyncReader reader(Core::ThreadPool::GetDefault(), QueueDepth);
+    std::uint32_t file = reader.OpenFile(TestPath);
+
+    if (file == IO::AsyncReader::InvalidFile)
+        return false;
+
+    std::vector<std::uint8_t> buffer(Contents.size() + PieceSize);
+    std::atomic<unsigned int> completed(0);
+    std::atomic<unsigned int> failed(0);
+
+    // Reads are issued back to front so the last one is short, clipped by the end of the file.
+    auto issue = std::async(std::launch::async, [&]()
+    {
+        for (unsigned int i = ReadCount; i-- > 0;)
+        {
+            std::size_t size = (i == ReadCount - 1 ? 2 * PieceSize : PieceSize);
+            std::size_t expected = PieceSize;
+
+            reader.Read(file, i * PieceSize, buffer.data() + i * PieceSize, size, [&, expected](const IO::ReadResult &Result)
+            {
+                if (Result.result != static_cast<std::int64_t>(expected))
+                    failed++;
+
+                completed++;
+            });
+        }
+
+        reader.Wait();
+    });
+
+    if (issue.wait_for(std::chrono::seconds(20)) != std::future_status::ready)
+    {
+        std::printf("queue overflow: reads did not complete\n");
+        std::fflush(stdout);
+        std::_Exit(1);
+    }
+
+    reader.CloseFile(file);
+
+    return (completed == ReadCount && failed == 0 && std::memcmp(buffer.data(), Contents.data(), Contents.size()) == 0);
+};
+
+int main()
+{
+    std::vector<std::uint8_t> contents;
+
+    if (!WriteTestFile(contents))
+    {
+        std::printf("cannot write %s\n", TestPath);
+        return 1;
+    }
+
+    int failures = 0;
+
+    if (!TestQueueOverflow(contents))
+    {
+        std::printf("FAIL queue overflow\n");
+        failures++;
+    }
+
+    std::remove(TestPath);
+    std::printf("%s\n", (failures ? "FAILED" : "PASSED"));
+
+    return (failures ? 1 : 0);
+};
@@ -0,0 +1,267 @@
+//-------------------------------------------------------------------------------------------------
+// Warlock® Application Engine
+// Copyright © 2019 Miguel Nischor
+//
+// File: Tests/Network/Loopback.cpp
+// Description: Snapshot round trips through the bit stream and a lossy, reordering loopback link.
+//-------------------------------------------------------------------------------------------------
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+// http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//-------------------------------------------------------------------------------------------------
+#include "Network/Loopback.hpp"
+#include "Network/SnapshotChannel.hpp"
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace Warlock;
+
+static constexpr std::size_t EntityCount = 203;
+static constexpr std::uint32_t TickCount = 600;
+
+// Every field width and variable field class, then a read past the end.
+static bool TestBitStream()
+{
+    std::mt19937 random(7);
+    std::vector<std::uint32_t> values(4000);
+    std::vector<unsigned int> widths(values.size());
+    Network::BitWriter writer;
+
+    // Every third field is variable; the random widths cover each of its classes.
+    for (std::size_t i = 0; i < values.size(); i++)
+    {
+        widths[i] = static_cast<unsigned int>(random() % 33);
+        values[i] = (widths[i] ? static_cast<std::uint32_t>(random()) >> (32 - widths[i]) : 0);
+
+        if (i % 3 == 0)
+            writer.WriteVariable(values[i]);
+        else
+            writer.Write(values[i], widths[i]);
+    }
+
+    writer.Flush();
+
+    const std::vector<std::uint8_t> &data = writer.GetData();
+    Network::BitReader reader(data.data(), data.size());
+    bool matched = (data.size() == (writer.GetBitCount() + 7) / 8);
+
+    for (std::size_t i = 0; i < values.size(); i++)
+        matched = matched && ((i % 3 == 0 ? reader.ReadVariable() : reader.Read(widths[i])) == values[i]);
+
+    matched = matched && !reader.IsOverflowed();
+    reader.Read(16);
+
+    return (matched && reader.IsOverflowed());
+};
+
+// A world that moves a little each tick: some entities still, some drifting, some turning.
+struct World
+{
+    World() : x(EntityCount), y(EntityCount), z(EntityCount)
+    {
+        for (std::vector<float> &component : rotation)
+            component.resize(EntityCount);
+
+        Step(0);
+    };
+
+    void Step(std::uint32_t Tick)
+    {
+        const float time = static_cast<float>(Tick) * (1.0f / 60.0f);
+
+        for (std::size_t i = 0; i < EntityCount; i++)
+        {
+            const float speed = (i % 4 == 0 ? 0.0f : static_cast<float>(i % 7) * 0.5f);
+            const float angle = (i % 3 == 0 ? 0.0f : time * static_cast<float>(i % 5));
+
+            x[i] = static_cast<float>(i) * 2.0f + speed * time;
+            y[i] = std::sin(time + static_cast<float>(i)) * (i % 2 ? 3.0f : 0.0f);
+            z[i] = -static_cast<float>(i) - speed * time * 0.25f;
+
+            rotation[0][i] = 0.0f;
+            rotation[1][i] = std::sin(angle * 0.5f);
+            rotation[2][i] = 0.0f;
+            rotation[3][i] = std::cos(angle * 0.5f);
+        }
+    };
+
+    Network::Snapshot Capture() const
+    {
+        const float *components[4] = {rotation[0].data(), rotation[1].data(), rotation[2].data(), rotation[3].data()};
+        Network::Snapshot snapshot;
+
+        snapshot.Quantize(x.data(), y.data(), z.data(), components, EntityCount);
+
+        return snapshot;
+    };
+
+    std::vector<float> x, y, z;
+    std::vector<float> rotation[4];
+};
+
+static bool IsEqual(const Network::Snapshot &First, const Network::Snapshot &Second)
+{
+    return (First.x == Second.x && First.y == Second.y && First.z == Second.z && First.rotation == Second.rotation);
+};
+
+// Quantization stays within half a step on positions and a component step on rotations.
+static bool TestQuantization()
+{
+    World world;
+    world.Step(97);
+
+    Network::Snapshot snapshot = world.Capture();
+    std::vector<float> x(EntityCount), y(EntityCount), z(EntityCount), rotation[4];
+
+    for (std::vector<float> &component : rotation)
+        component.resize(EntityCount);
+
+    float *components[4] = {rotation[0].data(), rotation[1].data(), rotation[2].data(), rotation[3].data()};
+    snapshot.Dequantize(x.data(), y.data(), z.data(), components);
+
+    const float precision = Network::SnapshotSettings().positionPrecision;
+    float positionError = 0.0f, rotationError = 0.0f;
+
+    for (std::size_t i = 0; i < EntityCount; i++)
+    {
+        positionError = std::fmax(positionError, std::fabs(x[i] - world.x[i]));
+        positionError = std::fmax(positionError, std::fabs(y[i] - world.y[i]));
+        positionError = std::fmax(positionError, std::fabs(z[i] - world.z[i]));
+
+        // q and -q are the same rotation.
+        float dot = 0.0f;
+
+        for (int c = 0; c < 4; c++)
+            dot += rotation[c][i] * world.rotation[c][i];
+
+        rotationError = std::fmax(rotationError, 1.0f - std::fabs(dot));
+    }
+
+    return (positionError <= precision * 0.5f + 1.0e-4f && rotationError < 1.0e-5f);
+};
+
+// Runs a sender and a receiver over a pair of links. Every snapshot the receiver accepts must
+// be bit identical to the one sent under that sequence, and acknowledgements must move the
+// sender onto delta packets despite the loss.
+static bool TestChannel(const Network::LoopbackSettings &Forward, const Network::LoopbackSettings &Backward, bool Lossless)
+{
+    World world;
+    Network::SnapshotSender sender;
+    Network::SnapshotReceiver receiver;
+    Network::LoopbackLink forward(Forward), backward(Backward);
+    std::vector<Network::Snapshot> sent;
+    std::vector<std::uint8_t> packet;
+    std::size_t accepted = 0, rejected = 0, deltas = 0, mismatches = 0;
+
+    for (std::uint32_t tick = 0; tick < TickCount + 16; tick++)
+    {
+        if (tick < TickCount)
+        {
+            world.Step(tick);
+            sent.push_back(world.Capture());
+            forward.Send(sender.Send(sent.back()));
+        }
+
+        while (forward.Receive(packet))
+        {
+            Network::BitReader header(packet.data(), packet.size());
+            const std::uint32_t sequence = header.Read(32);
+            const bool delta = (header.Read(32) != Network::NoBaseline);
+
+            if (!receiver.Receive(packet.data(), packet.size()))
+            {
+                rejected++;
+                continue;
+            }
+
+            accepted++;
+            deltas += (delta ? 1 : 0);
+
+            if (receiver.GetLatestSequence() != sequence || !IsEqual(receiver.GetLatest(), sent[sequence]))
+                mismatches++;
+
+            const std::uint32_t acknowledgement = receiver.GetLatestSequence();
+            backward.Send(reinterpret_cast<const std::uint8_t *>(&acknowledgement), sizeof(acknowledgement));
+        }
+
+        while (backward.Receive(packet))
+        {
+            std::uint32_t acknowledgement;
+            std::memcpy(&acknowledgement, packet.data(), sizeof(acknowledgement));
+            sender.Acknowledge(acknowledgement);
+        }
+
+        forward.Tick();
+        backward.Tick();
+    }
+
+    std::printf("    sent %u dropped %zu accepted %zu rejected %zu deltas %zu mismatches %zu\n", TickCount, forward.GetDroppedCount(), accepted, rejected, deltas, mismatches);
+
+    if (mismatches != 0 || !receiver.HasSnapshot() || !IsEqual(receiver.GetLatest(), sent[receiver.GetLatestSequence()]))
+        return false;
+
+    // Without loss every packet lands in order; with it, stale packets are turned away but
+    // most still arrive, and nearly all of them as deltas.
+    if (Lossless)
+        return (accepted == TickCount && rejected == 0 && deltas + Forward.latency + Backward.latency + 2 >= TickCount);
+
+    return (rejected > 0 && accepted + forward.GetDroppedCount() + rejected == TickCount && accepted > TickCount / 2 && deltas * 10 > accepted * 9);
+};
+
+int main()
+{
+    int failures = 0;
+
+    if (!TestBitStream())
+    {
+        std::printf("FAIL bit stream\n");
+        failures++;
+    }
+
+    if (!TestQuantization())
+    {
+        std::printf("FAIL quantization\n");
+        failures++;
+    }
+
+    Network::LoopbackSettings clean;
+    clean.latency = 3;
+
+    if (!TestChannel(clean, clean, true))
+    {
+        std::printf("FAIL lossless channel\n");
+        failures++;
+    }
+
+    Network::LoopbackSettings forward, backward;
+    forward.latency = 2;
+    forward.jitter = 4;
+    forward.loss = 0.2f;
+    forward.seed = 11;
+    backward.latency = 2;
+    backward.jitter = 3;
+    backward.loss = 0.3f;
+    backward.seed = 23;
+
+    if (!TestChannel(forward, backward, false))
+    {
+        std::printf("FAIL lossy channel\n");
+        failures++;
+    }
+
+    std::printf("%s\n", (failures ? "FAILED" : "PASSED"));
+
+    return (failures ? 1 : 0);
+};